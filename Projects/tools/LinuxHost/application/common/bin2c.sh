@@ -2,17 +2,57 @@
 
 lengthSuffix="_Length"
 sourceSuffix="_Source"
+packedSuffix="_PackedLength"
+packedDefine="_PACKED"
+
+# PackBits encoder. Reads one decimal byte per line, writes the encoded stream as C hex bytes,
+# 16 per line. Runs of 3 or more identical bytes (typically erased 0xFF flash) become a
+# 2 byte repeat record, everything else is stored as literal records of up to 128 bytes.
+packbits='
+function emit(v) {
+    printf("%s0x%02x", (cnt == 0) ? "\t" : ((cnt % 16) == 0) ? ",\n\t" : ",", v)
+    cnt++
+}
+{ b[n++] = $1 }
+END {
+    i = 0
+    while (i < n) {
+        r = 1
+        while ((i + r < n) && (r < 128) && (b[i + r] == b[i])) r++
+        if (r >= 3) {
+            emit(257 - r); emit(b[i]); i += r
+        } else {
+            s = i
+            while ((i < n) && (i - s < 128)) {
+                if ((i + 2 < n) && (b[i] == b[i + 1]) && (b[i] == b[i + 2])) break
+                i++
+            }
+            emit(i - s - 1)
+            for (k = s; k < i; k++) emit(b[k])
+        }
+    }
+    printf("\n")
+}'
+
+packed=0
+if [ "$4" = "packed" ]; then
+    packed=1
+fi
 
 if [ ! -e $1 ] || [ -z "$2" ] || [ -z "$3" ]; then
     echo "$0 v1.1 - Convert a file to a C file representing its contents as a binary array."
     echo ""
-    echo "Usage: $0 <InFile> <VariableNameToUseInC> <OutFileWithoutExtension>"
+    echo "Usage: $0 <InFile> <VariableNameToUseInC> <OutFileWithoutExtension> [packed]"
     echo "       Reads from <InpFile>."
     echo "       Creates <OutFile>.c & <OutFile>.h (overwriting already exists) with 3 variables:"
     echo "            A 'const char *' named <VariableNameToUseInC>$sourceSuffix containing the base name of <InFile>, and"
     echo "            a 'const unsigned char []' named <VariableNameToUseInC>, and"
     echo "            a 'const unsigned int' named <VariableNameToUseInC>$lengthSuffix."
     echo ""
+    echo "       With 'packed', the array holds the PackBits compressed image instead, its size is"
+    echo "       in a 'const unsigned int' named <VariableNameToUseInC>$packedSuffix, <VariableNameToUseInC>$lengthSuffix"
+    echo "       remains the uncompressed size, and <VariableNameToUseInC>$packedDefine is defined in <OutFile>.h."
+    echo ""
     echo "Exits with 0 if success, otherwise non-zero."
     rc=1
 else
@@ -20,7 +60,9 @@ else
     hFile=$3.h
     cFile=$3.c
     imageLength=`ls -l $1 | cut -d ' ' -f 5`
-    imageDataRaw=`hexdump -v -e '/1 "0x%02x,"' $1`
+    if [ $packed -eq 0 ]; then
+        imageDataRaw=`hexdump -v -e '/1 "0x%02x,"' $1`
+    fi
     # Create H file
     echo "extern const char *$2$sourceSuffix;" > $hFile
     rc=$?
@@ -28,7 +70,13 @@ else
         echo "ERROR: Unable to create $hFile"
     else
     	echo "extern const unsigned int  $2$lengthSuffix;" >> $hFile
-        echo "extern const unsigned char $2[$imageLength];" >> $hFile
+        if [ $packed -eq 0 ]; then
+            echo "extern const unsigned char $2[$imageLength];" >> $hFile
+        else
+            echo "#define $2$packedDefine" >> $hFile
+            echo "extern const unsigned int  $2$packedSuffix;" >> $hFile
+            echo "extern const unsigned char $2[];" >> $hFile
+        fi
         # Now create C file
         echo "#include \"$hFile\"" > $cFile
         rc=$?
@@ -37,10 +85,17 @@ else
         else
             echo "const char *$2$sourceSuffix = \"$sourceFileName\";" > $cFile
             echo "const unsigned int  $2$lengthSuffix = $imageLength;" >> $cFile
-            echo "const unsigned char $2[$imageLength] = {" >> $cFile
-            # Strip final trailing comma, and for readibility, add leading tab, and replace evey 16th comma with a comma, line-break & tab.
-            echo "${imageDataRaw::-1}" | sed -e's|^|\t|g' | sed -e's|\(\([^,]*,\)\{15\}[^,]*\),|\1,\n\t|g' >> $cFile
-            echo "};" >> $cFile
+            if [ $packed -eq 0 ]; then
+                echo "const unsigned char $2[$imageLength] = {" >> $cFile
+                # Strip final trailing comma, and for readibility, add leading tab, and replace evey 16th comma with a comma, line-break & tab.
+                echo "${imageDataRaw::-1}" | sed -e's|^|\t|g' | sed -e's|\(\([^,]*,\)\{15\}[^,]*\),|\1,\n\t|g' >> $cFile
+                echo "};" >> $cFile
+            else
+                echo "const unsigned char $2[] = {" >> $cFile
+                hexdump -v -e '/1 "%u\n"' $1 | awk "$packbits" >> $cFile
+                echo "};" >> $cFile
+                echo "const unsigned int  $2$packedSuffix = sizeof($2);" >> $cFile
+            fi
             echo "Created files $cFile and $hFile with data from $1 containing variables $2 and $2$lengthSuffix"
         fi
     fi
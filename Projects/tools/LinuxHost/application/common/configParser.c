@@ -36,15 +36,45 @@
 
 **************************************************************************************************/
 #include "unistd.h"
+#include "errno.h"
 #include "configParser.h"
 #include "pthread.h"
 #include "common_app.h"
 #include "tiLogging.h"
+#include "configStore.h"
+
+// Longest value returned, matching the line length of the shadow file writer
+#define CFG_PRS_VALUE_MAX 2048
+
+// One pending update of a transaction
+typedef struct
+{
+	char *section;
+	char *key;
+	char *value;
+	uint8 written;
+} configParserUpdate_t;
+
+struct configParserTransaction_s
+{
+	char                 *configFilePath;
+	char                 *shadowPath;
+	configParserUpdate_t *updates;
+	int                  numUpdates;
+	int                  maxUpdates;
+};
 
 static FILE *configFileFd;
-static FILE *shadowFileFd;
+// Path configFileFd was opened from, updates replace the file there with a new one
+static char *cfgFilePath = NULL;
 
-static pthread_mutex_t cfgFileAccessMutex;
+// Parsed configuration, rebuilt when the file looked up changes
+static configStore_t *cfgStore = NULL;
+
+// Updates made after ConfigParserInit() with a shadow path, written by ConfigParserClose()
+static configParserTransaction_t *cfgTransaction = NULL;
+
+static pthread_mutex_t cfgFileAccessMutex = PTHREAD_MUTEX_INITIALIZER;
 
 /**************************************************************************************************
  *
@@ -56,9 +86,10 @@ static pthread_mutex_t cfgFileAccessMutex;
  * input parameters
  *
  * @param          configFilePath   - path to configuration file
- * @param          shadowPath   	- path to shadow file used for new entries. Caller is
- * 									  responsible to verify permission to write to this
- * 									  file.
+ * @param          shadowPath   	- path to shadow file used for new entries, or NULL for
+ * 									  read only use. Values set until ConfigParserClose()
+ * 									  are written to it at once, then it replaces the
+ * 									  configuration file.
  *
  * output parameters
  *
@@ -76,39 +107,42 @@ int ConfigParserInit(const char *configFilePath, const char *shadowPath)
 	configFileFd = fopen(configFilePath, "r");
 	if (configFileFd)
 	{
+		cfgFilePath = strdup(configFilePath);
+
+		// Parse the file once, ConfigParser() then only looks keys up
+		pthread_mutex_lock(&cfgFileAccessMutex);
+		configStore_Free(cfgStore);
+		cfgStore = configStore_LoadFd(fileno(configFileFd));
+		pthread_mutex_unlock(&cfgFileAccessMutex);
+
 		if (shadowPath)
 		{
-			shadowFileFd = fopen(shadowPath, "w");
+			pthread_mutex_lock(&cfgFileAccessMutex);
+			cfgTransaction = ConfigParserTransactionBegin(configFilePath, shadowPath);
+			pthread_mutex_unlock(&cfgFileAccessMutex);
+			if (cfgTransaction == NULL)
+			{
+				LOG_ERROR("[CFG_PRS] Failed to start transaction on %s\n", shadowPath);
+				// Do not leave the file and its parsed contents behind
+				ConfigParserClose();
+				return -1;
+			}
 		}
 
-		if ( (!shadowPath) || (shadowFileFd && shadowPath) )
-		{
-			return 0;
-		}
-		else
-		{
-			perror("[CFG_PRS] Failed to open shadow file when it was requested");
-			return -1;
-		}
+		return 0;
 	}
 	else
 	{
 		perror("[CFG_PRS] Failed to open configuration file");
 		return -1;
 	}
-
-	if (pthread_mutex_init(&cfgFileAccessMutex, NULL))
-	{
-		LOG("[CFG_PRS][ERROR] Failed To Initialize Mutex cfgFileAccessMutex\n");
-		return -1;
-	}
 }
 
 /**************************************************************************************************
  *
  * @fn          ConfigParserClose
  *
- * @brief       Closes opened files
+ * @brief       Closes opened files, and commits the values set since ConfigParserInit()
  *
  * input parameters
  *
@@ -130,16 +164,21 @@ void ConfigParserClose()
 		fclose(configFileFd);
 		configFileFd = NULL;
 	}
-	if (shadowFileFd)
+	free(cfgFilePath);
+	cfgFilePath = NULL;
+	pthread_mutex_lock(&cfgFileAccessMutex);
+	configStore_Free(cfgStore);
+	cfgStore = NULL;
+	if (cfgTransaction)
 	{
-		// Flush stream
-		fflush(shadowFileFd);
-		// Immediately commit changes to disk.
-		fsync(fileno(shadowFileFd));
-		// Close previous file descriptor if it exist.
-		fclose(shadowFileFd);
-		shadowFileFd = NULL;
+		// Write all updates in one go
+		if (ConfigParserTransactionCommit(cfgTransaction) != 0)
+		{
+			LOG_ERROR("[CFG_PRS] Failed to save configuration\n");
+		}
+		cfgTransaction = NULL;
 	}
+	pthread_mutex_unlock(&cfgFileAccessMutex);
 }
 
 /**************************************************************************************************
@@ -301,36 +340,39 @@ int ConfigParser(const char* section, const char* key, char* resultString)
 
 int ConfigParserSet(const char *configFilePath, const char *shadowPath, const char* section, const char* key, char* newValue)
 {
-	int returnVal = 0;
-
-	// First initialize the ConfigParser
-	ConfigParserInit(configFilePath, shadowPath);
+	configParserTransaction_t *transaction;
+	int res;
 
-	if (configFileFd && shadowFileFd)
+	transaction = ConfigParserTransactionBegin(configFilePath, shadowPath);
+	if (transaction == NULL)
 	{
-		returnVal = ConfigParserSetGetFromFd(configFileFd, section, key, NULL, newValue);
+		return -1;
 	}
-	else
+
+	if (ConfigParserTransactionSet(transaction, section, key, newValue) != 0)
 	{
-		returnVal = -1;
+		ConfigParserTransactionAbort(transaction);
+		return -1;
 	}
 
-	// Now copy the updated shadow over to the NV file. First make sure the files are not
-	// used by Config Parser
-	ConfigParserClose();
+	res = ConfigParserTransactionCommit(transaction);
 
-	// The following function assumes that the system will overwrite the existing file.
-	rename(shadowPath, configFilePath);
+	// The file was replaced, make the next lookup parse it again
+	pthread_mutex_lock(&cfgFileAccessMutex);
+	configStore_Free(cfgStore);
+	cfgStore = NULL;
+	pthread_mutex_unlock(&cfgFileAccessMutex);
 
-	return returnVal;
+	return res;
 }
 
 /**************************************************************************************************
  *
  * @fn          ConfigParserSetValue
  *
- * @brief       This function searches for a key and updates its value, in the shadow file
- * 				NOTE! Config Parser must have been initialized first.
+ * @brief       This function records a new value for a key. It is written to the shadow
+ * 				file, together with all other values set, by ConfigParserClose().
+ * 				NOTE! Config Parser must have been initialized with a shadow path first.
  *
  * input parameters
  *
@@ -347,14 +389,16 @@ int ConfigParserSet(const char *configFilePath, const char *shadowPath, const ch
  **************************************************************************************************/
 int ConfigParserSetValue(const char* section, const char* key, char* newValue)
 {
-	if (configFileFd && shadowFileFd)
-	{
-		return 0;
-	}
-	else
+	int res = -1;
+
+	pthread_mutex_lock(&cfgFileAccessMutex);
+	if (cfgTransaction)
 	{
-		return -1;
+		res = ConfigParserTransactionSet(cfgTransaction, section, key, newValue);
 	}
+	pthread_mutex_unlock(&cfgFileAccessMutex);
+
+	return res;
 }
 
 /**************************************************************************************************
@@ -382,14 +426,21 @@ int ConfigParserSetValue(const char* section, const char* key, char* newValue)
 int ConfigParserFromPath(const char *configFilePath, const char* section,
 		const char* key, char* resultString)
 {
-	FILE *configFileTmpFd;
-	int res = 1;
-
-	configFileTmpFd = fopen(configFilePath, "r");
-
-	ConfigParserFromFd(configFileTmpFd, section, key, resultString);
+	configStore_t *store;
+	const char *value;
+	int res = -1;
 
-	fclose(configFileTmpFd);
+	store = configStore_Load(configFilePath);
+	if (store)
+	{
+		value = configStore_Get(store, section, key);
+		if (value && (strlen(value) < CFG_PRS_VALUE_MAX))
+		{
+			strcpy(resultString, value);
+			res = 0;
+		}
+		configStore_Free(store);
+	}
 
 	return res;
 }
@@ -399,7 +450,10 @@ int ConfigParserFromPath(const char *configFilePath, const char* section,
  * @fn          ConfigParserFromFd
  *
  * @brief       This function searches for a string a returns its value. It searches
- * 				in the file you provide.
+ * 				in the file you provide. The file is parsed on first use and again only
+ * 				when it changes, so consecutive calls are table lookups. For the file
+ * 				opened by ConfigParserInit() the path is checked, so that a file written
+ * 				by ConfigParserSet() or a transaction commit is picked up.
  *
  * input parameters
  *
@@ -418,8 +472,52 @@ int ConfigParserFromPath(const char *configFilePath, const char* section,
 int ConfigParserFromFd(FILE* cfgFd, const char* section,
 		const char* key, char* resultString)
 {
-	return ConfigParserSetGetFromFd( cfgFd, section,
-			key, resultString, NULL);
+	const char *value;
+	int res = -1;
+
+	// Do nothing if the file doesn't exist
+	if (cfgFd == NULL)
+	{
+		return res;
+	}
+
+	pthread_mutex_lock(&cfgFileAccessMutex);
+
+	if ((cfgFd == configFileFd) && cfgFilePath)
+	{
+		// Updates rename a new file over the path, cfgFd still refers to the old one
+		if (!configStore_IsCurrentPath(cfgStore, cfgFilePath))
+		{
+			LOG_TRACE("[CFG_PRS][INFO] Parsing configuration file %s\n", cfgFilePath);
+			configStore_Free(cfgStore);
+			if ((cfgStore = configStore_Load(cfgFilePath)) == NULL)
+			{
+				// Gone from the path, keep using what was opened
+				cfgStore = configStore_LoadFd(fileno(cfgFd));
+			}
+		}
+	}
+	else if (!configStore_IsCurrent(cfgStore, fileno(cfgFd)))
+	{
+		LOG_TRACE("[CFG_PRS][INFO] Parsing configuration file\n");
+		configStore_Free(cfgStore);
+		cfgStore = configStore_LoadFd(fileno(cfgFd));
+	}
+
+	value = cfgStore ? configStore_Get(cfgStore, section, key) : NULL;
+	if (value && (strlen(value) < CFG_PRS_VALUE_MAX))
+	{
+		LOG_TRACE2("[CFG_PRS]Found [%s] %s = '%s'\n", section, key, value);
+		// Only copy result if it was asked for.
+		if (resultString)
+		{
+			strcpy(resultString, value);
+		}
+		res = 0;
+	}
+
+	pthread_mutex_unlock(&cfgFileAccessMutex);
+	return res;
 }
 
 /**************************************************************************************************
@@ -427,8 +525,8 @@ int ConfigParserFromFd(FILE* cfgFd, const char* section,
  * @fn          ConfigParserSetGetFromFd
  *
  * @brief       This function searches for a string a returns its value. It searches
- * 				in the file you provide. It also updates the shadow file if newValue string is
- * 				non-NULL
+ * 				in the file you provide. If newValue string is non-NULL it is also recorded
+ * 				as the new value, see ConfigParserSetValue().
  *
  * input parameters
  *
@@ -448,250 +546,480 @@ int ConfigParserFromFd(FILE* cfgFd, const char* section,
 int ConfigParserSetGetFromFd(FILE* cfgFd, const char* section,
 		const char* key, char* resultString, char* newValue)
 {
-	uint8 sectionFound = FALSE, invalidLineLen = FALSE, newValueWritten = FALSE;
-	char* resString = NULL;
-	char* resStringToFree = NULL;
-	char* lineToShadow = NULL;
-	char* lineToShadowToFree = NULL;
-	char* lineToShadowCreated = NULL;
-	char* lineToShadowCreatedToFree = NULL;
-	char* psStr; // Processing string pointer
-	int res = -1;
+	int res = ConfigParserFromFd(cfgFd, section, key, resultString);
 
-	// Get file access lock first
-	pthread_mutex_lock(&cfgFileAccessMutex);
+	if (newValue && (ConfigParserSetValue(section, key, newValue) != 0))
+	{
+		res = -1;
+	}
 
-	resString = malloc (2048);
-	lineToShadow = malloc (2048);
-	lineToShadowCreated = malloc (1024);
-	if (!resString || !lineToShadow || !lineToShadowCreated)
+	return res;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          ConfigParserTransactionBegin
+ *
+ * @brief       Starts a set of updates to a configuration file. Values set on the
+ * 				transaction are kept in memory until ConfigParserTransactionCommit().
+ *
+ * input parameters
+ *
+ * @param          configFilePath   - path to configuration file
+ * @param          shadowPath   	- path of the temporary file the result is written to
+ * 									  before it replaces the configuration file. NULL to
+ * 									  use configFilePath with a ".tmp" suffix.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      The transaction, or NULL if out of memory.
+ *
+ **************************************************************************************************/
+configParserTransaction_t *ConfigParserTransactionBegin(const char *configFilePath, const char *shadowPath)
+{
+	configParserTransaction_t *transaction;
+
+	transaction = calloc(1, sizeof(configParserTransaction_t));
+	if (transaction)
 	{
-		return res;
+		transaction->configFilePath = strdup(configFilePath);
+		if (shadowPath)
+		{
+			transaction->shadowPath = strdup(shadowPath);
+		}
+		else if (transaction->configFilePath)
+		{
+			transaction->shadowPath = malloc(strlen(configFilePath) + sizeof(".tmp"));
+			if (transaction->shadowPath)
+			{
+				strcpy(transaction->shadowPath, configFilePath);
+				strcat(transaction->shadowPath, ".tmp");
+			}
+		}
+
+		if (!transaction->configFilePath || !transaction->shadowPath)
+		{
+			ConfigParserTransactionAbort(transaction);
+			transaction = NULL;
+		}
 	}
-	resStringToFree = resString;
-	lineToShadowToFree = lineToShadow;
-	lineToShadowCreatedToFree = lineToShadowCreated;
-	LOG_TRACE2("[CFG_PRS]------------------------------------------------------\n");
-	LOG_TRACE2("[CFG_PRS]Config Parsing:\n");
-	LOG_TRACE2("[CFG_PRS]- \tSection \t%s:\n", section);
-	LOG_TRACE2("[CFG_PRS]- \tKey \t\t%s:\n", key);
 
-	// Do nothing if the file doesn't exist
-	if (cfgFd != NULL)
+	return transaction;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          configParserFindUpdate
+ *
+ * @brief       Finds the pending update of a key.
+ *
+ * input parameters
+ *
+ * @param          transaction      - transaction to search
+ * @param          section          - section name, not NUL terminated
+ * @param          sectionLen       - its length
+ * @param          key              - key name, not NUL terminated
+ * @param          keyLen           - its length
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      The update, or NULL if the key has not been set.
+ *
+ **************************************************************************************************/
+static configParserUpdate_t *configParserFindUpdate(configParserTransaction_t *transaction,
+		const char *section, size_t sectionLen, const char *key, size_t keyLen)
+{
+	configParserUpdate_t *update;
+	int i;
+
+	for (i = 0; i < transaction->numUpdates; i++)
+	{
+		update = &transaction->updates[i];
+		if ((strncmp(update->section, section, sectionLen) == 0) &&
+			(update->section[sectionLen] == '\0') &&
+			(strncmp(update->key, key, keyLen) == 0) &&
+			(update->key[keyLen] == '\0'))
+		{
+			return update;
+		}
+	}
+
+	return NULL;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          ConfigParserTransactionSet
+ *
+ * @brief       Records a new value for a key. Setting the same key again replaces the
+ * 				previous value. Keys and sections that do not exist are created.
+ *
+ * input parameters
+ *
+ * @param          transaction      - transaction from ConfigParserTransactionBegin()
+ * @param          section          - section of the key
+ * @param          key              - key to set
+ * @param          newValue         - string to set as new value
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      0 on success, -1 if out of memory.
+ *
+ **************************************************************************************************/
+int ConfigParserTransactionSet(configParserTransaction_t *transaction, const char* section, const char* key, const char* newValue)
+{
+	configParserUpdate_t *update;
+	char *value;
+
+	value = strdup(newValue);
+	if (!value)
+	{
+		return -1;
+	}
+
+	update = configParserFindUpdate(transaction, section, strlen(section), key, strlen(key));
+	if (update)
+	{
+		free(update->value);
+		update->value = value;
+		return 0;
+	}
+
+	if (transaction->numUpdates == transaction->maxUpdates)
 	{
-		LOG_TRACE("[CFG_PRS][INFO] Resetting files - \tSection \t%s:\t%s:\n", section, key);
-		if (shadowFileFd != NULL)
+		int maxUpdates = transaction->maxUpdates ? (2 * transaction->maxUpdates) : 16;
+
+		update = realloc(transaction->updates, maxUpdates * sizeof(configParserUpdate_t));
+		if (!update)
 		{
-			// Make sure we restart the shadow file
-			fseek(shadowFileFd, 0, SEEK_SET);
+			free(value);
+			return -1;
 		}
-		// Make sure we start search from the beginning of the file
-		fseek(cfgFd, 0, SEEK_SET);
+		transaction->updates = update;
+		transaction->maxUpdates = maxUpdates;
+	}
+
+	update = &transaction->updates[transaction->numUpdates];
+	update->section = strdup(section);
+	update->key = strdup(key);
+	update->value = value;
+	update->written = FALSE;
+	if (!update->section || !update->key)
+	{
+		free(update->section);
+		free(update->key);
+		free(update->value);
+		return -1;
+	}
+	transaction->numUpdates++;
 
-		LOG_TRACE("[CFG_PRS][INFO] Files reset, now searching\n");
+	return 0;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          configParserTrim
+ *
+ * @brief       Strips blanks and carriage returns on both ends of [*pStart, *pEnd).
+ *
+ **************************************************************************************************/
+static void configParserTrim(const char **pStart, const char **pEnd)
+{
+	while ((*pStart < *pEnd) && ((**pStart == ' ') || (**pStart == '\t')))
+	{
+		(*pStart)++;
+	}
+	while ((*pEnd > *pStart) &&
+			(((*pEnd)[-1] == ' ') || ((*pEnd)[-1] == '\t') || ((*pEnd)[-1] == '\r')))
+	{
+		(*pEnd)--;
+	}
+}
 
-		// Search through the configuration file for the wanted
-		while ((resString = fgets(resString, 2048, cfgFd)) != NULL)
+/**************************************************************************************************
+ *
+ * @fn          configParserWriteSection
+ *
+ * @brief       Writes the updates of a section that did not replace an existing line.
+ *
+ * input parameters
+ *
+ * @param          transaction      - transaction to write
+ * @param          out              - destination
+ * @param          section          - section name, not NUL terminated
+ * @param          sectionLen       - its length
+ * @param          newline          - line ending used by the file
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+static void configParserWriteSection(configParserTransaction_t *transaction, FILE *out,
+		const char *section, size_t sectionLen, const char *newline)
+{
+	configParserUpdate_t *update;
+	int i;
+
+	for (i = 0; i < transaction->numUpdates; i++)
+	{
+		update = &transaction->updates[i];
+		if ((update->written == FALSE) &&
+			(strncmp(update->section, section, sectionLen) == 0) &&
+			(update->section[sectionLen] == '\0'))
 		{
-			if (shadowFileFd && lineToShadow && newValue)
+			LOG_TRACE("[CFG_PRS][NEW] [%s] %s=%s\n", update->section, update->key, update->value);
+			fprintf(out, "%s=%s%s", update->key, update->value, newline);
+			update->written = TRUE;
+		}
+	}
+}
+
+/**************************************************************************************************
+ *
+ * @fn          configParserReadFile
+ *
+ * @brief       Reads a whole file in memory. A file that does not exist reads as empty.
+ *
+ * input parameters
+ *
+ * @param          path             - file to read
+ *
+ * output parameters
+ *
+ * @param          pLen             - number of bytes read
+ *
+ * @return      Allocated content, or NULL on error.
+ *
+ **************************************************************************************************/
+static char *configParserReadFile(const char *path, size_t *pLen)
+{
+	FILE *fd;
+	char *buf = NULL;
+	long len;
+
+	*pLen = 0;
+	fd = fopen(path, "r");
+	if (!fd)
+	{
+		return (errno == ENOENT) ? calloc(1, 1) : NULL;
+	}
+
+	if ((fseek(fd, 0, SEEK_END) == 0) && ((len = ftell(fd)) >= 0) &&
+		(fseek(fd, 0, SEEK_SET) == 0))
+	{
+		buf = malloc(len + 1);
+		if (buf && (fread(buf, 1, len, fd) != (size_t)len))
+		{
+			free(buf);
+			buf = NULL;
+		}
+		else if (buf)
+		{
+			buf[len] = '\0';
+			*pLen = len;
+		}
+	}
+	fclose(fd);
+
+	return buf;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          ConfigParserTransactionCommit
+ *
+ * @brief       Writes the configuration file with all updates applied. The result goes to
+ * 				the shadow file, which is synced once and then renamed over the
+ * 				configuration file, so readers see either the old or the new content.
+ * 				The transaction is released in all cases.
+ *
+ * input parameters
+ *
+ * @param          transaction      - transaction from ConfigParserTransactionBegin()
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      0 on success, -1 on error (the configuration file is then unchanged).
+ *
+ **************************************************************************************************/
+int ConfigParserTransactionCommit(configParserTransaction_t *transaction)
+{
+	const char *line, *eol, *end, *p, *q, *eq;
+	const char *newline = "\n", *lineEnd;
+	const char *section = NULL;
+	size_t sectionLen = 0, len;
+	configParserUpdate_t *update;
+	char *buf;
+	FILE *out;
+	int i, res = -1;
+
+	if (transaction->numUpdates == 0)
+	{
+		// Nothing to write
+		ConfigParserTransactionAbort(transaction);
+		return 0;
+	}
+
+	buf = configParserReadFile(transaction->configFilePath, &len);
+	if (!buf)
+	{
+		perror("[CFG_PRS] Failed to read configuration file");
+		ConfigParserTransactionAbort(transaction);
+		return -1;
+	}
+	end = buf + len;
+
+	out = fopen(transaction->shadowPath, "w");
+	if (!out)
+	{
+		perror("[CFG_PRS] Failed to open shadow file");
+		free(buf);
+		ConfigParserTransactionAbort(transaction);
+		return -1;
+	}
+
+	// Keep the line ending of the file for the lines we write
+	eol = memchr(buf, '\n', len);
+	if (eol && (eol > buf) && (eol[-1] == '\r'))
+	{
+		newline = "\r\n";
+	}
+
+	for (line = buf; line < end; line = eol + 1)
+	{
+		eol = memchr(line, '\n', end - line);
+		if (!eol)
+		{
+			eol = end;
+		}
+		lineEnd = (eol == end) ? newline : ((eol > line) && (eol[-1] == '\r')) ? "\r\n" : "\n";
+		p = line;
+		q = eol;
+		configParserTrim(&p, &q);
+
+		if ((p < q) && (*p == '['))
+		{
+			// Keys missing from the section we leave are added at its end
+			if (section)
 			{
-				// Copy line to shadow line
-				strcpy(lineToShadow, resString);
+				configParserWriteSection(transaction, out, section, sectionLen, newline);
 			}
-
-			// Check if we have a valid line, i.e. begins with [.
-			// Note! No valid line can span more than 2048 bytes. Hence we
-			// must hold off parsing until we hit a newline.
-			if (strlen(resString) == 2048)
+			eq = memchr(p + 1, ']', q - (p + 1));
+			p++;
+			if (eq)
 			{
-				invalidLineLen = TRUE;
-				LOG_TRACE2("[CFG_PRS]Found line > 2048 bytes");
+				q = eq;
 			}
-			else
+			configParserTrim(&p, &q);
+			section = p;
+			sectionLen = q - p;
+		}
+		else if (section && (p < q) && (*p != '#') && ((eq = memchr(p, '=', q - p)) != NULL))
+		{
+			q = eq;
+			configParserTrim(&p, &q);
+			update = configParserFindUpdate(transaction, section, sectionLen, p, q - p);
+			if (update && (update->written == FALSE))
 			{
-				// First time we find a valid line length after having
-				// found invalid line length may be the end of the
-				// invalid line. Hence, do not process this string.
-				// We set the invalidLineLen parameter to FALSE after
-				// the processing logic.
-				if (invalidLineLen == FALSE)
-				{
-					// Remove the newline character (ok even if line had length 2048)
-					resString[strlen(resString) - 1] = '\0';
-
-					LOG_TRACE2("[CFG_PRS]Found line < 2048 bytes");
-					fflush(LOG_DESTINATION_FP);
-					if (resString[0] == '[')
-					{
-						LOG_TRACE2("[CFG_PRS]Found section %s\n", resString);
-						// Search for wanted section
-						psStr = strstr(resString, section);
-						if (psStr != NULL)
-						{
-							resString = psStr;
-							// We found our wanted section. Now search for wanted key.
-							sectionFound = TRUE;
-							LOG_TRACE2("[CFG_PRS]Found wanted section!\n");
-						}
-						else
-						{
-							// We found another section.
-							if (sectionFound == TRUE)
-							{
-								// We passed the whole section without finding the value. Add it manually instead
-								if (shadowFileFd && lineToShadow && newValue)
-								{
-									if (newValueWritten == TRUE)
-									{
-										LOG_TRACE2("[CFG_PRS] Value already written, can move on!\n");
-									}
-									else
-									{
-										LOG_TRACE("[CFG_PRS][NEW] Section found, but not value in it. We add it here: ");
-										// Create new line based on known key and value
-										lineToShadowCreated[0] = '\0';
-										strcat(lineToShadowCreated, key);
-										strcat(lineToShadowCreated, "=");
-										strcat(lineToShadowCreated, newValue);
-										strcat(lineToShadowCreated, "\n");
-										// Write it to file
-										fputs(lineToShadowCreated, shadowFileFd);
-										LOG_TRACE("%s", lineToShadowCreated);
-										newValueWritten = TRUE;
-									}
-								}
-							}
-							sectionFound = FALSE;
-						}
-					}
-					else if (sectionFound == TRUE)
-					{
-						LOG_TRACE2("[CFG_PRS]Line to process %s (strlen=%zd)\n",
-								resString,
-								strlen(resString));
-						// We have found our section, now we search for wanted key
-						// Check for commented lines, tagged with '#', and
-						// lines > 0 in length
-						if ((resString[0] != '#') && (strlen(resString) > 0))
-						{
-							// Search for wanted section
-							psStr = strstr(resString, key);
-							if (psStr != NULL)
-							{
-								LOG_TRACE2("[CFG_PRS]Found key \t'%s' in \t'%s'\n", key, resString);
-								// The value is located after the '='
-								// after the key.
-								psStr = strtok(psStr, "=");
-								psStr = strtok(NULL, "=;\"\r");
-
-								// Trim potential return and/or newline character
-
-								resString = psStr;
-								res = 0;
-								LOG_TRACE2("[CFG_PRS]Found value '%s'\n", resString);
-
-								// Only copy result if it was asked for.
-								if (resultString)
-								{
-									strcpy(resultString, resString);
-									LOG_TRACE2("[CFG_PRS]Found value2 '%s'\n", resultString);
-								}
-
-								// Update shadow file if new value is provided
-								if (shadowFileFd && lineToShadow && newValue)
-								{
-									if (newValueWritten == TRUE)
-									{
-										LOG_TRACE2("[CFG_PRS] Value already written!\n");
-									}
-									else
-									{
-										// Create new line based on known key and value
-										strcpy(lineToShadow, key);
-										strcat(lineToShadow, "=");
-										strcat(lineToShadow, newValue);
-										strcat(lineToShadow, "\n");
-										LOG_TRACE("[CFG_PRS] Updated line to '%s'\n", lineToShadow);
-										newValueWritten = TRUE;
-									}
-									// Move back pointer
-									resString = resStringToFree;
-								}
-								else
-								{
-									// We can return this string to the calling function
-
-									// Only break if we're not trying to update file
-									break;
-								}
-							}
-						}
-					}
-					// Write line to shadow file
-					if (shadowFileFd && lineToShadow && newValue)
-					{
-						LOG_TRACE2("[CFG_PRS][OLD] Writing existing line '%s' to shadow file\n", lineToShadow);
-						fputs(lineToShadow, shadowFileFd);
-					}
-				}
-				else
-				{
-					LOG_TRACE2("[CFG_PRS]Found end of line > 2048 bytes\n");
-					invalidLineLen = FALSE;
-				}
+				LOG_TRACE("[CFG_PRS] Updated [%s] %s=%s\n", update->section, update->key, update->value);
+				fprintf(out, "%s=%s%s", update->key, update->value, lineEnd);
+				update->written = TRUE;
+				continue;
 			}
 		}
 
-		LOG_TRACE("[CFG_PRS][INFO] Search complete\n");
+		fwrite(line, 1, eol - line, out);
+		if (eol == end)
+		{
+			fputs(newline, out);
+		}
+		else
+		{
+			fputc('\n', out);
+		}
 	}
-	else
+	if (section)
 	{
-		free(resStringToFree);
-		free(lineToShadowToFree);
-		free(lineToShadowCreatedToFree);
-		return res;
+		configParserWriteSection(transaction, out, section, sectionLen, newline);
 	}
 
-	// We passed the whole section without finding the value. Add it manually instead
-	if (shadowFileFd && lineToShadow && newValue)
+	// Sections that do not exist yet go to the end of the file
+	for (i = 0; i < transaction->numUpdates; i++)
 	{
-		if (newValueWritten == TRUE)
+		update = &transaction->updates[i];
+		if (update->written == FALSE)
 		{
-			LOG_TRACE2("[CFG_PRS] Value written successfully!\n");
-		}
-		else
-		{
-			if (sectionFound == FALSE)
-			{
-				LOG_TRACE("[CFG_PRS] Section not found. We add it here\n");
-				// Create new section line
-				lineToShadowCreated[0] = '[';
-				lineToShadowCreated[1] = '\0';
-				strcat(lineToShadowCreated, section);
-				strcat(lineToShadowCreated, "]");
-				strcat(lineToShadowCreated, "\n");
-				// Write it to file
-				LOG_TRACE("[CFG_PRS][NEW] Writing line '%s' to shadow file\n", lineToShadowCreated);
-				fputs(lineToShadowCreated, shadowFileFd);
-			}
-			LOG_TRACE("[CFG_PRS][NEW] Preparing line to shadow file\n");
-			// Create new line based on known key and value
-			lineToShadowCreated[0] = '\0';
-			strcat(lineToShadowCreated, key);
-			strcat(lineToShadowCreated, "=");
-			strcat(lineToShadowCreated, newValue);
-			strcat(lineToShadowCreated, "\n");
-			LOG_TRACE("[CFG_PRS][NEW] Writing line '%s' to shadow file\n", lineToShadowCreated);
-			// Write it to file
-			fputs(lineToShadowCreated, shadowFileFd);
+			LOG_TRACE("[CFG_PRS][NEW] Section [%s]\n", update->section);
+			fprintf(out, "[%s]%s", update->section, newline);
+			configParserWriteSection(transaction, out, update->section, strlen(update->section), newline);
 		}
 	}
+	free(buf);
 
-	free(resStringToFree);
-	free(lineToShadowToFree);
-	free(lineToShadowCreatedToFree);
+	// Single flush to disk, then atomically replace the configuration file
+	if ((fflush(out) == 0) && !ferror(out) && (fsync(fileno(out)) == 0))
+	{
+		res = 0;
+	}
+	if ((fclose(out) != 0) || (res != 0))
+	{
+		perror("[CFG_PRS] Failed to write shadow file");
+		unlink(transaction->shadowPath);
+		res = -1;
+	}
+	else if (rename(transaction->shadowPath, transaction->configFilePath) != 0)
+	{
+		perror("[CFG_PRS] Failed to replace configuration file");
+		res = -1;
+	}
 
-	// Release file access lock first
-	pthread_mutex_unlock(&cfgFileAccessMutex);
+	ConfigParserTransactionAbort(transaction);
 	return res;
 }
+
+/**************************************************************************************************
+ *
+ * @fn          ConfigParserTransactionAbort
+ *
+ * @brief       Releases a transaction without writing anything.
+ *
+ * input parameters
+ *
+ * @param          transaction      - transaction from ConfigParserTransactionBegin()
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+void ConfigParserTransactionAbort(configParserTransaction_t *transaction)
+{
+	int i;
+
+	if (transaction)
+	{
+		for (i = 0; i < transaction->numUpdates; i++)
+		{
+			free(transaction->updates[i].section);
+			free(transaction->updates[i].key);
+			free(transaction->updates[i].value);
+		}
+		free(transaction->updates);
+		free(transaction->configFilePath);
+		free(transaction->shadowPath);
+		free(transaction);
+	}
+}
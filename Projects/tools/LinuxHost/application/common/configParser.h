@@ -57,6 +57,8 @@ typedef struct {
 	uint8 macChannel;
 } appBaseSetting_s;
 
+// Set of updates written to a configuration file at once, see ConfigParserTransactionBegin()
+typedef struct configParserTransaction_s configParserTransaction_t;
 
 int ConfigParserInit(const char *configFilePath, const char *shadowPath);
 void ConfigParserClose( void );
@@ -67,3 +69,9 @@ int ConfigParserSetGetFromFd(FILE* cfgFd, const char* section, const char* key,
 
 int ConfigParserSet(const char *configFilePath, const char *shadowPath, const char* section, const char* key, char* newValue);
 int ConfigParser(const char* section, const char* key, char* resultString);
+int ConfigParserSetValue(const char* section, const char* key, char* newValue);
+
+configParserTransaction_t *ConfigParserTransactionBegin(const char *configFilePath, const char *shadowPath);
+int ConfigParserTransactionSet(configParserTransaction_t *transaction, const char* section, const char* key, const char* newValue);
+int ConfigParserTransactionCommit(configParserTransaction_t *transaction);
+void ConfigParserTransactionAbort(configParserTransaction_t *transaction);
@@ -0,0 +1,601 @@
+/**************************************************************************************************
+  Filename:       reactor.c
+
+  Description:    Event loop multiplexing the NPI client, timers, stdin and
+                  application descriptors on one epoll set. Callbacks run
+                  on the thread calling reactor_run().
+
+    Copyright (C) 2015 Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#include "reactor.h"
+#include "timer.h"
+#include "npi_ipc_client.h"
+#include "npi_lnx_error.h"
+
+#include "tiLogging.h"
+
+#define REACTOR_MAX_FDS				16
+#define REACTOR_MAX_EVENTS			REACTOR_MAX_FDS
+#define REACTOR_MAX_TIMER_THREADS	4
+#define REACTOR_STDIN_LINE_LEN		128
+
+typedef struct
+{
+	int					fd;			// -1 when the slot is free
+	uint8				source;		// REACTOR_SOURCE_*
+	reactorFdCback_t	pCback;		// NULL for descriptors that only wake up the loop
+	void				*pArg;
+} reactorFd_t;
+
+typedef struct
+{
+	uint8						threadId;
+	reactorTimerEventCback_t	pCback;
+	void						*pArg;
+} reactorTimerEvents_t;
+
+typedef struct
+{
+	uint32				count;
+	unsigned long long	totalUs;
+	uint32				maxUs;
+} reactorStats_t;
+
+static int reactorEpollFd = -1;
+static int reactorTerminate;
+static int reactorResult;
+
+static reactorFd_t reactorFds[REACTOR_MAX_FDS];
+
+// Timers, set up by reactor_addTimerEvents
+static int reactorTimers = FALSE;
+static int reactorTimerTimeout = -1;
+static reactorTimerEvents_t reactorTimerEvents[REACTOR_MAX_TIMER_THREADS];
+static int reactorNumTimerEvents;
+
+// NPI client in event loop mode, set up by reactor_addNpiClient
+static int reactorNpi = FALSE;
+static unsigned long long reactorNpiDeadline;
+
+// stdin line assembly, set up by reactor_addStdin
+static reactorStdinCback_t reactorStdinCback;
+static void *reactorStdinArg;
+static char reactorStdinLine[REACTOR_STDIN_LINE_LEN];
+static int reactorStdinLen;
+
+// Time from the loop waking up to a callback being called, per source
+static reactorStats_t reactorStats[REACTOR_NUM_SOURCES];
+
+/**************************************************************************************************
+ *
+ * @fn      reactorNow
+ *
+ * @brief   Current CLOCK_MONOTONIC time in microseconds
+ *
+ * @return  time in us
+ */
+static unsigned long long reactorNow(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((unsigned long long)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactorRecordLatency
+ *
+ * @brief   Account the time from the loop waking up to a callback being called.
+ *
+ * @param   source - REACTOR_SOURCE_*
+ * @param	woken - time the loop woke up
+ *
+ * @return  void
+ */
+static void reactorRecordLatency(uint8 source, unsigned long long woken)
+{
+	uint32 latency = (uint32)(reactorNow() - woken);
+
+	reactorStats[source].count++;
+	reactorStats[source].totalUs += latency;
+	if (latency > reactorStats[source].maxUs)
+	{
+		reactorStats[source].maxUs = latency;
+	}
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactorAdd
+ *
+ * @brief   Add a descriptor to the epoll set.
+ *
+ * @param   fd - descriptor
+ * @param	events - epoll events to wait for
+ * @param	source - REACTOR_SOURCE_*
+ * @param	pCback - callback, or NULL to only wake up the loop
+ * @param	pArg - argument passed to pCback
+ *
+ * @return  NPI_LNX_SUCCESS, or NPI_LNX_FAILURE if out of room or epoll fails
+ */
+static int reactorAdd(int fd, uint32 events, uint8 source, reactorFdCback_t pCback, void *pArg)
+{
+	struct epoll_event ev;
+	int i;
+
+	for (i = 0; i < REACTOR_MAX_FDS; i++)
+	{
+		if (reactorFds[i].fd == -1)
+		{
+			break;
+		}
+	}
+	if (i == REACTOR_MAX_FDS)
+	{
+		LOG_ERROR("[REACTOR] No room for fd %d\n", fd);
+		return NPI_LNX_FAILURE;
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = events;
+	ev.data.ptr = &reactorFds[i];
+	if (epoll_ctl(reactorEpollFd, EPOLL_CTL_ADD, fd, &ev) < 0)
+	{
+		LOG_ERROR("[REACTOR] Failed to add fd %d, errno %d\n", fd, errno);
+		return NPI_LNX_FAILURE;
+	}
+
+	reactorFds[i].fd = fd;
+	reactorFds[i].source = source;
+	reactorFds[i].pCback = pCback;
+	reactorFds[i].pArg = pArg;
+
+	return NPI_LNX_SUCCESS;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactorNpiCback
+ *
+ * @brief   Handle the messages ready on the NPI client descriptors.
+ *
+ * @return  void
+ */
+static void reactorNpiCback(int fd, uint32 events, void *pArg)
+{
+	int timeout;
+
+	if (NPI_ClientProcess(&timeout) != NPI_LNX_SUCCESS)
+	{
+		LOG_ERROR("[REACTOR] Lost connection to the NPI server\n");
+		reactorResult = NPI_LNX_FAILURE;
+		reactor_stop();
+	}
+	reactorNpiDeadline = (timeout < 0) ? 0 : (reactorNow() + ((unsigned long long)timeout * 1000));
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactorStdinCbackFd
+ *
+ * @brief   Read stdin and pass each complete line to the stdin callback.
+ *
+ * @return  void
+ */
+static void reactorStdinCbackFd(int fd, uint32 events, void *pArg)
+{
+	char buf[REACTOR_STDIN_LINE_LEN];
+	int len, i;
+
+	len = read(fd, buf, sizeof(buf));
+	if (len <= 0)
+	{
+		if ((len == 0) || ((errno != EINTR) && (errno != EAGAIN)))
+		{
+			// End of input, stop polling it
+			reactor_removeFd(fd);
+		}
+		return;
+	}
+
+	for (i = 0; i < len; i++)
+	{
+		if (buf[i] == '\n')
+		{
+			reactorStdinLine[reactorStdinLen] = '\0';
+			reactorStdinLen = 0;
+			reactorStdinCback(reactorStdinLine, reactorStdinArg);
+		}
+		else if (reactorStdinLen < (REACTOR_STDIN_LINE_LEN - 1))
+		{
+			reactorStdinLine[reactorStdinLen++] = buf[i];
+		}
+	}
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactorProcessTimers
+ *
+ * @brief   Expire due timers and hand the pending events to their callbacks.
+ *
+ * @param   woken - time the loop woke up
+ *
+ * @return  void
+ */
+static void reactorProcessTimers(unsigned long long woken)
+{
+	uint32 events;
+	int i;
+
+	reactorTimerTimeout = timer_process();
+
+	for (i = 0; (i < reactorNumTimerEvents) && !reactorTerminate; i++)
+	{
+		events = timer_get_event(reactorTimerEvents[i].threadId);
+		if (events != 0)
+		{
+			reactorRecordLatency(REACTOR_SOURCE_TIMER, woken);
+			reactorTimerEvents[i].pCback(events, reactorTimerEvents[i].pArg);
+		}
+	}
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactorNextTimeout
+ *
+ * @brief   Time the loop may sleep without missing a deadline.
+ *
+ * @return  timeout in ms, -1 for none
+ */
+static int reactorNextTimeout(void)
+{
+	int timeout = reactorTimers ? reactorTimerTimeout : -1;
+
+	if (reactorNpi && (reactorNpiDeadline != 0))
+	{
+		unsigned long long now = reactorNow();
+		int npiTimeout = (reactorNpiDeadline > now) ? (int)((reactorNpiDeadline - now + 999) / 1000) : 0;
+
+		if ((timeout < 0) || (npiTimeout < timeout))
+		{
+			timeout = npiTimeout;
+		}
+	}
+
+	return timeout;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactor_init
+ *
+ * @brief   Create the reactor. The NPI client and the timer module must be
+ * 			initialized in event loop mode before they are added.
+ *
+ * @return  NPI_LNX_SUCCESS, or NPI_LNX_FAILURE
+ */
+int reactor_init(void)
+{
+	int i;
+
+	for (i = 0; i < REACTOR_MAX_FDS; i++)
+	{
+		reactorFds[i].fd = -1;
+	}
+	memset(reactorStats, 0, sizeof(reactorStats));
+	reactorNumTimerEvents = 0;
+	reactorStdinLen = 0;
+
+	reactorEpollFd = epoll_create1(EPOLL_CLOEXEC);
+	if (reactorEpollFd < 0)
+	{
+		LOG_ERROR("[REACTOR] Failed to create epoll set, errno %d\n", errno);
+		return NPI_LNX_FAILURE;
+	}
+
+	return NPI_LNX_SUCCESS;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactor_close
+ *
+ * @brief   Release the reactor. Descriptors added to it are not closed.
+ *
+ * @return  void
+ */
+void reactor_close(void)
+{
+	if (reactorEpollFd >= 0)
+	{
+		close(reactorEpollFd);
+		reactorEpollFd = -1;
+	}
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactor_run
+ *
+ * @brief   Dispatch callbacks until reactor_stop() is called.
+ *
+ * @return  NPI_LNX_SUCCESS, or NPI_LNX_FAILURE if the loop had to stop on an error
+ */
+int reactor_run(void)
+{
+	struct epoll_event events[REACTOR_MAX_EVENTS];
+	unsigned long long woken;
+	int n, i;
+
+	reactorTerminate = FALSE;
+	reactorResult = NPI_LNX_SUCCESS;
+
+	// Handle whatever was queued while the application initialized
+	woken = reactorNow();
+	if (reactorNpi)
+	{
+		reactorNpiCback(-1, 0, NULL);
+	}
+	if (reactorTimers)
+	{
+		reactorProcessTimers(woken);
+	}
+
+	while (!reactorTerminate)
+	{
+		n = epoll_wait(reactorEpollFd, events, REACTOR_MAX_EVENTS, reactorNextTimeout());
+		woken = reactorNow();
+		if (n < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			LOG_ERROR("[REACTOR] epoll_wait failed, errno %d\n", errno);
+			reactorResult = NPI_LNX_FAILURE;
+			break;
+		}
+
+		for (i = 0; (i < n) && !reactorTerminate; i++)
+		{
+			reactorFd_t *pFd = (reactorFd_t *)events[i].data.ptr;
+
+			// The descriptor may have been removed by an earlier callback
+			if ((pFd->fd == -1) || (pFd->pCback == NULL))
+			{
+				continue;
+			}
+			reactorRecordLatency(pFd->source, woken);
+			pFd->pCback(pFd->fd, events[i].events, pFd->pArg);
+		}
+
+		if (reactorNpi && !reactorTerminate && (reactorNpiDeadline != 0) && (reactorNow() >= reactorNpiDeadline))
+		{
+			// Fail requests that got no response
+			reactorNpiCback(-1, 0, NULL);
+		}
+
+		if (reactorTimers && !reactorTerminate)
+		{
+			// Cheap when nothing is due, and catches events set by the callbacks above
+			reactorProcessTimers(woken);
+		}
+	}
+
+	return reactorResult;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactor_stop
+ *
+ * @brief   Make reactor_run() return after the current callback. Must be
+ * 			called from a reactor callback.
+ *
+ * @return  void
+ */
+void reactor_stop(void)
+{
+	reactorTerminate = TRUE;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactor_addFd
+ *
+ * @brief   Call pCback from the loop whenever fd has one of the given events.
+ *
+ * @param   fd - descriptor
+ * @param	events - epoll events to wait for, e.g. EPOLLIN
+ * @param	pCback - callback
+ * @param	pArg - argument passed to pCback
+ *
+ * @return  NPI_LNX_SUCCESS, or NPI_LNX_FAILURE
+ */
+int reactor_addFd(int fd, uint32 events, reactorFdCback_t pCback, void *pArg)
+{
+	return reactorAdd(fd, events, REACTOR_SOURCE_USER, pCback, pArg);
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactor_removeFd
+ *
+ * @brief   Stop polling a descriptor. May be called from a callback.
+ *
+ * @param   fd - descriptor
+ *
+ * @return  NPI_LNX_SUCCESS, or NPI_LNX_FAILURE if fd was not added
+ */
+int reactor_removeFd(int fd)
+{
+	int i;
+
+	for (i = 0; i < REACTOR_MAX_FDS; i++)
+	{
+		if (reactorFds[i].fd == fd)
+		{
+			epoll_ctl(reactorEpollFd, EPOLL_CTL_DEL, fd, NULL);
+			reactorFds[i].fd = -1;
+			return NPI_LNX_SUCCESS;
+		}
+	}
+
+	return NPI_LNX_FAILURE;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactor_addNpiClient
+ *
+ * @brief   Handle the NPI client in the loop. AREQ handlers and
+ * 			NPI_SendSynchDataAsync callbacks then run in the loop. The client
+ * 			must be initialized with NPI_ClientInitEventLoop().
+ *
+ * @return  NPI_LNX_SUCCESS, or NPI_LNX_FAILURE
+ */
+int reactor_addNpiClient(void)
+{
+	int socketFd, wakeFd;
+
+	NPI_ClientGetPollFds(&socketFd, &wakeFd);
+	if ((reactorAdd(socketFd, EPOLLIN | EPOLLPRI, REACTOR_SOURCE_NPI, reactorNpiCback, NULL) != NPI_LNX_SUCCESS) ||
+			(reactorAdd(wakeFd, EPOLLIN, REACTOR_SOURCE_NPI, reactorNpiCback, NULL) != NPI_LNX_SUCCESS))
+	{
+		return NPI_LNX_FAILURE;
+	}
+	reactorNpi = TRUE;
+	reactorNpiDeadline = 0;
+
+	return NPI_LNX_SUCCESS;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactor_addTimerEvents
+ *
+ * @brief   Call pCback from the loop with the events set for threadId, see
+ * 			timer_set_event(). The callback clears the events it handled.
+ * 			The timer module must be initialized with timer_initEventLoop().
+ *
+ * @param   threadId - timer module thread Id
+ * @param	pCback - callback
+ * @param	pArg - argument passed to pCback
+ *
+ * @return  NPI_LNX_SUCCESS, or NPI_LNX_FAILURE
+ */
+int reactor_addTimerEvents(uint8 threadId, reactorTimerEventCback_t pCback, void *pArg)
+{
+	int eventFd, timerFd;
+
+	if (reactorNumTimerEvents == REACTOR_MAX_TIMER_THREADS)
+	{
+		LOG_ERROR("[REACTOR] No room for timer events of thread %d\n", threadId);
+		return NPI_LNX_FAILURE;
+	}
+
+	if (!reactorTimers)
+	{
+		// Timers are handled after each wake-up, the descriptors only wake the loop
+		timer_getPollFds(&eventFd, &timerFd);
+		if ((reactorAdd(eventFd, EPOLLIN, REACTOR_SOURCE_TIMER, NULL, NULL) != NPI_LNX_SUCCESS) ||
+				((timerFd >= 0) && (reactorAdd(timerFd, EPOLLIN, REACTOR_SOURCE_TIMER, NULL, NULL) != NPI_LNX_SUCCESS)))
+		{
+			return NPI_LNX_FAILURE;
+		}
+		reactorTimers = TRUE;
+	}
+
+	reactorTimerEvents[reactorNumTimerEvents].threadId = threadId;
+	reactorTimerEvents[reactorNumTimerEvents].pCback = pCback;
+	reactorTimerEvents[reactorNumTimerEvents].pArg = pArg;
+	reactorNumTimerEvents++;
+
+	return NPI_LNX_SUCCESS;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactor_addStdin
+ *
+ * @brief   Call pCback from the loop with each line typed on stdin.
+ *
+ * @param   pCback - callback
+ * @param	pArg - argument passed to pCback
+ *
+ * @return  NPI_LNX_SUCCESS, or NPI_LNX_FAILURE
+ */
+int reactor_addStdin(reactorStdinCback_t pCback, void *pArg)
+{
+	reactorStdinCback = pCback;
+	reactorStdinArg = pArg;
+
+	return reactorAdd(fileno(stdin), EPOLLIN, REACTOR_SOURCE_STDIN, reactorStdinCbackFd, NULL);
+}
+
+/**************************************************************************************************
+ *
+ * @fn      reactor_getStats
+ *
+ * @brief   Callback statistics of a source. The latency is the time from the
+ * 			loop waking up to the callback being called, it does not include the
+ * 			time the message waited in the socket before the wake-up.
+ *
+ * @param   source - REACTOR_SOURCE_*
+ *
+ * output parameters
+ *
+ * @param   pCount - number of callbacks
+ * @param   pAvgLatencyUs - average latency in us
+ * @param   pMaxLatencyUs - maximum latency in us
+ *
+ * @return  void
+ */
+void reactor_getStats(uint8 source, uint32 *pCount, uint32 *pAvgLatencyUs, uint32 *pMaxLatencyUs)
+{
+	*pCount = reactorStats[source].count;
+	*pAvgLatencyUs = reactorStats[source].count ? (uint32)(reactorStats[source].totalUs / reactorStats[source].count) : 0;
+	*pMaxLatencyUs = reactorStats[source].maxUs;
+}
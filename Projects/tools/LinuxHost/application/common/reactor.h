@@ -0,0 +1,74 @@
+/**************************************************************************************************
+  Filename:       reactor.h
+
+  Description:    Event loop multiplexing the NPI client, timers, stdin and
+                  application descriptors on one epoll set.
+
+
+  Copyright (C) 2015 Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+**************************************************************************************************/
+
+
+#ifndef REACTOR_H_
+#define REACTOR_H_
+
+#include "common_app.h"
+
+// Sources of reactor callbacks, for statistics
+#define REACTOR_SOURCE_NPI			0
+#define REACTOR_SOURCE_TIMER		1
+#define REACTOR_SOURCE_STDIN		2
+#define REACTOR_SOURCE_USER			3
+#define REACTOR_NUM_SOURCES			4
+
+// Called with the epoll events (EPOLLIN, ...) of a descriptor added by reactor_addFd()
+typedef void (*reactorFdCback_t)(int fd, uint32 events, void *pArg);
+// Called with the events set for a thread by the timer module, see timer_get_event()
+typedef void (*reactorTimerEventCback_t)(uint32 events, void *pArg);
+// Called for each line read from stdin, without the trailing newline
+typedef void (*reactorStdinCback_t)(char *pLine, void *pArg);
+
+extern int    reactor_init			(void);
+extern void   reactor_close			(void);
+extern int    reactor_run			(void);
+extern void   reactor_stop			(void);
+
+extern int    reactor_addFd			(int fd, uint32 events, reactorFdCback_t pCback, void *pArg);
+extern int    reactor_removeFd		(int fd);
+extern int    reactor_addNpiClient	(void);
+extern int    reactor_addTimerEvents	(uint8 threadId, reactorTimerEventCback_t pCback, void *pArg);
+extern int    reactor_addStdin		(reactorStdinCback_t pCback, void *pArg);
+
+extern void   reactor_getStats		(uint8 source, uint32 *pCount, uint32 *pAvgLatencyUs, uint32 *pMaxLatencyUs);
+
+#endif /* REACTOR_H_ */
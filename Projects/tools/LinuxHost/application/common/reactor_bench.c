@@ -0,0 +1,359 @@
+/**************************************************************************************************
+  Filename:       reactor_bench.c
+
+  Description:    AREQ delivery latency benchmark. Compares the time from an AREQ
+                  being sent to its handler running, for the thread based client
+                  and for the event loop of reactor.c.
+
+    Copyright (C) 2015 Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+**************************************************************************************************/
+
+#include <stdio.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "hal_rpc.h"
+#include "npi_lnx_error.h"
+#include "npi_lnx_ipc_rpc.h"
+#include "npi_ipc_client.h"
+#include "reactor.h"
+#include "tiLogging.h"
+
+// Time the sender leaves the client to connect and register before the first AREQ
+#define REACTOR_BENCH_START_DELAY_US	1000000
+
+sem_t eventSem;
+
+#ifdef NPI_RTI
+// The client library routes RCAF AREQs here when no handler is registered,
+// which the benchmark always does, so the RTI library need not be linked
+int RTI_AsynchMsgCback(npiMsgData_t *pMsg)
+{
+	return 0;
+}
+#endif //NPI_RTI
+
+static int reactorBenchCount = 5000;
+static int reactorBenchReceived;
+static unsigned long long *reactorBenchLatency;
+static unsigned long long reactorBenchPending;
+static sem_t reactorBenchSem;
+
+static unsigned long long reactorBenchNow(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((unsigned long long)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+}
+
+static int reactorBenchCompare(const void *a, const void *b)
+{
+	unsigned long long la = *(const unsigned long long *)a, lb = *(const unsigned long long *)b;
+
+	return (la > lb) - (la < lb);
+}
+
+static void reactorBenchUsage(const char *name)
+{
+	printf("Usage: %s [-r] [-n count] [-i interval ms]\n", name);
+	printf("  Starts a minimal NPI server on the loopback interface which sends count\n");
+	printf("  RCAF AREQs, interval ms apart, each carrying its CLOCK_MONOTONIC send time.\n");
+	printf("  The client reports the time from send to handler. By default the handler\n");
+	printf("  hands each AREQ over to the main thread with sem_post(), as applications\n");
+	printf("  without an event loop do. With -r the handler is called from reactor_run().\n");
+	printf("  Pin the benchmark to a CPU for stable figures, e.g. taskset -c 1.\n");
+}
+
+/**************************************************************************************************
+ * Sender, forked off so it does not share the client's threads
+ **************************************************************************************************/
+
+static int reactorBenchReadAll(int fd, uint8 *pBuf, int len)
+{
+	int n, done = 0;
+
+	while (done < len)
+	{
+		n = recv(fd, pBuf + done, len - done, 0);
+		if (n <= 0)
+		{
+			return -1;
+		}
+		done += n;
+	}
+	return 0;
+}
+
+static void *reactorBenchServeSreqs(void *pArg)
+{
+	int fd = *(int *)pArg;
+	npiMsgData_t msg;
+
+	// Answer the version request, which grants no features, and echo anything else
+	while (reactorBenchReadAll(fd, (uint8 *)&msg, RPC_FRAME_HDR_SZ) == 0)
+	{
+		if ((msg.len > 0) && (reactorBenchReadAll(fd, msg.pData, msg.len) != 0))
+		{
+			break;
+		}
+		msg.subSys = RPC_CMD_SRSP | (msg.subSys & RPC_SUBSYSTEM_MASK);
+		if (((msg.subSys & RPC_SUBSYSTEM_MASK) == RPC_SYS_SRV_CTRL) && (msg.cmdId == NPI_LNX_CMD_ID_VERSION_REQ))
+		{
+			msg.len = 4;
+			msg.pData[0] = NPI_LNX_SUCCESS;
+			msg.pData[1] = 1;
+			msg.pData[2] = 4;
+			msg.pData[3] = 3;
+		}
+		else if (msg.len == 0)
+		{
+			msg.len = 1;
+			msg.pData[0] = 0;
+		}
+		if (send(fd, &msg, RPC_FRAME_HDR_SZ + msg.len, MSG_NOSIGNAL) < 0)
+		{
+			break;
+		}
+	}
+	return NULL;
+}
+
+static void reactorBenchSender(int listenFd, int intervalMs)
+{
+	int fd, one = 1, i;
+	pthread_t sreqThread;
+	npiMsgData_t msg;
+	unsigned long long stamp;
+
+	fd = accept(listenFd, NULL, NULL);
+	if (fd < 0)
+	{
+		_exit(1);
+	}
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	pthread_create(&sreqThread, NULL, reactorBenchServeSreqs, &fd);
+
+	usleep(REACTOR_BENCH_START_DELAY_US);
+	msg.len = sizeof(stamp);
+	msg.subSys = RPC_CMD_AREQ | RPC_SYS_RCAF;
+	msg.cmdId = 0x01;
+	for (i = 0; i < reactorBenchCount; i++)
+	{
+		stamp = reactorBenchNow();
+		memcpy(msg.pData, &stamp, sizeof(stamp));
+		if (send(fd, &msg, RPC_FRAME_HDR_SZ + msg.len, MSG_NOSIGNAL) < 0)
+		{
+			break;
+		}
+		usleep(intervalMs * 1000);
+	}
+
+	// Everything sent stays readable for the client after the connection closes
+	_exit(0);
+}
+
+/**************************************************************************************************
+ * Client
+ **************************************************************************************************/
+
+static void reactorBenchRecord(unsigned long long stamp)
+{
+	if (reactorBenchReceived < reactorBenchCount)
+	{
+		reactorBenchLatency[reactorBenchReceived++] = reactorBenchNow() - stamp;
+	}
+}
+
+static int reactorBenchHandoffCback(npiMsgData_t *pMsg)
+{
+	memcpy(&reactorBenchPending, pMsg->pData, sizeof(reactorBenchPending));
+	sem_post(&reactorBenchSem);
+	return 0;
+}
+
+static int reactorBenchReactorCback(npiMsgData_t *pMsg)
+{
+	unsigned long long stamp;
+
+	memcpy(&stamp, pMsg->pData, sizeof(stamp));
+	reactorBenchRecord(stamp);
+	if (reactorBenchReceived >= reactorBenchCount)
+	{
+		reactor_stop();
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int useReactor = FALSE, intervalMs = 2, opt, i, listenFd, one = 1, ret;
+	struct sockaddr_in addr;
+	socklen_t addrLen = sizeof(addr);
+	char devPath[32];
+	unsigned long long sum = 0;
+	pid_t sender;
+
+	while ((opt = getopt(argc, argv, "rn:i:h")) != -1)
+	{
+		switch (opt)
+		{
+		case 'r':
+			useReactor = TRUE;
+			break;
+		case 'n':
+			reactorBenchCount = atoi(optarg);
+			break;
+		case 'i':
+			intervalMs = atoi(optarg);
+			break;
+		default:
+			reactorBenchUsage(argv[0]);
+			return (opt == 'h') ? 0 : -1;
+		}
+	}
+	if ((reactorBenchCount <= 0) || (intervalMs < 0))
+	{
+		reactorBenchUsage(argv[0]);
+		return -1;
+	}
+
+	reactorBenchLatency = (unsigned long long *) malloc(sizeof(unsigned long long) * reactorBenchCount);
+	if (reactorBenchLatency == NULL)
+	{
+		return -1;
+	}
+
+	// Listen on an ephemeral loopback port before forking, so the client can connect at once
+	listenFd = socket(AF_INET, SOCK_STREAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if ((listenFd < 0) ||
+			(bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0) ||
+			(listen(listenFd, 1) != 0) ||
+			(getsockname(listenFd, (struct sockaddr *)&addr, &addrLen) != 0))
+	{
+		perror("listen");
+		return -1;
+	}
+	snprintf(devPath, sizeof(devPath), "127.0.0.1:%d", ntohs(addr.sin_port));
+
+	sender = fork();
+	if (sender < 0)
+	{
+		perror("fork");
+		return -1;
+	}
+	else if (sender == 0)
+	{
+		reactorBenchSender(listenFd, intervalMs);
+	}
+	close(listenFd);
+
+	tiLogging_Init(NULL);
+	printf("AREQ latency benchmark: %d x %dms apart (%s)\n", reactorBenchCount, intervalMs,
+			useReactor ? "reactor" : "thread handoff");
+
+	if (useReactor)
+	{
+		reactor_init();
+		ret = NPI_ClientInitEventLoop(devPath);
+		if (ret == NPI_LNX_SUCCESS)
+		{
+			NPI_RegisterAsynchMsgCback(RPC_SYS_RCAF, NPI_AREQ_CMD_ANY, reactorBenchReactorCback, NPI_AREQ_LANE_INLINE);
+			reactor_addNpiClient();
+			reactor_run();
+		}
+	}
+	else
+	{
+		sem_init(&reactorBenchSem, 0, 0);
+		ret = NPI_ClientInit(devPath);
+		if (ret == NPI_LNX_SUCCESS)
+		{
+			NPI_RegisterAsynchMsgCback(RPC_SYS_RCAF, NPI_AREQ_CMD_ANY, reactorBenchHandoffCback, NPI_AREQ_LANE_INLINE);
+			while (reactorBenchReceived < reactorBenchCount)
+			{
+				while ((sem_wait(&reactorBenchSem) != 0) && (errno == EINTR));
+				reactorBenchRecord(reactorBenchPending);
+			}
+		}
+	}
+	if (ret != NPI_LNX_SUCCESS)
+	{
+		printf("Could not connect to the sender\n");
+		kill(sender, SIGTERM);
+		waitpid(sender, NULL, 0);
+		return -1;
+	}
+
+	NPI_ClientClose();
+	waitpid(sender, NULL, 0);
+	if (reactorBenchReceived == 0)
+	{
+		printf("No AREQ received\n");
+		return -1;
+	}
+
+	for (i = 0; i < reactorBenchReceived; i++)
+	{
+		sum += reactorBenchLatency[i];
+	}
+	qsort(reactorBenchLatency, reactorBenchReceived, sizeof(unsigned long long), reactorBenchCompare);
+	printf("Send to handler (us): min %llu, avg %llu, p50 %llu, p90 %llu, p99 %llu, max %llu\n",
+			reactorBenchLatency[0], sum / reactorBenchReceived,
+			reactorBenchLatency[reactorBenchReceived / 2],
+			reactorBenchLatency[(reactorBenchReceived * 90) / 100],
+			reactorBenchLatency[(reactorBenchReceived * 99) / 100],
+			reactorBenchLatency[reactorBenchReceived - 1]);
+
+	free(reactorBenchLatency);
+
+	return 0;
+}
@@ -45,6 +45,8 @@
 #include <time.h>
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <stddef.h>
 #include <unistd.h>
 
@@ -79,8 +81,25 @@ uint8 sblState;
 struct timeval curTime, startTime, prevTimeSend, prevTimeRec;
 struct timeval curTime, prevTime;
 
+// Image source. The image is never materialized as a whole; sbExec() pulls it one flash page
+// at a time. Source is either the mmap'ed file given to SBL_Init(), or the image linked in
+// through bin2c.sh, which may be PackBits compressed.
+typedef struct
+{
+	const uint8 *pData;		// Raw or PackBits encoded image
+	int dataLen;
+	uint8 packed;
+	uint8 mapped;			// pData is an mmap of an image file
+	int imageLen;			// Uncompressed image length
+	// Stream state
+	int inPos;
+	int outPos;
+	int runLen;				// Bytes left in current PackBits record
+	uint8 runIsRepeat;
+} sblImage_t;
+
 // Static variables
-uint8 *sblImageBuf = NULL;
+static sblImage_t sblImage = { NULL, 0, FALSE, FALSE, 0, 0, 0, 0, FALSE };
 static int sblImageLen = 0;
 static uint8 isUSBdevice = FALSE;
 
@@ -93,7 +112,11 @@ static char tmpStrForTimePrint[1024];
 //THREAD and MUTEX
 
 static void SoftwareVersionToString(char *retStr, int maxStrLen, swVerExtended_t* swVerExtended);
-static int  sbExec(uint8 *pBuf, int length);
+static int  sbExec(sblImage_t *pImage);
+static void sblImageRelease(sblImage_t *pImage);
+static void sblImageRewind(sblImage_t *pImage);
+static int  sblImageRead(sblImage_t *pImage, uint8 *pBuf, int length);
+static int  sblImageGetVersion(sblImage_t *pImage, swVerExtended_t *pVersion);
 
 #define SB_DST_ADDR_DIV                    4
 
@@ -122,32 +145,38 @@ int SBL_Init(const char *imagePath)
 	int retVal = NPI_LNX_SUCCESS;
 	LOG_INFO("[SBL] Provided path:%s (%d)\n", imagePath, (int)strlen(imagePath));
 
+	// Release existing image if already initialized
+	sblImageRelease(&sblImage);
+	sblImageLen = 0;
+
 	if (strlen(imagePath) > 0)
 	{
 		struct stat fileStat;
-		if (stat(imagePath, &fileStat) == 0)
+		int imageFd = open(imagePath, O_RDONLY);
+		if ((imageFd >= 0) && (fstat(imageFd, &fileStat) == 0))
 		{
 			// Get size of file
 			sblImageLen = fileStat.st_size;
 			if (sblImageLen > 0)
 			{
-				// Free existing memory if already allocated
-				if (sblImageBuf != NULL)
-				{
-					free(sblImageBuf);
-					sblImageBuf = NULL;
-				}
-				LOG_INFO("[SBL] Allocating %d bytes for image %s\n", sblImageLen, imagePath);
+				LOG_INFO("[SBL] Mapping %d bytes for image %s\n", sblImageLen, imagePath);
 
-				// Then allocate memory for the new file
-				sblImageBuf = (uint8 *)malloc(fileStat.st_size);
-				if (sblImageBuf == NULL)
+				// Map the file rather than reading it; pages are faulted in as sbExec() reaches them
+				void *pMap = mmap(NULL, sblImageLen, PROT_READ, MAP_PRIVATE, imageFd, 0);
+				if (pMap == MAP_FAILED)
 				{
-					LOG_ERROR("[SBL] Allocation of memory for file failed\n");
+					LOG_ERROR("[SBL] Mapping of file failed: %s\n", strerror(errno));
 
-					// File is empty skip processing it
 					retVal = NPI_LNX_FAILURE;
 				}
+				else
+				{
+					madvise(pMap, sblImageLen, MADV_SEQUENTIAL);
+					sblImage.pData = (const uint8 *)pMap;
+					sblImage.dataLen = sblImageLen;
+					sblImage.packed = FALSE;
+					sblImage.mapped = TRUE;
+				}
 			}
 			else
 			{
@@ -163,15 +192,26 @@ int SBL_Init(const char *imagePath)
 
 			retVal = NPI_LNX_FAILURE;
 		}
-		FILE *imageFd = fopen(imagePath, "rb");
-		fread(sblImageBuf, 1, sblImageLen, imageFd);
-		fclose(imageFd);
+		if (imageFd >= 0)
+		{
+			// The mapping stays valid after the descriptor is closed
+			close(imageFd);
+		}
 	}
 	else if (rf4ceFirmware_Length > 1) //empty file is 1 byte, so ensure >1
 	{
 		sblImageLen = (int)rf4ceFirmware_Length;
-		sblImageBuf = (uint8 *)rf4ceFirmware;
-		LOG_INFO("[SBL] RNP firmware image linked in from source %s: size %d, location %p\n", rf4ceFirmware_Source, sblImageLen, sblImageBuf);
+		sblImage.pData = (const uint8 *)rf4ceFirmware;
+#ifdef rf4ceFirmware_PACKED
+		sblImage.dataLen = (int)rf4ceFirmware_PackedLength;
+		sblImage.packed = TRUE;
+		LOG_INFO("[SBL] RNP firmware image linked in from source %s: size %d, packed %d, location %p\n", rf4ceFirmware_Source, sblImageLen, sblImage.dataLen, sblImage.pData);
+#else
+		sblImage.dataLen = sblImageLen;
+		sblImage.packed = FALSE;
+		LOG_INFO("[SBL] RNP firmware image linked in from source %s: size %d, location %p\n", rf4ceFirmware_Source, sblImageLen, sblImage.pData);
+#endif //rf4ceFirmware_PACKED
+		sblImage.mapped = FALSE;
 	}
 	else
 	{
@@ -182,21 +222,20 @@ int SBL_Init(const char *imagePath)
 	if (retVal == NPI_LNX_SUCCESS)
 	{
 		swVerExtended_t newRNPversion;
+		sblImage.imageLen = sblImageLen;
 		// Find version number in image we want to update to
-		if (sblImageLen < (96 * 1024))
+		retVal = sblImageGetVersion(&sblImage, &newRNPversion);
+		if (retVal == NPI_LNX_SUCCESS)
 		{
-			isUSBdevice = FALSE;
-			// CC253xF64 or CC253xF96
-			memcpy((uint8 *)&newRNPversion, &sblImageBuf[SBL_RNP_VERSION_OFFSET], SBL_RNP_EXTENDED_VERSION_LEN);
+			SoftwareVersionToString(tmpStrForTimePrint, sizeof(tmpStrForTimePrint), &newRNPversion);
+			LOG_INFO("New image %s\n", tmpStrForTimePrint);
 		}
-		else
-		{
-			isUSBdevice = TRUE;
-			// CC253xF128 or CC253xF256
-			memcpy((uint8 *)&newRNPversion, &sblImageBuf[SBL_RNP_CC2531_VERSION_OFFSET], SBL_RNP_EXTENDED_VERSION_LEN);
-		}
-		SoftwareVersionToString(tmpStrForTimePrint, sizeof(tmpStrForTimePrint), &newRNPversion);
-		LOG_INFO("New image %s\n", tmpStrForTimePrint);
+	}
+
+	if (retVal != NPI_LNX_SUCCESS)
+	{
+		sblImageRelease(&sblImage);
+		sblImageLen = 0;
 	}
 
 	return retVal;
@@ -207,30 +246,20 @@ int SBL_CheckForUpdate(swVerExtended_t *RNPversion)
 	int retVal = NPI_LNX_FAILURE;
 	swVerExtended_t newRNPversion;
 
-	if ((NULL == sblImageBuf) || (sblImageLen <= 0))
+	if ((NULL == sblImage.pData) || (sblImageLen <= 0))
 	{
 		LOG_WARN("[SBL] Skipping update check because no new firmware image has been specified.\n");
 	}
+	else if (sblImageGetVersion(&sblImage, &newRNPversion) != NPI_LNX_SUCCESS)
+	{
+		LOG_ERROR("[SBL] Skipping update check because version of new firmware image cannot be read.\n");
+	}
 	else
 	{
 		uint8 versionHigher = FALSE;
 		uint8 versionLower = FALSE;
 
-		// Find version number in image we want to update to
-		if (sblImageLen < (96 * 1024))
-		{
-			isUSBdevice = FALSE;
-			// CC253xF64 or CC253xF96
-			memcpy((uint8 *)&newRNPversion, &sblImageBuf[SBL_RNP_VERSION_OFFSET], SBL_RNP_EXTENDED_VERSION_LEN);
-		}
-		else
-		{
-			isUSBdevice = TRUE;
-			// CC253xF128 or CC253xF256
-			memcpy((uint8 *)&newRNPversion, &sblImageBuf[SBL_RNP_CC2531_VERSION_OFFSET], SBL_RNP_EXTENDED_VERSION_LEN);
-		}
-
-		LOG_INFO("[SBL] Checking for update (%p, %d)\n", sblImageBuf, sblImageLen);
+		LOG_INFO("[SBL] Checking for update (%p, %d)\n", sblImage.pData, sblImageLen);
 
 		uint8 hardwareOkay = TRUE;
 #ifndef SKIP_SBL_HARDWARE_VERSION_CHECK
@@ -349,7 +378,7 @@ int SBL_Execute()
 
 	LOG_INFO("[SBL] Executing Serial Bootloader\n");
 
-	if (!sblImageBuf || (sblImageLen <= 0))
+	if (!sblImage.pData || (sblImageLen <= 0))
 	{
 		LOG_ERROR("[SBL] No binary file found\n");
 		retVal = NPI_LNX_FAILURE;
@@ -357,8 +386,14 @@ int SBL_Execute()
 	else
 	{
 		int sbResult = 0;
+		uint8 qosStatus;
+		uint8 qosClass = NPI_GetQosClass();
+
+		// Let interactive clients go ahead of the image download
+		NPI_SetQosClassReq(NPI_LNX_QOS_CLASS_BULK, &qosStatus);
+
 		sblState = SBL_STATE_SERIAL_BOOT;
-		sbResult = sbExec(sblImageBuf, sblImageLen);
+		sbResult = sbExec(&sblImage);
 
 		if (sbResult != 0)
 		{
@@ -385,9 +420,11 @@ int SBL_Execute()
 			else
 			{
 				// Try again
-				retVal = sbExec(sblImageBuf, sblImageLen);
+				retVal = sbExec(&sblImage);
 			}
 		}
+
+		NPI_SetQosClassReq(qosClass, &qosStatus);
 	}
 	return retVal;
 }
@@ -416,10 +453,11 @@ int SBL_IsDeviceInSBLMode()
  * @fn          sbExec
  *
  * @brief       This function executes the serial boot loading of a binary image.
+ *              The image is streamed one flash page at a time from its source.
  *
  * input parameters
  *
- * None.
+ * @param       pImage - image to load.
  *
  * output parameters
  *
@@ -428,14 +466,18 @@ int SBL_IsDeviceInSBLMode()
  * @return      None.
  **************************************************************************************************
  */
-static int sbExec(uint8 *pBuf, int length)
+static int sbExec(sblImage_t *pImage)
 {
 	uint8 returnVal = 0;
+	int length = pImage->imageLen;
 	// Create a "blank page" that we can compare with later to find if source is an empty page
 	uint8 blankPage[SBL_FLASH_PAGE_SIZE];
 	memset(blankPage, 0xFF, sizeof(blankPage));
 
-	uint8* srcAddr = pBuf;
+	// Only the page being written is held in memory. Retries never go back past its border.
+	uint8 pageBuf[SBL_FLASH_PAGE_SIZE];
+	int srcOffset = SBL_FLASH_PAGE_SIZE;
+	sblImageRewind(pImage);
 
 	// The destination address is shifted down by two, so address & length do not exceed uint16.
 	uint16 dstAddr = 0, readAddr = 0; // The embedded boot loader on RNP adds any necessary offset.
@@ -503,7 +545,13 @@ static int sbExec(uint8 *pBuf, int length)
 			LOG_INFO("[SBL] Block %u of %u (%u%%)\n", blkTotal - blkCnt, blkTotal, ((blkTotal-blkCnt) * 100) / blkTotal);
 			fflush(LOG_DESTINATION_FP);
 		}
-		memcpy(bufw, srcAddr, SB_RW_BUF_LEN);
+		if (srcOffset >= SBL_FLASH_PAGE_SIZE)
+		{
+			// Fetch next page, the tail of the last page is padded as erased flash
+			sblImageRead(pImage, pageBuf, SBL_FLASH_PAGE_SIZE);
+			srcOffset = 0;
+		}
+		memcpy(bufw, &pageBuf[srcOffset], SB_RW_BUF_LEN);
 
 		//This Overwrite is done to force the CRC value to 0xFF.
 		// However, the CRC is now calculated without this memory range.
@@ -577,24 +625,24 @@ static int sbExec(uint8 *pBuf, int length)
 						 * what the rest of the page is. If the rest of the page is blank, i.e. all 0xFF,
 						 * then we don't have to send the rest of the page as it is already erased to all 0xFF.
 						 */
-						if (memcmp(srcAddr, blankPage , SBL_FLASH_PAGE_SIZE) == 0)
+						if (memcmp(&pageBuf[srcOffset], blankPage , SBL_FLASH_PAGE_SIZE) == 0)
 						{
 							// This is an empty page. Skip it
 							dstAddr += (SBL_FLASH_PAGE_SIZE / SB_DST_ADDR_DIV);
-							srcAddr += SBL_FLASH_PAGE_SIZE;
+							srcOffset += SBL_FLASH_PAGE_SIZE;
 							blkCnt -= (SBL_FLASH_PAGE_SIZE / SB_RW_BUF_LEN);
 						}
 						else
 						{
 							dstAddr += (SB_RW_BUF_LEN / SB_DST_ADDR_DIV);
-							srcAddr += SB_RW_BUF_LEN;
+							srcOffset += SB_RW_BUF_LEN;
 							blkCnt--;
 						}
 					}
 					else
 					{
 						dstAddr += (SB_RW_BUF_LEN / SB_DST_ADDR_DIV);
-						srcAddr += SB_RW_BUF_LEN;
+						srcOffset += SB_RW_BUF_LEN;
 						blkCnt--;
 					}
 					consecutiveFailedReadAttempts = 0;
@@ -636,7 +684,7 @@ static int sbExec(uint8 *pBuf, int length)
 			uint16 pageOffset = dstAddr % (SBL_FLASH_PAGE_SIZE / SB_DST_ADDR_DIV), previousBlock = blkTotal - blkCnt;
 			dstAddr -= pageOffset;
 			blkCnt += (pageOffset * SB_DST_ADDR_DIV) / SB_RW_BUF_LEN;
-			srcAddr -= pageOffset * SB_DST_ADDR_DIV;
+			srcOffset -= pageOffset * SB_DST_ADDR_DIV;
 			LOG_WARN("[SBL] Moving back to page border after error, from block %d to %d\n", previousBlock, blkTotal - blkCnt);
 		}
 	}
@@ -668,6 +716,216 @@ static int sbExec(uint8 *pBuf, int length)
 	return returnVal;
 }
 
+/**************************************************************************************************
+ * @fn          sblImageRelease
+ *
+ * @brief       Release the image source, unmapping the image file if one was mapped.
+ *
+ * input parameters
+ *
+ * @param       pImage - image to release.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+static void sblImageRelease(sblImage_t *pImage)
+{
+	if (pImage->mapped && (pImage->pData != NULL))
+	{
+		munmap((void *)pImage->pData, pImage->dataLen);
+	}
+	memset(pImage, 0, sizeof(sblImage_t));
+}
+
+/**************************************************************************************************
+ * @fn          sblImageRewind
+ *
+ * @brief       Restart streaming of the image from its first byte.
+ *
+ * input parameters
+ *
+ * @param       pImage - image to rewind.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+static void sblImageRewind(sblImage_t *pImage)
+{
+	pImage->inPos = 0;
+	pImage->outPos = 0;
+	pImage->runLen = 0;
+	pImage->runIsRepeat = FALSE;
+}
+
+/**************************************************************************************************
+ * @fn          sblImageRead
+ *
+ * @brief       Read the next bytes of the uncompressed image. PackBits records are decoded
+ *              on the fly: a header byte n in 0..127 is followed by n+1 literal bytes, a header
+ *              in 129..255 is followed by one byte repeated 257-n times, and 128 is ignored.
+ *
+ * input parameters
+ *
+ * @param       pImage - image to read from.
+ * @param       length - number of bytes to read.
+ *
+ * output parameters
+ *
+ * @param       pBuf - image data, padded with 0xFF (erased flash) past the end of the image.
+ *
+ * @return      Number of image bytes read, excluding padding.
+ **************************************************************************************************
+ */
+static int sblImageRead(sblImage_t *pImage, uint8 *pBuf, int length)
+{
+	int count = 0;
+
+	if (!pImage->packed)
+	{
+		count = pImage->imageLen - pImage->outPos;
+		if (count > length)
+		{
+			count = length;
+		}
+		if (count > 0)
+		{
+			memcpy(pBuf, &pImage->pData[pImage->outPos], count);
+			pImage->outPos += count;
+		}
+		else
+		{
+			count = 0;
+		}
+	}
+	else
+	{
+		while ((count < length) && (pImage->outPos < pImage->imageLen))
+		{
+			if (pImage->runLen == 0)
+			{
+				uint8 header;
+				if (pImage->inPos >= pImage->dataLen)
+				{
+					LOG_ERROR("[SBL] Packed image truncated at %d of %d bytes\n", pImage->outPos, pImage->imageLen);
+					break;
+				}
+				header = pImage->pData[pImage->inPos++];
+				if (header < 128)
+				{
+					pImage->runLen = header + 1;
+					pImage->runIsRepeat = FALSE;
+				}
+				else if (header > 128)
+				{
+					pImage->runLen = 257 - header;
+					pImage->runIsRepeat = TRUE;
+				}
+				continue;
+			}
+
+			int chunk = pImage->runLen;
+			if (chunk > (length - count))
+			{
+				chunk = length - count;
+			}
+			if (chunk > (pImage->imageLen - pImage->outPos))
+			{
+				chunk = pImage->imageLen - pImage->outPos;
+			}
+
+			if (pImage->runIsRepeat)
+			{
+				if (pImage->inPos >= pImage->dataLen)
+				{
+					LOG_ERROR("[SBL] Packed image truncated at %d of %d bytes\n", pImage->outPos, pImage->imageLen);
+					break;
+				}
+				memset(&pBuf[count], pImage->pData[pImage->inPos], chunk);
+				pImage->runLen -= chunk;
+				if (pImage->runLen == 0)
+				{
+					// Consume the repeated byte
+					pImage->inPos++;
+				}
+			}
+			else
+			{
+				if (chunk > (pImage->dataLen - pImage->inPos))
+				{
+					LOG_ERROR("[SBL] Packed image truncated at %d of %d bytes\n", pImage->outPos, pImage->imageLen);
+					break;
+				}
+				memcpy(&pBuf[count], &pImage->pData[pImage->inPos], chunk);
+				pImage->inPos += chunk;
+				pImage->runLen -= chunk;
+			}
+			count += chunk;
+			pImage->outPos += chunk;
+		}
+	}
+
+	if (count < length)
+	{
+		memset(&pBuf[count], 0xFF, length - count);
+	}
+
+	return count;
+}
+
+/**************************************************************************************************
+ * @fn          sblImageGetVersion
+ *
+ * @brief       Extract the extended version embedded in the image. Also determines, from the
+ *              image size, whether the image targets a USB device.
+ *
+ * input parameters
+ *
+ * @param       pImage - image to inspect.
+ *
+ * output parameters
+ *
+ * @param       pVersion - extended version of the image.
+ *
+ * @return      NPI_LNX_SUCCESS, or NPI_LNX_FAILURE if the image is too short.
+ **************************************************************************************************
+ */
+static int sblImageGetVersion(sblImage_t *pImage, swVerExtended_t *pVersion)
+{
+	uint8 header[SBL_RNP_CC2531_VERSION_OFFSET + SBL_RNP_EXTENDED_VERSION_LEN];
+	int versionOffset;
+
+	if (pImage->imageLen < (96 * 1024))
+	{
+		isUSBdevice = FALSE;
+		// CC253xF64 or CC253xF96
+		versionOffset = SBL_RNP_VERSION_OFFSET;
+	}
+	else
+	{
+		isUSBdevice = TRUE;
+		// CC253xF128 or CC253xF256
+		versionOffset = SBL_RNP_CC2531_VERSION_OFFSET;
+	}
+
+	sblImageRewind(pImage);
+	if (sblImageRead(pImage, header, versionOffset + SBL_RNP_EXTENDED_VERSION_LEN) < (versionOffset + SBL_RNP_EXTENDED_VERSION_LEN))
+	{
+		LOG_ERROR("[SBL] Image too short to hold version information\n");
+		return NPI_LNX_FAILURE;
+	}
+	memcpy((uint8 *)pVersion, &header[versionOffset], SBL_RNP_EXTENDED_VERSION_LEN);
+
+	return NPI_LNX_SUCCESS;
+}
+
 static void SoftwareVersionToString(char *retStr, int maxStrLen, swVerExtended_t* swVerExtended)
 {
 	static char   tmpStr[1024];
@@ -45,6 +45,10 @@
 #include <time.h>
 #include <unistd.h>
 #include <math.h>
+#include <sys/eventfd.h>
+#ifdef NPI_TIMERFD
+#include <sys/timerfd.h>
+#endif
 
 #include "timer.h"
 #include "hal_defs.h"
@@ -52,7 +56,12 @@
 
 #include "tiLogging.h"
 
-#define TIMER_MAX			(0xFFFF * 1000 + 1)
+#define TIMER_HEAP_INIT_SIZE		32
+#if !defined NPI_TICKLESS && !defined NPI_TIMERFD
+// Wake up this much before the deadline and sleep the remainder with nanosleep()
+#define TIMER_WAIT_MARGIN			2000
+#define TIMER_WAIT_MARGIN_MAX		20000
+#endif
 
 #ifdef TIMER_DEBUG
 #define LOG_DEBUG_TIMER(__FMT, __REST...)	LOG_DEBUG(__FMT, ##__REST)
@@ -60,6 +69,30 @@
 #define LOG_DEBUG_TIMER(__FMT, __REST...)
 #endif
 
+// A timer is either a compatibility timer owned by a (thread, event bit) pair,
+// or a handle allocated with timer_alloc(). Armed timers live in a binary
+// min-heap ordered on their latest allowed expiry, so start and stop are
+// O(log n) and the timer thread only ever looks at the heap root.
+// A timer with slack may expire anywhere in [deadline, deadline + slack],
+// which lets the thread expire several timers on one wake-up.
+struct timer_entry_s
+{
+	unsigned long long	deadline;	// Absolute CLOCK_MONOTONIC expiry time in us
+	unsigned long long	expiry;		// deadline + slack, the heap key
+	uint32				slack;		// Allowed lateness in us
+	int					heapIndex;	// Position in timerHeap, -1 when not armed
+	uint8				threadId;
+	uint32				event;		// Event to set on expiry, if pCback is NULL
+	timer_callback_t	pCback;
+	void				*pArg;
+};
+
+typedef struct
+{
+	uint32			eventFlag;
+	timer_handle_t	eventTimer[32];	// 1 compatibility timer per event
+} timer_thread_s;
+
 static void timerInitSyncRes(void);
 static void *timerThreadFunc(void *ptr);
 
@@ -71,6 +104,8 @@ static pthread_mutex_t  timerEventMutex;
 
 // conditional variable to notify that a TIMER is set
 static pthread_cond_t timerSetCond;
+// conditional variable to notify that a timer callback has returned
+static pthread_cond_t timerCbackDoneCond;
 
 static pthread_t        timerThreadId;
 static int timerThreadTerminate;
@@ -78,16 +113,89 @@ static int timerThreadTerminate;
 static timer_thread_s *timerThreadTbl;
 static uint16 timerNumOfThreads;
 
-int timer_init(uint16 numOfThreads)
+// Min-heap of armed timers, protected by timerMutex
+static timer_handle_t **timerHeap;
+static int timerHeapSize;
+static int timerHeapMax;
+
+// Timer whose callback is currently running, and the thread running it,
+// protected by timerMutex
+static timer_handle_t *timerCbackEntry;
+static pthread_t timerCbackThread;
+
+// Set by timer_initEventLoop, timers then expire in timer_process() and
+// events are announced on timerEventFd instead of eventSem.
+static int timerEventLoop = FALSE;
+static int timerEventFd = -1;
+
+#ifdef NPI_TIMERFD
+// CLOCK_MONOTONIC timerfd programmed with the absolute expiry of the heap root
+static int timerFd = -1;
+#endif
+
+// Number of timer thread wake-ups that did not expire any timer
+static uint32 timerIdleWakeups;
+
+/**************************************************************************************************
+ *
+ * @fn      timerInitTables
+ *
+ * @brief   Allocate the timer tables and synchronization resources.
+ *
+ * @param   numOfThreads - number of application threads using event timers
+ *
+ * @return  0 on success, -1 otherwise
+ */
+static int timerInitTables(uint16 numOfThreads)
 {
+	int i, j;
+
 	timerThreadTbl = (timer_thread_s *) malloc(sizeof(timer_thread_s) * numOfThreads);
+	timerHeap = (timer_handle_t **) malloc(sizeof(timer_handle_t *) * TIMER_HEAP_INIT_SIZE);
+	if ((timerThreadTbl == NULL) || (timerHeap == NULL))
+	{
+		LOG_ERROR("[TIMER]Failed to allocate timer tables\n");
+		return -1;
+	}
 	memset(timerThreadTbl, 0, sizeof(timer_thread_s) * numOfThreads);
+	for (i = 0; i < numOfThreads; i++)
+	{
+		for (j = 0; j < 32; j++)
+		{
+			timerThreadTbl[i].eventTimer[j].heapIndex = -1;
+			timerThreadTbl[i].eventTimer[j].threadId = i;
+			timerThreadTbl[i].eventTimer[j].event = BV(j);
+		}
+	}
 
 	timerNumOfThreads = numOfThreads;
+	timerHeapSize = 0;
+	timerHeapMax = TIMER_HEAP_INIT_SIZE;
+	timerCbackEntry = NULL;
 
 	timerThreadTerminate = 0;
 	timerInitSyncRes();
 
+#ifdef NPI_TIMERFD
+	// The event loop polls the timerfd, it must never block in read()
+	timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | (timerEventLoop ? TFD_NONBLOCK : 0));
+	if (timerFd < 0)
+	{
+		LOG_ERROR("[TIMER]Failed to create timerfd, errno %d\n", errno);
+		return -1;
+	}
+#endif
+
+	return 0;
+}
+
+int timer_init(uint16 numOfThreads)
+{
+	if (timerInitTables(numOfThreads) != 0)
+	{
+		return -1;
+	}
+
 	if(pthread_create(&timerThreadId, NULL, timerThreadFunc, NULL))
 	{
 		// thread creation failed
@@ -98,273 +206,450 @@ int timer_init(uint16 numOfThreads)
 	return 0;
 }
 
-static void *timerThreadFunc(void *ptr)
+/**************************************************************************************************
+ *
+ * @fn      timer_initEventLoop
+ *
+ * @brief   Initialize the timer module without a timer thread, for
+ * 			applications running their own event loop. The application polls
+ * 			the descriptors returned by timer_getPollFds() and calls
+ * 			timer_process() when one is readable, or when the timeout
+ * 			returned by the previous timer_process() call expires. Timer
+ * 			callbacks then run in the thread calling timer_process(), and
+ * 			events are announced on the event descriptor instead of eventSem.
+ *
+ * @param   numOfThreads - number of application threads using event timers
+ *
+ * @return  0 on success, -1 otherwise
+ */
+int timer_initEventLoop(uint16 numOfThreads)
 {
-	/* lock mutex in order not to lose signal */
-	pthread_mutex_lock(&timerThreadMutex);
-	int i, j, tryLockFirstTimeOnly = 0, waitRes = TRUE;
-	long int diffPrev, decrementValue = 0, minimumTimeout = 0, waitMargin = 2000, active = FALSE;
-	int t = 0, res;
+	timerEventLoop = TRUE;
 
-	struct timespec curMonotonicTime, prevMonotonicTime;
-	struct timespec waitToRealtime, remWaitRealtime;
+	timerEventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (timerEventFd < 0)
+	{
+		LOG_ERROR("[TIMER]Failed to create event eventfd, errno %d\n", errno);
+		return -1;
+	}
 
-	clock_gettime(CLOCK_MONOTONIC, &prevMonotonicTime);
+	return timerInitTables(numOfThreads);
+}
 
-	LOG_DEBUG_TIMER("[TIMER]  Timer Thread Started \n");
-	LOG_DEBUG_TIMER("[TIMER] \t%d threads supported \n", timerNumOfThreads);
+/**************************************************************************************************
+ *
+ * @fn      timer_getPollFds
+ *
+ * @brief   Descriptors to poll for reading in event loop mode. pTimerFd is
+ * 			set to -1 when timeouts are only reported by timer_process().
+ *
+ * @param   pEventFd - readable when an event was set or the next expiry moved
+ * @param	pTimerFd - readable when a timer is due
+ *
+ * @return  void
+ */
+void timer_getPollFds(int *pEventFd, int *pTimerFd)
+{
+	*pEventFd = timerEventFd;
+#ifdef NPI_TIMERFD
+	*pTimerFd = timerFd;
+#else
+	*pTimerFd = -1;
+#endif
+}
 
-	while(!timerThreadTerminate)
+/**************************************************************************************************
+ *
+ * @fn      timerNow
+ *
+ * @brief   Current CLOCK_MONOTONIC time in microseconds
+ *
+ * @return  time in us
+ */
+static unsigned long long timerNow(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((unsigned long long)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+}
+
+/**************************************************************************************************
+ *
+ * @fn      timerHeapSet
+ *
+ * @brief   Place a timer at a heap position. timerMutex must be held.
+ *
+ * @return  void
+ */
+static void timerHeapSet(int index, timer_handle_t *pEntry)
+{
+	timerHeap[index] = pEntry;
+	pEntry->heapIndex = index;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      timerHeapUp / timerHeapDown
+ *
+ * @brief   Restore the heap order for the timer at a heap position after its
+ * 			deadline moved earlier (up) or later (down). timerMutex must be held.
+ *
+ * @return  void
+ */
+static void timerHeapUp(int index)
+{
+	timer_handle_t *pEntry = timerHeap[index];
+
+	while (index > 0)
 	{
-		if (tryLockFirstTimeOnly == 0)
+		int parent = (index - 1) / 2;
+		if (timerHeap[parent]->expiry <= pEntry->expiry)
 		{
-			// Lock mutex
-			LOG_DEBUG_TIMER("[TIMER][MUTEX] Lock TIMER Mutex (Handle)\n");
-			int mutexRet = 0, writeOnce = 0;
-			while ( (mutexRet = pthread_mutex_trylock(&timerMutex)) == EBUSY)
-			{
-				if (writeOnce == 0)
-				{
-					LOG_DEBUG_TIMER("[TIMER][MUTEX] TIMER Mutex (Handle) busy\n");
-					fflush(LOG_DESTINATION_FP);
-					writeOnce++;
-				}
-				else
-				{
-					writeOnce++;
-					if ( (writeOnce % 1000) == 0)
-					{
-#ifdef TIMER_DEBUG
-						fprintf(LOG_DESTINATION_FP, "."); // We just want periods, not normal logging with line prefixes.
-						fflush(LOG_DESTINATION_FP);
-#endif
-					}
-					if (writeOnce > 0xEFFFFFF0)
-						writeOnce = 1;
-					fflush(LOG_DESTINATION_FP);
-				}
-			}
-			LOG_DEBUG_TIMER("[TIMER][MUTEX] TIMER Lock (Handle) status: %d\n", (int)mutexRet);
-			tryLockFirstTimeOnly = 1;
+			break;
+		}
+		timerHeapSet(index, timerHeap[parent]);
+		index = parent;
+	}
+	timerHeapSet(index, pEntry);
+}
 
-			LOG_DEBUG_TIMER("[TIMER] Timer Table\n");
-			int i, j;
-			for (i = 0; i < timerNumOfThreads; i++)
-			{
-				LOG_DEBUG_TIMER("[TIMER] Thread %d\n", i);
-				LOG_DEBUG_TIMER("[TIMER]\t Events:\t0x%.8X\n", timerThreadTbl[i].eventFlag);
-				LOG_DEBUG_TIMER("[TIMER]\t Enabled:\t0x%.8X\n", timerThreadTbl[i].timerEnabled);
-				LOG_DEBUG_TIMER("[TIMER]\t Timeouts:\n");
-				for (j = 0; j < 32; j++)
-				{
-					LOG_DEBUG_TIMER("[TIMER]\t\t %d:\t%ld\n", j, timerThreadTbl[i].timeoutValue[j]);
-				}
-			}
+static void timerHeapDown(int index)
+{
+	timer_handle_t *pEntry = timerHeap[index];
+
+	for (;;)
+	{
+		int child = (2 * index) + 1;
+		if (child >= timerHeapSize)
+		{
+			break;
 		}
+		if (((child + 1) < timerHeapSize) &&
+				(timerHeap[child + 1]->expiry < timerHeap[child]->expiry))
+		{
+			child++;
+		}
+		if (pEntry->expiry <= timerHeap[child]->expiry)
+		{
+			break;
+		}
+		timerHeapSet(index, timerHeap[child]);
+		index = child;
+	}
+	timerHeapSet(index, pEntry);
+}
+
+/**************************************************************************************************
+ *
+ * @fn      timerDisarm
+ *
+ * @brief   Remove a timer from the heap, if armed. timerMutex must be held.
+ *
+ * @return  void
+ */
+static void timerDisarm(timer_handle_t *pEntry)
+{
+	int index = pEntry->heapIndex;
 
-		// Get current time to compensate for processing.
-		clock_gettime(CLOCK_MONOTONIC, &curMonotonicTime);
+	if (index < 0)
+	{
+		return;
+	}
+	pEntry->heapIndex = -1;
 
-		if (curMonotonicTime.tv_nsec >= prevMonotonicTime.tv_nsec)
+	timerHeapSize--;
+	if (index != timerHeapSize)
+	{
+		// Move the last timer into the hole and restore the heap order
+		timerHeapSet(index, timerHeap[timerHeapSize]);
+		if ((index > 0) && (timerHeap[(index - 1) / 2]->expiry > timerHeap[index]->expiry))
 		{
-			diffPrev = (curMonotonicTime.tv_nsec - prevMonotonicTime.tv_nsec)/1000; // Want microseconds
-			t = 0;
+			timerHeapUp(index);
 		}
 		else
 		{
-			diffPrev = ((curMonotonicTime.tv_nsec + 1000000000) - prevMonotonicTime.tv_nsec) / 1000; // Want microseconds
-			t = 1;
+			timerHeapDown(index);
 		}
+	}
+}
 
-		decrementValue = diffPrev  + 1000000 * (curMonotonicTime.tv_sec - prevMonotonicTime.tv_sec - t); 
+#ifdef NPI_TIMERFD
+/**************************************************************************************************
+ *
+ * @fn      timerFdProgram
+ *
+ * @brief   Program the timerfd with the expiry of the heap root, or disarm it
+ * 			if no timer is running. timerMutex must be held.
+ *
+ * @return  void
+ */
+static void timerFdProgram(void)
+{
+	struct itimerspec its;
 
-		// minimumTimeout is the value we expected to wait. If the timer indicates active
-		// it means that decrementValue should equal minimumTimeout. The difference is the
-		// extra time it took to get back running. We can compensate for this by waking up
-		// earlier and then use less CPU friendly wait mechanism for the remaining wait time.
-		// The adjustment time is also updated if we're still waking up too late.
-		if (active == TRUE)
+	memset(&its, 0, sizeof(its));
+	if (timerHeapSize > 0)
+	{
+		its.it_value.tv_sec = timerHeap[0]->expiry / 1000000;
+		its.it_value.tv_nsec = (timerHeap[0]->expiry % 1000000) * 1000;
+		if ((its.it_value.tv_sec == 0) && (its.it_value.tv_nsec == 0))
 		{
-			LOG_DEBUG_TIMER("[TIMER] Timer Table\n");
-			int i, j;
-			for (i = 0; i < timerNumOfThreads; i++)
-			{
-				LOG_DEBUG_TIMER("[TIMER] Thread %d\n", i);
-				LOG_DEBUG_TIMER("[TIMER]\t Events:\t0x%.8X\n", timerThreadTbl[i].eventFlag);
-				LOG_DEBUG_TIMER("[TIMER]\t Enabled:\t0x%.8X\n", timerThreadTbl[i].timerEnabled);
-				LOG_DEBUG_TIMER("[TIMER]\t Timeouts:\n");
-				for (j = 0; j < 32; j++)
-				{
-					LOG_DEBUG_TIMER("[TIMER]\t\t %d:\t%ld\n", j, timerThreadTbl[i].timeoutValue[j]);
-				}
-			}
-			long int timeWaitedDifference = (decrementValue - minimumTimeout);
-			LOG_DEBUG_TIMER("[TIMER] Decrementing value %dus, diff %dus\n", (int)decrementValue, (int)timeWaitedDifference);
-			if ( timeWaitedDifference > 250)
-			{
-				// Waited too long, must increase waitMargin, add the difference
-				waitMargin += (decrementValue - minimumTimeout);
-				LOG_DEBUG_TIMER("[TIMER] Adjusting waitMargin %dus, because decrementValue = %dus and minimumTimeout = %dus\n",
-						(int)waitMargin, (int)decrementValue, (int)minimumTimeout);
-			}
-			else if ( (timeWaitedDifference < -200) && (timeWaitedDifference > (-waitMargin)) )
-			{
-				// Wait the remainder with more accurate means if it's less than the margin.
-				// Use nanosleep to wait the remainder
-				waitToRealtime.tv_sec = 0;
-				waitToRealtime.tv_nsec = 1000;
-
-				while (timeWaitedDifference < 0)
-				{
-					waitRes = nanosleep(&waitToRealtime, &remWaitRealtime);
-					while (waitRes != 0)
-					{
-						if (errno == EINTR)
-						{
-							// Restart timer with the remainder
-							waitRes = nanosleep(&remWaitRealtime, &remWaitRealtime);
-						}
-						else
-						{
-							LOG_ERROR("[TIMER] Nanosleep failed:");
-							break;
-						}
-					}
-					// Update decrement value
-
-					// Get current time to compensate for processing.
-					clock_gettime(CLOCK_MONOTONIC, &curMonotonicTime);
-
-					if (curMonotonicTime.tv_nsec >= prevMonotonicTime.tv_nsec)
-					{
-						diffPrev = (curMonotonicTime.tv_nsec - prevMonotonicTime.tv_nsec) / 1000; // Want microseconds
-						t = 0;
-					}
-					else
-					{
-						diffPrev = ((curMonotonicTime.tv_nsec + 1000000000) - prevMonotonicTime.tv_nsec) / 1000; // Want microseconds
-						t = 1;
-					}
-
-					decrementValue = diffPrev + 1000000 * (curMonotonicTime.tv_sec - prevMonotonicTime.tv_sec - t);
-					timeWaitedDifference = (decrementValue - minimumTimeout);
-					LOG_DEBUG_TIMER("[TIMER] Updated decrementing value %dus (diffPrev: %ldus)(left: %ldus)(t: %d)\n",
-							(int)decrementValue, diffPrev, timeWaitedDifference, t);
-				}
-			}
+			// A zero it_value would disarm the timer
+			its.it_value.tv_nsec = 1;
 		}
+	}
+
+	if (timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &its, NULL) < 0)
+	{
+		LOG_ERROR("[TIMER] timerfd_settime failed, errno %d\n", errno);
+	}
+}
+#endif //NPI_TIMERFD
+
+/**************************************************************************************************
+ *
+ * @fn      timerArm
+ *
+ * @brief   (Re)arm a timer to expire timeout milliseconds from now.
+ * 			timerMutex must be held.
+ *
+ * @param   pEntry - timer
+ * @param	timeout - number of milliseconds to count down
+ *
+ * @return  TRUE if armed, FALSE if the heap could not grow
+ */
+static uint8 timerArm(timer_handle_t *pEntry, uint32 timeout)
+{
+	unsigned long long prevRoot = (timerHeapSize > 0) ? timerHeap[0]->expiry : 0;
 
-		active = FALSE;
-		minimumTimeout = TIMER_MAX;
+	pEntry->deadline = timerNow() + ((unsigned long long)timeout * 1000);
+	pEntry->expiry = pEntry->deadline + pEntry->slack;
 
-		// Do all the timer calculation for all threads
-		for( i = 0 ; i < timerNumOfThreads; i++)
+	if (pEntry->heapIndex < 0)
+	{
+		if (timerHeapSize == timerHeapMax)
 		{
-			// Decrement all enabled counters, and check if they have timed out
-			for (j = 0; j < 32; j++)
+			timer_handle_t **pNewHeap = (timer_handle_t **) realloc(timerHeap,
+					sizeof(timer_handle_t *) * timerHeapMax * 2);
+			if (pNewHeap == NULL)
 			{
-				// Check if event j for timer (for thread) i is enabled
-				if (timerThreadTbl[i].timerEnabled & BV(j))
-				{
-					LOG_DEBUG_TIMER("[TIMER] Decrementing %ldus for ThreadID 0x%.2X, event 0x%.8X. Time left before decrementing: %d\n",
-								decrementValue,
-								i,
-								BV(j),
-								(int)timerThreadTbl[i].timeoutValue[j]);
-
-					if (timerThreadTbl[i].justKicked & BV(j))
-					{
-						timerThreadTbl[i].justKicked &= ~(BV(j));
-					}
-					else
-					{
-						// Decrement active timer
-						timerThreadTbl[i].timeoutValue[j] -= decrementValue;
-					}
-					// !!! Possible race condition !!!
-					if (timerThreadTbl[i].timeoutValue[j] <= 0)
-					{
-						LOG_DEBUG_TIMER("[TIMER] Timer Expired. \t Thread ID: %.2d \t Event Mask: 0x%.8X\n",
-								i, BV(j));
-						// timerEnabled can only be set to 0 here
-						timerThreadTbl[i].timerEnabled &= ~(BV(j));
-						timer_set_event(i, BV(j));
-					}
-					else if ( timerThreadTbl[i].timeoutValue[j] < minimumTimeout )
-					{
-						minimumTimeout = timerThreadTbl[i].timeoutValue[j];
-						active = TRUE;
-					}
-				}
+				LOG_ERROR("[TIMER] Failed to grow timer heap beyond %d timers\n", timerHeapMax);
+				return FALSE;
 			}
+			timerHeap = pNewHeap;
+			timerHeapMax *= 2;
+		}
+		timerHeapSet(timerHeapSize++, pEntry);
+		timerHeapUp(pEntry->heapIndex);
+	}
+	else
+	{
+		timerHeapUp(pEntry->heapIndex);
+		timerHeapDown(pEntry->heapIndex);
+	}
+
+	// Only wake up the timer thread if the next expiry moved earlier
+	if ((pEntry->heapIndex == 0) && ((timerHeapSize == 1) || (pEntry->expiry < prevRoot)))
+	{
+#ifdef NPI_TIMERFD
+		timerFdProgram();
+#else
+		if (timerEventLoop)
+		{
+			// Let the event loop compute its new timeout
+			eventfd_write(timerEventFd, 1);
+		}
+		else
+		{
+			pthread_cond_signal(&timerSetCond);
 		}
+#endif
+	}
+
+	LOG_DEBUG_TIMER("[TIMER] Timer armed for %dms, for event 0x%.8X and thread %d (%d timers active)\n",
+			timeout, pEntry->event, pEntry->threadId, timerHeapSize);
+
+	return TRUE;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      timerExpire
+ *
+ * @brief   Expire all timers that are due. Callbacks run without timerMutex,
+ * 			which must be held when calling.
+ *
+ * @param   pNow - current time, updated after running callbacks
+ *
+ * @return  TRUE if at least one timer expired
+ */
+static int timerExpire(unsigned long long *pNow)
+{
+	int expired = FALSE;
+
+	while ((timerHeapSize > 0) && (timerHeap[0]->deadline <= *pNow))
+	{
+		timer_handle_t *pEntry = timerHeap[0];
+
+		timerDisarm(pEntry);
+		expired = TRUE;
 
-		clock_gettime(CLOCK_MONOTONIC, &prevMonotonicTime);
-		clock_gettime(CLOCK_REALTIME, &waitToRealtime);
+		LOG_DEBUG_TIMER("[TIMER] Timer Expired. \t Thread ID: %.2d \t Event Mask: 0x%.8X\n",
+				pEntry->threadId, pEntry->event);
 
-		// We need to adjust for the inaccuracy of pthread_cond_timedwait
-		LOG_DEBUG_TIMER("[TIMER] wait margin %dus, minimumTimeout %dus\n", (int)waitMargin, (int)minimumTimeout);
-		if ( (minimumTimeout > (waitMargin + 1)) || (minimumTimeout == 0) )
+		if (pEntry->pCback != NULL)
 		{
-			if (active == TRUE)
-			{
-				minimumTimeout -= waitMargin;
-			}
+			timer_callback_t pCback = pEntry->pCback;
+			void *pArg = pEntry->pArg;
+
+			// Run the callback without the lock so it may restart timers
+			timerCbackEntry = pEntry;
+			timerCbackThread = pthread_self();
+			pthread_mutex_unlock(&timerMutex);
+			pCback(pArg);
+			pthread_mutex_lock(&timerMutex);
+			timerCbackEntry = NULL;
+			pthread_cond_broadcast(&timerCbackDoneCond);
+
+			*pNow = timerNow();
+		}
+		else
+		{
+			timer_set_event(pEntry->threadId, pEntry->event);
+		}
+	}
 
-			if (minimumTimeout > 1000000)
-			{
-				// Adjust seconds
-				waitToRealtime.tv_sec += (minimumTimeout / 1000000);
-			}
-			// Adjust nanoseconds to comply with the timespec struct
-			waitToRealtime.tv_nsec += ((minimumTimeout % 1000000) * 1000);
-			if (waitToRealtime.tv_nsec >= 1000000000 )
-			{
-				// Fix overflow
-				waitToRealtime.tv_nsec -= 1000000000;
-				waitToRealtime.tv_sec += 1;
-			}
+	return expired;
+}
 
-			// Conditional wait for a call to TimerSet()
-			if ((minimumTimeout <= 0) || (active == FALSE))
-			{
-				LOG_DEBUG_TIMER("[TIMER][MUTEX] TIMER Wait forever... effectively releasing lock\n");
-				res = pthread_cond_wait(&timerSetCond, &timerMutex);
+static void *timerThreadFunc(void *ptr)
+{
+	/* lock mutex in order not to lose signal */
+	pthread_mutex_lock(&timerThreadMutex);
 
-				// Since we have waited an unknown period we set previous time here.
-				clock_gettime(CLOCK_MONOTONIC, &prevMonotonicTime);
-			}
-			else
+	int res = 0, expired;
+	unsigned long long now;
+#ifdef NPI_TIMERFD
+	unsigned long long expirations;
+	ssize_t readRes;
+#else
+	long long waitUs;
+	struct timespec waitTo;
+#endif
+#if !defined NPI_TICKLESS && !defined NPI_TIMERFD
+	struct timespec remWait;
+	long long waitMargin = TIMER_WAIT_MARGIN;
+	unsigned long long waitTarget = 0;
+#endif
+
+	LOG_DEBUG_TIMER("[TIMER]  Timer Thread Started \n");
+	LOG_DEBUG_TIMER("[TIMER] \t%d threads supported \n", timerNumOfThreads);
+
+	pthread_mutex_lock(&timerMutex);
+
+	while(!timerThreadTerminate)
+	{
+		now = timerNow();
+
+#if !defined NPI_TICKLESS && !defined NPI_TIMERFD
+		// The condition variable may wake us up late. Increase the margin we
+		// sleep with nanosleep() if that happens.
+		if ((res == ETIMEDOUT) && (now > (waitTarget + 250)))
+		{
+			waitMargin += (now - waitTarget);
+			if (waitMargin > TIMER_WAIT_MARGIN_MAX)
 			{
-				LOG_DEBUG_TIMER("[TIMER][MUTEX] Wait %dus (%ds:%dns) for TIMER Set Cond (Handle) signal... effectively releasing lock\n",
-						(int)minimumTimeout, (int)(minimumTimeout / 1000000), (int)((minimumTimeout % 1000000) * 1000));
-				res = pthread_cond_timedwait(&timerSetCond, &timerMutex, &waitToRealtime);
-				if ( (res != ETIMEDOUT) && (res != 0) )
-				{
-					LOG_DEBUG_TIMER("[TIMER][MUTEX] TIMER conditional wait returned with %d\n", res);
-					if (res == EINVAL)
-					{
-						LOG_DEBUG_TIMER("[TIMER][MUTEX] Wait until %lds:%ldns\n",
-							waitToRealtime.tv_sec, waitToRealtime.tv_nsec);
-						// Terminate thread
-						timerThreadTerminate = 1;
-					}
-				}
+				waitMargin = TIMER_WAIT_MARGIN_MAX;
 			}
+			LOG_DEBUG_TIMER("[TIMER] Adjusting waitMargin %lldus\n", waitMargin);
+		}
+#endif //NPI_TICKLESS
+
+		expired = timerExpire(&now);
+
+		if ((res == ETIMEDOUT) && (expired == FALSE))
+		{
+			// Woke up too early, or for a timer that was stopped meanwhile
+			timerIdleWakeups++;
+		}
+		res = 0;
+
+#ifdef NPI_TIMERFD
+		// Sleep until the absolute expiry of the heap root. Timers armed
+		// meanwhile reprogram the timerfd directly, see timerArm().
+		timerFdProgram();
+		pthread_mutex_unlock(&timerMutex);
+		readRes = read(timerFd, &expirations, sizeof(expirations));
+		pthread_mutex_lock(&timerMutex);
+		if (readRes == sizeof(expirations))
+		{
+			res = ETIMEDOUT;
+		}
+		else if ((readRes < 0) && (errno != EINTR) && (errno != EAGAIN))
+		{
+			LOG_ERROR("[TIMER] timerfd read failed, errno %d\n", errno);
+			// Terminate thread
+			timerThreadTerminate = 1;
+		}
+#else
+		if (timerHeapSize == 0)
+		{
+			LOG_DEBUG_TIMER("[TIMER][MUTEX] TIMER Wait forever... effectively releasing lock\n");
+			res = pthread_cond_wait(&timerSetCond, &timerMutex);
+			continue;
+		}
 
-			// Add the value back so calculations are based on correct numbers.
-			if (active == TRUE)
+		waitUs = (long long)(timerHeap[0]->expiry - now);
+#ifndef NPI_TICKLESS
+		if (waitUs <= waitMargin)
+		{
+			// Wait the remainder with more accurate means
+			waitTo.tv_sec = waitUs / 1000000;
+			waitTo.tv_nsec = (waitUs % 1000000) * 1000;
+			pthread_mutex_unlock(&timerMutex);
+			while ((nanosleep(&waitTo, &remWait) != 0) && (errno == EINTR))
 			{
-				minimumTimeout += waitMargin;
+				// Restart timer with the remainder
+				waitTo = remWait;
 			}
-			LOG_DEBUG_TIMER("[TIMER][MUTEX] TIMER (Handle) has lock\n");
+			pthread_mutex_lock(&timerMutex);
+			continue;
 		}
-		else
+		waitUs -= waitMargin;
+		waitTarget = now + waitUs;
+		clock_gettime(CLOCK_REALTIME, &waitTo);
+#else
+		// timerSetCond uses the monotonic clock in tickless mode, sleep exactly until the deadline
+		clock_gettime(CLOCK_MONOTONIC, &waitTo);
+#endif //NPI_TICKLESS
+
+		waitTo.tv_sec += (waitUs / 1000000);
+		waitTo.tv_nsec += ((waitUs % 1000000) * 1000);
+		if (waitTo.tv_nsec >= 1000000000)
+		{
+			// Fix overflow
+			waitTo.tv_nsec -= 1000000000;
+			waitTo.tv_sec += 1;
+		}
+
+		LOG_DEBUG_TIMER("[TIMER][MUTEX] Wait %lldus for TIMER Set Cond (Handle) signal... effectively releasing lock\n", waitUs);
+		res = pthread_cond_timedwait(&timerSetCond, &timerMutex, &waitTo);
+		if ( (res != ETIMEDOUT) && (res != 0) )
 		{
-			// Wait time is lower than the margin, so move on in loop, skip sleep
+			LOG_DEBUG_TIMER("[TIMER][MUTEX] TIMER conditional wait returned with %d\n", res);
+			if (res == EINVAL)
+			{
+				LOG_DEBUG_TIMER("[TIMER][MUTEX] Wait until %lds:%ldns\n",
+					waitTo.tv_sec, waitTo.tv_nsec);
+				// Terminate thread
+				timerThreadTerminate = 1;
+			}
 		}
+#endif //NPI_TIMERFD
 	}
 
+	pthread_mutex_unlock(&timerMutex);
 	pthread_mutex_unlock(&timerThreadMutex);
 
 	return 0;
@@ -384,11 +669,18 @@ static void *timerThreadFunc(void *ptr)
 uint8 timer_isActive(uint8 threadId, uint32 event)
 {
 	uint8 isActive = FALSE;
+	uint8 i;
 
-	if (timerThreadTbl[threadId].timerEnabled & event)
+	pthread_mutex_lock(&timerMutex);
+	for (i = 0; i < 32; i++)
 	{
-		isActive = TRUE;
+		if ((event & BV(i)) && (timerThreadTbl[threadId].eventTimer[i].heapIndex >= 0))
+		{
+			isActive = TRUE;
+			break;
+		}
 	}
+	pthread_mutex_unlock(&timerMutex);
 
 	return isActive;
 }
@@ -409,7 +701,9 @@ uint8 timer_isActive(uint8 threadId, uint32 event)
  */
 uint8 timer_start_timerEx(uint8 threadId, uint32 event, uint32 timeout)
 {
-	uint8 i;
+	uint8 i, ret = 1;
+	timer_handle_t *pEntry;
+
 	if (event == 0)
 	{
 		// No event requested, just return
@@ -420,40 +714,258 @@ uint8 timer_start_timerEx(uint8 threadId, uint32 event, uint32 timeout)
 		if (event & BV(i))
 			break;
 	}
+	pEntry = &timerThreadTbl[threadId].eventTimer[i];
 
 	LOG_DEBUG_TIMER("[TIMER] timer_start_timerEx(%d, 0x%.8X, %d)... \n", threadId, event, timeout);
-	fflush(LOG_DESTINATION_FP);
-	// To avoid race conditions we cannot update timerThreadTbl without mutex lock
+	// To avoid race conditions we cannot update the timer heap without mutex lock
 	pthread_mutex_lock(&timerMutex);
-	LOG_DEBUG_TIMER("lock (line: %d)\n", __LINE__);
 
-	// Value is stored in us for better precision
-	timerThreadTbl[threadId].timeoutValue[i] = timeout * 1000;
 	// Use a 0 value of timeout to disable timer
 	if (timeout)
 	{
-		// Enable event
-		timerThreadTbl[threadId].timerEnabled |= event;
-		// We also need to make sure the timer update does not decrement now.
-		timerThreadTbl[threadId].justKicked |= event;
+		pEntry->event = event;
+		if (timerArm(pEntry, timeout) == FALSE)
+		{
+			ret = 0;
+		}
 	}
 	else
 	{
-		timerThreadTbl[threadId].timerEnabled &= ~event;
+		timerDisarm(pEntry);
 		// Clear event in case it just fired.
 		timer_clear_event(threadId, event);
 	}
 
-	LOG_DEBUG_TIMER("[TIMER] Timer started for %dus, for event 0x%.8X and thread %d\n",
-			(int)timerThreadTbl[threadId].timeoutValue[i], event, threadId);
+	pthread_mutex_unlock(&timerMutex);
+
+	return ret;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      timer_alloc
+ *
+ * @brief   Allocate a timer that is not tied to an event bit. Any number of
+ * 			these may exist per thread. On expiry pCback(pArg) is called from
+ * 			the timer thread, or if pCback is NULL, event is set for threadId.
+ *
+ * @param   threadId - Id of the thread to set the event for
+ * @param	event - event bitmask, used when pCback is NULL
+ * @param	pCback - expiry callback, or NULL
+ * @param	pArg - argument passed to pCback
+ *
+ * @return  timer handle, NULL if out of memory
+ */
+timer_handle_t *timer_alloc(uint8 threadId, uint32 event, timer_callback_t pCback, void *pArg)
+{
+	timer_handle_t *pEntry = (timer_handle_t *) malloc(sizeof(timer_handle_t));
+
+	if (pEntry == NULL)
+	{
+		LOG_ERROR("[TIMER] Failed to allocate timer\n");
+		return NULL;
+	}
+	pEntry->deadline = 0;
+	pEntry->expiry = 0;
+	pEntry->slack = 0;
+	pEntry->heapIndex = -1;
+	pEntry->threadId = threadId;
+	pEntry->event = event;
+	pEntry->pCback = pCback;
+	pEntry->pArg = pArg;
+
+	return pEntry;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      timer_free
+ *
+ * @brief   Stop and free a timer allocated with timer_alloc(). If its callback
+ * 			is running in the timer thread this waits for it to return, unless
+ * 			called from the callback itself.
+ *
+ * @param   pTimer - timer handle
+ *
+ * @return  void
+ */
+void timer_free(timer_handle_t *pTimer)
+{
+	if (pTimer == NULL)
+	{
+		return;
+	}
 
-	// Unlock mutex before notifying timer thread
+	pthread_mutex_lock(&timerMutex);
+	timerDisarm(pTimer);
+	while ((timerCbackEntry == pTimer) && !pthread_equal(pthread_self(), timerCbackThread))
+	{
+		pthread_cond_wait(&timerCbackDoneCond, &timerMutex);
+	}
 	pthread_mutex_unlock(&timerMutex);
 
-	// Notify timer thread that timer has been set
-	pthread_cond_signal(&timerSetCond);
+	free(pTimer);
+}
+
+/**************************************************************************************************
+ *
+ * @fn      timer_start
+ *
+ * @brief   (Re)start a timer allocated with timer_alloc().
+ *
+ * @param   pTimer - timer handle
+ * @param	timeout - number of milliseconds to count down, 0 stops the timer
+ *
+ * @return  TRUE on success
+ */
+uint8 timer_start(timer_handle_t *pTimer, uint32 timeout)
+{
+	uint8 ret = TRUE;
 
-	return 1;
+	if (timeout == 0)
+	{
+		return timer_stop(pTimer);
+	}
+
+	pthread_mutex_lock(&timerMutex);
+	ret = timerArm(pTimer, timeout);
+	pthread_mutex_unlock(&timerMutex);
+
+	return ret;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      timer_setSlack
+ *
+ * @brief   Allow a timer allocated with timer_alloc() to expire up to slack
+ * 			milliseconds late, so it can share a wake-up with other timers.
+ * 			Takes effect the next time the timer is started.
+ *
+ * @param   pTimer - timer handle
+ * @param	slack - allowed lateness in milliseconds
+ *
+ * @return  void
+ */
+void timer_setSlack(timer_handle_t *pTimer, uint32 slack)
+{
+	pthread_mutex_lock(&timerMutex);
+	pTimer->slack = slack * 1000;
+	pthread_mutex_unlock(&timerMutex);
+}
+
+/**************************************************************************************************
+ *
+ * @fn      timer_stop
+ *
+ * @brief   Stop a timer allocated with timer_alloc(). An event that already
+ * 			fired is not cleared, since other timers may share the event bit.
+ *
+ * @param   pTimer - timer handle
+ *
+ * @return  TRUE
+ */
+uint8 timer_stop(timer_handle_t *pTimer)
+{
+	pthread_mutex_lock(&timerMutex);
+	timerDisarm(pTimer);
+	pthread_mutex_unlock(&timerMutex);
+
+	return TRUE;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      timer_handleIsActive
+ *
+ * @brief   Check to see if a timer allocated with timer_alloc() is running
+ *
+ * @param   pTimer - timer handle
+ *
+ * @return  TRUE is timer is running
+ */
+uint8 timer_handleIsActive(timer_handle_t *pTimer)
+{
+	uint8 isActive;
+
+	pthread_mutex_lock(&timerMutex);
+	isActive = (pTimer->heapIndex >= 0) ? TRUE : FALSE;
+	pthread_mutex_unlock(&timerMutex);
+
+	return isActive;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      timer_getNumActive
+ *
+ * @brief   Number of timers currently running.
+ *
+ * @return  active timer count
+ */
+uint32 timer_getNumActive(void)
+{
+	return timerHeapSize;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      timer_process
+ *
+ * @brief   Expire the timers that are due, in event loop mode, see
+ * 			timer_initEventLoop(). Afterwards timer_get_event() returns the
+ * 			events to handle.
+ *
+ * @return  milliseconds until timer_process must be called again if no
+ * 			descriptor becomes readable, -1 if there is no such deadline.
+ */
+int timer_process(void)
+{
+	unsigned long long now, expirations;
+	int timeout = -1;
+
+	// Clear the wake-ups, then look at everything they may have announced
+	if ((read(timerEventFd, &expirations, sizeof(expirations)) < 0) && (errno != EAGAIN))
+	{
+		LOG_ERROR("[TIMER] Failed to read event eventfd, errno %d\n", errno);
+	}
+#ifdef NPI_TIMERFD
+	if ((read(timerFd, &expirations, sizeof(expirations)) < 0) && (errno != EAGAIN))
+	{
+		LOG_ERROR("[TIMER] Failed to read timerfd, errno %d\n", errno);
+	}
+#endif
+
+	pthread_mutex_lock(&timerMutex);
+	now = timerNow();
+	timerExpire(&now);
+
+#ifdef NPI_TIMERFD
+	// The timerfd reports the next expiry
+	timerFdProgram();
+#else
+	if (timerHeapSize > 0)
+	{
+		// Round up, waking up early would only cost another iteration
+		timeout = (int)((timerHeap[0]->expiry - now + 999) / 1000);
+	}
+#endif
+	pthread_mutex_unlock(&timerMutex);
+
+	return timeout;
+}
+
+/**************************************************************************************************
+ *
+ * @fn      timer_getIdleWakeups
+ *
+ * @brief   Number of times the timer thread woke up without expiring a timer.
+ *
+ * @return  idle wake-up count
+ */
+uint32 timer_getIdleWakeups(void)
+{
+	return timerIdleWakeups;
 }
 
 uint8 timer_set_event(uint8 threadId, uint32 event)
@@ -467,7 +979,14 @@ uint8 timer_set_event(uint8 threadId, uint32 event)
 	timerThreadTbl[threadId].eventFlag |= event;
 
 	// Release resources waiting for this event
-	if (sem_post(&eventSem) < 0)
+	if (timerEventLoop)
+	{
+		if (eventfd_write(timerEventFd, 1) < 0)
+		{
+			LOG_ERROR("[TIMER] Failed to post event 0x%.8X, errno %d\n", event, errno);
+		}
+	}
+	else if (sem_post(&eventSem) < 0)
 	{
 		LOG_ERROR("[TIMER] Failed to post event 0x%.8X, semaphore %p\n", event, &eventSem);
 		perror("eventSem");
@@ -542,9 +1061,23 @@ static void timerInitSyncRes(void)
 	}
 
 	// initialize conditions
+#ifdef NPI_TICKLESS
+	// Wait on the monotonic clock so deadlines are not affected by time changes
+	pthread_condattr_t condAttr;
+	pthread_condattr_init(&condAttr);
+	pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+	if (pthread_cond_init(&timerSetCond, &condAttr))
+#else
 	if (pthread_cond_init(&timerSetCond, NULL))
+#endif
 	{
 		LOG_ERROR("[TIMER]Fail To Initialize Cond timerSetCond\n");
 		exit(-1);
 	}
+
+	if (pthread_cond_init(&timerCbackDoneCond, NULL))
+	{
+		LOG_ERROR("[TIMER]Fail To Initialize Cond timerCbackDoneCond\n");
+		exit(-1);
+	}
 }
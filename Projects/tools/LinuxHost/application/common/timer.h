@@ -45,32 +45,31 @@
 
 #include "common_app.h"
 
-#if !defined PACK_1
-#define PACK_1
-#endif
-
-#if defined(_MSC_VER) || defined(unix) || (defined(__ICC430__) && (__ICC430__==1))
-#pragma pack(1)
-#endif
-
-typedef struct
-{
-	uint32 		eventFlag;
-	long int 	timeoutValue[32];	// 1 timer per event
-	uint32 		timerEnabled;		// Maps to event mask
-	uint32		justKicked;
-} timer_thread_s ;
-
-#if defined _MSC_VER || defined(unix)
-#pragma pack()
-#endif
+// Callback invoked from the timer thread when a callback timer expires.
+// It must not block; typically it records state and calls timer_set_event().
+typedef void (*timer_callback_t)(void *pArg);
+
+// Opaque timer handle, see timer_alloc()
+typedef struct timer_entry_s timer_handle_t;
 
 extern int    timer_init			(uint16 numOfThreads);
+extern int    timer_initEventLoop	(uint16 numOfThreads);
+extern void   timer_getPollFds		(int *pEventFd, int *pTimerFd);
+extern int    timer_process		(void);
 
 extern uint8  timer_start_timerEx	(uint8 threadId, uint32 event, uint32 timeout);
 extern uint8  timer_isActive		(uint8 threadId, uint32 event);
 extern uint8  timer_set_event		(uint8 threadId, uint32 event);
 extern uint8  timer_clear_event		(uint8 threadId, uint32 event);
 extern uint32 timer_get_event		(uint8 threadId);
+extern uint32 timer_getIdleWakeups	(void);
+
+extern timer_handle_t *timer_alloc	(uint8 threadId, uint32 event, timer_callback_t pCback, void *pArg);
+extern void   timer_free			(timer_handle_t *pTimer);
+extern uint8  timer_start			(timer_handle_t *pTimer, uint32 timeout);
+extern uint8  timer_stop			(timer_handle_t *pTimer);
+extern void   timer_setSlack		(timer_handle_t *pTimer, uint32 slack);
+extern uint8  timer_handleIsActive	(timer_handle_t *pTimer);
+extern uint32 timer_getNumActive	(void);
 
 #endif /* TIMER_H_ */
@@ -0,0 +1,226 @@
+/**************************************************************************************************
+  Filename:       timer_bench.c
+
+  Description:    Timer jitter benchmark. Reports how late timer expirations are
+                  delivered to the application thread.
+
+    Copyright (C) 2015 Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <semaphore.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "timer.h"
+#include "hal_defs.h"
+
+#define TIMER_BENCH_THREAD_ID		0
+#define TIMER_BENCH_EVENT			0x00000001
+
+// Lateness histogram bucket upper bounds in us, last bucket is open ended
+static const long timerBenchBuckets[] = { 50, 100, 250, 500, 1000, 2000, 5000, 10000 };
+#define TIMER_BENCH_NUM_BUCKETS		(sizeof(timerBenchBuckets) / sizeof(timerBenchBuckets[0]))
+
+sem_t eventSem;
+
+static unsigned long long timerBenchNow(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((unsigned long long)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+}
+
+static int timerBenchCompare(const void *a, const void *b)
+{
+	long la = *(const long *)a, lb = *(const long *)b;
+
+	return (la > lb) - (la < lb);
+}
+
+static double timerBenchCpuMs(void)
+{
+	struct rusage usage;
+
+	getrusage(RUSAGE_SELF, &usage);
+	return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+			(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+}
+
+static void timerBenchUsage(const char *name)
+{
+	printf("Usage: %s [-n count] [-t timeout ms] [-s slack ms]\n", name);
+	printf("  Starts count timers of timeout ms one after the other and reports\n");
+	printf("  how late each expiration reached the waiting thread.\n");
+	printf("  With -s the timers are allocated with timer_alloc() and the given\n");
+	printf("  slack instead of using timer_start_timerEx().\n");
+}
+
+int main(int argc, char **argv)
+{
+	int count = 200, slack = -1, opt, i, semRet;
+	uint32 timeout = 20;
+	unsigned long long start, wallStart;
+	long *lateness, sum = 0;
+	unsigned int hist[TIMER_BENCH_NUM_BUCKETS + 1];
+	timer_handle_t *pTimer = NULL;
+	double cpuStart;
+
+	while ((opt = getopt(argc, argv, "n:t:s:h")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n':
+			count = atoi(optarg);
+			break;
+		case 't':
+			timeout = atoi(optarg);
+			break;
+		case 's':
+			slack = atoi(optarg);
+			break;
+		default:
+			timerBenchUsage(argv[0]);
+			return (opt == 'h') ? 0 : -1;
+		}
+	}
+	if ((count <= 0) || (timeout == 0))
+	{
+		timerBenchUsage(argv[0]);
+		return -1;
+	}
+
+	lateness = (long *) malloc(sizeof(long) * count);
+	if (lateness == NULL)
+	{
+		return -1;
+	}
+	memset(hist, 0, sizeof(hist));
+
+	sem_init(&eventSem, 0, 0);
+	if (timer_init(1) != 0)
+	{
+		return -1;
+	}
+	if (slack >= 0)
+	{
+		pTimer = timer_alloc(TIMER_BENCH_THREAD_ID, TIMER_BENCH_EVENT, NULL, NULL);
+		if (pTimer == NULL)
+		{
+			return -1;
+		}
+		timer_setSlack(pTimer, slack);
+	}
+
+	printf("Timer jitter benchmark: %d x %ums (%s", count, timeout,
+			(pTimer != NULL) ? "timer_start" : "timer_start_timerEx");
+	if (pTimer != NULL)
+	{
+		printf(", slack %dms", slack);
+	}
+#if defined NPI_TIMERFD
+	printf(", timerfd backend)\n");
+#elif defined NPI_TICKLESS
+	printf(", tickless condvar backend)\n");
+#else
+	printf(", condvar backend)\n");
+#endif
+
+	cpuStart = timerBenchCpuMs();
+	wallStart = timerBenchNow();
+	for (i = 0; i < count; i++)
+	{
+		start = timerBenchNow();
+		if (pTimer != NULL)
+		{
+			timer_start(pTimer, timeout);
+		}
+		else
+		{
+			timer_start_timerEx(TIMER_BENCH_THREAD_ID, TIMER_BENCH_EVENT, timeout);
+		}
+
+		do
+		{
+			while (((semRet = sem_wait(&eventSem)) != 0) && (errno == EINTR));
+		} while ((semRet == 0) && !(timer_get_event(TIMER_BENCH_THREAD_ID) & TIMER_BENCH_EVENT));
+
+		lateness[i] = (long)(timerBenchNow() - start) - ((long)timeout * 1000);
+		timer_clear_event(TIMER_BENCH_THREAD_ID, TIMER_BENCH_EVENT);
+	}
+
+	printf("Wall time %llums, CPU time %.1fms, idle timer wake-ups %u\n",
+			(timerBenchNow() - wallStart) / 1000, timerBenchCpuMs() - cpuStart, timer_getIdleWakeups());
+
+	for (i = 0; i < count; i++)
+	{
+		unsigned int b;
+
+		sum += lateness[i];
+		for (b = 0; b < TIMER_BENCH_NUM_BUCKETS; b++)
+		{
+			if (lateness[i] < timerBenchBuckets[b])
+			{
+				break;
+			}
+		}
+		hist[b]++;
+	}
+	qsort(lateness, count, sizeof(long), timerBenchCompare);
+
+	printf("Lateness (us): min %ld, avg %ld, p50 %ld, p90 %ld, p99 %ld, max %ld\n",
+			lateness[0], sum / count, lateness[count / 2], lateness[(count * 90) / 100],
+			lateness[(count * 99) / 100], lateness[count - 1]);
+	for (i = 0; i <= (int)TIMER_BENCH_NUM_BUCKETS; i++)
+	{
+		if (i < (int)TIMER_BENCH_NUM_BUCKETS)
+		{
+			printf("  < %6ldus: %u\n", timerBenchBuckets[i], hist[i]);
+		}
+		else
+		{
+			printf("  >=%6ldus: %u\n", timerBenchBuckets[i - 1], hist[i]);
+		}
+	}
+
+	timer_free(pTimer);
+	free(lateness);
+
+	return 0;
+}
@@ -1535,62 +1535,50 @@ static void appSetCFGParamOnRNP( void )
 	// Apply Configuration Parameters //
 	////////////////////////////////////
 
-	LOG_DEBUG("\n-------------------- SET RNP CONFIGURATION PARAMETERS-------------------\n");
-	if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_CAPABILITIES, 1,
-			(uint8*)&(appCFGParam.nodeCapabilities)) != RTI_SUCCESS) {
-		//   AP_FATAL_ERROR();
-		LOG_ERROR("Could not write RTI_CP_ITEM_NODE_CAPABILITIES\n");
-	}
-	else
-		LOG_DEBUG("Successfully wrote RTI_CP_ITEM_NODE_CAPABILITIES\n");
-
-	if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES,
-			RTI_MAX_NUM_SUPPORTED_TGT_TYPES, appCFGParam.tgtTypeList) != RTI_SUCCESS) {
-		///AP_FATAL_ERROR();
-		LOG_ERROR("Could not write RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES\n");
-	}
-	else
-		LOG_DEBUG("Successfully wrote RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES\n");
-
-	if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_CAPABILITIES, 1,
-			(uint8*)&(appCFGParam.appCapabilities)) != RTI_SUCCESS) {
-		// AP_FATAL_ERROR();
-		LOG_ERROR("Could not write RTI_CP_ITEM_APPL_CAPABILITIES\n");
-	}
-	else
-		LOG_DEBUG("Successfully wrote RTI_CP_ITEM_APPL_CAPABILITIES\n");
-
-	if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_DEV_TYPE_LIST,
-			RTI_MAX_NUM_DEV_TYPES, appCFGParam.devTypeList) != RTI_SUCCESS) {
-		//   AP_FATAL_ERROR();
-		LOG_ERROR("Could not write RTI_CP_ITEM_APPL_DEV_TYPE_LIST\n");
-	}
-	else
-		LOG_DEBUG("Successfully wrote RTI_CP_ITEM_APPL_DEV_TYPE_LIST\n");
+	rtiItem_t items[] =
+	{
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_CAPABILITIES, 1,
+				(uint8*)&(appCFGParam.nodeCapabilities) },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES, RTI_MAX_NUM_SUPPORTED_TGT_TYPES,
+				appCFGParam.tgtTypeList },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_CAPABILITIES, 1,
+				(uint8*)&(appCFGParam.appCapabilities) },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_DEV_TYPE_LIST, RTI_MAX_NUM_DEV_TYPES,
+				appCFGParam.devTypeList },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_PROFILE_ID_LIST, RTI_MAX_NUM_PROFILE_IDS,
+				appCFGParam.profileIdList },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_ID, 2,
+				(uint8*)&(appCFGParam.vendorId) },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_NAME, sizeof(vendorName),
+				appCFGParam.vendorString },
+	};
+	static const char * const itemNames[] =
+	{
+		"RTI_CP_ITEM_NODE_CAPABILITIES",
+		"RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES",
+		"RTI_CP_ITEM_APPL_CAPABILITIES",
+		"RTI_CP_ITEM_APPL_DEV_TYPE_LIST",
+		"RTI_CP_ITEM_APPL_PROFILE_ID_LIST",
+		"RTI_CP_ITEM_VENDOR_ID",
+		"RTI_CP_ITEM_VENDOR_NAME",
+	};
+	uint8 i;
 
-	if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_PROFILE_ID_LIST,
-			RTI_MAX_NUM_PROFILE_IDS, appCFGParam.profileIdList) != RTI_SUCCESS) {
-		//    AP_FATAL_ERROR();
-		LOG_ERROR("Could not write RTI_CP_ITEM_APPL_PROFILE_ID_LIST\n");
-	}
-	else
-		LOG_DEBUG("Successfully wrote RTI_CP_ITEM_APPL_PROFILE_ID_LIST\n");
+	LOG_DEBUG("\n-------------------- SET RNP CONFIGURATION PARAMETERS-------------------\n");
 
-	if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_ID, 2,
-			(uint8*)&(appCFGParam.vendorId)) != RTI_SUCCESS) {
-		//  AP_FATAL_ERROR();
-		LOG_ERROR("Could not write RTI_CP_ITEM_VENDOR_ID\n");
-	}
-	else
-		LOG_DEBUG("Successfully wrote RTI_CP_ITEM_VENDOR_ID\n");
+	// All items in one go, the client waits once. The server still forwards
+	// them to the RNP one at a time, so only the IPC round trips are saved.
+	RTI_WriteItems(sizeof(items) / sizeof(items[0]), items);
 
-	if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_NAME,
-			sizeof(vendorName), appCFGParam.vendorString) != RTI_SUCCESS) {
-		//  AP_FATAL_ERROR();
-		LOG_ERROR("Could not write RTI_CP_ITEM_VENDOR_NAME\n");
+	for (i = 0; i < sizeof(items) / sizeof(items[0]); i++)
+	{
+		if (items[i].status != RTI_SUCCESS) {
+			//  AP_FATAL_ERROR();
+			LOG_ERROR("Could not write %s\n", itemNames[i]);
+		}
+		else
+			LOG_DEBUG("Successfully wrote %s\n", itemNames[i]);
 	}
-	else
-		LOG_DEBUG("Successfully wrote RTI_CP_ITEM_VENDOR_NAME\n");
 }
 
 
@@ -1604,46 +1592,45 @@ int appVerifyCFGParamAgainstRNP( void )
 
 	appDevInfo_t appCFGParamOnRNP = {0};
 
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_CAPABILITIES, 1,
-			(uint8*)&(appCFGParamOnRNP.nodeCapabilities)) != RTI_SUCCESS) {
-		//   AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read Node Capabilities\n");
-	}
-
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES,
-			RTI_MAX_NUM_SUPPORTED_TGT_TYPES, appCFGParamOnRNP.tgtTypeList) != RTI_SUCCESS) {
-		///AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read Target Types\n");
-	}
-
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_CAPABILITIES, 1,
-			(uint8*)&(appCFGParamOnRNP.appCapabilities)) != RTI_SUCCESS) {
-		// AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read Application Capabilities\n");
-	}
-
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_DEV_TYPE_LIST,
-			RTI_MAX_NUM_DEV_TYPES, appCFGParamOnRNP.devTypeList) != RTI_SUCCESS) {
-		//   AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read Device Types\n");
-	}
-
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_PROFILE_ID_LIST,
-			RTI_MAX_NUM_PROFILE_IDS, appCFGParamOnRNP.profileIdList) != RTI_SUCCESS) {
-		//    AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read Profile IDs\n");
-	}
+	rtiItem_t items[] =
+	{
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_CAPABILITIES, 1,
+				(uint8*)&(appCFGParamOnRNP.nodeCapabilities) },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES, RTI_MAX_NUM_SUPPORTED_TGT_TYPES,
+				appCFGParamOnRNP.tgtTypeList },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_CAPABILITIES, 1,
+				(uint8*)&(appCFGParamOnRNP.appCapabilities) },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_DEV_TYPE_LIST, RTI_MAX_NUM_DEV_TYPES,
+				appCFGParamOnRNP.devTypeList },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_PROFILE_ID_LIST, RTI_MAX_NUM_PROFILE_IDS,
+				appCFGParamOnRNP.profileIdList },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_ID, 2,
+				(uint8*)&(appCFGParamOnRNP.vendorId) },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_NAME, sizeof(vendorName),
+				appCFGParamOnRNP.vendorString },
+	};
+	static const char * const itemNames[] =
+	{
+		"Node Capabilities",
+		"Target Types",
+		"Application Capabilities",
+		"Device Types",
+		"Profile IDs",
+		"Vendor ID",
+		"Vendor String",
+	};
+	uint8 i;
 
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_ID, 2,
-			(uint8*)&(appCFGParamOnRNP.vendorId)) != RTI_SUCCESS) {
-		//  AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read Vendor ID\n");
-	}
+	// All items in one go, the client waits once. The server still forwards
+	// them to the RNP one at a time, so only the IPC round trips are saved.
+	RTI_ReadItems(sizeof(items) / sizeof(items[0]), items);
 
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_NAME,
-			sizeof(vendorName), appCFGParamOnRNP.vendorString) != RTI_SUCCESS) {
-		//  AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read Vendor String\n");
+	for (i = 0; i < sizeof(items) / sizeof(items[0]); i++)
+	{
+		if (items[i].status != RTI_SUCCESS) {
+			//  AP_FATAL_ERROR();
+			LOG_ERROR("Failed to read %s\n", itemNames[i]);
+		}
 	}
 
 	// Now perform comparison
@@ -1670,30 +1657,13 @@ void appDisplayPairingTable() {
 	// Allocate memory for one pairing entry
 	pEntry = (rcnNwkPairingEntry_t *) malloc(sizeof(rcnNwkPairingEntry_t));
 
-	uint8 i, result, atLeastOneEntryFound = 0, maxNumPairingEntries = 1;
+	uint8 i, result, atLeastOneEntryFound = 0, maxNumPairingEntries;
 
-	// Initialize memory for backup pairing table
-	RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CONST_ITEM_MAX_PAIRING_TABLE_ENTRIES, 1,&maxNumPairingEntries);
+	// The pairing table is served from the RTI library mirror
+	maxNumPairingEntries = RTI_GetPairingTableSize();
 	for (i = 0; i < maxNumPairingEntries; i++) {
-    if (supportIndexedAPI == TRUE)
-    {
-      // Try to read out this entry
-      result = RTI_ReadIndexedItem(RTI_PROFILE_RTI,
-          RTI_SA_ITEM_PAIRING_TABLE_ENTRY,
-          i,
-          sizeof(rcnNwkPairingEntry_t),
-          (uint8 *) pEntry);
-    }
-    else
-    {
-      // Set current pairing entry
-      RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_PT_CURRENT_ENTRY_INDEX, 1,
-          (uint8 *) &i);
-      // Try to read out this entry
-      result = RTI_ReadItemEx(RTI_PROFILE_RTI,
-          RTI_SA_ITEM_PT_CURRENT_ENTRY, sizeof(rcnNwkPairingEntry_t),
-          (uint8 *) pEntry);
-    }
+    // Try to read out this entry
+    result = RTI_ReadPairingEntry(i, pEntry);
     if (result == RTI_SUCCESS)
     {
       // Found pairing entry; display this.
@@ -45,6 +45,7 @@
 #include <pthread.h>
 #include <poll.h>
 
+#include <time.h>
 #include <sys/time.h>
 
 #include "common_app.h"
@@ -298,6 +299,7 @@ static void appReturnFromSubmodule(void);
 static int getAndPrintExtendedSoftwareVersion(uint8 timePrint);
 static void appSetCFGParamOnRNP(void);
 static void appGetCFGParamFromRNP(void);
+static void appBenchmarkCFGParam(void);
 static void appInitConfigParam( char tgtSelection );
 static void appConfigParamProcessKey(char* strIn);
 static void appAttenuatorControlProcessKey(char* strIn);
@@ -980,31 +982,33 @@ static void appProcessEvents(uint32 events)
  */
 void appClearPairingTable()
 {
-	rcnNwkPairingEntry_t *pEntry;
-	// Allocate memory for one pairing entry
-	pEntry = (rcnNwkPairingEntry_t *) malloc(sizeof(rcnNwkPairingEntry_t));
-
-	uint8 i, result, pairingTableSize;
-
-	(void)RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CONST_ITEM_MAX_PAIRING_TABLE_ENTRIES, 1, (uint8*)&pairingTableSize);
+	rcnNwkPairingEntry_t *pEntries;
+	uint8 *pValid;
+	uint8 i, pairingTableSize;
+
+	// Read out all entries first; writing one drops the pairing table mirror
+	pairingTableSize = RTI_GetPairingTableSize();
+	// Allocate memory for the pairing entries
+	pEntries = (rcnNwkPairingEntry_t *) malloc((pairingTableSize + 1) * sizeof(rcnNwkPairingEntry_t));
+	pValid = (uint8 *) malloc(pairingTableSize + 1);
+	for (i = 0; i < pairingTableSize; i++)
+	{
+		pValid[i] = (RTI_ReadPairingEntry(i, &pEntries[i]) == RTI_SUCCESS);
+	}
 
 	for (i = 0; i < pairingTableSize; i++)
 	{
-		// Set current pairing entry
-		RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_PT_CURRENT_ENTRY_INDEX, 1,
-				(uint8 *) &i);
-		// Try to read out this entry
-		if ((result = RTI_ReadItemEx(RTI_PROFILE_RTI,
-				RTI_SA_ITEM_PT_CURRENT_ENTRY,
-				sizeof(rcnNwkPairingEntry_t),
-				(uint8 *) pEntry)) == RTI_SUCCESS)
+		if (pValid[i])
 		{
+			// Set current pairing entry
+			RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_PT_CURRENT_ENTRY_INDEX, 1,
+					(uint8 *) &i);
 			// Invalidate item
-			pEntry->pairingRef = RTI_INVALID_PAIRING_REF;
+			pEntries[i].pairingRef = RTI_INVALID_PAIRING_REF;
 			RTI_WriteItemEx(RTI_PROFILE_RTI,
 				RTI_SA_ITEM_PT_CURRENT_ENTRY,
 				sizeof(rcnNwkPairingEntry_t),
-				(uint8 *) pEntry);
+				(uint8 *) &pEntries[i]);
 		}
 	}
 
@@ -1012,8 +1016,9 @@ void appClearPairingTable()
 	LOG_INFO("* Pairing Table Is Empty\n");
 	LOG_INFO("*************************************\n");
 
-	// Free pairing entry buffer
-	free(pEntry);
+	// Free pairing entry buffers
+	free(pValid);
+	free(pEntries);
 }
 
 /**************************************************************************************************
@@ -1034,20 +1039,15 @@ void appDisplayPairingTable()
 
 	uint8 i, result, atLeastOneEntryFound = 0, numOfEntries;
 
-	RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CONST_ITEM_MAX_PAIRING_TABLE_ENTRIES,
-			1, (uint8 *) &numOfEntries);
+	// The pairing table is served from the RTI library mirror
+	numOfEntries = RTI_GetPairingTableSize();
 
 	LOG_INFO("*************************************\n");
 	LOG_INFO("* Max number of pairing entries: %d\n", numOfEntries);
 	for (i = 0; i < numOfEntries; i++)
 	{
-		// Set current pairing entry
-		RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_PT_CURRENT_ENTRY_INDEX, 1,
-				(uint8 *) &i);
 		// Try to read out this entry
-		if ((result = RTI_ReadItemEx(RTI_PROFILE_RTI,
-				RTI_SA_ITEM_PT_CURRENT_ENTRY, sizeof(rcnNwkPairingEntry_t),
-				(uint8 *) pEntry)) == RTI_SUCCESS) {
+		if ((result = RTI_ReadPairingEntry(i, pEntry)) == RTI_SUCCESS) {
 
 			// Found pairing entry; display this.
 			DisplayPairingTable(pEntry);
@@ -1834,6 +1834,10 @@ static void appConfigParamProcessKey(char* strIn)
 			// List current chosen configuration (not the one programmed to RNP)
 			DispCFGCurrentCfg(appCFGParam, ownNwkAddr, ownPANID, ownIEEE);
 			break;
+		case 'b':
+			// Compare batched configuration access against one item at a time
+			appBenchmarkCFGParam();
+			break;
 		default:
 			appCFGstate = APP_CFG_STATE_INIT;
 			DispMenuInit();
@@ -2043,71 +2047,58 @@ static void appSetCFGParamOnRNP( void )
 	// Apply Configuration Parameters //
 	////////////////////////////////////
 
-	LOG_INFO("-------------------- SET RNP CONFIGURATION PARAMETERS-------------------\n");
-	if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_CAPABILITIES, 1,
-			(uint8*)&(appCFGParam.nodeCapabilities)) != RTI_SUCCESS) {
-		//   AP_FATAL_ERROR();
-		LOG_ERROR("Could not write RTI_CP_ITEM_NODE_CAPABILITIES\n");
-	}
-	else
-		LOG_DEBUG("Successfully wrote RTI_CP_ITEM_NODE_CAPABILITIES\n");
-
-	if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES,
-			RTI_MAX_NUM_SUPPORTED_TGT_TYPES, appCFGParam.tgtTypeList) != RTI_SUCCESS) {
-		///AP_FATAL_ERROR();
-		LOG_ERROR("Could not write RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES\n");
-	}
-	else
-		LOG_DEBUG("Successfully wrote RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES\n");
-
-	if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_CAPABILITIES, 1,
-			(uint8*)&(appCFGParam.appCapabilities)) != RTI_SUCCESS) {
-		// AP_FATAL_ERROR();
-		LOG_ERROR("Could not write RTI_CP_ITEM_APPL_CAPABILITIES\n");
-	}
-	else
-		LOG_DEBUG("Successfully wrote RTI_CP_ITEM_APPL_CAPABILITIES\n");
-
-	if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_DEV_TYPE_LIST,
-			RTI_MAX_NUM_DEV_TYPES, appCFGParam.devTypeList) != RTI_SUCCESS) {
-		//   AP_FATAL_ERROR();
-		LOG_ERROR("Could not write RTI_CP_ITEM_APPL_DEV_TYPE_LIST\n");
-	}
-	else
-		LOG_DEBUG("Successfully wrote RTI_CP_ITEM_APPL_DEV_TYPE_LIST\n");
-
-	if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_PROFILE_ID_LIST,
-			RTI_MAX_NUM_PROFILE_IDS, appCFGParam.profileIdList) != RTI_SUCCESS) {
-		//    AP_FATAL_ERROR();
-		LOG_ERROR("Could not write RTI_CP_ITEM_APPL_PROFILE_ID_LIST\n");
-	}
-	else
-		LOG_DEBUG("Successfully wrote RTI_CP_ITEM_APPL_PROFILE_ID_LIST\n");
+	rtiItem_t items[] =
+	{
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_CAPABILITIES, 1,
+				(uint8*)&(appCFGParam.nodeCapabilities) },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES, RTI_MAX_NUM_SUPPORTED_TGT_TYPES,
+				appCFGParam.tgtTypeList },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_CAPABILITIES, 1,
+				(uint8*)&(appCFGParam.appCapabilities) },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_DEV_TYPE_LIST, RTI_MAX_NUM_DEV_TYPES,
+				appCFGParam.devTypeList },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_PROFILE_ID_LIST, RTI_MAX_NUM_PROFILE_IDS,
+				appCFGParam.profileIdList },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_ID, 2,
+				(uint8*)&(appCFGParam.vendorId) },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_NAME, sizeof(vendorName),
+				appCFGParam.vendorString },
+		{ RTI_PROFILE_RTI, RTI_SA_ITEM_USER_STRING, sizeof(userString),
+				appCFGParam.userString },
+	};
+	static const char * const itemNames[] =
+	{
+		"RTI_CP_ITEM_NODE_CAPABILITIES",
+		"RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES",
+		"RTI_CP_ITEM_APPL_CAPABILITIES",
+		"RTI_CP_ITEM_APPL_DEV_TYPE_LIST",
+		"RTI_CP_ITEM_APPL_PROFILE_ID_LIST",
+		"RTI_CP_ITEM_VENDOR_ID",
+		"RTI_CP_ITEM_VENDOR_NAME",
+		"RTI_SA_ITEM_USER_STRING",
+	};
+	struct timespec start, end;
+	uint8 i;
 
-	if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_ID, 2,
-			(uint8*)&(appCFGParam.vendorId)) != RTI_SUCCESS) {
-		//  AP_FATAL_ERROR();
-		LOG_ERROR("Could not write RTI_CP_ITEM_VENDOR_ID\n");
-	}
-	else
-		LOG_DEBUG("Successfully wrote RTI_CP_ITEM_VENDOR_ID\n");
+	LOG_INFO("-------------------- SET RNP CONFIGURATION PARAMETERS-------------------\n");
 
-	if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_NAME,
-			sizeof(vendorName), appCFGParam.vendorString) != RTI_SUCCESS) {
-		//  AP_FATAL_ERROR();
-		LOG_ERROR("Could not write RTI_CP_ITEM_VENDOR_NAME\n");
-	}
-	else
-		LOG_DEBUG("Successfully wrote RTI_CP_ITEM_VENDOR_NAME\n");
+	// All items in one go, the client waits once. The server still forwards
+	// them to the RNP one at a time, so only the IPC round trips are saved.
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	RTI_WriteItems(sizeof(items) / sizeof(items[0]), items);
+	clock_gettime(CLOCK_MONOTONIC, &end);
 
-	if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_USER_STRING,
-			sizeof(userString), appCFGParam.userString) != RTI_SUCCESS) {
-		//  AP_FATAL_ERROR();
-		LOG_ERROR("Could not write RTI_SA_ITEM_USER_STRING\n");
+	for (i = 0; i < sizeof(items) / sizeof(items[0]); i++)
+	{
+		if (items[i].status != RTI_SUCCESS) {
+			//  AP_FATAL_ERROR();
+			LOG_ERROR("Could not write %s\n", itemNames[i]);
+		}
+		else
+			LOG_DEBUG("Successfully wrote %s\n", itemNames[i]);
 	}
-	else
-		LOG_DEBUG("Successfully wrote RTI_SA_ITEM_USER_STRING\n");
-
+	LOG_INFO("Wrote %d configuration items in %ld us\n", (int)(sizeof(items) / sizeof(items[0])),
+			((end.tv_sec - start.tv_sec) * 1000000L) + ((end.tv_nsec - start.tv_nsec) / 1000L));
 }
 
 
@@ -2117,71 +2108,161 @@ void appGetCFGParamFromRNP( void )
 	// Read Configuration Parameters From RNP//
 	///////////////////////////////////////////
 
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_CAPABILITIES, 1,
-			(uint8*)&(appCFGParam.nodeCapabilities)) != RTI_SUCCESS) {
-		//   AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read Node Capabilities\n");
-	}
-
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES,
-			RTI_MAX_NUM_SUPPORTED_TGT_TYPES, appCFGParam.tgtTypeList) != RTI_SUCCESS) {
-		///AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read Target Types\n");
-	}
-
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_CAPABILITIES, 1,
-			(uint8*)&(appCFGParam.appCapabilities)) != RTI_SUCCESS) {
-		// AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read Application Capabilities\n");
-	}
-
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_DEV_TYPE_LIST,
-			RTI_MAX_NUM_DEV_TYPES, appCFGParam.devTypeList) != RTI_SUCCESS) {
-		//   AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read Device Types\n");
-	}
-
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_PROFILE_ID_LIST,
-			RTI_MAX_NUM_PROFILE_IDS, appCFGParam.profileIdList) != RTI_SUCCESS) {
-		//    AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read Profile IDs\n");
+	rtiItem_t items[] =
+	{
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_CAPABILITIES, 1,
+				(uint8*)&(appCFGParam.nodeCapabilities) },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES, RTI_MAX_NUM_SUPPORTED_TGT_TYPES,
+				appCFGParam.tgtTypeList },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_CAPABILITIES, 1,
+				(uint8*)&(appCFGParam.appCapabilities) },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_DEV_TYPE_LIST, RTI_MAX_NUM_DEV_TYPES,
+				appCFGParam.devTypeList },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_PROFILE_ID_LIST, RTI_MAX_NUM_PROFILE_IDS,
+				appCFGParam.profileIdList },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_ID, 2,
+				(uint8*)&(appCFGParam.vendorId) },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_NAME, sizeof(vendorName),
+				appCFGParam.vendorString },
+		{ RTI_PROFILE_RTI, RTI_SA_ITEM_USER_STRING, sizeof(userString),
+				appCFGParam.userString },
+		{ RTI_PROFILE_RTI, RTI_SA_ITEM_SHORT_ADDRESS, sizeof(uint16),
+				(uint8 *)&ownNwkAddr },
+		{ RTI_PROFILE_RTI, RTI_SA_ITEM_PAN_ID, sizeof(uint16),
+				(uint8 *)&ownPANID },
+		{ RTI_PROFILE_RTI, RTI_SA_ITEM_IEEE_ADDRESS, sizeof(ownIEEE),
+				ownIEEE },
+	};
+	static const char * const itemNames[] =
+	{
+		"Node Capabilities",
+		"Target Types",
+		"Application Capabilities",
+		"Device Types",
+		"Profile IDs",
+		"Vendor ID",
+		"Vendor String",
+		"User String",
+		"network address",
+		"PAN ID",
+		"IEEE address",
+	};
+	struct timespec start, end;
+	uint8 i;
+
+	// All items in one go, the client waits once. The server still forwards
+	// them to the RNP one at a time, so only the IPC round trips are saved.
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	RTI_ReadItems(sizeof(items) / sizeof(items[0]), items);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (i = 0; i < sizeof(items) / sizeof(items[0]); i++)
+	{
+		if (items[i].status != RTI_SUCCESS) {
+			//  AP_FATAL_ERROR();
+			LOG_ERROR("Failed to read %s\n", itemNames[i]);
+		}
 	}
+	LOG_INFO("Read %d configuration items in %ld us\n", (int)(sizeof(items) / sizeof(items[0])),
+			((end.tv_sec - start.tv_sec) * 1000000L) + ((end.tv_nsec - start.tv_nsec) / 1000L));
+}
 
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_ID, 2,
-			(uint8*)&(appCFGParam.vendorId)) != RTI_SUCCESS) {
-		//  AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read Vendor ID\n");
+/**************************************************************************************************
+ * @fn          appBenchmarkCFGParam
+ *
+ * @brief       This function measures the startup configuration of the RNP;
+ *              the items written by appSetCFGParamOnRNP() are read and
+ *              written back one RTI_ReadItemEx()/RTI_WriteItemEx() call at a
+ *              time, as before RTI_ReadItems()/RTI_WriteItems(), and then
+ *              with the batched calls. The RNP configuration is left as it
+ *              was.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+static void appBenchmarkCFGParam( void )
+{
+#define APP_CFG_BENCHMARK_ROUNDS	10
+	appDevInfo_t cfg;
+	rtiItem_t items[] =
+	{
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_CAPABILITIES, 1,
+				(uint8*)&(cfg.nodeCapabilities) },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES, RTI_MAX_NUM_SUPPORTED_TGT_TYPES,
+				cfg.tgtTypeList },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_CAPABILITIES, 1,
+				(uint8*)&(cfg.appCapabilities) },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_DEV_TYPE_LIST, RTI_MAX_NUM_DEV_TYPES,
+				cfg.devTypeList },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_PROFILE_ID_LIST, RTI_MAX_NUM_PROFILE_IDS,
+				cfg.profileIdList },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_ID, 2,
+				(uint8*)&(cfg.vendorId) },
+		{ RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_NAME, sizeof(vendorName),
+				cfg.vendorString },
+		{ RTI_PROFILE_RTI, RTI_SA_ITEM_USER_STRING, sizeof(userString),
+				cfg.userString },
+	};
+	const int numItems = sizeof(items) / sizeof(items[0]);
+	// Total time in us for reading and writing, one by one and batched
+	long readSingle = 0, writeSingle = 0, readBatch = 0, writeBatch = 0;
+	int failures = 0, round, i;
+	struct timespec start, end;
+
+	// Current values are written back, so the configuration does not change
+	if (RTI_ReadItems(numItems, items) != RTI_SUCCESS)
+	{
+		LOG_ERROR("Benchmark: could not read the current configuration\n");
+		return;
 	}
 
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_NAME,
-			sizeof(vendorName), appCFGParam.vendorString) != RTI_SUCCESS) {
-		//  AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read Vendor String\n");
-	}
+	for (round = 0; round < APP_CFG_BENCHMARK_ROUNDS; round++)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < numItems; i++)
+		{
+			failures += (RTI_ReadItemEx(items[i].profileId, items[i].itemId, items[i].len, items[i].pValue) != RTI_SUCCESS);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		readSingle += ((end.tv_sec - start.tv_sec) * 1000000L) + ((end.tv_nsec - start.tv_nsec) / 1000L);
 
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_USER_STRING,
-			sizeof(userString), appCFGParam.userString) != RTI_SUCCESS) {
-		//  AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read User String\n");
-	}
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		failures += (RTI_ReadItems(numItems, items) != RTI_SUCCESS);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		readBatch += ((end.tv_sec - start.tv_sec) * 1000000L) + ((end.tv_nsec - start.tv_nsec) / 1000L);
 
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_SHORT_ADDRESS,
-			sizeof(uint16), (uint8 *)&ownNwkAddr) != RTI_SUCCESS) {
-		//  AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read network address\n");
-	}
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < numItems; i++)
+		{
+			failures += (RTI_WriteItemEx(items[i].profileId, items[i].itemId, items[i].len, items[i].pValue) != RTI_SUCCESS);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		writeSingle += ((end.tv_sec - start.tv_sec) * 1000000L) + ((end.tv_nsec - start.tv_nsec) / 1000L);
 
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_PAN_ID,
-			sizeof(uint16), (uint8 *)&ownPANID) != RTI_SUCCESS) {
-		//  AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read PAN ID\n");
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		failures += (RTI_WriteItems(numItems, items) != RTI_SUCCESS);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		writeBatch += ((end.tv_sec - start.tv_sec) * 1000000L) + ((end.tv_nsec - start.tv_nsec) / 1000L);
 	}
 
-	if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_IEEE_ADDRESS, sizeof(ownIEEE), ownIEEE)) {
-		//  AP_FATAL_ERROR();
-		LOG_ERROR("Failed to read IEEE address\n");
+	LOG_INFO("------------------------------------------------------\n");
+	LOG_INFO("Configuration of %d items, average of %d rounds:\n", numItems, APP_CFG_BENCHMARK_ROUNDS);
+	LOG_INFO("\tRead:  %ld us one by one, %ld us batched\n",
+			readSingle / APP_CFG_BENCHMARK_ROUNDS, readBatch / APP_CFG_BENCHMARK_ROUNDS);
+	LOG_INFO("\tWrite: %ld us one by one, %ld us batched\n",
+			writeSingle / APP_CFG_BENCHMARK_ROUNDS, writeBatch / APP_CFG_BENCHMARK_ROUNDS);
+	if (failures)
+	{
+		LOG_WARN("Benchmark: %d calls failed, timings include their timeouts\n", failures);
 	}
-
 }
 
 /**************************************************************************************************
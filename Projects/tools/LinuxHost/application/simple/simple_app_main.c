@@ -356,6 +356,7 @@ void DispMenuInit(void)
 	LOG_INFO("5- Supported Target Types \n");
 	LOG_INFO("i- Initialize without configuration. (Restore from NV).\n");
 	LOG_INFO("g- Get current configuration from RNP.\n");
+	LOG_INFO("b- Benchmark configuration, batched against one item at a time.\n");
 	LOG_INFO("l- Show configuration. Note! Not Necessarily the One Written To RNP\n");
 	LOG_INFO("s- Apply Configuration and Move On To Application\n");
 	LOG_INFO("r- Back To Application, Do Not Apply Changes\n");
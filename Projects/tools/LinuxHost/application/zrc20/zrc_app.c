@@ -49,6 +49,7 @@
 
 #include "common_app.h"
 #include "timer.h"
+#include "reactor.h"
 #include "tiLogging.h"
 
 #ifndef RTI_TESTMODE
@@ -149,17 +150,14 @@ typedef struct zrcMsgQueue
 
 zrcMsgQueue_t *pRsaMsgQueueHead = NULL;
 
-//THREAD and MUTEX
-static pthread_mutex_t zrcAppThreadMutex;
-static pthread_mutex_t zrcAppInitMutex;
-
-static pthread_t AppThreadId;
-static void *zrcAppThreadFunc(void *ptr);
-static int zrcAppThreadTerminate;
-
 static void zrcAppProcessEvents(uint32 events);
+static void zrcAppTimerEventCback(uint32 events, void *pArg);
 
 uint8 ZRC_App_threadId;
+
+// One lost key release timer per remote, set from the timer thread on expiry
+static timer_handle_t *zrcAppKeyReleaseLostTimer[ZRC_MAX_BOUND_REMOTES];
+static volatile uint8 zrcAppKeyReleaseLost[ZRC_MAX_BOUND_REMOTES];
 
 uint8 zrcAppSendDataState;
 
@@ -176,7 +174,8 @@ void zrcBuildIdentifyClientNotificationCmd( uint8 *pLen, uint8 **ppBuf );
 void zrcMsgQueue_push( uint8 *pMsg, uint8 len, uint8 profileId);
 void zrcMsgQueue_pop( uint8 **ppMsg, uint8 *pLen, uint8 *pProfileId );
 bool zrcMsgQueue_isEmpty( void );
-static int zrcAppInitSyncRes(void);
+static void zrcAppKeyReleaseLostCback(void *pArg);
+static void zrcAppTrackKeyRelease(uint8 srcIndex, uint32 timeout);
 
 int zrcAppGetAndPrintExtendedSoftwareVersion(swVerExtended_t *swVerExtended);
 static int zrcAppGetAndPrintSoftwareVersions(uint8 *baseVersion, swVerExtended_t *swVerExtended);
@@ -196,16 +195,20 @@ void RTI_AllowPairCnf(rStatus_t status, uint8 dstIndex, uint8 devType) {}
 
 int ZRC_AppInit(int mode, char threadId)
 {
-    zrcAppThreadTerminate = 0;
+    ZRC_App_threadId = threadId;
 
-    //Initialize Mutex
-    if (NPI_LNX_SUCCESS != zrcAppInitSyncRes())
+    uint8 remoteIndex;
+    for (remoteIndex = 0; remoteIndex < ZRC_MAX_BOUND_REMOTES; remoteIndex++)
     {
-        return NPI_LNX_FAILURE;
+        zrcAppKeyReleaseLost[remoteIndex] = FALSE;
+        zrcAppKeyReleaseLostTimer[remoteIndex] = timer_alloc(ZRC_App_threadId, ZRC_APP_EVT_KEY_RELEASE_LOST,
+                zrcAppKeyReleaseLostCback, (void *)(size_t)remoteIndex);
+        if (zrcAppKeyReleaseLostTimer[remoteIndex] == NULL)
+        {
+            return NPI_LNX_FAILURE;
+        }
     }
 
-    ZRC_App_threadId = threadId;
-
     LOG_INFO("-------------------- START TOGGLE DEBUG TRACES on SERVER/DAEMON SIDE-------------------\n");
     npiMsgData_t pMsg;
     pMsg.len = 1;
@@ -340,12 +343,17 @@ int ZRC_AppInit(int mode, char threadId)
     RTI_TestModeInit(zrcAppReturnFromSubmodule);
 #endif //RTI_TESTMODE
 
-    if (pthread_create(&AppThreadId, NULL, zrcAppThreadFunc, NULL))
+    // Events are handled by the event loop from now on
+    if (reactor_addTimerEvents(ZRC_App_threadId, zrcAppTimerEventCback, NULL) != NPI_LNX_SUCCESS)
     {
-        // thread creation failed
-        LOG_ERROR("Failed to create app thread\n");
+        LOG_ERROR("Failed to add app events to the event loop\n");
         return NPI_LNX_FAILURE;
     }
+
+    LOG_INFO("[ZRC Initialization] ZRC App Started \n");
+
+    //Display menu...
+    DispMenuInit();
 
     return NPI_LNX_SUCCESS;
 }
@@ -354,97 +362,150 @@ void ZRCApp_start_timerEx(uint32 event, uint32 timeout)
 {
     timer_start_timerEx(ZRC_App_threadId, event, timeout);
 }
-
-static int zrcAppInitSyncRes(void)
+
+/**************************************************************************************************
+ *
+ * @fn          zrcAppKeyReleaseLostCback
+ *
+ * @brief       Timer callback, runs in the timer thread when a remote did not
+ *              send a key release in time. Flags the remote and wakes up the
+ *              application thread.
+ *
+ * input parameters
+ *
+ * @param       pArg - remote index
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+static void zrcAppKeyReleaseLostCback(void *pArg)
+{
+    zrcAppKeyReleaseLost[(size_t)pArg] = TRUE;
+    timer_set_event(ZRC_App_threadId, ZRC_APP_EVT_KEY_RELEASE_LOST);
+}
+
+/**************************************************************************************************
+ *
+ * @fn          zrcAppTrackKeyRelease
+ *
+ * @brief       (Re)start tracking of a lost key release for a remote.
+ *
+ * input parameters
+ *
+ * @param       srcIndex - remote index
+ * @param       timeout - time to wait for the release, 0 stops tracking
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+static void zrcAppTrackKeyRelease(uint8 srcIndex, uint32 timeout)
 {
-    // initialize all mutexes
-    if (pthread_mutex_init(&zrcAppThreadMutex, NULL))
+    if (srcIndex >= ZRC_MAX_BOUND_REMOTES)
     {
-        LOG_ERROR("Fail To Initialize Mutex appThreadMutex\n");
-        return NPI_LNX_FAILURE;
+        return;
     }
-
-    if (pthread_mutex_init(&zrcAppInitMutex, NULL))
+
+    timer_start(zrcAppKeyReleaseLostTimer[srcIndex], timeout);
+    if (timeout == 0)
     {
-        LOG_ERROR("Fail To Initialize Mutex appInitMutex\n");
-        return NPI_LNX_FAILURE;
+        // Release received, forget about a timeout that may just have fired
+        zrcAppKeyReleaseLost[srcIndex] = FALSE;
     }
-
-    return NPI_LNX_SUCCESS;
 }
 
-static void *zrcAppThreadFunc(void *ptr)
-{
-    uint32 events = 0;
-
-    /* lock mutex in order not to lose signal */
-    pthread_mutex_lock(&zrcAppThreadMutex);
-    int semRet = 0;
-
-    zrcAppState = AP_STATE_INIT;
-
-    LOG_INFO("[ZRC Initialization] ZRC App Thread Started \n");
+/**************************************************************************************************
+ *
+ * @fn      zrcAppTimerEventCback
+ *
+ * @brief   Event loop callback, handles the events set by timers and callbacks.
+ *
+ * @param   events - pending events
+ * @param   pArg - unused
+ *
+ * @return  void
+ */
+static void zrcAppTimerEventCback(uint32 events, void *pArg)
+{
+    zrcAppProcessEvents(events);
+    LOG_INFO("State: %s [0x%.2X]\n", AppState_list[zrcAppState], zrcAppState);
+}
 
-    //Display menu...
-    DispMenuInit();
-
-    /* thread loop */
-    while (!zrcAppThreadTerminate)
+/**************************************************************************************************
+ *
+ * @fn      ZRC_AppProcessConsoleInput
+ *
+ * @brief   Handle the command in consoleInput, called from the event loop.
+ *
+ * @param   none
+ *
+ * @return  void
+ */
+void ZRC_AppProcessConsoleInput(void)
+{
+    // Only process actions if there is a character available
+    if (consoleInput.handle == MAIN_INPUT_READY)
     {
-        // Wait for event
-        while ((semRet = sem_wait(&eventSem)) == EINTR);
-        if ( semRet != 0)
+        ch = consoleInput.latestCh;
+        strcpy(str, consoleInput.latestStr);
+
+        // 'q' has highest priority
+        if (zrcAppState == AP_STATE_INIT)
         {
-            if (errno != EINVAL)
+            // Let user configure the RNP
+            if ( (ch == 'c') || (ch == 't') )
             {
-                LOG_ERROR("sem_wait errno %d", errno);
+                zrcCfgSetTarget((ch == 't') ? TRUE : FALSE);
+
+                zrcCfgInitConfigParam();
+
+                zrcCfgSetCFGParamOnRNP();
+
+                // Initialize stack
+                zrcAppInitStack();
             }
             else
             {
-                usleep(1000);
-                events = timer_get_event(ZRC_App_threadId);
+                LOG_WARN("Invalid selection\n");
+                DispMenuInit();
             }
         }
-        else
+        else if (zrcAppState == AP_STATE_VALIDATION)
         {
-            events = timer_get_event(ZRC_App_threadId);
+            uint8 txBuf[5] = {0, 0, 0, 0, 0};
+            txBuf[0] = ZRC_CMD_ID_ACTIONS;
+            txBuf[1] = ZRC_ACTION_CTRL_TYPE_START;
+            txBuf[2] = 0; // action payload = 0
+            txBuf[3] = 0; // action bank = HDMI-CEC
+            txBuf[4] = (ch - 0x30) + RTI_CERC_NUM_0;
+            // Send validation digits
+            ZRCApp_SendDataReq( stbDstIndex, RTI_PROFILE_ZRC20,
+                    RTI_VENDOR_TEST_VENDOR,
+                    (RTI_TX_OPTION_ACKNOWLEDGED | RTI_TX_OPTION_SECURITY),
+                    sizeof(txBuf), txBuf, NULL );
         }
+        else if (zrcAppState == AP_STATE_RESET)
+        {
 
-        // Process events
-        if (events != 0)
+        }
+#ifdef RTI_TESTMODE
+        else if (zrcAppState == AP_STATE_LATENCY_TEST_MODE)
         {
-            zrcAppProcessEvents(events);
-            LOG_INFO("State: %s [0x%.2X]\n", AppState_list[zrcAppState], zrcAppState);
+            appTestModeProcessKey(str);
         }
-
-        // Only process actions if there is a character available
-        if (consoleInput.handle == MAIN_INPUT_READY)
+#endif //RTI_TESTMODE
+        else if (ch == 'm')
         {
-            ch = consoleInput.latestCh;
-            strcpy(str, consoleInput.latestStr);
-
-            // 'q' has highest priority
-            if (zrcAppState == AP_STATE_INIT)
-            {
-                // Let user configure the RNP
-                if ( (ch == 'c') || (ch == 't') )
-                {
-                    zrcCfgSetTarget((ch == 't') ? TRUE : FALSE);
-
-                    zrcCfgInitConfigParam();
-
-                    zrcCfgSetCFGParamOnRNP();
-
-                    // Initialize stack
-                    zrcAppInitStack();
-                }
-                else
-                {
-                    LOG_WARN("Invalid selection\n");
-                    DispMenuInit();
-                }
-            }
-            else if (zrcAppState == AP_STATE_VALIDATION)
+            // Display menu
+            DispMenuReady();
+        }
+        else if (zrcAppState == AP_STATE_NDATA)
+        {
+            // Do not allow key presses during transmission
+            LOG_WARN("Busy transmitting, please wait\n");
+        }
+        else if (zrcAppState == AP_STATE_NDATA_PREPARE)
+        {
+            if ( (ch >= 0x30) && (ch <= 0x39) )
             {
                 uint8 txBuf[5] = {0, 0, 0, 0, 0};
                 txBuf[0] = ZRC_CMD_ID_ACTIONS;
@@ -452,339 +513,297 @@ static void *zrcAppThreadFunc(void *ptr)
                 txBuf[2] = 0; // action payload = 0
                 txBuf[3] = 0; // action bank = HDMI-CEC
                 txBuf[4] = (ch - 0x30) + RTI_CERC_NUM_0;
-                // Send validation digits
+                zrcAppState = AP_STATE_NDATA;
+                // Send digits
                 ZRCApp_SendDataReq( stbDstIndex, RTI_PROFILE_ZRC20,
                         RTI_VENDOR_TEST_VENDOR,
                         (RTI_TX_OPTION_ACKNOWLEDGED | RTI_TX_OPTION_SECURITY),
                         sizeof(txBuf), txBuf, NULL );
             }
-            else if (zrcAppState == AP_STATE_RESET)
+            else
             {
+                zrcAppState = AP_STATE_READY;
 
-            }
-#ifdef RTI_TESTMODE
-            else if (zrcAppState == AP_STATE_LATENCY_TEST_MODE)
-            {
-                appTestModeProcessKey(str);
-            }
-#endif //RTI_TESTMODE
-            else if (ch == 'm')
-            {
-                // Display menu
+                LOG_INFO("Entered %s [0x%.2X]\n", AppState_list[zrcAppState], zrcAppState);
+
+                //Display menu...
                 DispMenuReady();
+
             }
-            else if (zrcAppState == AP_STATE_NDATA)
-            {
-                // Do not allow key presses during transmission
-                LOG_WARN("Busy transmitting, please wait\n");
-            }
-            else if (zrcAppState == AP_STATE_NDATA_PREPARE)
+        }
+        else if (ch == '1')
+        {
+            if (zrcAppState == AP_STATE_READY)
             {
-                if ( (ch >= 0x30) && (ch <= 0x39) )
+                // Enter pairing state
+                zrcAppState = AP_STATE_PAIR;
+                if (TRUE == zrcCfgIsTarget())
                 {
-                    uint8 txBuf[5] = {0, 0, 0, 0, 0};
-                    txBuf[0] = ZRC_CMD_ID_ACTIONS;
-                    txBuf[1] = ZRC_ACTION_CTRL_TYPE_START;
-                    txBuf[2] = 0; // action payload = 0
-                    txBuf[3] = 0; // action bank = HDMI-CEC
-                    txBuf[4] = (ch - 0x30) + RTI_CERC_NUM_0;
-                    zrcAppState = AP_STATE_NDATA;
-                    // Send digits
-                    ZRCApp_SendDataReq( stbDstIndex, RTI_PROFILE_ZRC20,
-                            RTI_VENDOR_TEST_VENDOR,
-                            (RTI_TX_OPTION_ACKNOWLEDGED | RTI_TX_OPTION_SECURITY),
-                            sizeof(txBuf), txBuf, NULL );
+                    // Then issue pairing request
+                    RTI_AllowBindReq();
                 }
                 else
                 {
-                    zrcAppState = AP_STATE_READY;
-
-                    LOG_INFO("Entered %s [0x%.2X]\n", AppState_list[zrcAppState], zrcAppState);
-
-                    //Display menu...
-                    DispMenuReady();
-
+                    // Then issue pairing request
+                    RTI_BindReq( zrcBindingType );
                 }
             }
-            else if (ch == '1')
+        }
+        else if (ch == '2')
+        {
+            if (zrcAppState == AP_STATE_READY)
             {
-                if (zrcAppState == AP_STATE_READY)
+                if (zrcAppRNPpowerState & ZRC_APP_RNP_POWER_STATE_NPI_BIT)
                 {
-                    // Enter pairing state
-                    zrcAppState = AP_STATE_PAIR;
-                    if (TRUE == zrcCfgIsTarget())
-                    {
-                        // Then issue pairing request
-                        RTI_AllowBindReq();
-                    }
-                    else
-                    {
-                        // Then issue pairing request
-                        RTI_BindReq( zrcBindingType );
-                    }
+                    // Warn user of sleep
+                    LOG_WARN("Cannot call RTI_UnpairReq because NPI is in sleep\n");
+                }
+                else {
+                    zrcAppState = AP_STATE_UNPAIR;
+                    // Unpair
+                    LOG_INFO("Calling RTI_UnpairReq for index %d\n", stbDstIndex);
+                    RTI_UnpairReq(stbDstIndex);
                 }
             }
-            else if (ch == '2')
+            else
             {
-                if (zrcAppState == AP_STATE_READY)
-                {
-                    if (zrcAppRNPpowerState & ZRC_APP_RNP_POWER_STATE_NPI_BIT)
-                    {
-                        // Warn user of sleep
-                        LOG_WARN("Cannot call RTI_UnpairReq because NPI is in sleep\n");
-                    }
-                    else {
-                        zrcAppState = AP_STATE_UNPAIR;
-                        // Unpair
-                        LOG_INFO("Calling RTI_UnpairReq for index %d\n", stbDstIndex);
-                        RTI_UnpairReq(stbDstIndex);
-                    }
-                }
-                else
-                {
-                    // Simply remain in whatever state we're in
-                    LOG_INFO("Cannot call RTI_UnpairReq, because we're in state: 0x%.2X\n", zrcAppState);
-                }
+                // Simply remain in whatever state we're in
+                LOG_INFO("Cannot call RTI_UnpairReq, because we're in state: 0x%.2X\n", zrcAppState);
             }
-            else if (ch == '3')
+        }
+        else if (ch == '3')
+        {
+            if (zrcAppState == AP_STATE_READY)
             {
-                if (zrcAppState == AP_STATE_READY)
-                {
-                    zrcAppState = AP_STATE_LATENCY_TEST_MODE;
-                    LOG_INFO("Entering Test Mode\n");
-                    RTI_EnterTestMode();
-                }
-                else
-                {
-                    LOG_WARN("Cannot enter testmode, because we're in state: 0x%.2X\n", zrcAppState);
-                }
+                zrcAppState = AP_STATE_LATENCY_TEST_MODE;
+                LOG_INFO("Entering Test Mode\n");
+                RTI_EnterTestMode();
+            }
+            else
+            {
+                LOG_WARN("Cannot enter testmode, because we're in state: 0x%.2X\n", zrcAppState);
+            }
+        }
+        else if ((ch == 'h') ||
+                (ch == 'j') ||
+                (ch == 'k') ||
+                (ch == 'l'))
+        {
+            // Set channel
+            uint8 channel, faEnable = FALSE, status = RTI_SUCCESS;
+            if (ch == 'l')
+            {
+                faEnable = TRUE;
+                status = RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_AGILITY_ENABLE, 1, (uint8 *)&faEnable);
+                LOG_INFO("Frequency Agility re-enabled (%s)\n", rtiStatus_list[status]);
             }
-            else if ((ch == 'h') ||
-                    (ch == 'j') ||
-                    (ch == 'k') ||
-                    (ch == 'l'))
+            else
             {
-                // Set channel
-                uint8 channel, faEnable = FALSE, status = RTI_SUCCESS;
-                if (ch == 'l')
+                if (ch == 'h')
                 {
-                    faEnable = TRUE;
-                    status = RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_AGILITY_ENABLE, 1, (uint8 *)&faEnable);
-                    LOG_INFO("Frequency Agility re-enabled (%s)\n", rtiStatus_list[status]);
+                    channel = 15;
                 }
-                else
+                else if (ch == 'j')
                 {
-                    if (ch == 'h')
-                    {
-                        channel = 15;
-                    }
-                    else if (ch == 'j')
-                    {
-                        channel = 20;
-                    }
-                    else if (ch == 'k')
-                    {
-                        channel = 25;
-                    }
-                    status = RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_AGILITY_ENABLE, 1, (uint8 *)&faEnable);
-                    LOG_INFO("Frequency Agility disabled (%s)\n", rtiStatus_list[status]);
-                    if (status == RTI_SUCCESS)
-                    {
-                        RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_CURRENT_CHANNEL, 1, (uint8 *)&channel);
-                        LOG_INFO("Channel set to %d\n", channel);
-                    }
+                    channel = 20;
                 }
-            }
-            else if (ch == 'f')
-            {
-                // Find my remote feature
-                uint8 len;
-                uint8 *pMsg;
-                if (zrcCfgGetIdentificationClientCapabilities())
+                else if (ch == 'k')
                 {
-                    LOG_INFO("[POLL] Preparing outgoing data\n");
-                    zrcBuildIdentifyClientNotificationCmd( &len, &pMsg );
-                    zrcMsgQueue_push( pMsg, len, RTI_PROFILE_GDP);
+                    channel = 25;
                 }
-                else
+                status = RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_AGILITY_ENABLE, 1, (uint8 *)&faEnable);
+                LOG_INFO("Frequency Agility disabled (%s)\n", rtiStatus_list[status]);
+                if (status == RTI_SUCCESS)
                 {
-                    LOG_WARN("[POLL] Cannot preparing outgoing data as no polling is configured\n");
+                    RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_CURRENT_CHANNEL, 1, (uint8 *)&channel);
+                    LOG_INFO("Channel set to %d\n", channel);
                 }
             }
-            else if (ch == 's')
+        }
+        else if (ch == 'f')
+        {
+            // Find my remote feature
+            uint8 len;
+            uint8 *pMsg;
+            if (zrcCfgGetIdentificationClientCapabilities())
             {
-                // Let RNP know we enter sleep
-                LOG_INFO("Calling RTI_EnableSleepReq\n");
-                RTI_EnableSleepReq();
+                LOG_INFO("[POLL] Preparing outgoing data\n");
+                zrcBuildIdentifyClientNotificationCmd( &len, &pMsg );
+                zrcMsgQueue_push( pMsg, len, RTI_PROFILE_GDP);
             }
-            else if (ch == 'p')
+            else
             {
-                // Acknowledge waking up on GPIO
-                LOG_INFO("Calling RTI_PingReq\n");
-                RTI_PingReq();
+                LOG_WARN("[POLL] Cannot preparing outgoing data as no polling is configured\n");
             }
-            else if (ch == 'c')
-            {
-                // Prepare connection request
-                npiMsgData_t pMsg;
-                pMsg.subSys = RPC_SYS_SRV_CTRL;
-                pMsg.cmdId  = NPI_LNX_CMD_ID_CONNECT_DEVICE;
-                pMsg.len    = 1;
+        }
+        else if (ch == 's')
+        {
+            // Let RNP know we enter sleep
+            LOG_INFO("Calling RTI_EnableSleepReq\n");
+            RTI_EnableSleepReq();
+        }
+        else if (ch == 'p')
+        {
+            // Acknowledge waking up on GPIO
+            LOG_INFO("Calling RTI_PingReq\n");
+            RTI_PingReq();
+        }
+        else if (ch == 'c')
+        {
+            // Prepare connection request
+            npiMsgData_t pMsg;
+            pMsg.subSys = RPC_SYS_SRV_CTRL;
+            pMsg.cmdId  = NPI_LNX_CMD_ID_CONNECT_DEVICE;
+            pMsg.len    = 1;
 
-                pMsg.pData[0] = NPI_SERVER_DEVICE_INDEX_SPI;
-                LOG_INFO("Connecting to %d ...", pMsg.pData[0]);
+            pMsg.pData[0] = NPI_SERVER_DEVICE_INDEX_SPI;
+            LOG_INFO("Connecting to %d ...", pMsg.pData[0]);
 
-                NPI_SendSynchData( &pMsg );
-                LOG_INFO("status %d\n", pMsg.pData[0]);
-            }
-            else if (ch == 'd')
+            NPI_SendSynchData( &pMsg );
+            LOG_INFO("status %d\n", pMsg.pData[0]);
+        }
+        else if (ch == 'd')
+        {
+            // Set debug level
+            char *strDigit;
+            // First call will give 'd'
+            strDigit = strtok(str, " -:");
+            if (strDigit != NULL)
             {
-                // Set debug level
-                char *strDigit;
-                // First call will give 'd'
-                strDigit = strtok(str, " -:");
+                // Second call will give the level to use for debugging
+                strDigit = strtok(NULL, " -:");
+
                 if (strDigit != NULL)
                 {
-                    // Second call will give the level to use for debugging
-                    strDigit = strtok(NULL, " -:");
-
-                    if (strDigit != NULL)
-                    {
-                        __APP_LOG_LEVEL = strtol(strDigit, NULL, 10);
-                        LOG_INFO("Debug level set to %d\n", __APP_LOG_LEVEL);
-                    }
-                    else
-                    {
-                        LOG_WARN("Debug level could not be set, please provide valid input\n");
-                    }
+                    __APP_LOG_LEVEL = strtol(strDigit, NULL, 10);
+                    LOG_INFO("Debug level set to %d\n", __APP_LOG_LEVEL);
                 }
                 else
                 {
                     LOG_WARN("Debug level could not be set, please provide valid input\n");
                 }
             }
-            else if (ch == '8')
+            else
             {
-                if (zrcAppRNPpowerState & ZRC_APP_RNP_POWER_STATE_NPI_BIT)
-                {
-                    // Warn user of sleep
-                    LOG_WARN("Cannot clear pairing table because NPI is in sleep\n");
-                }
-                else
-                {
-                    // Read out and display all pairing entries
-                    zrcCfgClearPairingTable();
-                }
+                LOG_WARN("Debug level could not be set, please provide valid input\n");
             }
-            else if (ch == '9')
+        }
+        else if (ch == '8')
+        {
+            if (zrcAppRNPpowerState & ZRC_APP_RNP_POWER_STATE_NPI_BIT)
             {
-                if (zrcAppRNPpowerState & ZRC_APP_RNP_POWER_STATE_NPI_BIT)
-                {
-                    // Warn user of sleep
-                    LOG_WARN("Cannot display pairing table because NPI is in sleep\n");
-                }
-                else
-                {
-                    // Read out and display all pairing entries
-                    zrcCfgDisplayPairingTable();
-                }
+                // Warn user of sleep
+                LOG_WARN("Cannot clear pairing table because NPI is in sleep\n");
             }
-            else if (ch == '4')
+            else
             {
-                uint8           baseVersion;
-                swVerExtended_t rnpSwVerExtended;
-
-                LOG_INFO("-------------------- START SOFTWARE VERSION READING-------------------\n");
-                zrcAppGetAndPrintSoftwareVersions(&baseVersion, &rnpSwVerExtended);
-                LOG_INFO("-------------------- END SOFTWARE VERSION READING-------------------\n");
-
-                DispMenuReady();
+                // Read out and display all pairing entries
+                zrcCfgClearPairingTable();
             }
-            else if (ch == 'r')
+        }
+        else if (ch == '9')
+        {
+            if (zrcAppRNPpowerState & ZRC_APP_RNP_POWER_STATE_NPI_BIT)
             {
-                timer_set_event(ZRC_App_threadId, ZRC_APP_EVT_RESET);
-
-                // Schedule event to Init RNP.
-                //                DispMenuReady();
+                // Warn user of sleep
+                LOG_WARN("Cannot display pairing table because NPI is in sleep\n");
             }
-            else if (ch == 't')
+            else
             {
-                npiMsgData_t pMsg;
-                pMsg.len = 1;
-                pMsg.subSys = RPC_SYS_SRV_CTRL | RPC_CMD_SREQ;
-                pMsg.cmdId = NPI_LNX_CMD_ID_CTRL_TIME_PRINT_REQ;
+                // Read out and display all pairing entries
+                zrcCfgDisplayPairingTable();
+            }
+        }
+        else if (ch == '4')
+        {
+            uint8           baseVersion;
+            swVerExtended_t rnpSwVerExtended;
+
+            LOG_INFO("-------------------- START SOFTWARE VERSION READING-------------------\n");
+            zrcAppGetAndPrintSoftwareVersions(&baseVersion, &rnpSwVerExtended);
+            LOG_INFO("-------------------- END SOFTWARE VERSION READING-------------------\n");
 
-                if (toggleTimerPrintOnServer == FALSE)
-                {
-                    // Turn timer debug ON
-                    toggleTimerPrintOnServer = TRUE;
-                }
-                else
-                {
-                    // Turn timer debug OFF
-                    toggleTimerPrintOnServer = FALSE;
-                }
+            DispMenuReady();
+        }
+        else if (ch == 'r')
+        {
+            timer_set_event(ZRC_App_threadId, ZRC_APP_EVT_RESET);
 
-                pMsg.pData[0] = toggleTimerPrintOnServer;
+            // Schedule event to Init RNP.
+            //                DispMenuReady();
+        }
+        else if (ch == 't')
+        {
+            npiMsgData_t pMsg;
+            pMsg.len = 1;
+            pMsg.subSys = RPC_SYS_SRV_CTRL | RPC_CMD_SREQ;
+            pMsg.cmdId = NPI_LNX_CMD_ID_CTRL_TIME_PRINT_REQ;
 
-                // send debug flag value
-                NPI_SendSynchData( &pMsg );
-                if (RTI_SUCCESS == pMsg.pData[0])
-                {
-                    LOG_INFO("__DEBUG_TIME_ACTIVE set to: 0x%.2X\n", toggleTimerPrintOnServer);
-                }
+            if (toggleTimerPrintOnServer == FALSE)
+            {
+                // Turn timer debug ON
+                toggleTimerPrintOnServer = TRUE;
             }
-            else if (ch == 'y')
+            else
             {
-                npiMsgData_t pMsg;
-                pMsg.len = 1;
-                pMsg.subSys = RPC_SYS_SRV_CTRL | RPC_CMD_SREQ;
-                pMsg.cmdId = NPI_LNX_CMD_ID_CTRL_BIG_DEBUG_PRINT_REQ;
+                // Turn timer debug OFF
+                toggleTimerPrintOnServer = FALSE;
+            }
 
-                if (toggleBigDebugPrintOnServer == FALSE)
-                {
-                    // Turn timer debug ON
-                    toggleBigDebugPrintOnServer = TRUE;
-                }
-                else
-                {
-                    // Turn timer debug OFF
-                    toggleBigDebugPrintOnServer = FALSE;
-                }
+            pMsg.pData[0] = toggleTimerPrintOnServer;
 
-                pMsg.pData[0] = toggleBigDebugPrintOnServer;
+            // send debug flag value
+            NPI_SendSynchData( &pMsg );
+            if (RTI_SUCCESS == pMsg.pData[0])
+            {
+                LOG_INFO("__DEBUG_TIME_ACTIVE set to: 0x%.2X\n", toggleTimerPrintOnServer);
+            }
+        }
+        else if (ch == 'y')
+        {
+            npiMsgData_t pMsg;
+            pMsg.len = 1;
+            pMsg.subSys = RPC_SYS_SRV_CTRL | RPC_CMD_SREQ;
+            pMsg.cmdId = NPI_LNX_CMD_ID_CTRL_BIG_DEBUG_PRINT_REQ;
 
-                // send debug flag value
-                NPI_SendSynchData( &pMsg );
-                if (RTI_SUCCESS == pMsg.pData[0])
-                {
-                    LOG_INFO("__BIG_DEBUG_ACTIVE set to: 0x%.2X\n", toggleBigDebugPrintOnServer);
-                }
+            if (toggleBigDebugPrintOnServer == FALSE)
+            {
+                // Turn timer debug ON
+                toggleBigDebugPrintOnServer = TRUE;
             }
-            else if (ch != '\n')
+            else
             {
-                LOG_WARN("unknown command %c (0x%.2X) \n", ch, ch);
-                DispMenuReady();
+                // Turn timer debug OFF
+                toggleBigDebugPrintOnServer = FALSE;
             }
 
-            // 'q' requires special attention, hence it is not part of if/else
-            if (ch == 'q')
+            pMsg.pData[0] = toggleBigDebugPrintOnServer;
+
+            // send debug flag value
+            NPI_SendSynchData( &pMsg );
+            if (RTI_SUCCESS == pMsg.pData[0])
             {
-                //Terminate Thread
-                zrcAppThreadTerminate = 1;
-                //Terminate Thread and exit everything
+                LOG_INFO("__BIG_DEBUG_ACTIVE set to: 0x%.2X\n", toggleBigDebugPrintOnServer);
             }
+        }
+        else if (ch != '\n')
+        {
+            LOG_WARN("unknown command %c (0x%.2X) \n", ch, ch);
+            DispMenuReady();
+        }
 
-            // Release handle at the end to indicate to main thread that character is processed
-            consoleInput.handle = MAIN_INPUT_RELEASED;
+        // 'q' requires special attention, hence it is not part of if/else
+        if (ch == 'q')
+        {
+            //Terminate event loop and exit everything
+            reactor_stop();
         }
 
+        // Release handle at the end to indicate to main thread that character is processed
+        consoleInput.handle = MAIN_INPUT_RELEASED;
     }
-    pthread_mutex_unlock(&zrcAppThreadMutex);
-
-    return NULL;
-}
-
+}
+
 /**************************************************************************************************
  *
  * @fn      zrcAppInitStack
@@ -797,19 +816,8 @@ static void *zrcAppThreadFunc(void *ptr)
  */
 static void zrcAppInitStack()
 {
-    int mutexRet = 0;
     // Initialize node and RF4CE stack
     LOG_INFO("Calling RTI_InitReq...\n");
-    //When Launching the Thread, Mutex is unlocked.
-    LOG_DEBUG("[MUTEX] Lock zrcAppInit Mutex\n");
-    if ((mutexRet = pthread_mutex_trylock(&zrcAppInitMutex)) == EBUSY)
-    {
-        LOG_ERROR("[MUTEX] zrcAppInit Mutex busy\n");
-    }
-    else
-    {
-        LOG_DEBUG("[MUTEX] zrcAppInit Lock status: %d\n", mutexRet);
-    }
     // Check if the firmware was previously incorrectly initialized. This is a specific spot check with limited scope.
     uint8 routeToApp = FALSE, startupFlg = CLEAR_STATE, retVal;
     retVal = RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_ROUTE_DISCOVERY_TO_APP, 1, (uint8 *)&routeToApp);
@@ -832,10 +840,9 @@ static void zrcAppInitStack()
     }
     // Then call initialize stack
     RTI_InitReq();
+    // RTI_InitCnf() is handled by the event loop once it arrives, the
+    // application state machine keeps other actions out until then.
     LOG_INFO("...Waiting for RTI_InitCnf. (can take up to 6s if cold start and target RNP)...\n");
-    //Mutex is unlocked only inside RTI_Initcnf(); So this would effectively prevent application from continuing until initialization is complete
-    pthread_mutex_lock(&zrcAppInitMutex);
-    pthread_mutex_unlock(&zrcAppInitMutex);
 }
 
 /**************************************************************************************************
@@ -914,23 +921,25 @@ static void zrcAppProcessEvents(uint32 events)
         RTI_ResetInd();
     }
 
-    if (events & ZRC_APP_EVT_KEY_RELEASE_LOST_MASK)
+    if (events & ZRC_APP_EVT_KEY_RELEASE_LOST)
     {
+        // Prepare to clear event
+        procEvents |= ZRC_APP_EVT_KEY_RELEASE_LOST;
+
         // At least one release key was missed, report them all to IARM
         uint8 remoteIndex;
         for (remoteIndex = 0; remoteIndex < ZRC_MAX_BOUND_REMOTES; remoteIndex++)
         {
-            if (events & ZRC_APP_EVT_KEY_RELEASE_LOST(remoteIndex))
+            if (zrcAppKeyReleaseLost[remoteIndex])
             {
+                zrcAppKeyReleaseLost[remoteIndex] = FALSE;
+
                 /*********************************************************
                  * Indicate lost Key release
                  */
                 LOG_INFO("Lost Event Key: code 0x%.2x, remoteId %d\n",
                         zrcCfgGetLastKeypressCommand(remoteIndex),
                         remoteIndex);
-
-                // Prepare to clear event
-                procEvents |= ZRC_APP_EVT_KEY_RELEASE_LOST(remoteIndex);
             }
         }
     }
@@ -1057,10 +1066,6 @@ void RTI_InitCnf(rStatus_t status)
         // Schedule event to try again.
         timer_start_timerEx(ZRC_App_threadId, ZRC_APP_EVT_INIT, 1200); // Retry initialization after 1.2 seconds
     }
-
-    //Unlock Mutex So that Application can continue
-    LOG_DEBUG("[MUTEX] Unlock zrcAppInit Mutex\n");
-    pthread_mutex_unlock(&zrcAppInitMutex);
 }
 
 /**************************************************************************************************
@@ -1306,12 +1311,12 @@ void RTI_ReceiveDataInd(uint8 srcIndex, uint8 profileId, uint16 vendorId,
             if ((pData[0] == RTI_CERC_USER_CONTROL_PRESSED) || (pData[0] == RTI_CERC_USER_CONTROL_REPEATED))
             {
                 // Track lost release
-                timer_start_timerEx(ZRC_App_threadId, ZRC_APP_EVT_KEY_RELEASE_LOST(srcIndex), ZRC_APP_KEY_RELEASE_LOST_TIMEOUT);
+                zrcAppTrackKeyRelease(srcIndex, ZRC_APP_KEY_RELEASE_LOST_TIMEOUT);
             }
             else
             {
-                // Release received, stop timer by setting timer to 0
-                timer_start_timerEx(ZRC_App_threadId, ZRC_APP_EVT_KEY_RELEASE_LOST(srcIndex), 0);
+                // Release received, stop timer
+                zrcAppTrackKeyRelease(srcIndex, 0);
             }
         }
         else if (pData[0] == 0x50)
@@ -1400,8 +1405,8 @@ static void zrcAppProcessZRC20ProfileData(uint8 srcIndex, uint8 len, uint8 *pDat
         if (pBuf == pEndBuf)
         {
             LOG_INFO("[ZRC 2.0][%d][%3d dBm] Key released.\n", srcIndex, ZRC_APP_LQI_TO_DBM_CONVERSION(rxLQI));
-            // Release received, stop timer by setting timer to 0
-            timer_start_timerEx(ZRC_App_threadId, ZRC_APP_EVT_KEY_RELEASE_LOST(srcIndex), 0);
+            // Release received, stop timer
+            zrcAppTrackKeyRelease(srcIndex, 0);
         }
         else
         {
@@ -1506,13 +1511,13 @@ static void zrcAppProcessZRC20ProfileData(uint8 srcIndex, uint8 len, uint8 *pDat
 
                             if (actionType == ZRC_ACTION_CTRL_TYPE_ATOMIC)
                             {
-                                // Release received, stop timer by setting timer to 0
-                                timer_start_timerEx(ZRC_App_threadId, ZRC_APP_EVT_KEY_RELEASE_LOST(srcIndex), 0);
+                                // Release received, stop timer
+                                zrcAppTrackKeyRelease(srcIndex, 0);
                             }
                             else
                             {
                                 // Key repeat timer handled by IR Manager, but not lost release
-                                timer_start_timerEx(ZRC_App_threadId, ZRC_APP_EVT_KEY_RELEASE_LOST(srcIndex), ZRC_APP_KEY_RELEASE_LOST_TIMEOUT);
+                                zrcAppTrackKeyRelease(srcIndex, ZRC_APP_KEY_RELEASE_LOST_TIMEOUT);
                             }
                         }
                     }
@@ -2059,7 +2064,7 @@ void RTI_ResetInd(void)
     // RNP is now back in default state
     zrcAppRNPpowerState = ZRC_APP_RNP_POWER_STATE_ACTIVE;
 
-    // Perform initialization from timer thread context, not AREQ thread context (which would prevent RTI_InitCnf() to be called)
+    // Perform initialization from the event handler, not from within this AREQ callback
     timer_set_event(ZRC_App_threadId, ZRC_APP_EVT_INIT);
     // Warn user of reset
     LOG_INFO("Timed init request started\n");
@@ -94,8 +94,7 @@ extern "C" {
 
 #define ZRC_APP_EVT_SEND_SET_GET_ATTR_RESPONSE         0x00100000 // Event to send Set/Get Attributes Response
 
-#define ZRC_APP_EVT_KEY_RELEASE_LOST_MASK              0xFF000000 // The upper 8 events are reserved for tracking lost key presses
-#define ZRC_APP_EVT_KEY_RELEASE_LOST(key)              (1 << (24 + key))
+#define ZRC_APP_EVT_KEY_RELEASE_LOST                   0x01000000 // At least one remote lost a key release, see zrcAppKeyReleaseLost[]
 
 #define ZRC_APP_SEND_GET_ATTR_RESPONSE_WAIT_TIME       1 // Set to 1ms because of delays in serial communication. Wait 20ms before transmitting the response
 #define ZRC_APP_SEND_SET_ATTR_RESPONSE_WAIT_TIME       20 // Wait 20ms before transmitting the response
@@ -255,6 +254,7 @@ extern const char * const AppState_list[AP_STATE_READY + 1];//18 Application Sta
 // Function declarations
 
 extern int ZRC_AppInit( int mode, char threadId );
+extern void ZRC_AppProcessConsoleInput( void );
 extern void ZRCApp_start_timerEx(uint32 event, uint32 timeout);
 extern void zrc_appTestModeProcessKey (char* strIn);
 
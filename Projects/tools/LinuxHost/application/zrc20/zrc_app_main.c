@@ -40,7 +40,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <getopt.h>
-#include <poll.h>
 
 
 // Linux surrogate interface
@@ -50,6 +49,7 @@
 
 #include "zrc_app_main.h"
 #include "timer.h"
+#include "reactor.h"
 #include "tiLogging.h"
 
 #include "hal_rpc.h"
@@ -59,7 +59,6 @@
 
 #define NAME_ELEMENT(element) [element] = #element
 
-struct pollfd fds[1];
 const char *device = "";
 const char *debugOption = "";
 char *imagePath = "";
@@ -84,6 +83,38 @@ static void print_usage(const char *prog) {
     exit(1);
 }
 
+/**************************************************************************************************
+ *
+ * @fn      zrcMainInputCback
+ *
+ * @brief   Event loop callback for a line typed on the console.
+ *
+ * @param   pLine - line without the newline character
+ * @param   pArg - unused
+ *
+ * @return  void
+ */
+static void zrcMainInputCback(char *pLine, void *pArg)
+{
+    strncpy(consoleInput.latestStr, pLine, sizeof(consoleInput.latestStr) - 1);
+    consoleInput.latestStr[sizeof(consoleInput.latestStr) - 1] = '\0';
+    consoleInput.latestCh = consoleInput.latestStr[0];
+    if (consoleInput.latestCh == 'q')
+    {
+        reactor_stop();
+        return;
+    }
+    // Do not act on -1, . and new line (\n)
+    if ( (consoleInput.latestCh != -1)
+            && (consoleInput.latestCh != '.')
+            && (consoleInput.latestCh != '\n') )
+    {
+        // Let the application handle the input right away
+        consoleInput.handle = MAIN_INPUT_READY;
+        ZRC_AppProcessConsoleInput();
+    }
+}
+
 static void parse_opts(int argc, char *argv[])
 {
     while (1)
@@ -137,22 +168,31 @@ int main(int argc, char **argv)
     consoleInput.latestCh = ' ';
     consoleInput.handle = MAIN_INPUT_RELEASED;
 
-    // setup filedescriptor for stdin
-    fds[0].fd = fileno(stdin);
-    fds[0].events = POLLIN;
-
     parse_opts(argc, argv);
 
     // Initialize shared semaphore. Must happen before program begins execution
     sem_init(&eventSem,0,1);
 
+    // The application, the NPI client and the timers all run on one event loop
+    if ((ret = reactor_init()) != NPI_LNX_SUCCESS)
+    {
+        LOG_FATAL("Failed to create event loop\n");
+        return ret;
+    }
+
     // Initialize Network Processor Interface.
-    if ((ret = NPI_ClientInit(device)) != NPI_LNX_SUCCESS)
+    if ((ret = NPI_ClientInitEventLoop(device)) != NPI_LNX_SUCCESS)
     {
         LOG_FATAL("Failed to start NPI library module, device; %s\n", device);
         print_usage(argv[0]);
         return ret;
     }
+
+    if ((ret = timer_initEventLoop(ZRC_main_threadId_tblSize)) != 0)
+    {
+        LOG_FATAL("Failed to start timers. Exiting...");
+        return ret;
+    }
 
     // Toggle Timer Print on Server state variable
     uint8 mode = 0;
@@ -172,77 +212,32 @@ int main(int argc, char **argv)
         mode = 1;
     }
 
-    //Start ZRC thread, management of RTI command in separate thread.
+    //Start ZRC application, its events are handled by the event loop.
     if ((ret = ZRC_AppInit(mode, ZRC_App_threadId)) != 0)
     {
         return ret;
     }
-
-    LOG_INFO("Starting timer thread\n");
-
-    //Start MAC timer thread, management of timer in separate thread.
-    // No Timer for Mac for now...
-    if ((ret = timer_init(ZRC_main_threadId_tblSize)) != 0)
-    {
-        LOG_FATAL("Failed to start timer thread. Exiting...");
-        return ret;
-    }
-
+
     //first Menu will be display at the end of the RNP initialization.
-
-    int pollRet;
-
-    //MANAGE MAIN DISPLAY HERE
-    // Equivalent to OSAL Main Loop
-    while (1) 
+
+    if (((ret = reactor_addNpiClient()) != NPI_LNX_SUCCESS) ||
+            ((ret = reactor_addStdin(zrcMainInputCback, NULL)) != NPI_LNX_SUCCESS))
     {
-        //Wait for Display Mutex release before displaying anything.
-        //pthread_mutex_lock(&appDisplayMutex);
-        //pthread_mutex_unlock(&appDisplayMutex);
-
-        //Check Display buffer, if not empty display one element
-//        if (first_start)
-//        {
-//            consoleInput.handle = MAIN_INPUT_READY;
-//            sem_post(&eventSem);
-//            first_start=0;
-//        }
-
-        // Check for input characters, timeout after 500ms
-        pollRet = poll(fds, 1, 500);
-        if ((pollRet == 1) && (consoleInput.handle == MAIN_INPUT_RELEASED))
-        {
-            fgets(consoleInput.latestStr, sizeof(consoleInput.latestStr), stdin);
-            // Remove \n character from string
-            char* p;
-            if ( (p= strchr(consoleInput.latestStr, '\n')) != NULL)
-                *p = '\0';
-            consoleInput.latestCh = consoleInput.latestStr[0];
-            if (consoleInput.latestCh == 'q')
-            {
-                ret = 0;
-                break;
-            }
-            // Do not act on -1, . and new line (\n)
-            if ( (consoleInput.latestCh != -1)
-                    && (consoleInput.latestCh != '.')
-                    && (consoleInput.latestCh != '\n') )
-            {
-                // Indicate to application thread that the input is ready
-                consoleInput.handle = MAIN_INPUT_READY;
-                // Release resources waiting for this event
-                LOG_DEBUG("POSTING EVENT\n");
-                if (sem_post(&eventSem) < 0)
-                {
-                    LOG_ERROR("[MAIN] Failed to post semaphore %p\n", &eventSem);
-                }
-            }
-//            LOG_DEBUG("Character read: \t%c, int: %d\n", consoleInput.latestCh,
-//                    consoleInput.latestCh);
-//            LOG_DEBUG("String read: \t%s\n", consoleInput.latestStr,
-//                    consoleInput.latestStr);
-        }
-//        LOG_DEBUG("poll returned: %d; console handle: %d\n", pollRet, consoleInput.handle);
+        LOG_FATAL("Failed to set up event loop. Exiting...");
+        return ret;
+    }
+
+    // Equivalent to OSAL Main Loop, returns when 'q' is entered
+    ret = reactor_run();
+    reactor_close();
+
+    uint8 source;
+    for (source = 0; source < REACTOR_NUM_SOURCES; source++)
+    {
+        uint32 count, avgUs, maxUs;
+        reactor_getStats(source, &count, &avgUs, &maxUs);
+        LOG_INFO("[MAIN] Event loop source %d: %u callbacks, wake-up to callback avg %uus max %uus\n",
+                source, count, avgUs, maxUs);
     }
 
     // Destroy semaphores
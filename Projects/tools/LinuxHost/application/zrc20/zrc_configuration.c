@@ -641,150 +641,82 @@ void zrcCfgSetCFGParamOnRNP(void)
     // Apply Configuration Parameters //
     ////////////////////////////////////
 
-    LOG_INFO("[Configuration] -------------------- SET RNP CONFIGURATION PARAMETERS-------------------\n");
-    if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_CAPABILITIES, 1,
-            (uint8*) &(zrcCfgCFGParam.devInfo.nodeCapabilities)) != RTI_SUCCESS) {
-        //   AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Could not write RTI_CP_ITEM_NODE_CAPABILITIES\n");
-    } else
-        LOG_DEBUG("[Configuration] Successfully wrote RTI_CP_ITEM_NODE_CAPABILITIES\n");
-
-    if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES,
-            RTI_MAX_NUM_SUPPORTED_TGT_TYPES,
-            zrcCfgCFGParam.devInfo.tgtTypeList) != RTI_SUCCESS) {
-        ///AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Could not write RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES\n");
-    } else
-        LOG_DEBUG("[Configuration] Successfully wrote RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES\n");
-
-    if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_CAPABILITIES, 1,
-            (uint8*) &(zrcCfgCFGParam.devInfo.appCapabilities)) != RTI_SUCCESS) {
-        // AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Could not write RTI_CP_ITEM_APPL_CAPABILITIES\n");
-    } else
-        LOG_DEBUG("[Configuration] Successfully wrote RTI_CP_ITEM_APPL_CAPABILITIES\n");
-
-    if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_DEV_TYPE_LIST,
-            RTI_MAX_NUM_DEV_TYPES, zrcCfgCFGParam.devInfo.devTypeList) != RTI_SUCCESS) {
-        //   AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Could not write RTI_CP_ITEM_APPL_DEV_TYPE_LIST\n");
-    } else
-        LOG_DEBUG("[Configuration] Successfully wrote RTI_CP_ITEM_APPL_DEV_TYPE_LIST\n");
-
-    if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_PROFILE_ID_LIST,
-            RTI_MAX_NUM_PROFILE_IDS, zrcCfgCFGParam.devInfo.profileIdList) != RTI_SUCCESS) {
-        //    AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Could not write RTI_CP_ITEM_APPL_PROFILE_ID_LIST\n");
-    } else
-        LOG_DEBUG("[Configuration] Successfully wrote RTI_CP_ITEM_APPL_PROFILE_ID_LIST\n");
-
-    if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_ID, 2,
-            (uint8*) &(zrcCfgCFGParam.devInfo.vendorId)) != RTI_SUCCESS) {
-        //  AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Could not write RTI_CP_ITEM_VENDOR_ID\n");
-    } else
-        LOG_DEBUG("[Configuration] Successfully wrote RTI_CP_ITEM_VENDOR_ID\n");
-
-    if (RTI_WriteItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_NAME,
-            sizeof(vendorName), zrcCfgCFGParam.devInfo.vendorString) != RTI_SUCCESS) {
-        //  AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Could not write RTI_CP_ITEM_VENDOR_NAME\n");
-    } else
-        LOG_DEBUG("[Configuration] Successfully wrote RTI_CP_ITEM_VENDOR_NAME\n");
-
-    if (RTI_WriteItemEx( RTI_PROFILE_ZRC20,
-                       ZRC_ITEM_ZRC_PROFILE_CAPABILITIES,
-                       sizeof( zrcCfgCFGParam.zrcInfo.zrcCapabilities ),
-                       (uint8 *)&zrcCfgCFGParam.zrcInfo.zrcCapabilities ) != RTI_SUCCESS)
-    {
-        //  AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Could not write ZRC_ITEM_ZRC_PROFILE_CAPABILITIES\n");
-    }
-    else
-    {
-        LOG_DEBUG("[Configuration] Successfully wrote ZRC_ITEM_ZRC_PROFILE_CAPABILITIES\n");
-    }
-
-    // Action Banks supported
-    if (RTI_WriteItemEx( RTI_PROFILE_ZRC20,
-            ZRC_ITEM_ACTION_BANKS_SUPPORTED_RX,
-            ZRC_ATTR_LEN_ACTION_BANKS_SUPPORTED,
-            zrcCfgCFGParam.zrcInfo.actionBanksSupported ) != RTI_SUCCESS)
-    {
-        //  AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Could not write ZRC_ITEM_ACTION_BANKS_SUPPORTED_RX\n");
-    }
-    else
-    {
-        LOG_DEBUG("[Configuration] Successfully wrote ZRC_ITEM_ACTION_BANKS_SUPPORTED_RX\n");
-    }
-
-    if (RTI_WriteItemEx( RTI_PROFILE_GDP,
-            GDP_ITEM_PRIMARY_CLASS_DESCRIPTOR,
-            sizeof(zrcCfgCFGParam.gdpInfo.primaryClassDescriptor),
-            (uint8 *)&zrcCfgCFGParam.gdpInfo.primaryClassDescriptor ) != RTI_SUCCESS)
-    {
-        //  AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Could not write GDP_ITEM_PRIMARY_CLASS_DESCRIPTOR\n");
-    }
-    else
-    {
-        LOG_DEBUG("[Configuration] Successfully wrote GDP_ITEM_PRIMARY_CLASS_DESCRIPTOR\n");
-    }
-
-    if (RTI_WriteItemEx( RTI_PROFILE_GDP,
-            GDP_ITEM_SECONDARY_CLASS_DESCRIPTOR,
-            sizeof(zrcCfgCFGParam.gdpInfo.secondaryClassDescriptor),
-            (uint8 *)&zrcCfgCFGParam.gdpInfo.secondaryClassDescriptor ) != RTI_SUCCESS)
+    rtiItem_t items[] =
     {
-        //  AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Could not write GDP_ITEM_SECONDARY_CLASS_DESCRIPTOR\n");
-    }
-    else
+        { RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_CAPABILITIES, 1,
+                (uint8*) &(zrcCfgCFGParam.devInfo.nodeCapabilities) },
+        { RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES, RTI_MAX_NUM_SUPPORTED_TGT_TYPES,
+                zrcCfgCFGParam.devInfo.tgtTypeList },
+        { RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_CAPABILITIES, 1,
+                (uint8*) &(zrcCfgCFGParam.devInfo.appCapabilities) },
+        { RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_DEV_TYPE_LIST, RTI_MAX_NUM_DEV_TYPES,
+                zrcCfgCFGParam.devInfo.devTypeList },
+        { RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_PROFILE_ID_LIST, RTI_MAX_NUM_PROFILE_IDS,
+                zrcCfgCFGParam.devInfo.profileIdList },
+        { RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_ID, 2,
+                (uint8*) &(zrcCfgCFGParam.devInfo.vendorId) },
+        { RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_NAME, sizeof(vendorName),
+                zrcCfgCFGParam.devInfo.vendorString },
+        { RTI_PROFILE_ZRC20, ZRC_ITEM_ZRC_PROFILE_CAPABILITIES, sizeof( zrcCfgCFGParam.zrcInfo.zrcCapabilities ),
+                (uint8 *)&zrcCfgCFGParam.zrcInfo.zrcCapabilities },
+        // Action Banks supported
+        { RTI_PROFILE_ZRC20, ZRC_ITEM_ACTION_BANKS_SUPPORTED_RX, ZRC_ATTR_LEN_ACTION_BANKS_SUPPORTED,
+                zrcCfgCFGParam.zrcInfo.actionBanksSupported },
+        { RTI_PROFILE_GDP, GDP_ITEM_PRIMARY_CLASS_DESCRIPTOR, sizeof(zrcCfgCFGParam.gdpInfo.primaryClassDescriptor),
+                (uint8 *)&zrcCfgCFGParam.gdpInfo.primaryClassDescriptor },
+        { RTI_PROFILE_GDP, GDP_ITEM_SECONDARY_CLASS_DESCRIPTOR, sizeof(zrcCfgCFGParam.gdpInfo.secondaryClassDescriptor),
+                (uint8 *)&zrcCfgCFGParam.gdpInfo.secondaryClassDescriptor },
+        { RTI_PROFILE_GDP, GDP_ITEM_TERTIARY_CLASS_DESCRIPTOR, sizeof(zrcCfgCFGParam.gdpInfo.tertiaryClassDescriptor),
+                (uint8 *)&zrcCfgCFGParam.gdpInfo.tertiaryClassDescriptor },
+        // recipient binding type used
+        { RTI_PROFILE_GDP, GDP_ITEM_BINDING_CAP, sizeof(zrcCfgCFGParam.gdpInfo.bindingCapabilities),
+                (uint8 *)&zrcCfgCFGParam.gdpInfo.bindingCapabilities },
+        // Extended validation wait time
+        { RTI_PROFILE_GDP, GDP_ITEM_BINDING_RECIPIENT_EXTENDED_VALIDATION_WAIT_TIME, sizeof( zrcCfgCFGParam.gdpInfo.extendedValidationWaitTime ),
+                (uint8 *)&zrcCfgCFGParam.gdpInfo.extendedValidationWaitTime },
+    };
+    static const char * const itemNames[] =
     {
-        LOG_DEBUG("[Configuration] Successfully wrote GDP_ITEM_SECONDARY_CLASS_DESCRIPTOR\n");
-    }
+        "RTI_CP_ITEM_NODE_CAPABILITIES",
+        "RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES",
+        "RTI_CP_ITEM_APPL_CAPABILITIES",
+        "RTI_CP_ITEM_APPL_DEV_TYPE_LIST",
+        "RTI_CP_ITEM_APPL_PROFILE_ID_LIST",
+        "RTI_CP_ITEM_VENDOR_ID",
+        "RTI_CP_ITEM_VENDOR_NAME",
+        "ZRC_ITEM_ZRC_PROFILE_CAPABILITIES",
+        "ZRC_ITEM_ACTION_BANKS_SUPPORTED_RX",
+        "GDP_ITEM_PRIMARY_CLASS_DESCRIPTOR",
+        "GDP_ITEM_SECONDARY_CLASS_DESCRIPTOR",
+        "GDP_ITEM_TERTIARY_CLASS_DESCRIPTOR",
+        "GDP_ITEM_BINDING_CAP",
+        "GDP_ITEM_BINDING_RECIPIENT_EXTENDED_VALIDATION_WAIT_TIME",
+    };
+    struct timespec start, end;
+    uint8 i;
 
-    if (RTI_WriteItemEx( RTI_PROFILE_GDP,
-            GDP_ITEM_TERTIARY_CLASS_DESCRIPTOR,
-            sizeof(zrcCfgCFGParam.gdpInfo.tertiaryClassDescriptor),
-            (uint8 *)&zrcCfgCFGParam.gdpInfo.tertiaryClassDescriptor ) != RTI_SUCCESS)
-    {
-        //  AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Could not write GDP_ITEM_TERTIARY_CLASS_DESCRIPTOR\n");
-    }
-    else
-    {
-        LOG_DEBUG("[Configuration] Successfully wrote GDP_ITEM_TERTIARY_CLASS_DESCRIPTOR\n");
-    }
+    LOG_INFO("[Configuration] -------------------- SET RNP CONFIGURATION PARAMETERS-------------------\n");
 
-    // recipient binding type used
-    if (RTI_WriteItemEx( RTI_PROFILE_GDP,
-            GDP_ITEM_BINDING_CAP,
-            sizeof(zrcCfgCFGParam.gdpInfo.bindingCapabilities),
-            (uint8 *)&zrcCfgCFGParam.gdpInfo.bindingCapabilities ) != RTI_SUCCESS)
-    {
-        //  AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Could not write GDP_ITEM_BINDING_CAP\n");
-    }
-    else
-    {
-        LOG_DEBUG("[Configuration] Successfully wrote GDP_ITEM_BINDING_CAP\n");
-    }
+    // All items in one go, the client waits once. The server still forwards
+    // them to the RNP one at a time, so only the IPC round trips are saved.
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    RTI_WriteItems(sizeof(items) / sizeof(items[0]), items);
+    clock_gettime(CLOCK_MONOTONIC, &end);
 
-    // Extended validation wait time
-    if (RTI_WriteItemEx( RTI_PROFILE_GDP,
-            GDP_ITEM_BINDING_RECIPIENT_EXTENDED_VALIDATION_WAIT_TIME,
-            sizeof( zrcCfgCFGParam.gdpInfo.extendedValidationWaitTime ),
-            (uint8 *)&zrcCfgCFGParam.gdpInfo.extendedValidationWaitTime ) != RTI_SUCCESS)
+    for (i = 0; i < sizeof(items) / sizeof(items[0]); i++)
     {
-        //  AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Could not write GDP_ITEM_BINDING_RECIPIENT_EXTENDED_VALIDATION_WAIT_TIME\n");
-    }
-    else
-    {
-        LOG_DEBUG("[Configuration] Successfully wrote GDP_ITEM_BINDING_RECIPIENT_EXTENDED_VALIDATION_WAIT_TIME\n");
+        if (items[i].status != RTI_SUCCESS)
+        {
+            //  AP_FATAL_ERROR();
+            LOG_WARN("[Configuration] Could not write %s\n", itemNames[i]);
+        }
+        else
+        {
+            LOG_DEBUG("[Configuration] Successfully wrote %s\n", itemNames[i]);
+        }
     }
+    LOG_INFO("[Configuration] Wrote %d items in %ld us\n", (int)(sizeof(items) / sizeof(items[0])),
+            ((end.tv_sec - start.tv_sec) * 1000000L) + ((end.tv_nsec - start.tv_nsec) / 1000L));
 
     zrcRIBInit();
 }
@@ -800,63 +732,62 @@ void zrcCfgGetCFGParamFromRNP(void)
     // Read Configuration Parameters From RNP//
     ///////////////////////////////////////////
 
-    if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_CAPABILITIES, 1,
-            (uint8*) &(zrcCfgCFGParam.devInfo.nodeCapabilities)) != RTI_SUCCESS) {
-        //   AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Failed to read Node Capabilities\n");
-    }
-    else
+    uint16 shortAddr = 0xFFFF;
+    uint16 panID = 0xFFFF;
+    rtiItem_t items[] =
     {
-        zrcCfgSetTarget((zrcCfgCFGParam.devInfo.nodeCapabilities & RCN_NODE_CAP_TARGET) ? TRUE : FALSE);
-    }
-
-    if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES,
-            RTI_MAX_NUM_SUPPORTED_TGT_TYPES,
-            zrcCfgCFGParam.devInfo.tgtTypeList) != RTI_SUCCESS) {
-        ///AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Failed to read Target Types\n");
-    }
-
-    if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_CAPABILITIES, 1,
-            (uint8*) &(zrcCfgCFGParam.devInfo.appCapabilities)) != RTI_SUCCESS) {
-        // AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Failed to read Application Capabilities\n");
-    }
-
-    if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_DEV_TYPE_LIST,
-            RTI_MAX_NUM_DEV_TYPES, zrcCfgCFGParam.devInfo.devTypeList) != RTI_SUCCESS) {
-        //   AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Failed to read Device Types\n");
-    }
-
-    if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_PROFILE_ID_LIST,
-            RTI_MAX_NUM_PROFILE_IDS, zrcCfgCFGParam.devInfo.profileIdList) != RTI_SUCCESS) {
-        //    AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Failed to read Profile IDs\n");
-    }
-
-    if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_ID, 2,
-            (uint8*) &(zrcCfgCFGParam.devInfo.vendorId)) != RTI_SUCCESS) {
-        //  AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Failed to read Vendor ID\n");
+        { RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_CAPABILITIES, 1,
+                (uint8*) &(zrcCfgCFGParam.devInfo.nodeCapabilities) },
+        { RTI_PROFILE_RTI, RTI_CP_ITEM_NODE_SUPPORTED_TGT_TYPES, RTI_MAX_NUM_SUPPORTED_TGT_TYPES,
+                zrcCfgCFGParam.devInfo.tgtTypeList },
+        { RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_CAPABILITIES, 1,
+                (uint8*) &(zrcCfgCFGParam.devInfo.appCapabilities) },
+        { RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_DEV_TYPE_LIST, RTI_MAX_NUM_DEV_TYPES,
+                zrcCfgCFGParam.devInfo.devTypeList },
+        { RTI_PROFILE_RTI, RTI_CP_ITEM_APPL_PROFILE_ID_LIST, RTI_MAX_NUM_PROFILE_IDS,
+                zrcCfgCFGParam.devInfo.profileIdList },
+        { RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_ID, 2,
+                (uint8*) &(zrcCfgCFGParam.devInfo.vendorId) },
+        { RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_NAME, sizeof(vendorName),
+                zrcCfgCFGParam.devInfo.vendorString },
+        { RTI_PROFILE_RTI, RTI_SA_ITEM_SHORT_ADDRESS, sizeof(shortAddr), (uint8*)&shortAddr },
+        { RTI_PROFILE_RTI, RTI_SA_ITEM_PAN_ID, sizeof(panID), (uint8*)&panID },
+    };
+    static const char * const itemNames[] =
+    {
+        "Node Capabilities",
+        "Target Types",
+        "Application Capabilities",
+        "Device Types",
+        "Profile IDs",
+        "Vendor ID",
+        "Vendor String",
+        "shortAddr",
+        "panID",
+    };
+    struct timespec start, end;
+    uint8 i;
+
+    // All items in one go, the client waits once. The server still forwards
+    // them to the RNP one at a time, so only the IPC round trips are saved.
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    RTI_ReadItems(sizeof(items) / sizeof(items[0]), items);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    for (i = 0; i < sizeof(items) / sizeof(items[0]); i++)
+    {
+        if (items[i].status != RTI_SUCCESS)
+        {
+            //  AP_FATAL_ERROR();
+            LOG_WARN("[Configuration] Failed to read %s\n", itemNames[i]);
+        }
     }
+    LOG_INFO("[Configuration] Read %d items in %ld us\n", (int)(sizeof(items) / sizeof(items[0])),
+            ((end.tv_sec - start.tv_sec) * 1000000L) + ((end.tv_nsec - start.tv_nsec) / 1000L));
 
-    if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_CP_ITEM_VENDOR_NAME,
-            sizeof(vendorName), zrcCfgCFGParam.devInfo.vendorString) != RTI_SUCCESS) {
-        //  AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Failed to read Vendor String\n");
-    }
-    uint16 shortAddr = 0xFFFF;
-    if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_SHORT_ADDRESS,
-            sizeof(shortAddr), (uint8*)&shortAddr) != RTI_SUCCESS) {
-        //  AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Failed to read shortAddr\n");
-    }
-    uint16 panID = 0xFFFF;
-    if (RTI_ReadItemEx(RTI_PROFILE_RTI, RTI_SA_ITEM_PAN_ID,
-            sizeof(panID), (uint8*)&panID) != RTI_SUCCESS) {
-        //  AP_FATAL_ERROR();
-        LOG_WARN("[Configuration] Failed to read panID\n");
+    if (items[0].status == RTI_SUCCESS)
+    {
+        zrcCfgSetTarget((zrcCfgCFGParam.devInfo.nodeCapabilities & RCN_NODE_CAP_TARGET) ? TRUE : FALSE);
     }
     DispCFGCurrentCfg(&zrcCfgCFGParam, shortAddr, panID);
 }
@@ -868,10 +799,11 @@ void zrcCfgGetCFGParamFromRNP(void)
  * @brief   INTERNAL (common-code) function to clear ONE entry from the pairing table
  *
  * @param   index - Index (0..pairingTableSize) within the pairing table to clear.
- * @param   tempEntry - Caller-allocated working buf (so if called repeatedly, this func doesn't have to alloc/free).
+ * @param   readStatus - Result of RTI_ReadPairingEntry() for this index.
+ * @param   tempEntry - Entry as read by RTI_ReadPairingEntry().
  * @return  void
  */
-static void zrcCfgClearPairingTableEntryPrivate(uint8 index, rcnNwkPairingEntry_t *tempEntry)
+static void zrcCfgClearPairingTableEntryPrivate(uint8 index, rStatus_t readStatus, rcnNwkPairingEntry_t *tempEntry)
 {
     // WARNING: Presumes caller pre-determined index is within range or that the read
     //.itself range checks the index and will fail if out of range.
@@ -880,9 +812,7 @@ static void zrcCfgClearPairingTableEntryPrivate(uint8 index, rcnNwkPairingEntry_
         LOG_ERROR("[Configuration] NULL tempEntry!\n");
     else
     {
-        if ((RTI_ReadIndexedItem(RTI_PROFILE_RTI,
-                RTI_SA_ITEM_PAIRING_TABLE_ENTRY, index, sizeof(*tempEntry),
-                (uint8 *) tempEntry)) != RTI_SUCCESS)
+        if (readStatus != RTI_SUCCESS)
         {
             LOG_ERROR("[Configuration] Pairing Table index %u read failed.  CANNOT CLEAR.\n", (unsigned int)index);
         }
@@ -912,11 +842,7 @@ static void zrcCfgClearPairingTableEntryPrivate(uint8 index, rcnNwkPairingEntry_
  */
 void zrcCfgClearPairingTableEntry(uint8 index)
 {
-    uint8 pairingTableSize = 0;
-
-    RTI_ReadItemEx(RTI_PROFILE_RTI,
-            RTI_CONST_ITEM_MAX_PAIRING_TABLE_ENTRIES, 1,
-            (uint8*) &pairingTableSize);
+    uint8 pairingTableSize = RTI_GetPairingTableSize();
 
     if (index >= pairingTableSize)
         LOG_WARN("[Configuration] Doing nothing! Index %u is out of range (0..%u).\n", (unsigned int)index, (unsigned int)pairingTableSize);
@@ -925,7 +851,7 @@ void zrcCfgClearPairingTableEntry(uint8 index)
         // Allocate memory for one pairing entry
         rcnNwkPairingEntry_t *pEntry = (rcnNwkPairingEntry_t *)malloc(sizeof(*pEntry));
 
-        zrcCfgClearPairingTableEntryPrivate(index, pEntry);
+        zrcCfgClearPairingTableEntryPrivate(index, RTI_ReadPairingEntry(index, pEntry), pEntry);
         // Free pairing entry buffer
         free(pEntry);
     }
@@ -943,18 +869,20 @@ void zrcCfgClearPairingTableEntry(uint8 index)
 void zrcCfgClearPairingTable()
 {
     uint8                index;
-    uint8                pairingTableSize = 0;
-    rcnNwkPairingEntry_t *pEntry = (rcnNwkPairingEntry_t *)malloc(sizeof(*pEntry));
+    uint8                pairingTableSize = RTI_GetPairingTableSize();
+    rcnNwkPairingEntry_t *pEntries = (rcnNwkPairingEntry_t *)malloc((pairingTableSize + 1) * sizeof(*pEntries));
+    rStatus_t            *pStatus = (rStatus_t *)malloc((pairingTableSize + 1) * sizeof(*pStatus));
 
-    RTI_ReadItemEx(RTI_PROFILE_RTI,
-            RTI_CONST_ITEM_MAX_PAIRING_TABLE_ENTRIES, 1,
-            (uint8*) &pairingTableSize);
+    // Read out all entries first; clearing one drops the pairing table mirror
+    for (index = 0; index < pairingTableSize; index++)
+        pStatus[index] = RTI_ReadPairingEntry(index, &pEntries[index]);
 
     for (index = 0; index < pairingTableSize; index++)
-        zrcCfgClearPairingTableEntryPrivate(index, pEntry);
+        zrcCfgClearPairingTableEntryPrivate(index, pStatus[index], &pEntries[index]);
 
-    // Free pairing entry buffer
-    free(pEntry);
+    // Free pairing entry buffers
+    free(pStatus);
+    free(pEntries);
 
     LOG_INFO("[Configuration] Pairing Table has been cleared.\n");
 }
@@ -1395,10 +1323,8 @@ void zrcCfgDisplayPairingTable() {
 
     for (i = 0; i < MIN(zrcCfgMaxNumPairingEntries, MAX_NUM_OF_PAIRING_ENTRIES_LINUX_SIDE); i++)
     {
-        // Try to read out this entry
-        if ((result = RTI_ReadIndexedItem(RTI_PROFILE_RTI,
-                RTI_SA_ITEM_PAIRING_TABLE_ENTRY, i, sizeof(rcnNwkPairingEntry_t),
-                (uint8 *) pEntry)) == RTI_SUCCESS)
+        // Try to read out this entry, served from the RTI library mirror
+        if ((result = RTI_ReadPairingEntry(i, pEntry)) == RTI_SUCCESS)
         {
             // Found pairing entry; display this.
             DisplayPairingTable(pEntry, NULL);
@@ -0,0 +1,440 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <configStore.h>
+
+#define CONFIG_STORE_MIN_SLOTS   16
+#define CONFIG_STORE_DELIMITERS  "=;\"\r"
+
+// One indexed key. Names and value are offsets in the string pool, offset 0
+// (the empty string at the start of the pool) marks a free slot.
+typedef struct
+{
+	uint32_t hash;
+	size_t   section;
+	size_t   key;
+	size_t   value;
+} configStoreEntry_t;
+
+struct configStore_s
+{
+	// Identity of the parsed file, for configStore_IsCurrent
+	dev_t              dev;
+	ino_t              ino;
+	off_t              size;
+	struct timespec    mtime;
+
+	size_t             mask;     // Number of slots - 1, power of 2
+	configStoreEntry_t *slots;
+	char               *pool;    // NUL terminated names and values
+	size_t             poolLen;
+};
+
+/**************************************************************************************************
+ * @fn      configStoreHash
+ * @brief   FNV-1a hash of a (section, key) pair.
+ *
+ * @param   *section    - section name
+ * @param   sectionLen  - its length
+ * @param   *key        - key name
+ * @param   keyLen      - its length
+ *
+ * @return  Hash value
+ **************************************************************************************************
+ */
+static uint32_t configStoreHash(char const *section, size_t sectionLen, char const *key, size_t keyLen)
+{
+	uint32_t hash = 2166136261u;
+	size_t i;
+
+	for (i = 0; i < sectionLen; i++)
+	{
+		hash = (hash ^ (unsigned char)section[i]) * 16777619u;
+	}
+	// Separator, so that "AB"/"C" and "A"/"BC" differ
+	hash = (hash ^ 0xFF) * 16777619u;
+	for (i = 0; i < keyLen; i++)
+	{
+		hash = (hash ^ (unsigned char)key[i]) * 16777619u;
+	}
+
+	return hash;
+}
+
+/**************************************************************************************************
+ * @fn      configStoreFind
+ * @brief   Probes the table for a (section, key) pair.
+ *
+ * @return  The slot holding the pair, or the free slot where it belongs.
+ **************************************************************************************************
+ */
+static configStoreEntry_t *configStoreFind(configStore_t const *store, uint32_t hash,
+		char const *section, size_t sectionLen, char const *key, size_t keyLen)
+{
+	size_t idx = hash & store->mask;
+	configStoreEntry_t *pEntry;
+
+	for (;;)
+	{
+		pEntry = &store->slots[idx];
+		if (pEntry->key == 0)
+		{
+			return pEntry;
+		}
+		if ((pEntry->hash == hash) &&
+			(strncmp(&store->pool[pEntry->section], section, sectionLen) == 0) &&
+			(store->pool[pEntry->section + sectionLen] == '\0') &&
+			(strncmp(&store->pool[pEntry->key], key, keyLen) == 0) &&
+			(store->pool[pEntry->key + keyLen] == '\0'))
+		{
+			return pEntry;
+		}
+		idx = (idx + 1) & store->mask;
+	}
+}
+
+/**************************************************************************************************
+ * @fn      configStorePoolAdd
+ * @brief   Copies a string into the pool.
+ *
+ * @return  Its offset in the pool
+ **************************************************************************************************
+ */
+static size_t configStorePoolAdd(configStore_t *store, char const *str, size_t len)
+{
+	size_t offset = store->poolLen;
+
+	memcpy(&store->pool[offset], str, len);
+	store->pool[offset + len] = '\0';
+	store->poolLen += len + 1;
+
+	return offset;
+}
+
+/**************************************************************************************************
+ * @fn      configStoreTrim
+ * @brief   Strips blanks on both ends of [*pStart, *pEnd).
+ *
+ * @return  NONE
+ **************************************************************************************************
+ */
+static void configStoreTrim(char const **pStart, char const **pEnd)
+{
+	while ((*pStart < *pEnd) && ((**pStart == ' ') || (**pStart == '\t')))
+	{
+		(*pStart)++;
+	}
+	while ((*pEnd > *pStart) &&
+			(((*pEnd)[-1] == ' ') || ((*pEnd)[-1] == '\t') || ((*pEnd)[-1] == '\r')))
+	{
+		(*pEnd)--;
+	}
+}
+
+/**************************************************************************************************
+ * @fn      configStoreParse
+ * @brief   Indexes every key of a file image.
+ *
+ * @param   *store - store with identity fields set, the rest is filled in
+ * @param   *buf   - file content
+ * @param   len    - its length
+ *
+ * @return  TRUE on success, FALSE if out of memory.
+ **************************************************************************************************
+ */
+static bool configStoreParse(configStore_t *store, char const *buf, size_t len)
+{
+	char const *end = buf + len;
+	char const *line, *eol, *p, *q;
+	size_t lines = 1, slots = CONFIG_STORE_MIN_SLOTS;
+	size_t section = 0, sectionLen = 0;
+
+	for (p = buf; p < end; p++)
+	{
+		if (*p == '\n')
+		{
+			lines++;
+		}
+	}
+	while (slots < (2 * lines))
+	{
+		slots <<= 1;
+	}
+
+	// A line yields at most its own characters plus two terminators
+	store->pool = malloc(len + (2 * lines) + 1);
+	store->slots = calloc(slots, sizeof(configStoreEntry_t));
+	if ((store->pool == NULL) || (store->slots == NULL))
+	{
+		return false;
+	}
+	store->mask = slots - 1;
+	store->pool[0] = '\0';
+	store->poolLen = 1;
+
+	for (line = buf; line < end; line = eol + 1)
+	{
+		eol = memchr(line, '\n', end - line);
+		if (eol == NULL)
+		{
+			eol = end;
+		}
+
+		p = line;
+		q = eol;
+		configStoreTrim(&p, &q);
+		if ((p == q) || (*p == '#'))
+		{
+			continue;
+		}
+
+		if (*p == '[')
+		{
+			char const *close = memchr(p + 1, ']', q - (p + 1));
+
+			p++;
+			if (close != NULL)
+			{
+				q = close;
+			}
+			configStoreTrim(&p, &q);
+			sectionLen = q - p;
+			section = configStorePoolAdd(store, p, sectionLen);
+		}
+		else if (section != 0)
+		{
+			char const *eq = memchr(p, '=', q - p);
+			char const *key = p, *keyEnd = eq;
+			char const *value, *valueEnd;
+			configStoreEntry_t *pEntry;
+			uint32_t hash;
+
+			if (eq == NULL)
+			{
+				continue;
+			}
+			configStoreTrim(&key, &keyEnd);
+			if (key == keyEnd)
+			{
+				continue;
+			}
+
+			// Same value extraction as the strtok() based parsers
+			value = eq + 1;
+			if ((q - value >= 2) && (value[0] == '"') && (value[1] == '"'))
+			{
+				valueEnd = value;
+			}
+			else
+			{
+				while ((value < q) && strchr(CONFIG_STORE_DELIMITERS, *value))
+				{
+					value++;
+				}
+				for (valueEnd = value; valueEnd < q; valueEnd++)
+				{
+					if (strchr(CONFIG_STORE_DELIMITERS, *valueEnd))
+					{
+						break;
+					}
+				}
+			}
+
+			hash = configStoreHash(&store->pool[section], sectionLen, key, keyEnd - key);
+			pEntry = configStoreFind(store, hash, &store->pool[section], sectionLen, key, keyEnd - key);
+			if (pEntry->key == 0)
+			{
+				pEntry->hash = hash;
+				pEntry->section = section;
+				pEntry->key = configStorePoolAdd(store, key, keyEnd - key);
+				pEntry->value = configStorePoolAdd(store, value, valueEnd - value);
+			}
+		}
+	}
+
+	return true;
+}
+
+/**************************************************************************************************
+ * @fn      configStoreReadAll
+ * @brief   Reads a file that cannot be mapped (not a regular file) to its end.
+ *
+ * @param   fd    - open file descriptor
+ * @param   *pLen - returns the number of bytes read
+ *
+ * @return  Allocated buffer, or NULL on error.
+ **************************************************************************************************
+ */
+static char *configStoreReadAll(int fd, size_t *pLen)
+{
+	size_t size = 4096, len = 0;
+	char *buf = malloc(size), *tmp;
+	ssize_t n;
+
+	while (buf != NULL)
+	{
+		if (len == size)
+		{
+			size *= 2;
+			tmp = realloc(buf, size);
+			if (tmp == NULL)
+			{
+				break;
+			}
+			buf = tmp;
+		}
+		n = read(fd, buf + len, size - len);
+		if (n == 0)
+		{
+			*pLen = len;
+			return buf;
+		}
+		if ((n < 0) && (errno != EINTR))
+		{
+			break;
+		}
+		if (n > 0)
+		{
+			len += n;
+		}
+	}
+
+	free(buf);
+	return NULL;
+}
+
+configStore_t *configStore_LoadFd(int fd)
+{
+	configStore_t *store;
+	struct stat st;
+	char *buf = NULL;
+	size_t len = 0;
+	bool mapped = false, parsed;
+
+	if (fstat(fd, &st) < 0)
+	{
+		return NULL;
+	}
+
+	if (S_ISREG(st.st_mode))
+	{
+		len = st.st_size;
+		if (len > 0)
+		{
+			buf = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (buf == MAP_FAILED)
+			{
+				return NULL;
+			}
+			mapped = true;
+		}
+	}
+	else
+	{
+		buf = configStoreReadAll(fd, &len);
+		if (buf == NULL)
+		{
+			return NULL;
+		}
+	}
+
+	store = calloc(1, sizeof(configStore_t));
+	if (store != NULL)
+	{
+		store->dev = st.st_dev;
+		store->ino = st.st_ino;
+		store->size = st.st_size;
+		store->mtime = st.st_mtim;
+	}
+	parsed = (store != NULL) && configStoreParse(store, buf ? buf : "", len);
+
+	if (mapped)
+	{
+		munmap(buf, len);
+	}
+	else
+	{
+		free(buf);
+	}
+
+	if (!parsed)
+	{
+		configStore_Free(store);
+		return NULL;
+	}
+	return store;
+}
+
+configStore_t *configStore_Load(char const *path)
+{
+	configStore_t *store;
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+	if (fd < 0)
+	{
+		return NULL;
+	}
+	store = configStore_LoadFd(fd);
+	close(fd);
+
+	return store;
+}
+
+static bool configStoreIsFile(configStore_t const *store, struct stat const *pSt)
+{
+	return (pSt->st_dev == store->dev) && (pSt->st_ino == store->ino) &&
+		(pSt->st_size == store->size) &&
+		(pSt->st_mtim.tv_sec == store->mtime.tv_sec) && (pSt->st_mtim.tv_nsec == store->mtime.tv_nsec);
+}
+
+bool configStore_IsCurrent(configStore_t const *store, int fd)
+{
+	struct stat st;
+
+	if ((store == NULL) || (fstat(fd, &st) < 0))
+	{
+		return false;
+	}
+
+	return configStoreIsFile(store, &st);
+}
+
+bool configStore_IsCurrentPath(configStore_t const *store, char const *path)
+{
+	struct stat st;
+
+	if ((store == NULL) || (stat(path, &st) < 0))
+	{
+		return false;
+	}
+
+	return configStoreIsFile(store, &st);
+}
+
+char const *configStore_Get(configStore_t const *store, char const *section, char const *key)
+{
+	size_t sectionLen = strlen(section), keyLen = strlen(key);
+	configStoreEntry_t const *pEntry;
+
+	pEntry = configStoreFind(store, configStoreHash(section, sectionLen, key, keyLen),
+			section, sectionLen, key, keyLen);
+
+	return (pEntry->key != 0) ? &store->pool[pEntry->value] : NULL;
+}
+
+void configStore_Free(configStore_t *store)
+{
+	if (store != NULL)
+	{
+		free(store->slots);
+		free(store->pool);
+		free(store);
+	}
+}
@@ -0,0 +1,100 @@
+#ifndef _CONFIG_STORE_
+#define _CONFIG_STORE_
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Parsed configuration file. The file is read once (through mmap when possible)
+// and every key=value line is indexed on its (section, key) pair, so lookups
+// are a hash probe instead of a scan of the file.
+//
+// Syntax handled, same as the line parsers it replaces:
+//    [Section]
+//    key=value ; comment
+//    #commented=line
+// Section and key names match exactly, surrounding blanks ignored. The value
+// is the first token after '=' delimited by '=', ';', '"' or CR, a "" value is
+// the empty string. When a key appears twice in a section the first one wins.
+typedef struct configStore_s configStore_t;
+
+/**************************************************************************************************
+ * @fn      configStore_Load
+ * @brief   Parses the configuration file at 'path'.
+ *
+ * @param   *path - configuration file
+ *
+ * @return  New store, or NULL if the file could not be read. Release with configStore_Free.
+ **************************************************************************************************
+ */
+extern configStore_t *configStore_Load(char const *path);
+
+/**************************************************************************************************
+ * @fn      configStore_LoadFd
+ * @brief   Parses the whole file open on 'fd', independently of its current offset.
+ *
+ * @param   fd - open file descriptor, left open
+ *
+ * @return  New store, or NULL if the file could not be read. Release with configStore_Free.
+ **************************************************************************************************
+ */
+extern configStore_t *configStore_LoadFd(int fd);
+
+/**************************************************************************************************
+ * @fn      configStore_IsCurrent
+ * @brief   Tells whether 'store' was parsed from the file now open on 'fd' and that file
+ *          has not been modified since.
+ *
+ * @param   *store - store to check, may be NULL
+ * @param   fd     - open file descriptor
+ *
+ * @return  TRUE if the store can be used for 'fd' as is.
+ **************************************************************************************************
+ */
+extern bool configStore_IsCurrent(configStore_t const *store, int fd);
+
+/**************************************************************************************************
+ * @fn      configStore_IsCurrentPath
+ * @brief   Tells whether 'store' was parsed from the file now found at 'path' and that file
+ *          has not been modified since. Unlike configStore_IsCurrent() this also notices
+ *          a new file renamed over the path.
+ *
+ * @param   *store - store to check, may be NULL
+ * @param   *path  - configuration file
+ *
+ * @return  TRUE if the store can be used for 'path' as is.
+ **************************************************************************************************
+ */
+extern bool configStore_IsCurrentPath(configStore_t const *store, char const *path);
+
+/**************************************************************************************************
+ * @fn      configStore_Get
+ * @brief   Looks up the value of 'key' in 'section'.
+ *
+ * @param   *store   - parsed file
+ * @param   *section - section name, without brackets
+ * @param   *key     - key name
+ *
+ * @return  The value, valid until configStore_Free, or NULL if the key is not defined.
+ **************************************************************************************************
+ */
+extern char const *configStore_Get(configStore_t const *store, char const *section, char const *key);
+
+/**************************************************************************************************
+ * @fn      configStore_Free
+ * @brief   Releases a store returned by configStore_Load or configStore_LoadFd.
+ *
+ * @param   *store - store to release, may be NULL
+ *
+ * @return  NONE
+ **************************************************************************************************
+ */
+extern void configStore_Free(configStore_t *store);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _CONFIG_STORE_
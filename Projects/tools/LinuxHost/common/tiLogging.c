@@ -5,16 +5,61 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <malloc.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/eventfd.h>
 #include <tiLogging.h>
 
 #define SIZEMAX(a,b) ((sizeof(a) >= sizeof(b)) ? sizeof(a) : sizeof(b))
 
+#define TI_LOG_QUEUE_MASK   (TI_LOG_QUEUE_SIZE - 1)
+#define TI_LOG_MAX_IOV      64
+
+// Per thread logging state. The queue is written by the owning thread only and
+// read by the writer thread only, so it needs no lock. Entries are never freed,
+// a thread that exits leaves its entry (and whatever is still queued in it) to
+// the next new thread.
+typedef struct tiLogThread_s
+{
+	struct tiLogThread_s *next;
+	int                  inUse;
+	volatile unsigned int head;           // Written by the owner
+	volatile unsigned int tail;           // Written by the writer
+	volatile unsigned int dropped;        // Lines that did not fit, written by the owner
+	unsigned int         droppedReported; // Written by the writer
+	time_t               stampSec;        // Second of the cached timestamp
+	int                  stampLen;
+	char                 stamp[32];       // "[YYYY-MM-DD HH:MM:SS."
+	bool                 midLine;         // The last text written did not end the line
+	char const           *lastFmt;        // Previous line, for repeat suppression
+	unsigned int         lastHash;
+	int                  lastLen;
+	long long            lastMs;
+	unsigned int         repeats;
+	char                 *queue;          // TI_LOG_QUEUE_SIZE bytes, allocated on the first queued line
+} tiLogThread_t;
+
 // Global variables (used by the logging macros)
 int               __APP_LOG_LEVEL = MAX_LOG_LEVEL_TO_STDIO;
 int               __BIG_DEBUG_ACTIVE = 0;
 char const        *processLogPrefix = ""; // Default to empty string, NOT NULL, so can be used even if tiLogging_Init is never called.
 
+static tiLogThread_t * volatile tiLogThreads = NULL;
+static __thread tiLogThread_t   *tiLogSelf = NULL;
+static pthread_key_t            tiLogKey;
+static pthread_once_t           tiLogKeyOnce = PTHREAD_ONCE_INIT;
+
+// Asynchronous backend
+static volatile bool            tiLogAsync = false;
+static volatile bool            tiLogStop = false;
+static volatile int             tiLogWriterIdle = 0;
+static int                      tiLogEventFd = -1;
+static pthread_t                tiLogWriterThread;
+static pthread_mutex_t          tiLogDrainMutex = PTHREAD_MUTEX_INITIALIZER;
+
 
 static char const *levelToName(int level)
 {
@@ -226,3 +271,530 @@ bool tiLogging_Init(char const *configFileName)
 	return foundConfig;
 }
 
+
+/**************************************************************************************************
+ * @fn      tiLogThreadExit
+ * @brief   Releases the logging state of an exiting thread for reuse. Anything still
+ *          queued in it is written out as usual.
+ *
+ * @param   *arg - the thread's tiLogThread_t
+ *
+ * @return  NONE
+ **************************************************************************************************
+ */
+static void tiLogThreadExit(void *arg)
+{
+	tiLogThread_t *pThread = (tiLogThread_t *)arg;
+
+	__sync_synchronize();
+	pThread->inUse = 0;
+}
+
+static void tiLogKeyCreate(void)
+{
+	pthread_key_create(&tiLogKey, tiLogThreadExit);
+}
+
+/**************************************************************************************************
+ * @fn      tiLogGetThread
+ * @brief   Returns the logging state of the calling thread, taking over the one of an
+ *          exited thread or allocating one on its first log line.
+ *
+ * @return  The thread's state, or NULL if none could be allocated.
+ **************************************************************************************************
+ */
+static tiLogThread_t *tiLogGetThread(void)
+{
+	tiLogThread_t *pThread;
+
+	if (tiLogSelf)
+	{
+		return tiLogSelf;
+	}
+
+	pthread_once(&tiLogKeyOnce, tiLogKeyCreate);
+
+	for (pThread = tiLogThreads; pThread; pThread = pThread->next)
+	{
+		if (__sync_bool_compare_and_swap(&pThread->inUse, 0, 1))
+		{
+			break;
+		}
+	}
+
+	if (!pThread)
+	{
+		if (!(pThread = calloc(1, sizeof(tiLogThread_t))))
+		{
+			return NULL;
+		}
+		pThread->inUse = 1;
+		do
+		{
+			pThread->next = tiLogThreads;
+		} while (!__sync_bool_compare_and_swap(&tiLogThreads, pThread->next, pThread));
+	}
+
+	// The queue may still hold lines of the previous owner, keep them
+	pThread->stampSec = (time_t)-1;
+	pThread->midLine = false;
+	pThread->lastFmt = NULL;
+	pThread->repeats = 0;
+
+	tiLogSelf = pThread;
+	pthread_setspecific(tiLogKey, pThread);
+	return pThread;
+}
+
+/**************************************************************************************************
+ * @fn      tiLogFormatPrefix
+ * @brief   Writes the "[date time.usecs] [process] " prefix of a line. The part up to the
+ *          seconds only changes once a second and is reused from the thread's cache.
+ *
+ * @param   *pThread - calling thread's state
+ * @param   *pNow    - time of the line
+ * @param   *buf     - destination, at least TI_LOG_LINE_MAX bytes
+ *
+ * @return  Length of the prefix
+ **************************************************************************************************
+ */
+static int tiLogFormatPrefix(tiLogThread_t *pThread, struct timespec const *pNow, char *buf)
+{
+	int len = 0, prefixLen;
+
+#ifdef __DEBUG_TIME__
+	long usecs = pNow->tv_nsec / 1000;
+	int  i;
+
+	if (pNow->tv_sec != pThread->stampSec)
+	{
+		struct tm currTm;
+
+		gmtime_r(&pNow->tv_sec, &currTm);
+		pThread->stampLen = snprintf(pThread->stamp, sizeof(pThread->stamp), "[%04d-%02d-%02d %02d:%02d:%02d.",
+				currTm.tm_year+1900, currTm.tm_mon+1, currTm.tm_mday,
+				currTm.tm_hour, currTm.tm_min, currTm.tm_sec);
+		pThread->stampSec = pNow->tv_sec;
+	}
+	memcpy(buf, pThread->stamp, pThread->stampLen);
+	len = pThread->stampLen;
+	for (i = 5; i >= 0; i--)
+	{
+		buf[len + i] = '0' + (usecs % 10);
+		usecs /= 10;
+	}
+	len += 6;
+	buf[len++] = ']';
+	buf[len++] = ' ';
+#else
+	(void)pThread;
+	(void)pNow;
+#endif
+
+	prefixLen = strlen(processLogPrefix);
+	if (prefixLen > (TI_LOG_LINE_MAX / 2))
+	{
+		prefixLen = TI_LOG_LINE_MAX / 2;
+	}
+	memcpy(buf + len, processLogPrefix, prefixLen);
+	return len + prefixLen;
+}
+
+/**************************************************************************************************
+ * @fn      tiLogDrain
+ * @brief   Writes out what is queued in all threads' queues, with one writev() for up to
+ *          TI_LOG_MAX_IOV/2 queues. Must be called with tiLogDrainMutex held.
+ *
+ * @return  Number of bytes taken from the queues
+ **************************************************************************************************
+ */
+static int tiLogDrain(void)
+{
+	struct iovec  iov[TI_LOG_MAX_IOV];
+	tiLogThread_t *pThreads[TI_LOG_MAX_IOV / 2];
+	unsigned int  pending[TI_LOG_MAX_IOV / 2];
+	unsigned int  newlyDropped = 0;
+	tiLogThread_t *pThread;
+	int           numIov = 0, numThreads = 0, total = 0, i, done;
+
+	for (pThread = tiLogThreads; pThread && (numThreads < (TI_LOG_MAX_IOV / 2)); pThread = pThread->next)
+	{
+		unsigned int head, tail, offset, count, first;
+
+		if (pThread->dropped != pThread->droppedReported)
+		{
+			newlyDropped += pThread->dropped - pThread->droppedReported;
+			pThread->droppedReported = pThread->dropped;
+		}
+
+		head = pThread->head;
+		__sync_synchronize();
+		tail = pThread->tail;
+		if (head == tail)
+		{
+			continue;
+		}
+
+		count = head - tail;
+		offset = tail & TI_LOG_QUEUE_MASK;
+		first = TI_LOG_QUEUE_SIZE - offset;
+		if (first > count)
+		{
+			first = count;
+		}
+		iov[numIov].iov_base = &pThread->queue[offset];
+		iov[numIov++].iov_len = first;
+		if (count > first)
+		{
+			iov[numIov].iov_base = pThread->queue;
+			iov[numIov++].iov_len = count - first;
+		}
+		pThreads[numThreads] = pThread;
+		pending[numThreads++] = count;
+		total += count;
+	}
+
+	// Write everything, a partial write continues where it stopped
+	for (i = 0; i < numIov; )
+	{
+		done = writev(fileno(LOG_DESTINATION_FP), &iov[i], numIov - i);
+		if (done < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			// Nowhere to write to, the lines are lost
+			break;
+		}
+		while ((i < numIov) && (done >= (int)iov[i].iov_len))
+		{
+			done -= iov[i++].iov_len;
+		}
+		if (i < numIov)
+		{
+			iov[i].iov_base = (char *)iov[i].iov_base + done;
+			iov[i].iov_len -= done;
+		}
+	}
+
+	// Hand the space back to the threads
+	__sync_synchronize();
+	for (i = 0; i < numThreads; i++)
+	{
+		pThreads[i]->tail += pending[i];
+	}
+
+	if (newlyDropped)
+	{
+		fprintf(LOG_DESTINATION_FP, "%s[WARN]   Logging queue full, %u lines dropped\n", processLogPrefix, newlyDropped);
+	}
+
+	return total;
+}
+
+/**************************************************************************************************
+ * @fn      tiLogWriter
+ * @brief   Writer thread of the asynchronous backend. Drains the queues until they are
+ *          empty, then sleeps until a thread queues a line.
+ *
+ * @return  NULL
+ **************************************************************************************************
+ */
+static void *tiLogWriter(void *arg)
+{
+	tiLogThread_t *pThread;
+	eventfd_t     wakeups;
+	int           pending;
+
+	(void)arg;
+
+	while (!tiLogStop)
+	{
+		pthread_mutex_lock(&tiLogDrainMutex);
+		pending = tiLogDrain();
+		pthread_mutex_unlock(&tiLogDrainMutex);
+		if (pending)
+		{
+			continue;
+		}
+
+		// Announce that we are about to sleep, then look again so that a line
+		// queued in between is not left waiting.
+		tiLogWriterIdle = 1;
+		__sync_synchronize();
+		for (pThread = tiLogThreads; pThread && !pending; pThread = pThread->next)
+		{
+			pending = (pThread->head != pThread->tail) || (pThread->dropped != pThread->droppedReported);
+		}
+		if ((pending || tiLogStop) && __sync_lock_test_and_set(&tiLogWriterIdle, 0))
+		{
+			continue;
+		}
+		if ((eventfd_read(tiLogEventFd, &wakeups) < 0) && (errno != EINTR))
+		{
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+/**************************************************************************************************
+ * @fn      tiLogWrite
+ * @brief   Queues a formatted line, or writes it right away if the asynchronous backend
+ *          is not running or the line is fatal.
+ *
+ * @param   *pThread - calling thread's state
+ * @param   level    - LOG_LEVEL_xxx of the line
+ * @param   *line    - the line
+ * @param   len      - its length
+ *
+ * @return  NONE
+ **************************************************************************************************
+ */
+static void tiLogWrite(tiLogThread_t *pThread, int level, char const *line, int len)
+{
+	unsigned int head, offset, first;
+
+	if (!tiLogAsync || (level == LOG_LEVEL_FATAL))
+	{
+		// Keep the order with what is still queued
+		tiLogging_Flush();
+		fwrite(line, 1, len, LOG_DESTINATION_FP);
+		return;
+	}
+
+	if (!pThread->queue)
+	{
+		// Threads that only ever log synchronously do not need a queue
+		pThread->queue = malloc(TI_LOG_QUEUE_SIZE);
+	}
+
+	head = pThread->head;
+	if (!pThread->queue || ((TI_LOG_QUEUE_SIZE - (head - pThread->tail)) < (unsigned int)len))
+	{
+		pThread->dropped++;
+	}
+	else
+	{
+		offset = head & TI_LOG_QUEUE_MASK;
+		first = TI_LOG_QUEUE_SIZE - offset;
+		if (first > (unsigned int)len)
+		{
+			first = len;
+		}
+		memcpy(&pThread->queue[offset], line, first);
+		memcpy(pThread->queue, line + first, len - first);
+		__sync_synchronize();
+		pThread->head = head + len;
+	}
+
+	__sync_synchronize();
+	if (tiLogWriterIdle && __sync_lock_test_and_set(&tiLogWriterIdle, 0))
+	{
+		eventfd_write(tiLogEventFd, 1);
+	}
+}
+
+/**************************************************************************************************
+ * @fn      tiLogging_Log
+ * @brief   Formats one log line, prefixed like _PREPEND_TO_LOG, and writes it. Used by the
+ *          LOG_xxx() macros once the level has passed the filter.
+ *
+ *          With the asynchronous backend running, a complete line identical to the
+ *          previous one of the same thread within TI_LOG_REPEAT_WINDOW_MS is not
+ *          written again, it is counted and reported with the next different line
+ *          instead. Text that does not end a line, such as the bytes of a dump, is
+ *          never suppressed.
+ *
+ *          With the asynchronous backend running (see tiLogging_InitAsync()) the line
+ *          is queued for the writer thread, otherwise it is written right away.
+ *          LOG_FATAL lines are always written right away, after everything queued.
+ *
+ * input parameters
+ *
+ * @param level - LOG_LEVEL_xxx of the line
+ * @param *fmt  - printf() style format
+ *
+ * @return  NONE
+ **************************************************************************************************
+ */
+void tiLogging_Log(int level, char const *fmt, ...)
+{
+	tiLogThread_t   *pThread = tiLogGetThread();
+	struct timespec now;
+	va_list         args;
+	char            line[TI_LOG_LINE_MAX];
+	unsigned int    hash = 2166136261u;
+	long long       nowMs = 0;
+	bool            complete, checkRepeat;
+	int             prefixLen, len, i;
+
+	if (!pThread)
+	{
+		// Out of memory, log the plain way
+		va_start(args, fmt);
+		fputs(processLogPrefix, LOG_DESTINATION_FP);
+		vfprintf(LOG_DESTINATION_FP, fmt, args);
+		va_end(args);
+		return;
+	}
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	prefixLen = tiLogFormatPrefix(pThread, &now, line);
+
+	va_start(args, fmt);
+	len = vsnprintf(line + prefixLen, TI_LOG_LINE_MAX - prefixLen, fmt, args);
+	va_end(args);
+	if (len < 0)
+	{
+		return;
+	}
+	if (len >= (TI_LOG_LINE_MAX - prefixLen))
+	{
+		// Truncated, but still a line of its own
+		len = TI_LOG_LINE_MAX - prefixLen - 1;
+		line[prefixLen + len - 1] = '\n';
+	}
+
+	// Suppress repetitions of the same whole line, only when queued: synchronous
+	// output is kept exactly as logged
+	complete = (len > 0) && (line[prefixLen + len - 1] == '\n');
+	checkRepeat = tiLogAsync && complete && !pThread->midLine && (level != LOG_LEVEL_FATAL);
+	pThread->midLine = !complete;
+	if (checkRepeat)
+	{
+		for (i = prefixLen; i < (prefixLen + len); i++)
+		{
+			hash = (hash ^ (unsigned char)line[i]) * 16777619u;
+		}
+		nowMs = ((long long)now.tv_sec * 1000) + (now.tv_nsec / 1000000);
+		if ((fmt == pThread->lastFmt) && (hash == pThread->lastHash) &&
+				(len == pThread->lastLen) && ((nowMs - pThread->lastMs) < TI_LOG_REPEAT_WINDOW_MS))
+		{
+			pThread->repeats++;
+			return;
+		}
+	}
+	if (pThread->repeats)
+	{
+		char notice[TI_LOG_LINE_MAX];
+		int  noticeLen;
+
+		memcpy(notice, line, prefixLen);
+		noticeLen = prefixLen + snprintf(notice + prefixLen, sizeof(notice) - prefixLen,
+				"[NOTICE] Previous line repeated %u more times\n", pThread->repeats);
+		tiLogWrite(pThread, LOG_LEVEL_ALWAYS, notice, noticeLen);
+		pThread->repeats = 0;
+	}
+	if (checkRepeat)
+	{
+		pThread->lastFmt = fmt;
+		pThread->lastHash = hash;
+		pThread->lastLen = len;
+		pThread->lastMs = nowMs;
+	}
+	else
+	{
+		pThread->lastFmt = NULL;
+	}
+
+	tiLogWrite(pThread, level, line, prefixLen + len);
+}
+
+/**************************************************************************************************
+ * @fn      tiLogging_InitAsync
+ * @brief   Starts the asynchronous logging backend. Each thread then queues its lines in
+ *          its own lock-free queue of TI_LOG_QUEUE_SIZE bytes, and a writer thread
+ *          drains all queues with one writev() per batch. Lines that do not fit in the
+ *          queue are dropped and reported by the writer. Queued lines are flushed on
+ *          exit().
+ *
+ * @return  TRUE if the backend runs, FALSE if it could not be started and logging
+ *          stays synchronous.
+ **************************************************************************************************
+ */
+bool tiLogging_InitAsync(void)
+{
+	static bool atExitRegistered = false;
+
+	if (tiLogAsync)
+	{
+		return true;
+	}
+
+	if ((tiLogEventFd = eventfd(0, 0)) < 0)
+	{
+		LOG_ERROR("%s(): Failed to create eventfd, errno %d. Logging stays synchronous.\n", __FUNCTION__, errno);
+		return false;
+	}
+
+	tiLogStop = false;
+	if (pthread_create(&tiLogWriterThread, NULL, tiLogWriter, NULL))
+	{
+		LOG_ERROR("%s(): Failed to create writer thread. Logging stays synchronous.\n", __FUNCTION__);
+		close(tiLogEventFd);
+		tiLogEventFd = -1;
+		return false;
+	}
+
+	if (!atExitRegistered)
+	{
+		atexit(tiLogging_Flush);
+		atExitRegistered = true;
+	}
+
+	__sync_synchronize();
+	tiLogAsync = true;
+	return true;
+}
+
+/**************************************************************************************************
+ * @fn      tiLogging_CloseAsync
+ * @brief   Writes out everything queued, stops the writer thread and returns to
+ *          synchronous logging. Other threads should no longer be logging.
+ *
+ * @return  NONE
+ **************************************************************************************************
+ */
+void tiLogging_CloseAsync(void)
+{
+	if (!tiLogAsync)
+	{
+		return;
+	}
+
+	tiLogAsync = false;
+	tiLogStop = true;
+	__sync_synchronize();
+	eventfd_write(tiLogEventFd, 1);
+	pthread_join(tiLogWriterThread, NULL);
+
+	pthread_mutex_lock(&tiLogDrainMutex);
+	while (tiLogDrain() > 0);
+	pthread_mutex_unlock(&tiLogDrainMutex);
+
+	close(tiLogEventFd);
+	tiLogEventFd = -1;
+}
+
+/**************************************************************************************************
+ * @fn      tiLogging_Flush
+ * @brief   Writes out everything queued by the asynchronous backend before returning.
+ *          Does nothing with synchronous logging.
+ *
+ * @return  NONE
+ **************************************************************************************************
+ */
+void tiLogging_Flush(void)
+{
+	if (tiLogEventFd < 0)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&tiLogDrainMutex);
+	while (tiLogDrain() > 0);
+	pthread_mutex_unlock(&tiLogDrainMutex);
+}
@@ -15,6 +15,9 @@ extern "C"
 #define DEFAULT_LOG_CFG_SUFFIX         "_log.conf"         // See notes for tiLogging_Init() below.
 #define LOG_CONFIG_FILE_OVERRIDE_PATH1 "/opt/"	           // See notes for tiLogging_Init() below.
 #define LOG_CONFIG_FILE_OVERRIDE_PATH2 "/mnt/flash/logs/"  // See notes for tiLogging_Init() below.
+#define TI_LOG_LINE_MAX                1024                // Longer log lines are truncated
+#define TI_LOG_QUEUE_SIZE              16384               // Bytes queued per thread by the asynchronous backend, power of 2
+#define TI_LOG_REPEAT_WINDOW_MS        1000                // Identical lines within this window are counted, not written
 
 #if __BIG_DEBUG__
 	#define  MAX_LOG_LEVEL_TO_STDIO  LOG_LEVEL_DEBUG
@@ -101,6 +104,65 @@ extern void time_printf_always(char const *fmt, ...);
  */
 extern void time_printf_always_localized(struct timespec const *callersStartTime, struct timespec const *callersCurrentTime, struct timespec *callersPrevTime, char const *fmt, ...);
 
+/**************************************************************************************************
+ * @fn      tiLogging_Log
+ * @brief   Formats one log line, prefixed like _PREPEND_TO_LOG, and writes it. Used by the
+ *          LOG_xxx() macros once the level has passed the filter.
+ *
+ *          With the asynchronous backend running, a complete line identical to the
+ *          previous one of the same thread within TI_LOG_REPEAT_WINDOW_MS is not
+ *          written again, it is counted and reported with the next different line
+ *          instead. Text that does not end a line, such as the bytes of a dump, is
+ *          never suppressed.
+ *
+ *          With the asynchronous backend running (see tiLogging_InitAsync()) the line
+ *          is queued for the writer thread, otherwise it is written right away.
+ *          LOG_FATAL lines are always written right away, after everything queued.
+ *
+ * input parameters
+ *
+ * @param level - LOG_LEVEL_xxx of the line
+ * @param *fmt  - printf() style format
+ *
+ * @return  NONE
+ **************************************************************************************************
+ */
+extern void tiLogging_Log(int level, char const *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**************************************************************************************************
+ * @fn      tiLogging_InitAsync
+ * @brief   Starts the asynchronous logging backend. Each thread then queues its lines in
+ *          its own lock-free queue of TI_LOG_QUEUE_SIZE bytes, and a writer thread
+ *          drains all queues with one writev() per batch. Lines that do not fit in the
+ *          queue are dropped and reported by the writer. Queued lines are flushed on
+ *          exit().
+ *
+ * @return  TRUE if the backend runs, FALSE if it could not be started and logging
+ *          stays synchronous.
+ **************************************************************************************************
+ */
+extern bool tiLogging_InitAsync(void);
+
+/**************************************************************************************************
+ * @fn      tiLogging_CloseAsync
+ * @brief   Writes out everything queued, stops the writer thread and returns to
+ *          synchronous logging. Other threads should no longer be logging.
+ *
+ * @return  NONE
+ **************************************************************************************************
+ */
+extern void tiLogging_CloseAsync(void);
+
+/**************************************************************************************************
+ * @fn      tiLogging_Flush
+ * @brief   Writes out everything queued by the asynchronous backend before returning.
+ *          Does nothing with synchronous logging.
+ *
+ * @return  NONE
+ **************************************************************************************************
+ */
+extern void tiLogging_Flush(void);
+
 #ifdef __DEBUG_TIME__
    /**************************************************************************************************
     * @fn      time_printf_start
@@ -133,8 +195,8 @@ extern void time_printf_always_localized(struct timespec const *callersStartTime
 
 // ------------------------------------------------------------------------
 // ------------------------------------------------------------------------
-// _PREPEND_TO_LOG is intended for use within this header, tiLogging.c and
-// time_printf.c ONLY
+// _PREPEND_TO_LOG is intended for use within time_printf.c ONLY. tiLogging_Log()
+// builds the same prefix itself.
 
 #ifdef __DEBUG_TIME__
 	#define  _PREPEND_TO_LOG(__CONST_FMT, __TM, __USECS)                  \
@@ -158,31 +220,14 @@ extern void time_printf_always_localized(struct timespec const *callersStartTime
 #define LOG_LEVEL_TRACE2  7
 #define LOG_LEVEL_MAX     LOG_LEVEL_TRACE2 // IMPORTANT! If this ever gets extended, you MUST extend the kLevelNames[] strings in tiLogging.c
 
-#ifdef __DEBUG_TIME__
-	#define INT_LOG(__LVL, __FMT, ...) do                                       \
-	{                                                                           \
-		struct timespec _currTime;                                               \
-		struct tm _currTm;                                                       \
-		long   _uSecs;                                                           \
-		if ((__LVL <= __APP_LOG_LEVEL) ||                                        \
-		    ((__LVL <= LOG_LEVEL_DEBUG) && __BIG_DEBUG_ACTIVE))                  \
-		{                                                                        \
-			clock_gettime(CLOCK_REALTIME, &_currTime);                            \
-			_currTm = *gmtime(&_currTime.tv_sec);                                 \
-			_uSecs = _currTime.tv_nsec/1000;                                      \
-			fprintf(LOG_DESTINATION_FP, _PREPEND_TO_LOG(__FMT, _currTm, _uSecs), ##__VA_ARGS__);\
-		}                                                                        \
-} while(0)
-#else
-	#define INT_LOG(__LVL, __FMT, ...) do                                       \
-	{                                                                           \
-		if ((__LVL <= __APP_LOG_LEVEL) ||                                        \
-		    ((__LVL <= LOG_LEVEL_DEBUG) && __BIG_DEBUG_ACTIVE))                  \
-		{                                                                        \
-			fprintf(LOG_DESTINATION_FP, _PREPEND_TO_LOG(__FMT), ##__VA_ARGS__);   \
-		}                                                                        \
+#define INT_LOG(__LVL, __FMT, ...) do                                       \
+{                                                                           \
+	if ((__LVL <= __APP_LOG_LEVEL) ||                                        \
+	    ((__LVL <= LOG_LEVEL_DEBUG) && __BIG_DEBUG_ACTIVE))                  \
+	{                                                                        \
+		tiLogging_Log(__LVL, __FMT, ##__VA_ARGS__);                           \
+	}                                                                        \
 } while(0)
-#endif
 
 #define LOG_TRACE2(__FMT, ...)   INT_LOG(LOG_LEVEL_TRACE2, "[TRACE2] " __FMT, ##__VA_ARGS__)
 #define LOG_TRACE(__FMT, ...)    INT_LOG(LOG_LEVEL_TRACE1, "[TRACE1] " __FMT, ##__VA_ARGS__)
@@ -58,10 +58,14 @@
 #include <sys/time.h>
 #include <unistd.h>
 #include <syscall.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
 
 #ifndef NPI_UNIX
 #include <netdb.h>
 #include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #endif
 
 /* NPI includes */
@@ -115,12 +119,43 @@
  *                                           Constant
  **************************************************************************************************/
 
-#define NPI_MSG_AREQ_READY			0x0000
-#define NPI_MSG_AREQ_BUSY			0x0001
-
 #define NPI_IPC_BUF_SIZE			(2 * (sizeof(npiMsgData_t)))
 
-typedef int (*npiProcessMsg_t)(npiMsgData_t *pBuf);
+// Number of preallocated AREQ message slots, must be a power of 2
+#ifndef NPI_IPC_AREQ_RING_SIZE
+#define NPI_IPC_AREQ_RING_SIZE		1024
+#endif
+#define NPI_IPC_AREQ_RING_MASK		(NPI_IPC_AREQ_RING_SIZE - 1)
+
+#if (NPI_IPC_AREQ_RING_SIZE & NPI_IPC_AREQ_RING_MASK)
+#error "NPI_IPC_AREQ_RING_SIZE must be a power of 2"
+#endif
+
+// Maximum number of AREQ messages handled per pass of the handle thread
+#define NPI_IPC_AREQ_BATCH			32
+
+// Maximum number of synchronous requests in flight per client
+#ifndef NPI_IPC_SREQ_MAX_PENDING
+#define NPI_IPC_SREQ_MAX_PENDING	16
+#endif
+
+// Completion status of a synchronous request still waiting for its response
+#define NPI_IPC_SREQ_WAITING		1
+
+// Maximum number of AREQ handlers registered at run time
+#ifndef NPI_IPC_AREQ_HANDLERS_MAX
+#define NPI_IPC_AREQ_HANDLERS_MAX	16
+#endif
+
+// Messages queued on an AREQ handler lane, further messages for it are dropped
+#ifndef NPI_IPC_AREQ_LANE_DEPTH
+#define NPI_IPC_AREQ_LANE_DEPTH		64
+#endif
+
+// Number of threads of the shared AREQ handler pool
+#ifndef NPI_IPC_AREQ_POOL_THREADS
+#define NPI_IPC_AREQ_POOL_THREADS	2
+#endif
 
 //if Value, max number of RPC command type change, this table needs to be updated.
 npiProcessMsg_t NpiAsyncMsgCbackParserTable[] =
@@ -207,13 +242,66 @@ const char * const RpcCmdType_list[RPC_SYS_MAX + 1] = { //18 Cmd Type
  *                                        Type definitions
  **************************************************************************************************/
 
-struct linkedAreqMsg
+// Slot of the AREQ ring. The sequence number tells whose turn it is; a slot
+// at position pos is free for a producer when sequence == pos, holds a
+// message for the consumer when sequence == pos + 1 and is handed back to
+// the producers by setting sequence to pos + NPI_IPC_AREQ_RING_SIZE.
+typedef struct
 {
+	volatile uint32 sequence;
+	npiSynchDataCback_t pSreqCback;	// set when the slot completes an NPI_SendSynchDataAsync request
+	void *pSreqCtx;
+	int sreqStatus;
 	npiMsgData_t message;
-	struct linkedAreqMsg *nextMessage;
-};
+} npiAreqSlot_t;
+
+// Synchronous request waiting for its response. The server answers the
+// requests of a connection in order, so these are kept in the order sent.
+// When the server grants NPI_LNX_FEATURE_CORRELATION_ID, the low byte of seq
+// goes along with the request and the response is matched on it instead.
+typedef struct
+{
+	uint32 seq;						// identifies the request to its waiter
+	uint8 subSys;					// subsystem of the request, without command type
+	uint8 cmdId;
+	uint8 abandoned;				// requester gave up, the response is discarded
+	npiSynchDataCback_t pCback;		// completion callback, NULL for NPI_SendSynchData
+	void *ctx;
+	npiMsgData_t *pRsp;				// NPI_SendSynchData buffer receiving the response
+	int *pStatus;					// NPI_SendSynchData completion status
+	struct timespec deadline;		// CLOCK_MONOTONIC time at which the request fails
+} npiSreqPending_t;
+
+// AREQ message waiting on a handler lane
+typedef struct
+{
+	npiProcessMsg_t pCback;
+	npiMsgData_t message;
+} npiAreqLaneMsg_t;
 
-typedef struct linkedAreqMsg areqMsg;
+// Queue of AREQ messages and the threads calling their handlers
+typedef struct
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t notEmpty;
+	npiAreqLaneMsg_t queue[NPI_IPC_AREQ_LANE_DEPTH];
+	int head;
+	int count;
+	uint32 dropped;					// messages which found the lane full
+	int stop;						// threads exit once the queue is empty
+	int numThreads;
+	pthread_t threadId[NPI_IPC_AREQ_POOL_THREADS];
+} npiAreqLane_t;
+
+// AREQ handler registered at run time
+typedef struct
+{
+	uint8 inUse;
+	uint8 subSys;
+	int cmdId;						// NPI_AREQ_CMD_ANY for the whole subsystem
+	npiProcessMsg_t pCback;
+	npiAreqLane_t *pLane;			// NULL for NPI_AREQ_LANE_INLINE
+} npiAreqHandler_t;
 
 
 /**************************************************************************************************
@@ -228,35 +316,73 @@ typedef struct linkedAreqMsg areqMsg;
 int sNPIconnected;
 // Client data transmission buffers
 char npi_ipc_buf[2][NPI_IPC_BUF_SIZE];
-// Client data AREQ received buffer
-areqMsg *npi_ipc_areq_rec_buf;
-// Client data AREQ processing buffer
-areqMsg *npi_ipc_areq_proc_buf;
-
-// Message count to keep track of incoming and processed messages
-static int messageCount = 0;
-
-// Client data SRSP reception buffer
-char npi_ipc_srsp_buf[(sizeof(npiMsgData_t))];
-
-// variable to store the number of received synchronous response bytes
-static int numOfReceievedSRSPbytes = 0;
+// Time a producer waits for a free AREQ slot before checking again whether
+// the consumer is blocked in a synchronous request
+#define NPI_IPC_AREQ_FULL_RECHECK_MS	10
+
+// Bounded multi-producer single-consumer ring of received AREQ messages
+static npiAreqSlot_t npiAreqRing[NPI_IPC_AREQ_RING_SIZE];
+// Next position to be claimed by a producer
+static volatile uint32 npiAreqRingHead = 0;
+// Next position to be handled by the consumer
+static volatile uint32 npiAreqRingTail = 0;
+// Set by the consumer before it blocks on the eventfd
+static volatile int npiAreqRingIdle = 0;
+// eventfd used to wake up the consumer
+static int npiAreqRingEventFd = -1;
+// Set by a producer before it waits for a free slot, and eventfd used to wake it up
+static volatile int npiAreqRingFull = 0;
+static int npiAreqRingSpaceFd = -1;
+// Set while the consumer waits for a synchronous response; producers must
+// not wait for a free slot then, the response is queued behind their message.
+static volatile int npiAreqRingConsumerInSreq = 0;
+// Deepest the ring has been, and number of AREQ messages lost to a full ring
+static volatile uint32 npiAreqRingHighWater = 0;
+static volatile uint32 npiAreqRingDropped = 0;
+
+// Synchronous requests in flight, oldest at npiSreqPendingHead
+static npiSreqPending_t npiSreqPending[NPI_IPC_SREQ_MAX_PENDING];
+static int npiSreqPendingHead = 0;
+static int npiSreqPendingCount = 0;
+static uint32 npiSreqSeq = 0;
+// eventfd used to make the read thread pick up the deadline of a new request
+static int npiSreqWakeFd = -1;
+// NPI_LNX_FEATURE_* granted by the server, only set before any request is in
+// flight
+static uint8 npiClientFeatures = 0;
+
+// Priority class last granted by NPI_SetQosClassReq, the server starts every
+// connection in NPI_LNX_QOS_CLASS_NORMAL
+static uint8 npiClientQosClass = NPI_LNX_QOS_CLASS_NORMAL;
+
+// Set by NPI_ClientInitEventLoop, the application then reads and handles
+// messages through NPI_ClientProcess instead of the client threads.
+static int npiClientEventLoop = FALSE;
+// Set while a thread reads the socket in event loop mode, protected by npiLnxClientSREQmutex
+static int npiClientReading = FALSE;
+// Set once the connection to the server is lost, protected by npiLnxClientSREQmutex
+static int npiClientConnLost = FALSE;
+
+// AREQ handlers registered at run time, looked up before NpiAsyncMsgCbackParserTable
+static npiAreqHandler_t npiAreqHandlers[NPI_IPC_AREQ_HANDLERS_MAX];
+static pthread_rwlock_t npiAreqHandlersLock = PTHREAD_RWLOCK_INITIALIZER;
+// Lane shared by handlers registered with NPI_AREQ_LANE_POOL, created on first use
+static npiAreqLane_t *npiAreqPool = NULL;
 
 static pthread_t NPIThreadId;
 static void *npi_ipc_readThreadFunc (void *ptr);
+static int npi_ipc_readMsg(short revents);
+
+static pthread_t npiHandleThreadId;
+
+// Number of handle thread wake-ups that found no work
+static uint32 npiClientIdleWakeups = 0;
 static void *npi_ipc_handleThreadFunc (void *ptr);
 
-// Mutex to handle synchronous response
+// Mutex to protect the synchronous requests in flight
 pthread_mutex_t npiLnxClientSREQmutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t npiLnxClientSREQSerializationMutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t npiLnxClientAREQmutex = PTHREAD_MUTEX_INITIALIZER;
-// conditional variable to notify Synchronous response
+// conditional variable to notify Synchronous response, or room for a new request
 static pthread_cond_t npiLnxClientSREQcond;
-// conditional variable to notify that the AREQ is handled
-static pthread_cond_t npiLnxClientAREQcond;
-
-// mutex variable, AREQ message processing status
-static uint8 areqMsgProcessStatus = NPI_MSG_AREQ_READY;
 
 #ifndef NPI_UNIX
 struct addrinfo *resAddr;
@@ -277,6 +403,28 @@ static uint8 npiState;
 static void npi_ipc_initsyncres(void);
 static void npi_ipc_delsyncres(void);
 
+static npiMsgData_t *npi_ipc_areqRingClaim(uint32 *pPos);
+static npiMsgData_t *npi_ipc_areqRingClaimWait(uint32 *pPos);
+static void npi_ipc_areqRingPublish(uint32 pos);
+static int npi_ipc_areqRingDrainBatch(void);
+
+static npiSreqPending_t *npi_ipc_sreqEnqueue(npiMsgData_t *pMsg, npiSynchDataCback_t pCback, void *ctx, int wait);
+static int npi_ipc_sreqWait(long remainingMicroseconds);
+static void npi_ipc_sreqPost(const npiSreqPending_t *pEntry, int status, npiMsgData_t *pRsp);
+static void npi_ipc_sreqComplete(npiMsgData_t *pRsp);
+static void npi_ipc_sreqCompleteById(npiMsgData_t *pRsp, uint8 corrId);
+static void npi_ipc_sreqRemove(int index);
+static void npi_ipc_connectionLost(void);
+static int npi_ipc_sreqSend(npiMsgData_t *pMsg, uint32 seq);
+static void npi_ipc_requestFeatures(uint8 *pVersion);
+static int npi_ipc_sreqExpire(void);
+
+static npiAreqLane_t *npi_ipc_laneCreate(int numThreads);
+static void npi_ipc_laneDestroy(npiAreqLane_t *pLane);
+static int npi_ipc_laneIsOwnThread(npiAreqLane_t *pLane);
+static int npi_ipc_lanePush(npiAreqLane_t *pLane, npiProcessMsg_t pCback, npiMsgData_t *pMsg);
+static void *npi_ipc_laneThreadFunc(void *ptr);
+
 /**************************************************************************************************
  *
  * @fn          NPI_ClientInit
@@ -480,12 +628,42 @@ int NPI_ClientInit(const char *devPath)
     		res = NPI_LNX_ERROR_IPC_SOCKET_SET_SOCKET_OPTIONS;
     	}
     }
+#ifndef NPI_UNIX
+    if (res == NPI_LNX_SUCCESS)
+    {
+    	// Requests of a batch are sent back to back, without Nagle's
+    	// algorithm they are not held back until the server acknowledges
+    	// the first one.
+    	int yes = 1;
+    	if (setsockopt(sNPIconnected, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(int)) == -1)
+    	{
+    		LOG_WARN("[NPI Client] %s(): Failed to disable Nagle's algorithm, errno %d\n", __FUNCTION__, errno);
+    	}
+    }
+#endif //NPI_UNIX
 
 	/**********************************************************************
 	 * Create thread which can read new messages from the NPI server
 	 **********************************************************************/
 
     if (res == NPI_LNX_SUCCESS)
+    {
+    	// In event loop mode the application polls the AREQ eventfd, which
+    	// then also announces new request deadlines.
+    	if (((npiAreqRingEventFd = eventfd(0, npiClientEventLoop ? EFD_NONBLOCK : 0)) < 0) ||
+    		((npiAreqRingSpaceFd = eventfd(0, 0)) < 0) ||
+    		((npiSreqWakeFd = (npiClientEventLoop ? dup(npiAreqRingEventFd) : eventfd(0, 0))) < 0))
+    	{
+    		LOG_ERROR("[NPI Client] %s(): Failed to create AREQ eventfd\n", __FUNCTION__);
+            res = NPI_LNX_ERROR_IPC_THREAD_CREATION_FAILED;
+    	}
+    }
+
+    if ((res == NPI_LNX_SUCCESS) && npiClientEventLoop)
+    {
+    	LOG_INFO("[NPI Client] Event loop mode, messages are handled by NPI_ClientProcess()\n");
+    }
+    else if (res == NPI_LNX_SUCCESS)
     {
     	if (pthread_create(&NPIThreadId, NULL, npi_ipc_readThreadFunc, NULL))
     	{
@@ -499,9 +677,9 @@ int NPI_ClientInit(const char *devPath)
 	 * Create thread which can handle new messages from the NPI server
 	 **********************************************************************/
 
-    if (res == NPI_LNX_SUCCESS)
+    if ((res == NPI_LNX_SUCCESS) && !npiClientEventLoop)
     {
-    	if (pthread_create(&NPIThreadId, NULL, npi_ipc_handleThreadFunc, NULL))
+    	if (pthread_create(&npiHandleThreadId, NULL, npi_ipc_handleThreadFunc, NULL))
     	{
     		// thread creation failed
     		LOG_ERROR("[NPI Client] Failed to create NPI IPC Client handle thread\n");
@@ -513,8 +691,8 @@ int NPI_ClientInit(const char *devPath)
     {
     	uint8 version[3];
     	uint8 param[2];
-		//Read Software Version.
-		NPI_ReadVersionReq(version);
+		//Read Software Version, and agree on protocol features
+		npi_ipc_requestFeatures(version);
 		LOG_INFO("[NPI Client] Connected to Server v%d.%d.%d\n", version[0], version[1], version[2]);
 
 		//Read Number of Active Connection Version.
@@ -529,6 +707,163 @@ int NPI_ClientInit(const char *devPath)
 	return res;
 }
 
+/**************************************************************************************************
+ *
+ * @fn          NPI_ClientInitEventLoop
+ *
+ * @brief       This function initializes RTI Surrogate without client threads.
+ *              The application polls the descriptors returned by
+ *              NPI_ClientGetPollFds in its own event loop and calls
+ *              NPI_ClientProcess when one is readable, or when the timeout
+ *              returned by the previous NPI_ClientProcess call expires.
+ *              NPI_AsynchMsgCback and the NPI_SendSynchDataAsync callbacks
+ *              then run in the thread calling NPI_ClientProcess.
+ *
+ * input parameters
+ *
+ * @param       devPath - path to the NPI Server Socket
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      Same as NPI_ClientInit.
+ *
+ **************************************************************************************************/
+int NPI_ClientInitEventLoop(const char *devPath)
+{
+	npiClientEventLoop = TRUE;
+
+	return NPI_ClientInit(devPath);
+}
+
+/**************************************************************************************************
+ *
+ * @fn          NPI_ClientGetPollFds
+ *
+ * @brief       This function returns the descriptors an application in event
+ *              loop mode must poll for reading.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * @param       pSocketFd - socket connected to the NPI server
+ * @param       pWakeFd - eventfd signaled when received messages were queued
+ *                        by another thread, or a request deadline changed
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+void NPI_ClientGetPollFds(int *pSocketFd, int *pWakeFd)
+{
+	*pSocketFd = sNPIconnected;
+	*pWakeFd = npiAreqRingEventFd;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          NPI_ClientProcess
+ *
+ * @brief       This function reads the messages ready on the NPI server socket
+ *              and handles all queued messages, in event loop mode. It does
+ *              not block, except to read the rest of a message already
+ *              started.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * @param       pTimeout - milliseconds until NPI_ClientProcess must be called
+ *                         again if no descriptor becomes readable, -1 if
+ *                         there is no such deadline.
+ *
+ * @return      NPI_LNX_SUCCESS, or NPI_LNX_FAILURE if the connection to the
+ *              server is lost.
+ *
+ **************************************************************************************************/
+int NPI_ClientProcess(int *pTimeout)
+{
+	int ret = NPI_LNX_SUCCESS, reader, received = 0, processed = 0, batch, i;
+	struct pollfd ufds[1];
+	eventfd_t wakeups;
+
+	// Clear the wake-up, then look at everything it may have announced
+	npiAreqRingIdle = 0;
+	if ((eventfd_read(npiAreqRingEventFd, &wakeups) < 0) && (errno != EAGAIN))
+	{
+		LOG_ERROR("[NPI Client PROCESS] Failed to read AREQ eventfd, errno %d\n", errno);
+	}
+
+	ufds[0].fd = sNPIconnected;
+	ufds[0].events = POLLIN | POLLPRI;
+	do
+	{
+		// A thread waiting for a synchronous response may be reading the socket already
+		pthread_mutex_lock(&npiLnxClientSREQmutex);
+		if ((reader = !npiClientReading))
+		{
+			npiClientReading = TRUE;
+		}
+		pthread_mutex_unlock(&npiLnxClientSREQmutex);
+
+		// Read a batch at a time, and handle it before reading more, so the
+		// ring never fills up with nobody to drain it.
+		for (i = 0; reader && (i < NPI_IPC_AREQ_BATCH) && (ret == NPI_LNX_SUCCESS); i++)
+		{
+			if (poll(ufds, 1, 0) <= 0)
+			{
+				break;
+			}
+			ret = npi_ipc_readMsg(ufds[0].revents);
+			received++;
+		}
+
+		// Give up reading while the callbacks run, a synchronous request made
+		// from one of them reads its own response.
+		if (reader)
+		{
+			pthread_mutex_lock(&npiLnxClientSREQmutex);
+			npiClientReading = FALSE;
+			// Let a synchronous requester take over reading
+			pthread_cond_broadcast(&npiLnxClientSREQcond);
+			pthread_mutex_unlock(&npiLnxClientSREQmutex);
+		}
+
+		while ((batch = npi_ipc_areqRingDrainBatch()) > 0)
+		{
+			processed += batch;
+		}
+	} while ((i == NPI_IPC_AREQ_BATCH) && (received < NPI_IPC_AREQ_RING_SIZE));
+
+	// Fail requests without response, their callbacks run on the next call
+	*pTimeout = npi_ipc_sreqExpire();
+
+	// Announce that the application is about to wait, and make sure a message
+	// queued in between wakes it up again.
+	npiAreqRingIdle = 1;
+	__sync_synchronize();
+	if ((npiAreqRing[npiAreqRingTail & NPI_IPC_AREQ_RING_MASK].sequence == (npiAreqRingTail + 1)) &&
+			__sync_lock_test_and_set(&npiAreqRingIdle, 0))
+	{
+		if (eventfd_write(npiAreqRingEventFd, 1) < 0)
+		{
+			LOG_ERROR("[NPI Client PROCESS] Failed to wake up application, errno %d\n", errno);
+		}
+	}
+
+	if (!received && !processed)
+	{
+		npiClientIdleWakeups++;
+	}
+
+	return ret;
+}
+
 /**************************************************************************************************
  *
  * @fn          npi_ipc_handleThreadFunc
@@ -549,90 +884,44 @@ int NPI_ClientInit(const char *devPath)
  **************************************************************************************************/
 static void *npi_ipc_handleThreadFunc (void *ptr)
 {
-	int done = 0, tryLockFirstTimeOnly = 0;
+	int done = 0, processed, batch;
+	eventfd_t wakeups;
 
 	// Handle message from socket
 	do {
-
-		if (tryLockFirstTimeOnly == 0)
+		// Announce that we are about to block, then look at the ring once more
+		// so that a message published in between is not missed.
+		npiAreqRingIdle = 1;
+		__sync_synchronize();
+		if (npiAreqRing[npiAreqRingTail & NPI_IPC_AREQ_RING_MASK].sequence != (npiAreqRingTail + 1))
 		{
-			// Lock mutex
-			LOG_TRACE("[NPI Client HANDLE][MUTEX] Lock AREQ Mutex (Handle)\n");
-			int mutexRet = 0, writeOnce = 0;
-			while ( (mutexRet = pthread_mutex_trylock(&npiLnxClientAREQmutex)) == EBUSY)
+			LOG_TRACE("[NPI Client HANDLE] Wait for AREQ eventfd\n");
+			if (eventfd_read(npiAreqRingEventFd, &wakeups) < 0)
 			{
-				if (writeOnce == 0)
+				if (errno != EINTR)
 				{
-					LOG_TRACE("[NPI Client HANDLE][MUTEX] AREQ Mutex (Handle) busy");
-					fflush(LOG_DESTINATION_FP);
-					writeOnce++;
-				}
-				else
-				{
-					writeOnce++;
-					if ( (writeOnce % 1000) == 0)
-					{
-						LOG_TRACE(".");
-					}
-					if (writeOnce > 0xEFFFFFF0)
-						writeOnce = 1;
-					fflush(LOG_DESTINATION_FP);
+					LOG_ERROR("[NPI Client HANDLE][ERR] Failed to read AREQ eventfd, errno %d\n", errno);
+					done = 1;
 				}
+				continue;
 			}
-			LOG_TRACE("[NPI Client HANDLE][MUTEX] AREQ Lock (Handle) status: %d\n", mutexRet);
-			tryLockFirstTimeOnly = 1;
 		}
+		npiAreqRingIdle = 0;
 
-		// Conditional wait for the response handled in the AREQ handling thread,
-		LOG_TRACE("[NPI Client HANDLE][MUTEX] Wait for AREQ Cond (Handle) signal... (areqMsgProcessStatus = %d), effectively releasing lock\n", areqMsgProcessStatus);
-		pthread_cond_wait(&npiLnxClientAREQcond, &npiLnxClientAREQmutex);
-		LOG_TRACE("[NPI Client HANDLE][MUTEX] AREQ (Handle) has lock\n");
-
-		// Walk through all received AREQ messages before releasing MUTEX
-		areqMsg *searchList = npi_ipc_areq_proc_buf, *clearList;
-		while (searchList != NULL)
+		// Drain all received AREQ messages, a batch at a time
+		processed = 0;
+		while ((batch = npi_ipc_areqRingDrainBatch()) > 0)
 		{
-			LOG_TRACE("[NPI Client HANDLE][DBG] Processing \t@ %p next \t@ %p\n",
-					(void *)searchList,
-					(void *)(searchList->nextMessage));
-
-			// Must remove command type before calling NPI_AsynchMsgCback
-			searchList->message.subSys &= ~(RPC_CMD_TYPE_MASK);
-
-			LOG_TRACE("[NPI Client HANDLE][MUTEX] AREQ Calling NPI_AsynchMsgCback (Handle)...\n");
-
-			NPI_AsynchMsgCback((npiMsgData_t *)&(searchList->message));
-
-			LOG_TRACE("[NPI Client HANDLE][MUTEX] AREQ (Handle) (message @ %p)...\n", (void *)searchList);
+			processed += batch;
+		}
 
-			clearList = searchList;
-			// Set search list to next message
-			searchList = searchList->nextMessage;
-			// Free processed buffer
-			if (clearList == NULL)
-			{
-				// Impossible error, must abort
-				done = 1;
-				LOG_ERROR("[NPI Client HANDLE][ERR] clearList buffer was already free\n");
-				break;
-			}
-			else
-			{
-				messageCount--;
-				LOG_TRACE("[NPI Client HANDLE][DBG] Clearing \t\t@ %p (processed %d messages)...\n",
-						(void *)clearList,
-						messageCount);
-				memset(clearList, 0, sizeof(areqMsg));
-				free(clearList);
-			}
+		if (!processed)
+		{
+			npiClientIdleWakeups++;
 		}
-		LOG_TRACE("[NPI Client HANDLE][MUTEX] AREQ Signal message(s) handled (Handle) (processed %d messages)...\n", messageCount);
-		// Signal to the read thread that we're ready for more
-		//			pthread_cond_signal(&npiLnxClientAREQcond);
-		areqMsgProcessStatus = NPI_MSG_AREQ_READY;
 
 		LOG_DEBUG("[NPI Client HANDLE][DBG] Finished processing (processed %d messages)...\n",
-				messageCount);
+				processed);
 
 	} while (!done);
 
@@ -659,38 +948,37 @@ static void *npi_ipc_handleThreadFunc (void *ptr)
  **************************************************************************************************/
 static void *npi_ipc_readThreadFunc (void *ptr)
 {
-	int done = 0, n = 0;
-
-	int mutexRet = 0;
-#ifdef __BIG_DEBUG__
-	static int writeOnceAREQMutexTry = 0, writeOnceAREQReady = 0;
-#endif //__BIG_DEBUG__
+	int done = 0;
 
 	/* thread loop */
 
-	struct pollfd ufds[1];
-	int pollRet;
+	struct pollfd ufds[2];
+	int pollRet, timeout;
+	eventfd_t wakeups;
 	ufds[0].fd = sNPIconnected;
 	ufds[0].events = POLLIN | POLLPRI;
+	ufds[1].fd = npiSreqWakeFd;
+	ufds[1].events = POLLIN;
 
 	// Read from socket
 	do {
-		// To be able to continue processing previous AREQ we need to perform a non-blocking read of the socket,
-		// this is solved by using poll() to see if there are bytes to read.
-
-		if (npi_ipc_areq_rec_buf != NULL)
-		{
-#ifdef __DEBUG_TIME__
-			LOG_TRACE("[NPI Client READ] Read thread 1ms timeout \n");
-#endif //__DEBUG_TIME__
-			// In case there are messages received yet to be processed allow processing by timing out after 1ms.
-			pollRet = poll((struct pollfd*)&ufds, 1, 1);
-		}
-		else
+		// AREQ messages are handed over through the ring as soon as they are
+		// received, so the only reason to time out is a request of
+		// NPI_SendSynchDataAsync that must fail if it gets no response.
+		timeout = npi_ipc_sreqExpire();
+		LOG_TRACE("[NPI Client READ] Read thread Wait %d ms\n", timeout);
+		pollRet = poll((struct pollfd*)&ufds, 2, timeout);
+		if ((pollRet > 0) && (ufds[1].revents & POLLIN))
 		{
-			// In case there are no messages received to be processed wait forever.
-			LOG_TRACE("[NPI Client READ] Read thread Wait forever\n");
-			pollRet = poll((struct pollfd*)&ufds, 1, -1);
+			if (eventfd_read(npiSreqWakeFd, &wakeups) < 0)
+			{
+				LOG_ERROR("[NPI Client READ] Failed to read request eventfd, errno %d\n", errno);
+			}
+			if (!ufds[0].revents)
+			{
+				// Only woken up to arm a new deadline
+				continue;
+			}
 		}
 
 		if (pollRet == -1)
@@ -704,267 +992,188 @@ static void *npi_ipc_readThreadFunc (void *ptr)
 		}
 		else if (pollRet == 0)
 		{
-			// Timeout, could still be AREQ to process
+			// Deadline of an asynchronous request, expired on the next pass
 		}
 		else
 		{
-			if (ufds[0].revents & POLLIN) {
-				n = recv(sNPIconnected,
-						npi_ipc_buf[0],
-						RPC_FRAME_HDR_SZ,
-						0); // normal data
-			}
-			if (ufds[0].revents & POLLPRI) {
-				n = recv(sNPIconnected,
-						npi_ipc_buf[0],
-						RPC_FRAME_HDR_SZ,
-						MSG_OOB); // out-of-band data
-			}
-			if (n <= 0)
-			{
-				if (n < 0)
-					LOG_ERROR("[NPI Client] recv");
-				done = 1;
-				LOG_ERROR("Error: RECEIVED %d bytes.. other side might have closed connection\n", n);
-			}
-			else if  (n != RPC_FRAME_HDR_SZ)
-			{
-				// Invalid length received
-				LOG_ERROR("[NPI Client READ] Received invalid number of bytes %d, expected %d. Errno: %d\n",
-						n, RPC_FRAME_HDR_SZ, errno);
-			}
-			else
-			{
-				// We have received the header, now read out length bytes and process it,
-				// if there are bytes to receive.
-				if (((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len > 0)
-				{
-					n = recv(sNPIconnected,
-							(uint8*)&(npi_ipc_buf[0][RPC_FRAME_HDR_SZ]),
-							((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len,
-							0);
-				}
-				else
-				{
-					// There are no payload bytes; which is also valid.
-					n = ((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len;
-				}
+			done = (npi_ipc_readMsg(ufds[0].revents) != NPI_LNX_SUCCESS);
+		}
 
-				if (n != ((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len)
-				{
-					// Invalid length received
-					LOG_ERROR("[NPI Client READ] Received invalid number of bytes %d, expected %d. Errno: %d\n",
-							n, ((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len, errno);
-				}
-				else
-				{
-					int i;
-				    char str[256];
-				    uint8 charWritten;
-				    charWritten = snprintf(str, sizeof(str), "[NPI Client READ] Received %d bytes,\t subSys 0x%.2X, cmdId 0x%.2X, pData:\t",
-											((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len,
-											((npiMsgData_t *)&(npi_ipc_buf[0][0]))->subSys,
-											((npiMsgData_t *)&(npi_ipc_buf[0][0]))->cmdId);
-				    charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, "\t");
-					for (i = 3; i < (n + RPC_FRAME_HDR_SZ); i++)
-				    {
-				       charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, " 0x%.2X", (uint8)npi_ipc_buf[0][i]);
-				    }
-				    charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, "\n");
-				    LOG_DEBUG("%s", str);
-
-					if ( ( (uint8)(((npiMsgData_t *)&(npi_ipc_buf[0][0]))->subSys) & (uint8)RPC_CMD_TYPE_MASK) == RPC_CMD_SRSP )
-					{
-						numOfReceievedSRSPbytes = ((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len + RPC_FRAME_HDR_SZ;
+	} while (!done);
 
-						// Copy buffer so that we don't clear it before it's handled.
-						memcpy(npi_ipc_srsp_buf,
-								(uint8*)&(npi_ipc_buf[0][0]),
-								numOfReceievedSRSPbytes);
-
-						// and signal the synchronous reception
-						LOG_DEBUG("[NPI Client READ][MUTEX] SRSP Cond signal set\n");
-						LOG_TRACE("[NPI Client READ] Client Read SRSP: (len %d)\n", numOfReceievedSRSPbytes);
-						fflush(LOG_DESTINATION_FP);
-						// Get mutex first
-						pthread_mutex_lock(&npiLnxClientSREQmutex);   // Make sure the receiver has begin the wait on the cond so it doesn't miss the signal.
-						pthread_cond_signal(&npiLnxClientSREQcond);   // Signal the receiver, unblocking it on the cond.
-						pthread_mutex_unlock(&npiLnxClientSREQmutex); // Release the mutex so the receiver can re-acquire it.
-					}
-					else if ( ( (uint8)(((npiMsgData_t *)&(npi_ipc_buf[0][0]))->subSys) & (uint8)RPC_CMD_TYPE_MASK) == RPC_CMD_AREQ )
-					{
-						LOG_DEBUG("[NPI Client READ] RPC_CMD_AREQ cmdId: 0x%.2X\n", ((npiMsgData_t *)&(npi_ipc_buf[0][0]))->cmdId);
-						// Verify the size of the incoming message before passing it
-						if ( (((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len + RPC_FRAME_HDR_SZ) <= sizeof(npiMsgData_t) )
-						{
-							// Allocate memory for new message
-							areqMsg *newMessage = (areqMsg *) malloc(sizeof(areqMsg));
-							if (newMessage == NULL)
-							{
-								// Serious error, must abort
-								done = 1;
-								LOG_ERROR("[NPI Client READ] Could not allocate memory for AREQ message\n");
-								break;
-							}
-							else
-							{
-								messageCount++;
-								memset(newMessage, 0, sizeof(areqMsg));
-								LOG_TRACE("[NPI Client READ][DBG] Allocated \t@ %p (received\040 %d messages)...\n",
-										(void *)newMessage,
-										messageCount);
-							}
-
-							LOG_TRACE("[NPI Client READ] Filling new message (@ %p)...\n", (void *)newMessage);
-
-							// Copy AREQ message into AREQ buffer
-							memcpy(&(newMessage->message),
-									(uint8*)&(npi_ipc_buf[0][0]),
-									(((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len + RPC_FRAME_HDR_SZ));
-
-							// Place message in read list
-							if (npi_ipc_areq_rec_buf == NULL)
-							{
-								// First message in list
-								npi_ipc_areq_rec_buf = newMessage;
-							}
-							else
-							{
-								areqMsg *searchList = npi_ipc_areq_rec_buf;
-								// Find last entry and place it here
-								while (searchList->nextMessage != NULL)
-								{
-									searchList = searchList->nextMessage;
-								}
-								searchList->nextMessage = newMessage;
-							}
-						}
-						else
-						{
-							// Serious error
-							LOG_ERROR("[NPI Client READ] ERR: Incoming AREQ has incorrect length field; %d\n",
-									((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len);
-
-							LOG_TRACE("[NPI Client READ][MUTEX] Unlock AREQ Mutex (Read)\n");
-							// Then unlock the thread so the handle can handle the AREQ
-							pthread_mutex_unlock(&npiLnxClientAREQmutex);
-						}
 
-					}
-					else
-					{
-						// Cannot handle synchronous requests from RNP
-						LOG_ERROR("[NPI Client READ] ERR: Received unknown subsystem: 0x%.2X\n", ((npiMsgData_t *)&(npi_ipc_buf[0][0]))->subSys);
-					}
+	return ptr;
+}
 
-					// Clear buffer for next message
-					memset(npi_ipc_buf[0], 0, NPI_IPC_BUF_SIZE);
-				}
-			}
-		}
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_readMsg
+ *
+ * @brief       This function reads one message from the NPI server socket and
+ *              dispatches it. The caller must have seen the socket readable,
+ *              and must be the only one reading it.
+ *
+ * input parameters
+ *
+ * @param       revents - poll events returned for the socket
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      NPI_LNX_SUCCESS, or NPI_LNX_FAILURE if the connection is lost.
+ *
+ **************************************************************************************************/
+static int npi_ipc_readMsg(short revents)
+{
+	int ret = NPI_LNX_SUCCESS, n = 0;
+
+	if (revents & POLLIN) {
+		n = recv(sNPIconnected,
+				npi_ipc_buf[0],
+				RPC_FRAME_HDR_SZ,
+				MSG_WAITALL); // normal data, may straddle segments under load
+	}
+	if (revents & POLLPRI) {
+		n = recv(sNPIconnected,
+				npi_ipc_buf[0],
+				RPC_FRAME_HDR_SZ,
+				MSG_OOB); // out-of-band data
+	}
+	if (n <= 0)
+	{
+		if (n < 0)
+			LOG_ERROR("[NPI Client] recv");
+		ret = NPI_LNX_FAILURE;
+		LOG_ERROR("Error: RECEIVED %d bytes.. other side might have closed connection\n", n);
+		npi_ipc_connectionLost();
+	}
+	else if  (n != RPC_FRAME_HDR_SZ)
+	{
+		// Invalid length received
+		LOG_ERROR("[NPI Client READ] Received invalid number of bytes %d, expected %d. Errno: %d\n",
+				n, RPC_FRAME_HDR_SZ, errno);
+	}
+	else
+	{
+		int corrId = -1;
 
-		// Place processing of AREQ message here so it can be retried without receiving a new message
-		// TODO: Can we replace this while with something a little safer?
-		if (areqMsgProcessStatus != NPI_MSG_AREQ_READY)
+		// Responses carry the correlation identifier of their request after the header
+		if (((((npiMsgData_t *)&(npi_ipc_buf[0][0]))->subSys & RPC_CMD_TYPE_MASK) == RPC_CMD_SRSP) &&
+				(npiClientFeatures & NPI_LNX_FEATURE_CORRELATION_ID))
 		{
-#ifdef __BIG_DEBUG__
-			// Can only process 1 AREQ at a time...
-			if (writeOnceAREQReady == 0)
+			uint8 id;
+			if (recv(sNPIconnected, &id, 1, MSG_WAITALL) != 1)
 			{
-				LOG_TRACE("[NPI Client READ][MUTEX] Waiting for AREQ Handle to acknowledge processing the message\n");
-				fflush(LOG_DESTINATION_FP);
-				writeOnceAREQReady++;
+				// The response cannot be matched to its request, treat as a lost connection
+				LOG_ERROR("[NPI Client READ] Failed to receive correlation identifier. Errno: %d\n", errno);
+				npi_ipc_connectionLost();
+				return NPI_LNX_FAILURE;
 			}
-			else
+			corrId = id;
+		}
+
+		// We have received the header, now read out length bytes and process it,
+		// if there are bytes to receive.
+		if (((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len > 0)
+		{
+			n = recv(sNPIconnected,
+					(uint8*)&(npi_ipc_buf[0][RPC_FRAME_HDR_SZ]),
+					((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len,
+					MSG_WAITALL);
+		}
+		else
+		{
+			// There are no payload bytes; which is also valid.
+			n = ((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len;
+		}
+
+		if (n != ((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len)
+		{
+			// Invalid length received
+			LOG_ERROR("[NPI Client READ] Received invalid number of bytes %d, expected %d. Errno: %d\n",
+					n, ((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len, errno);
+		}
+		else
+		{
+			int i;
+		    char str[256];
+		    uint8 charWritten;
+		    charWritten = snprintf(str, sizeof(str), "[NPI Client READ] Received %d bytes,\t subSys 0x%.2X, cmdId 0x%.2X, pData:\t",
+									((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len,
+									((npiMsgData_t *)&(npi_ipc_buf[0][0]))->subSys,
+									((npiMsgData_t *)&(npi_ipc_buf[0][0]))->cmdId);
+		    charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, "\t");
+			for (i = 3; i < (n + RPC_FRAME_HDR_SZ); i++)
+		    {
+		       charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, " 0x%.2X", (uint8)npi_ipc_buf[0][i]);
+		    }
+		    charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, "\n");
+		    LOG_DEBUG("%s", str);
+
+			if ( ( (uint8)(((npiMsgData_t *)&(npi_ipc_buf[0][0]))->subSys) & (uint8)RPC_CMD_TYPE_MASK) == RPC_CMD_SRSP )
 			{
-				writeOnceAREQReady++;
-				if ( (writeOnceAREQReady % 1000) == 0)
-				{
-					LOG_TRACE("[NPI Client READ][MUTEX] Still waiting for AREQ Handle to acknowledge processing the message\n");
-				}
-				else if ( (writeOnceAREQReady % 10) == 0)
+				LOG_TRACE("[NPI Client READ] Client Read SRSP: (len %d)\n", ((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len + RPC_FRAME_HDR_SZ);
+
+				// Hand the response to the request it answers
+				if (corrId >= 0)
 				{
-					LOG_TRACE("*");
+					npi_ipc_sreqCompleteById((npiMsgData_t *)&(npi_ipc_buf[0][0]), (uint8)corrId);
 				}
-				if (writeOnceAREQReady > 0xEFFFFFF0)
-					writeOnceAREQReady = 1;
-				fflush(LOG_DESTINATION_FP);
-			}
-#endif //__BIG_DEBUG__
-			if ( (messageCount > 100) && ( (messageCount % 100) == 0) )
-			{
-				LOG_WARN("[NPI Client READ] AREQ message count: %4d\n", messageCount);
-				if (messageCount > 500)
+				else
 				{
-					LOG_WARN("[NPI Client READ] SEVERE: More than 500 messages in the buffer requires attention!\n");
+					npi_ipc_sreqComplete((npiMsgData_t *)&(npi_ipc_buf[0][0]));
 				}
 			}
-		}
-		// Handle thread must make sure it has finished its list. See if there are new messages to move over
-		else if (npi_ipc_areq_rec_buf != NULL)
-		{
-#ifdef __BIG_DEBUG__
-			if (writeOnceAREQMutexTry == 0)
-				LOG_TRACE("[NPI Client READ][MUTEX] Lock AREQ Mutex (Read)\n");
-#endif //__BIG_DEBUG__
-			if ( (mutexRet = pthread_mutex_trylock(&npiLnxClientAREQmutex)) == EBUSY)
+			else if ( ( (uint8)(((npiMsgData_t *)&(npi_ipc_buf[0][0]))->subSys) & (uint8)RPC_CMD_TYPE_MASK) == RPC_CMD_AREQ )
 			{
-#ifdef __BIG_DEBUG__
-				if (writeOnceAREQMutexTry == 0)
+				LOG_DEBUG("[NPI Client READ] RPC_CMD_AREQ cmdId: 0x%.2X\n", ((npiMsgData_t *)&(npi_ipc_buf[0][0]))->cmdId);
+				// Verify the size of the incoming message before passing it
+				if ( (((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len + RPC_FRAME_HDR_SZ) <= sizeof(npiMsgData_t) )
 				{
-					LOG_TRACE("[NPI Client READ][MUTEX] AREQ Mutex (Read) busy");
-					fflush(LOG_DESTINATION_FP);
-					writeOnceAREQMutexTry++;
+					uint32 pos;
+					npiMsgData_t *pSlotMsg = npi_ipc_areqRingClaimWait(&pos);
+
+					if (pSlotMsg == NULL)
+					{
+						// The handle thread waits for a response behind this message,
+						// it cannot free a slot, so the message is lost.
+						npiAreqRingDropped++;
+						LOG_ERROR("[NPI Client READ] ERR: AREQ queue full (%d messages), dropping cmdId 0x%.2X\n",
+								NPI_IPC_AREQ_RING_SIZE, ((npiMsgData_t *)&(npi_ipc_buf[0][0]))->cmdId);
+					}
+					else
+					{
+						LOG_TRACE("[NPI Client READ] Filling AREQ slot %u...\n", pos);
+						npiAreqRing[pos & NPI_IPC_AREQ_RING_MASK].pSreqCback = NULL;
+
+						// Copy AREQ message into its slot and hand it to the handle thread
+						memcpy(pSlotMsg,
+								(uint8*)&(npi_ipc_buf[0][0]),
+								(((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len + RPC_FRAME_HDR_SZ));
+						npi_ipc_areqRingPublish(pos);
+					}
 				}
 				else
 				{
-					writeOnceAREQMutexTry++;
-					if ( (writeOnceAREQMutexTry % 100) == 0)
-					{
-						LOG_TRACE(".");
-					}
-					if (writeOnceAREQMutexTry > 0xEFFFFFF0)
-						writeOnceAREQMutexTry = 1;
-					fflush(LOG_DESTINATION_FP);
+					// Serious error
+					LOG_ERROR("[NPI Client READ] ERR: Incoming AREQ has incorrect length field; %d\n",
+							((npiMsgData_t *)&(npi_ipc_buf[0][0]))->len);
 				}
-#endif //__BIG_DEBUG__
+
 			}
-			else if (mutexRet == 0)
+			else
 			{
-#ifdef __BIG_DEBUG__
-				writeOnceAREQMutexTry = 0;
-				LOG_TRACE("[NPI Client READ][MUTEX] AREQ Lock (Read), status: %d\n", mutexRet);
-#endif //__BIG_DEBUG__
-
-				areqMsgProcessStatus = NPI_MSG_AREQ_BUSY;
-
-				// Move list over for processing
-				npi_ipc_areq_proc_buf = npi_ipc_areq_rec_buf;
-				// Clear receiving buffer for new messages
-				npi_ipc_areq_rec_buf = NULL;
-
-				LOG_TRACE("[NPI Client READ][DBG] Copied message list (processed %d messages)...\n",
-						messageCount);
-
-				LOG_TRACE("[NPI Client READ][MUTEX] Unlock AREQ Mutex (Read)\n");
-				// Then unlock the thread so the handle can handle the AREQ
-				pthread_mutex_unlock(&npiLnxClientAREQmutex);
-
-				LOG_TRACE("[NPI Client READ][MUTEX] AREQ Signal message read (Read)...\n");
-				// Signal to the handle thread an AREQ message is ready
-				pthread_cond_signal(&npiLnxClientAREQcond);
-				LOG_TRACE("[NPI Client READ][MUTEX] AREQ Signal message read (Read)... sent\n");
-
-#ifdef __BIG_DEBUG__
-				writeOnceAREQReady = 0;
-#endif //__BIG_DEBUG__
+				// Cannot handle synchronous requests from RNP
+				LOG_ERROR("[NPI Client READ] ERR: Received unknown subsystem: 0x%.2X\n", ((npiMsgData_t *)&(npi_ipc_buf[0][0]))->subSys);
 			}
+
+			// Clear buffer for next message
+			memset(npi_ipc_buf[0], 0, NPI_IPC_BUF_SIZE);
 		}
+	}
 
-	} while (!done);
-
-
-	return ptr;
+	return ret;
 }
 
 /**************************************************************************************************
@@ -986,271 +1195,1805 @@ static void *npi_ipc_readThreadFunc (void *ptr)
  **************************************************************************************************/
 static void npi_ipc_initsyncres(void)
 {
+  uint32 pos;
+
   // initialize all mutexes
   pthread_mutex_init(&npiLnxClientSREQmutex, NULL);
-  pthread_mutex_init(&npiLnxClientAREQmutex, NULL);
 
-  // initialize all conditional variables
-  pthread_cond_init(&npiLnxClientSREQcond, NULL);
-  pthread_cond_init(&npiLnxClientAREQcond, NULL);
+  // initialize all conditional variables
+  pthread_cond_init(&npiLnxClientSREQcond, NULL);
+
+  // hand all AREQ slots to the producers
+  for (pos = 0; pos < NPI_IPC_AREQ_RING_SIZE; pos++)
+  {
+    npiAreqRing[pos].sequence = pos;
+  }
+  npiAreqRingHead = 0;
+  npiAreqRingTail = 0;
+  npiAreqRingIdle = 0;
+  npiAreqRingHighWater = 0;
+  npiAreqRingDropped = 0;
+
+  npiSreqPendingHead = 0;
+  npiSreqPendingCount = 0;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_delsyncres
+ *
+ * @brief
+ *
+ * input parameters
+ *
+ * @param       none
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      none
+ *
+ **************************************************************************************************/
+static void npi_ipc_delsyncres(void)
+{
+  // In Linux, there is no dynamically allocated resources
+  // and hence the following calls do not actually matter.
+
+  // destroy all conditional variables
+  pthread_cond_destroy(&npiLnxClientSREQcond);
+
+  // destroy all mutexes
+  pthread_mutex_destroy(&npiLnxClientSREQmutex);
+
+}
+
+/**************************************************************************************************
+ *
+ * @fn          NPI_ClientClose
+ *
+ * @brief       This function stops RTI surrogate module
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+void NPI_ClientClose(void)
+{
+	int i;
+
+	// Close the NPI socket connection
+
+	close(sNPIconnected);
+	npiClientConnLost = FALSE;
+
+	LOG_INFO("[NPI Client] Idle wake-ups: %u, AREQ queue high-water mark: %u of %d, dropped: %u\n",
+			NPI_ClientIdleWakeups(), NPI_ClientAreqQueueHighWater(), NPI_IPC_AREQ_RING_SIZE, npiAreqRingDropped);
+
+	close(npiAreqRingEventFd);
+	close(npiAreqRingSpaceFd);
+	close(npiSreqWakeFd);
+	npiAreqRingEventFd = -1;
+	npiAreqRingSpaceFd = -1;
+	npiSreqWakeFd = -1;
+	npiClientEventLoop = FALSE;
+
+	// Stop the AREQ handler lanes once their queued messages are handled
+	for (i = 0; i < NPI_IPC_AREQ_HANDLERS_MAX; i++)
+	{
+		if (npiAreqHandlers[i].inUse)
+		{
+			NPI_UnregisterAsynchMsgCback(npiAreqHandlers[i].subSys, npiAreqHandlers[i].cmdId);
+		}
+	}
+	if (npiAreqPool != NULL)
+	{
+		npi_ipc_laneDestroy(npiAreqPool);
+		npiAreqPool = NULL;
+	}
+
+	// Delete synchronization resources
+	npi_ipc_delsyncres();
+
+#ifndef NPI_UNIX
+	freeaddrinfo(resAddr); // free the linked-list
+#endif //NPI_UNIX
+
+}
+
+/**************************************************************************************************
+ *
+ * @fn          NPI_ClientIdleWakeups
+ *
+ * @brief       This function returns the number of times the client threads
+ *              woke up without any message to receive or handle.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      Number of idle wake-ups.
+ *
+ **************************************************************************************************/
+uint32 NPI_ClientIdleWakeups(void)
+{
+	return npiClientIdleWakeups;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          NPI_ClientAreqQueueHighWater
+ *
+ * @brief       This function returns the largest number of received AREQ
+ *              messages that were waiting to be handled at the same time.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      AREQ queue depth high-water mark.
+ *
+ **************************************************************************************************/
+uint32 NPI_ClientAreqQueueHighWater(void)
+{
+	return npiAreqRingHighWater;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_areqRingClaim
+ *
+ * @brief       This function claims the next free AREQ slot. Safe to call
+ *              from several producer threads.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * @param       pPos - ring position of the claimed slot, to be published.
+ *
+ * @return      Pointer to the message of the claimed slot, NULL if the ring is full.
+ *
+ **************************************************************************************************/
+static npiMsgData_t *npi_ipc_areqRingClaim(uint32 *pPos)
+{
+	npiAreqSlot_t *pSlot;
+	uint32 pos = npiAreqRingHead;
+	int32 diff;
+
+	for (;;)
+	{
+		pSlot = &npiAreqRing[pos & NPI_IPC_AREQ_RING_MASK];
+		diff = (int32)(pSlot->sequence - pos);
+		__sync_synchronize();
+		if (diff == 0)
+		{
+			// Slot is free, try to take it before another producer does
+			if (__sync_bool_compare_and_swap(&npiAreqRingHead, pos, pos + 1))
+			{
+				*pPos = pos;
+				return &pSlot->message;
+			}
+		}
+		else if (diff < 0)
+		{
+			// Consumer has not handled this slot yet, ring is full
+			return NULL;
+		}
+		pos = npiAreqRingHead;
+	}
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_areqRingClaimWait
+ *
+ * @brief       This function claims the next free AREQ slot, waiting for the
+ *              handle thread to free one if the ring is full. It gives up
+ *              only if the handle thread itself waits for a synchronous
+ *              response, which would otherwise deadlock.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * @param       pPos - ring position of the claimed slot, to be published.
+ *
+ * @return      Pointer to the message of the claimed slot, NULL if no slot could be claimed.
+ *
+ **************************************************************************************************/
+static npiMsgData_t *npi_ipc_areqRingClaimWait(uint32 *pPos)
+{
+	npiMsgData_t *pMsg;
+	struct pollfd ufds[1];
+	eventfd_t freed;
+	int writeOnce = 0;
+
+	ufds[0].fd = npiAreqRingSpaceFd;
+	ufds[0].events = POLLIN;
+
+	while ((pMsg = npi_ipc_areqRingClaim(pPos)) == NULL)
+	{
+		if (npiAreqRingConsumerInSreq || npiClientEventLoop)
+		{
+			// In event loop mode the consumer is the application, which does
+			// not drain the ring until this thread is done reading.
+			return NULL;
+		}
+		if (writeOnce++ == 0)
+		{
+			LOG_WARN("[NPI Client READ] AREQ queue full (%d messages), waiting for handle thread\n", NPI_IPC_AREQ_RING_SIZE);
+		}
+
+		// Announce the wait, then check once more before blocking
+		npiAreqRingFull = 1;
+		__sync_synchronize();
+		if ((pMsg = npi_ipc_areqRingClaim(pPos)) != NULL)
+		{
+			break;
+		}
+		if ((poll(ufds, 1, NPI_IPC_AREQ_FULL_RECHECK_MS) > 0) && (ufds[0].revents & POLLIN))
+		{
+			if (eventfd_read(npiAreqRingSpaceFd, &freed) < 0)
+			{
+				LOG_ERROR("[NPI Client READ] Failed to read AREQ space eventfd, errno %d\n", errno);
+			}
+		}
+	}
+
+	return pMsg;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_areqRingPublish
+ *
+ * @brief       This function hands a filled AREQ slot to the handle thread
+ *              and wakes it up if it is blocked.
+ *
+ * input parameters
+ *
+ * @param       pos - ring position returned by npi_ipc_areqRingClaim.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+static void npi_ipc_areqRingPublish(uint32 pos)
+{
+	uint32 depth, highWater;
+
+	// Message must be complete before the consumer can see the slot
+	__sync_synchronize();
+	npiAreqRing[pos & NPI_IPC_AREQ_RING_MASK].sequence = pos + 1;
+
+	depth = pos + 1 - npiAreqRingTail;
+	while (depth > (highWater = npiAreqRingHighWater))
+	{
+		if (__sync_bool_compare_and_swap(&npiAreqRingHighWater, highWater, depth))
+		{
+			break;
+		}
+	}
+
+	// Only pay for the system call when the consumer is about to block
+	__sync_synchronize();
+	if (__sync_lock_test_and_set(&npiAreqRingIdle, 0))
+	{
+		if (eventfd_write(npiAreqRingEventFd, 1) < 0)
+		{
+			LOG_ERROR("[NPI Client READ] Failed to wake up handle thread, errno %d\n", errno);
+		}
+	}
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_areqRingDrainBatch
+ *
+ * @brief       This function handles up to NPI_IPC_AREQ_BATCH received AREQ
+ *              messages in place and hands their slots back to the producers.
+ *              Only called from the handle thread.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      Number of messages handled.
+ *
+ **************************************************************************************************/
+static int npi_ipc_areqRingDrainBatch(void)
+{
+	npiAreqSlot_t *pSlot;
+	uint32 pos = npiAreqRingTail;
+	int count;
+
+	for (count = 0; count < NPI_IPC_AREQ_BATCH; count++)
+	{
+		pSlot = &npiAreqRing[pos & NPI_IPC_AREQ_RING_MASK];
+		if (pSlot->sequence != (pos + 1))
+		{
+			// Not published yet
+			break;
+		}
+		__sync_synchronize();
+
+		if (pSlot->pSreqCback)
+		{
+			// Completion of a request sent by NPI_SendSynchDataAsync
+			LOG_TRACE("[NPI Client HANDLE] Completing asynchronous SREQ (slot %u, status %d)...\n", pos, pSlot->sreqStatus);
+			pSlot->pSreqCback(pSlot->sreqStatus,
+					(pSlot->sreqStatus == NPI_LNX_SUCCESS) ? &pSlot->message : NULL,
+					pSlot->pSreqCtx);
+		}
+		else
+		{
+			// Must remove command type before calling NPI_AsynchMsgCback
+			pSlot->message.subSys &= ~(RPC_CMD_TYPE_MASK);
+
+			LOG_TRACE("[NPI Client HANDLE] AREQ Calling NPI_AsynchMsgCback (slot %u)...\n", pos);
+			NPI_AsynchMsgCback(&pSlot->message);
+		}
+
+		// Callback is done with the message, return the slot
+		__sync_synchronize();
+		pSlot->sequence = pos + NPI_IPC_AREQ_RING_SIZE;
+		pos++;
+		npiAreqRingTail = pos;
+	}
+
+	// Wake up a producer waiting for room
+	__sync_synchronize();
+	if (count && __sync_lock_test_and_set(&npiAreqRingFull, 0))
+	{
+		if (eventfd_write(npiAreqRingSpaceFd, 1) < 0)
+		{
+			LOG_ERROR("[NPI Client HANDLE] Failed to wake up read thread, errno %d\n", errno);
+		}
+	}
+
+	return count;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_sreqEnqueue
+ *
+ * @brief       This function adds a request to the synchronous requests in
+ *              flight. Must be called with npiLnxClientSREQmutex held, and
+ *              the request must be sent before the mutex is released.
+ *
+ * input parameters
+ *
+ * @param       pMsg - request about to be sent
+ * @param       pCback - completion callback, NULL for NPI_SendSynchData
+ * @param       ctx - passed back to pCback
+ * @param       wait - TRUE to wait for room if NPI_IPC_SREQ_MAX_PENDING
+ *                     requests are in flight, FALSE to give up.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      The queued request, NULL if there was no room, or none was
+ *              made within NPI_IPC_CLIENT_SYNCH_TIMEOUT when waiting.
+ *
+ **************************************************************************************************/
+static npiSreqPending_t *npi_ipc_sreqEnqueue(npiMsgData_t *pMsg, npiSynchDataCback_t pCback, void *ctx, int wait)
+{
+	npiSreqPending_t *pEntry;
+	struct timespec monotonicStart, monotonicCurrent;
+	long remainingMicroseconds;
+
+	clock_gettime(CLOCK_MONOTONIC, &monotonicStart);
+	for (;;)
+	{
+		// Requests given up on only wait for a late response, they are the
+		// first to make room.
+		while ((npiSreqPendingCount == NPI_IPC_SREQ_MAX_PENDING) &&
+				npiSreqPending[npiSreqPendingHead].abandoned)
+		{
+			npiSreqPendingHead = (npiSreqPendingHead + 1) % NPI_IPC_SREQ_MAX_PENDING;
+			npiSreqPendingCount--;
+		}
+		if (npiSreqPendingCount < NPI_IPC_SREQ_MAX_PENDING)
+		{
+			break;
+		}
+		if (!wait)
+		{
+			return NULL;
+		}
+
+		// Room is made by the responses to the requests in flight, give up
+		// if none comes within NPI_IPC_CLIENT_SYNCH_TIMEOUT.
+		clock_gettime(CLOCK_MONOTONIC, &monotonicCurrent);
+		remainingMicroseconds = (NPI_IPC_CLIENT_SYNCH_TIMEOUT * 1000000L) -
+				((((long)monotonicCurrent.tv_sec - (long)monotonicStart.tv_sec) * 1000000L) +
+				(((long)monotonicCurrent.tv_nsec - (long)monotonicStart.tv_nsec) / 1000L));
+		if ((remainingMicroseconds <= 0) ||
+				(npi_ipc_sreqWait(remainingMicroseconds) != NPI_LNX_SUCCESS))
+		{
+			LOG_WARN("[NPI Client SEND SYNCH] No room for the request, %d requests in flight\n", NPI_IPC_SREQ_MAX_PENDING);
+			return NULL;
+		}
+	}
+
+	pEntry = &npiSreqPending[(npiSreqPendingHead + npiSreqPendingCount) % NPI_IPC_SREQ_MAX_PENDING];
+	npiSreqPendingCount++;
+
+	pEntry->seq = ++npiSreqSeq;
+	pEntry->subSys = pMsg->subSys & RPC_SUBSYSTEM_MASK;
+	pEntry->cmdId = pMsg->cmdId;
+	pEntry->abandoned = FALSE;
+	pEntry->pCback = pCback;
+	pEntry->ctx = ctx;
+	pEntry->pRsp = NULL;
+	pEntry->pStatus = NULL;
+	clock_gettime(CLOCK_MONOTONIC, &pEntry->deadline);
+	pEntry->deadline.tv_sec += NPI_IPC_CLIENT_SYNCH_TIMEOUT;
+
+	return pEntry;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_sreqWait
+ *
+ * @brief       This function waits for a change to the synchronous requests
+ *              in flight, e.g. a response. Must be called with
+ *              npiLnxClientSREQmutex held. In event loop mode no thread reads
+ *              the socket, so unless another waiter already does, one
+ *              message is read here; messages other than responses are
+ *              queued for NPI_ClientProcess.
+ *
+ * input parameters
+ *
+ * @param       remainingMicroseconds - longest time to wait
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      NPI_LNX_SUCCESS, or NPI_LNX_FAILURE if the connection to the
+ *              server is lost.
+ *
+ **************************************************************************************************/
+static int npi_ipc_sreqWait(long remainingMicroseconds)
+{
+	int ret = NPI_LNX_SUCCESS;
+	struct timespec expiryTime;
+
+	if (npiClientEventLoop && !npiClientReading)
+	{
+		struct pollfd ufds[1];
+
+		ufds[0].fd = sNPIconnected;
+		ufds[0].events = POLLIN | POLLPRI;
+		npiClientReading = TRUE;
+		pthread_mutex_unlock(&npiLnxClientSREQmutex);
+
+		if (poll(ufds, 1, (remainingMicroseconds + 999) / 1000) > 0)
+		{
+			ret = npi_ipc_readMsg(ufds[0].revents);
+		}
+
+		pthread_mutex_lock(&npiLnxClientSREQmutex);
+		npiClientReading = FALSE;
+		// Let another waiter take over reading
+		pthread_cond_broadcast(&npiLnxClientSREQcond);
+	}
+	else
+	{
+		// Since pthread_cond_timedwait requires a realtime clock, the caller
+		// takes the remaining time from the monotonic clock before each wait.
+		clock_gettime(CLOCK_REALTIME, &expiryTime);
+		expiryTime.tv_sec += (remainingMicroseconds / 1000000);
+		expiryTime.tv_nsec += ((remainingMicroseconds % 1000000) * 1000);
+
+		if (expiryTime.tv_nsec >= 1000000000)
+		{
+			expiryTime.tv_sec += 1;
+			expiryTime.tv_nsec -= 1000000000;
+		}
+		pthread_cond_timedwait(&npiLnxClientSREQcond, &npiLnxClientSREQmutex, &expiryTime);
+	}
+
+	return ret;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_sreqPost
+ *
+ * @brief       This function hands the completion of a request sent by
+ *              NPI_SendSynchDataAsync to the handle thread, which calls its
+ *              callback. Must be called without npiLnxClientSREQmutex held,
+ *              since the handle thread may be waiting for it.
+ *
+ * input parameters
+ *
+ * @param       pEntry - completed request
+ * @param       status - NPI_LNX_SUCCESS, or NPI_LNX_FAILURE if no response came
+ * @param       pRsp - response, NULL on failure
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+static void npi_ipc_sreqPost(const npiSreqPending_t *pEntry, int status, npiMsgData_t *pRsp)
+{
+	npiAreqSlot_t *pSlot;
+	uint32 pos;
+
+	if (npi_ipc_areqRingClaimWait(&pos) == NULL)
+	{
+		// The handle thread waits for a response behind this completion
+		npiAreqRingDropped++;
+		LOG_ERROR("[NPI Client READ] ERR: AREQ queue full (%d messages), dropping completion of subSys 0x%.2X cmdId 0x%.2X\n",
+				NPI_IPC_AREQ_RING_SIZE, pEntry->subSys, pEntry->cmdId);
+		return;
+	}
+
+	pSlot = &npiAreqRing[pos & NPI_IPC_AREQ_RING_MASK];
+	pSlot->pSreqCback = pEntry->pCback;
+	pSlot->pSreqCtx = pEntry->ctx;
+	pSlot->sreqStatus = status;
+	if (pRsp != NULL)
+	{
+		memcpy(&pSlot->message, pRsp, pRsp->len + RPC_FRAME_HDR_SZ);
+	}
+	npi_ipc_areqRingPublish(pos);
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_sreqComplete
+ *
+ * @brief       This function hands a received SRSP to the request it answers.
+ *              The server answers the requests of a connection in order, but
+ *              does not answer a request it fails to forward, so the response
+ *              belongs to the oldest request for the same command, and all
+ *              requests queued before that one have failed.
+ *
+ * input parameters
+ *
+ * @param       pRsp - received SRSP
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+static void npi_ipc_sreqComplete(npiMsgData_t *pRsp)
+{
+	npiSreqPending_t failed[NPI_IPC_SREQ_MAX_PENDING], matched;
+	npiSreqPending_t *pEntry;
+	uint8 subSys = pRsp->subSys & RPC_SUBSYSTEM_MASK;
+	int numFailed = 0, hasMatched = FALSE, match = -1, i;
+
+	pthread_mutex_lock(&npiLnxClientSREQmutex);
+
+	for (i = 0; (i < npiSreqPendingCount) && (match < 0); i++)
+	{
+		pEntry = &npiSreqPending[(npiSreqPendingHead + i) % NPI_IPC_SREQ_MAX_PENDING];
+		if ((pEntry->subSys == subSys) && (pEntry->cmdId == pRsp->cmdId))
+		{
+			match = i;
+		}
+	}
+	for (i = 0; (i < npiSreqPendingCount) && (match < 0); i++)
+	{
+		// Server sends an error response with a different command if the
+		// RNP did not respond properly
+		pEntry = &npiSreqPending[(npiSreqPendingHead + i) % NPI_IPC_SREQ_MAX_PENDING];
+		if (pEntry->subSys == subSys)
+		{
+			match = i;
+		}
+	}
+	if (match < 0)
+	{
+		if (npiSreqPendingCount == 0)
+		{
+			pthread_mutex_unlock(&npiLnxClientSREQmutex);
+			LOG_WARN("[NPI Client READ] Unexpected SRSP subSys 0x%.2X cmdId 0x%.2X, no request pending\n",
+					pRsp->subSys, pRsp->cmdId);
+			return;
+		}
+		LOG_WARN("[NPI Client READ] SRSP subSys 0x%.2X cmdId 0x%.2X matches no pending request, handing it to the oldest\n",
+				pRsp->subSys, pRsp->cmdId);
+		match = 0;
+	}
+
+	for (i = 0; i <= match; i++)
+	{
+		pEntry = &npiSreqPending[npiSreqPendingHead];
+		if (i < match)
+		{
+			LOG_WARN("[NPI Client READ] No response to SREQ subSys 0x%.2X cmdId 0x%.2X\n",
+					pEntry->subSys, pEntry->cmdId);
+		}
+
+		if (pEntry->abandoned)
+		{
+			// Requester already gave up, discard
+		}
+		else if (pEntry->pCback == NULL)
+		{
+			// Copy response back in the transmission buffer of NPI_SendSynchData
+			if (i == match)
+			{
+				memcpy((uint8*)pEntry->pRsp, (uint8*)pRsp, pRsp->len + RPC_FRAME_HDR_SZ);
+			}
+			*(pEntry->pStatus) = (i == match) ? NPI_LNX_SUCCESS : NPI_LNX_FAILURE;
+		}
+		else if (i == match)
+		{
+			matched = *pEntry;
+			hasMatched = TRUE;
+		}
+		else
+		{
+			failed[numFailed++] = *pEntry;
+		}
+
+		npiSreqPendingHead = (npiSreqPendingHead + 1) % NPI_IPC_SREQ_MAX_PENDING;
+		npiSreqPendingCount--;
+	}
+
+	// Wake up the synchronous requesters, and those waiting for room
+	LOG_DEBUG("[NPI Client READ][MUTEX] SRSP Cond broadcast\n");
+	pthread_cond_broadcast(&npiLnxClientSREQcond);
+	pthread_mutex_unlock(&npiLnxClientSREQmutex);
+
+	// Complete asynchronous requests in the order they were sent
+	for (i = 0; i < numFailed; i++)
+	{
+		npi_ipc_sreqPost(&failed[i], NPI_LNX_FAILURE, NULL);
+	}
+	if (hasMatched)
+	{
+		npi_ipc_sreqPost(&matched, NPI_LNX_SUCCESS, pRsp);
+	}
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_sreqCompleteById
+ *
+ * @brief       This function hands a received SRSP to the request carrying the
+ *              same correlation identifier. Responses may come in any order,
+ *              and the server answers every such request, so the others are
+ *              left waiting.
+ *
+ * input parameters
+ *
+ * @param       pRsp - received SRSP
+ * @param       corrId - correlation identifier which came with it
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+static void npi_ipc_sreqCompleteById(npiMsgData_t *pRsp, uint8 corrId)
+{
+	npiSreqPending_t matched;
+	npiSreqPending_t *pEntry = NULL;
+	int hasMatched = FALSE, i;
+
+	pthread_mutex_lock(&npiLnxClientSREQmutex);
+
+	for (i = 0; i < npiSreqPendingCount; i++)
+	{
+		pEntry = &npiSreqPending[(npiSreqPendingHead + i) % NPI_IPC_SREQ_MAX_PENDING];
+		if ((uint8)pEntry->seq == corrId)
+		{
+			break;
+		}
+	}
+	if (i == npiSreqPendingCount)
+	{
+		pthread_mutex_unlock(&npiLnxClientSREQmutex);
+		LOG_WARN("[NPI Client READ] SRSP subSys 0x%.2X cmdId 0x%.2X with unknown correlation identifier %d\n",
+				pRsp->subSys, pRsp->cmdId, corrId);
+		return;
+	}
+
+	if (pEntry->abandoned)
+	{
+		// Requester already gave up, discard
+	}
+	else if (pEntry->pCback == NULL)
+	{
+		// Copy response back in the transmission buffer of NPI_SendSynchData
+		memcpy((uint8*)pEntry->pRsp, (uint8*)pRsp, pRsp->len + RPC_FRAME_HDR_SZ);
+		*(pEntry->pStatus) = NPI_LNX_SUCCESS;
+	}
+	else
+	{
+		matched = *pEntry;
+		hasMatched = TRUE;
+	}
+	npi_ipc_sreqRemove(i);
+
+	// Wake up the synchronous requesters, and those waiting for room
+	pthread_cond_broadcast(&npiLnxClientSREQcond);
+	pthread_mutex_unlock(&npiLnxClientSREQmutex);
+
+	if (hasMatched)
+	{
+		npi_ipc_sreqPost(&matched, NPI_LNX_SUCCESS, pRsp);
+	}
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_sreqRemove
+ *
+ * @brief       This function takes a request out of the pending queue, keeping
+ *              the others in the order sent. Must be called with
+ *              npiLnxClientSREQmutex held.
+ *
+ * input parameters
+ *
+ * @param       index - position of the request from the oldest one
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+static void npi_ipc_sreqRemove(int index)
+{
+	for (; index < (npiSreqPendingCount - 1); index++)
+	{
+		npiSreqPending[(npiSreqPendingHead + index) % NPI_IPC_SREQ_MAX_PENDING] =
+				npiSreqPending[(npiSreqPendingHead + index + 1) % NPI_IPC_SREQ_MAX_PENDING];
+	}
+	npiSreqPendingCount--;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_connectionLost
+ *
+ * @brief       This function fails all requests in flight once the connection
+ *              to the server is lost, since no response will come. Requests
+ *              of NPI_SendSynchData return right away instead of timing out.
+ *              Must be called without npiLnxClientSREQmutex held.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+static void npi_ipc_connectionLost(void)
+{
+	npiSreqPending_t failed[NPI_IPC_SREQ_MAX_PENDING];
+	npiSreqPending_t *pEntry;
+	int numFailed = 0, i;
+
+	pthread_mutex_lock(&npiLnxClientSREQmutex);
+
+	npiClientConnLost = TRUE;
+	while (npiSreqPendingCount > 0)
+	{
+		pEntry = &npiSreqPending[npiSreqPendingHead];
+		if (pEntry->abandoned)
+		{
+			// Requester already gave up, discard
+		}
+		else if (pEntry->pCback == NULL)
+		{
+			*(pEntry->pStatus) = NPI_LNX_FAILURE;
+		}
+		else
+		{
+			failed[numFailed++] = *pEntry;
+		}
+
+		npiSreqPendingHead = (npiSreqPendingHead + 1) % NPI_IPC_SREQ_MAX_PENDING;
+		npiSreqPendingCount--;
+	}
+
+	pthread_cond_broadcast(&npiLnxClientSREQcond);
+	pthread_mutex_unlock(&npiLnxClientSREQmutex);
+
+	for (i = 0; i < numFailed; i++)
+	{
+		npi_ipc_sreqPost(&failed[i], NPI_LNX_FAILURE, NULL);
+	}
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_sreqSend
+ *
+ * @brief       This function writes a synchronous request to the socket, with
+ *              its correlation identifier when the server agreed to them.
+ *              Must be called with npiLnxClientSREQmutex held, so that
+ *              requests go out in the order they are queued.
+ *
+ * input parameters
+ *
+ * @param       pMsg - request, with the command type set
+ * @param       seq - sequence number of its pending entry
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      Number of message bytes sent, not counting the identifier,
+ *              -1 on error.
+ *
+ **************************************************************************************************/
+static int npi_ipc_sreqSend(npiMsgData_t *pMsg, uint32 seq)
+{
+	struct iovec iov[3];
+	uint8 corrId = (uint8)seq;
+	int bytesSent;
+
+	if (!(npiClientFeatures & NPI_LNX_FEATURE_CORRELATION_ID))
+	{
+		return send(sNPIconnected, (uint8 *)pMsg, pMsg->len + RPC_FRAME_HDR_SZ, 0);
+	}
+
+	iov[0].iov_base = (uint8 *)pMsg;
+	iov[0].iov_len = RPC_FRAME_HDR_SZ;
+	iov[1].iov_base = &corrId;
+	iov[1].iov_len = 1;
+	iov[2].iov_base = pMsg->pData;
+	iov[2].iov_len = pMsg->len;
+
+	bytesSent = writev(sNPIconnected, iov, 3);
+
+	return (bytesSent > 0) ? (bytesSent - 1) : bytesSent;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_sreqExpire
+ *
+ * @brief       This function fails the requests sent by NPI_SendSynchDataAsync
+ *              which got no response within NPI_IPC_CLIENT_SYNCH_TIMEOUT. They
+ *              stay queued so that a late response is matched to them.
+ *              Requests sent by NPI_SendSynchData time out in their caller.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      Milliseconds until the next request expires, -1 if none is waiting.
+ *
+ **************************************************************************************************/
+static int npi_ipc_sreqExpire(void)
+{
+	npiSreqPending_t expired[NPI_IPC_SREQ_MAX_PENDING];
+	npiSreqPending_t *pEntry;
+	struct timespec now;
+	long remainingMicroseconds;
+	int numExpired = 0, timeout = -1, i;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	pthread_mutex_lock(&npiLnxClientSREQmutex);
+	for (i = 0; i < npiSreqPendingCount; i++)
+	{
+		pEntry = &npiSreqPending[(npiSreqPendingHead + i) % NPI_IPC_SREQ_MAX_PENDING];
+		if (pEntry->abandoned || (pEntry->pCback == NULL))
+		{
+			continue;
+		}
+
+		remainingMicroseconds = ((long)(pEntry->deadline.tv_sec - now.tv_sec) * 1000000L) +
+		                        ((long)(pEntry->deadline.tv_nsec - now.tv_nsec) / 1000L);
+		if (remainingMicroseconds <= 0)
+		{
+			expired[numExpired++] = *pEntry;
+			pEntry->abandoned = TRUE;
+		}
+		else if ((timeout < 0) || (((remainingMicroseconds + 999) / 1000) < timeout))
+		{
+			timeout = (remainingMicroseconds + 999) / 1000;
+		}
+	}
+	pthread_mutex_unlock(&npiLnxClientSREQmutex);
+
+	for (i = 0; i < numExpired; i++)
+	{
+		LOG_WARN("[NPI Client READ] SREQ subSys 0x%.2X cmdId 0x%.2X timed out!\n",
+				expired[i].subSys, expired[i].cmdId);
+		npi_ipc_sreqPost(&expired[i], NPI_LNX_FAILURE, NULL);
+	}
+
+	return timeout;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          NPI_SendSynchData
+ *
+ * @brief       This function sends a message synchronously over the socket
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+void NPI_SendSynchData (npiMsgData_t *pMsg)
+{
+	NPI_SendSynchDataBatch(pMsg, 1);
+}
+
+/**************************************************************************************************
+ *
+ * @fn          NPI_SendSynchDataBatch
+ *
+ * @brief       This function sends several messages synchronously over the
+ *              socket. Up to NPI_IPC_SREQ_MAX_PENDING requests are sent back
+ *              to back, and then their responses are waited for at once.
+ *
+ * input parameters
+ *
+ * @param       pMsgs - array of requests
+ * @param       count - number of requests
+ *
+ * output parameters
+ *
+ * @param       pMsgs - each request answered is replaced by its response,
+ *                      the others are left as they are.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+void NPI_SendSynchDataBatch (npiMsgData_t *pMsgs, int count)
+{
+	int status[NPI_IPC_SREQ_MAX_PENDING];
+	uint32 seq[NPI_IPC_SREQ_MAX_PENDING];
+	npiMsgData_t *pMsg;
+	npiSreqPending_t *pEntry;
+	int bytesSent, first, num, waiting, j;
+	long remainingMicroseconds;
+	struct timespec monotonicStart;
+	long callingThreadID = syscall(SYS_gettid);
+	int fromHandleThread = pthread_equal(pthread_self(), npiHandleThreadId);
+
+	if (fromHandleThread)
+	{
+		// AREQ callback issues a request, the read thread must not wait for
+		// the handle thread to free AREQ slots until the response is in.
+		npiAreqRingConsumerInSreq = 1;
+	}
+
+	int i;
+	char str[256];
+	uint8 charWritten = 0;
+
+	for (first = 0; first < count; first += num)
+	{
+		num = ((count - first) < NPI_IPC_SREQ_MAX_PENDING) ? (count - first) : NPI_IPC_SREQ_MAX_PENDING;
+
+		// Queue the requests and send them under the same lock, so that the order of
+		// the pending requests is the order in which the server answers them.
+		LOG_TRACE("[NPI Client SEND SYNCH][MUTEX] Thread %ld: Lock SRSP Mutex\n", callingThreadID);
+		pthread_mutex_lock(&npiLnxClientSREQmutex);
+
+		if (npiClientConnLost)
+		{
+			// Nothing can be sent any more, the rest of the batch is left unanswered
+			LOG_WARN("[NPI Client SEND SYNCH] Thread %ld: Connection to the server is lost\n", callingThreadID);
+			pthread_mutex_unlock(&npiLnxClientSREQmutex);
+			break;
+		}
+
+		for (j = 0; j < num; j++)
+		{
+			pMsg = &pMsgs[first + j];
+
+			// Add Proper RPC type to header
+			((uint8*)pMsg)[RPC_POS_CMD0] = (((uint8*)pMsg)[RPC_POS_CMD0] & RPC_SUBSYSTEM_MASK) | RPC_CMD_SREQ;
+
+			charWritten = snprintf(str, sizeof(str), "[NPI Client SEND SYNCH] Thread %ld Preparing to send %d bytes, subSys 0x%.2X, cmdId 0x%.2X, pData:",
+									callingThreadID,
+									pMsg->len,
+									pMsg->subSys,
+									pMsg->cmdId);
+			charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, "\t");
+			for (i = 0; i < pMsg->len; i++)
+			{
+				charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, " 0x%.2X", pMsg->pData[i]);
+			}
+			charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, "\n");
+			LOG_DEBUG("%s", str);
+
+			if ((pEntry = npi_ipc_sreqEnqueue(pMsg, NULL, NULL, TRUE)) == NULL)
+			{
+				// No room was made, the rest of the batch is not sent
+				for (; j < num; j++)
+				{
+					status[j] = NPI_LNX_FAILURE;
+				}
+				break;
+			}
+			status[j] = NPI_IPC_SREQ_WAITING;
+			pEntry->pRsp = pMsg;
+			pEntry->pStatus = &status[j];
+			seq[j] = pEntry->seq;
+
+			bytesSent = npi_ipc_sreqSend(pMsg, pEntry->seq);
+
+			if (bytesSent == -1)
+			{
+				LOG_FATAL("[NPI Client] send");
+				exit(1);
+			}
+			else if (bytesSent != (pMsg->len + RPC_FRAME_HDR_SZ))
+			{
+				LOG_ERROR("[NPI Client] Sent only %d of %d bytes!\n", bytesSent, (pMsg->len + RPC_FRAME_HDR_SZ));
+
+				// The server lost the framing, drop the connection, the reader
+				// then fails the requests in flight.
+				npiClientConnLost = TRUE;
+				shutdown(sNPIconnected, SHUT_RDWR);
+				for (j++; j < num; j++)
+				{
+					status[j] = NPI_LNX_FAILURE;
+				}
+				break;
+			}
+		}
+
+		LOG_TRACE("[NPI Client SEND SYNCH] Sent %d requests.  Waiting for synchronous responses...\n", num);
+
+		// Conditional wait for the responses handled in the receiving thread,
+		// wait maximum NPI_IPC_CLIENT_SYNCH_TIMEOUT seconds.  Since this is
+		// vulnerable to clock adjustments and pthread_cond_timedwait requires
+		// a realtime clock, the remaining time is taken from the monotonic
+		// clock before each wait.
+		clock_gettime(CLOCK_MONOTONIC, &monotonicStart);
+		LOG_TRACE("[NPI Client SEND SYNCH][MUTEX] Thread %ld: Wait for SRSP Cond signal...\n", callingThreadID);
+		for (;;)
+		{
+			struct timespec monotonicCurrent;
+			long elapsedMicroseconds;
+
+			// Done once no request of this batch waits any more
+			for (waiting = FALSE, j = 0; (j < num) && !waiting; j++)
+			{
+				waiting = (status[j] == NPI_IPC_SREQ_WAITING);
+			}
+			if (!waiting)
+			{
+				break;
+			}
+
+			clock_gettime(CLOCK_MONOTONIC, &monotonicCurrent);
+			elapsedMicroseconds = ((long)((long)(monotonicCurrent.tv_sec) - (long)(monotonicStart.tv_sec)) * 1000000L) +
+			                      ((long)(((long)(monotonicCurrent.tv_nsec) - (long)(monotonicStart.tv_nsec))/1000L));
+
+			remainingMicroseconds = (NPI_IPC_CLIENT_SYNCH_TIMEOUT * 1000000L) - elapsedMicroseconds;
+			if (remainingMicroseconds <= 0)
+			{
+				break;
+			}
+
+			// No thread reads the socket in event loop mode, read it here
+			// until the responses are in. Otherwise the condition is shared
+			// by all requests in flight, so a wake-up may be for another one.
+			if (npi_ipc_sreqWait(remainingMicroseconds) != NPI_LNX_SUCCESS)
+			{
+				// Connection lost, no response will come
+				break;
+			}
+		}
+
+		for (j = 0; j < num; j++)
+		{
+			pMsg = &pMsgs[first + j];
+
+			if (status[j] == NPI_IPC_SREQ_WAITING)
+			{
+				// TODO: Indicate synchronous transaction error
+				LOG_WARN("[NPI Client SEND SYNCH] Thread %ld: SRSP Cond Wait timed out!\n", callingThreadID);
+
+				// Keep the request queued so that a late response is matched to it,
+				// but it must no longer touch this caller's buffer.
+				for (i = 0; i < npiSreqPendingCount; i++)
+				{
+					pEntry = &npiSreqPending[(npiSreqPendingHead + i) % NPI_IPC_SREQ_MAX_PENDING];
+					if (pEntry->seq == seq[j])
+					{
+						pEntry->abandoned = TRUE;
+						pEntry->pRsp = NULL;
+						pEntry->pStatus = NULL;
+						break;
+					}
+				}
+			}
+			else if (status[j] == NPI_LNX_SUCCESS)
+			{
+				charWritten = snprintf(str, sizeof(str), "[NPI Client] Thread %ld received data:", callingThreadID);
+				for (i = 0; i < (pMsg->len + RPC_FRAME_HDR_SZ); i++)
+				{
+					charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, " 0x%.2X", ((uint8 *)pMsg)[i]);
+				}
+				LOG_TRACE("%s\n", str);
+			}
+			else
+			{
+				LOG_WARN("[NPI Client SEND SYNCH] Thread %ld: Server did not answer the request\n", callingThreadID);
+			}
+		}
+
+		// Now unlock the mutex before returning
+		LOG_TRACE("[NPI Client SEND SYNCH][MUTEX] Thread %ld: Unlock SRSP Mutex\n", callingThreadID);
+		pthread_mutex_unlock(&npiLnxClientSREQmutex);
+	}
+
+	if (fromHandleThread)
+	{
+		npiAreqRingConsumerInSreq = 0;
+	}
+}
+
+
+/**************************************************************************************************
+ *
+ * @fn          NPI_SendSynchDataAsync
+ *
+ * @brief       This function sends a synchronous request over the socket
+ *              without waiting for its response. Up to
+ *              NPI_IPC_SREQ_MAX_PENDING requests may be in flight. The
+ *              callback is called from the thread that calls
+ *              NPI_AsynchMsgCback, in the order the requests were sent,
+ *              once the response is in or after NPI_IPC_CLIENT_SYNCH_TIMEOUT
+ *              seconds without one. With correlation identifiers the
+ *              callbacks follow the order in which the responses come.
+ *
+ * input parameters
+ *
+ * @param       pMsg - request to send, may be reused once this returns
+ * @param       pCback - completion callback
+ * @param       ctx - passed back to pCback
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      NPI_LNX_SUCCESS if the request was sent and pCback will be
+ *              called, NPI_LNX_FAILURE otherwise.
+ *
+ **************************************************************************************************/
+int NPI_SendSynchDataAsync (npiMsgData_t *pMsg, npiSynchDataCback_t pCback, void *ctx)
+{
+	int ret = NPI_LNX_SUCCESS, armed = FALSE, bytesSent, i;
+	npiSreqPending_t *pEntry;
+
+	if (pCback == NULL)
+	{
+		return NPI_LNX_FAILURE;
+	}
+
+	// Add Proper RPC type to header
+	((uint8*)pMsg)[RPC_POS_CMD0] = (((uint8*)pMsg)[RPC_POS_CMD0] & RPC_SUBSYSTEM_MASK) | RPC_CMD_SREQ;
+
+	LOG_DEBUG("[NPI Client SEND SYNCH ASYNC] Preparing to send %d bytes, subSys 0x%.2X, cmdId 0x%.2X\n",
+			pMsg->len, pMsg->subSys, pMsg->cmdId);
+
+	pthread_mutex_lock(&npiLnxClientSREQmutex);
+
+	// Deadlines only grow, the read thread is already waiting for an earlier one
+	for (i = 0; (i < npiSreqPendingCount) && !armed; i++)
+	{
+		pEntry = &npiSreqPending[(npiSreqPendingHead + i) % NPI_IPC_SREQ_MAX_PENDING];
+		armed = (pEntry->pCback != NULL) && !pEntry->abandoned;
+	}
+
+	if (npiClientConnLost)
+	{
+		LOG_WARN("[NPI Client SEND SYNCH ASYNC] Connection to the server is lost\n");
+		ret = NPI_LNX_FAILURE;
+	}
+	else if ((pEntry = npi_ipc_sreqEnqueue(pMsg, pCback, ctx, FALSE)) == NULL)
+	{
+		LOG_WARN("[NPI Client SEND SYNCH ASYNC] %d requests already in flight\n", NPI_IPC_SREQ_MAX_PENDING);
+		ret = NPI_LNX_FAILURE;
+	}
+	else
+	{
+		bytesSent = npi_ipc_sreqSend(pMsg, pEntry->seq);
+		if (bytesSent != (pMsg->len + RPC_FRAME_HDR_SZ))
+		{
+			LOG_ERROR("[NPI Client SEND SYNCH ASYNC] Sent %d bytes, of expected %d, errno %d\n",
+					bytesSent, pMsg->len + RPC_FRAME_HDR_SZ, errno);
+
+			// Request is the last one queued, take it back
+			npiSreqPendingCount--;
+			ret = NPI_LNX_FAILURE;
+
+			// Part of it may be on the socket already, the server would take
+			// whatever comes next for the rest of it. Drop the connection, the
+			// reader then fails the other requests.
+			npiClientConnLost = TRUE;
+			shutdown(sNPIconnected, SHUT_RDWR);
+		}
+		else if (!armed && (eventfd_write(npiSreqWakeFd, 1) < 0))
+		{
+			LOG_ERROR("[NPI Client SEND SYNCH ASYNC] Failed to wake up read thread, errno %d\n", errno);
+		}
+	}
+
+	pthread_mutex_unlock(&npiLnxClientSREQmutex);
+
+	return ret;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          NPI_SendAsynchData
+ *
+ * @brief       This function sends a message asynchronously over the socket
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+void NPI_SendAsynchData (npiMsgData_t *pMsg)
+{
+	// Add Proper RPC type to header
+	if ((((uint8*)pMsg)[RPC_POS_CMD0] & RPC_CMD_TYPE_MASK) == 0)
+		((uint8*)pMsg)[RPC_POS_CMD0] = (((uint8*)pMsg)[RPC_POS_CMD0] & RPC_SUBSYSTEM_MASK) | RPC_CMD_AREQ;
+
+	int i;
+    char str[256];
+    uint8 charWritten;
+    charWritten = snprintf(str, sizeof(str), "[NPI Client SEND ASYNCH] trying to send %d bytes,\t subSys 0x%.2X, cmdId 0x%.2X, pData:",
+							pMsg->len,
+							pMsg->subSys,
+							pMsg->cmdId);
+    charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, "\t");
+    for (i = 0; i < pMsg->len; i++)
+    {
+       charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, " 0x%.2X", pMsg->pData[i]);
+    }
+    LOG_DEBUG("%s\n", str);
+
+	int bytesSent = send(sNPIconnected, (uint8 *)pMsg, pMsg->len + RPC_FRAME_HDR_SZ, 0);
+	if (bytesSent == -1)
+	{
+		LOG_FATAL("[NPI Client SEND ASYNCH] send");
+		exit(1);
+	}
+	else if (bytesSent < pMsg->len + RPC_FRAME_HDR_SZ)
+	{
+		LOG_ERROR("[NPI Client SEND ASYNCH] Sent %d bytes, of expected %d\n", bytesSent, pMsg->len + RPC_FRAME_HDR_SZ);
+	}
+}
+
+int NPI_AsynchMsgCback(npiMsgData_t *pMsg )
+{
+  npiProcessMsg_t  func;
+  int res = -1;
+
+  if (npiState == NPI_STATE_READY)
+  {
+    /* check subsystem range */
+    if (pMsg->subSys < RPC_SYS_MAX)
+    {
+      /* look up handler registered at run time first */
+      npiAreqHandler_t *pHandler = NULL;
+      int i;
+
+      pthread_rwlock_rdlock(&npiAreqHandlersLock);
+      for (i = 0; i < NPI_IPC_AREQ_HANDLERS_MAX; i++)
+      {
+        if (npiAreqHandlers[i].inUse && (npiAreqHandlers[i].subSys == pMsg->subSys))
+        {
+          if (npiAreqHandlers[i].cmdId == pMsg->cmdId)
+          {
+            pHandler = &npiAreqHandlers[i];
+            break;
+          }
+          else if ((npiAreqHandlers[i].cmdId == NPI_AREQ_CMD_ANY) && (pHandler == NULL))
+          {
+            pHandler = &npiAreqHandlers[i];
+          }
+        }
+      }
+      if (pHandler && pHandler->pLane)
+      {
+        /* hand over to its lane, under the lock so the lane cannot be destroyed meanwhile.
+           Never waits, a full lane drops the message rather than hold up the others. */
+        npi_ipc_lanePush(pHandler->pLane, pHandler->pCback, pMsg);
+        res = 0;
+        func = NULL;
+      }
+      else
+      {
+        /* look up processing function */
+        func = (pHandler) ? pHandler->pCback : NpiAsyncMsgCbackParserTable[pMsg->subSys];
+      }
+      pthread_rwlock_unlock(&npiAreqHandlersLock);
+
+      if (func)
+      {
+#ifdef   __DEBUG_TIME__
+         char str[256];
+         uint8 charWritten, i;
+         charWritten = snprintf(str, sizeof(str), "[NPI Client CBACK START] subSys 0x%.2X, cmdId 0x%.2X, pData:",
+                           pMsg->subSys,
+                           pMsg->cmdId);
+         charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, "\t");
+         for (i = 0; i < pMsg->len; i++)
+         {
+            charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, " 0x%.2X", pMsg->pData[i]);
+         }
+         charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, "\n");
+         LOG_DEBUG("%s", str);
+#endif //__DEBUG_TIME__
+        /* execute processing function */
+        res = (*func)(pMsg);
+#ifdef __DEBUG_TIME__
+         LOG_DEBUG("[NPI Client CBACK ENDED] \n");
+#endif //__DEBUG_TIME__
+      }
+      else if (pHandler == NULL)
+      {
+        LOG_TRACE("Warning! Asynch Msg received not handled! Did you register the parser callback for ?: %s \n", RpcCmdType_list[pMsg->subSys]);
+      }
+    }
+    else
+    {
+        LOG_TRACE("Warning! Asynch Msg received does not correspond to any module: %d >=  RPC_SYS_MAX: \n", pMsg->subSys);
+    }
+  }
+  return res;
+
+}
+/**************************************************************************************************
+ *
+ * @fn          NPI_RegisterAsynchMsgCback
+ *
+ * @brief       This function registers an AREQ handler at run time. Handlers
+ *              registered for a command take precedence over those registered
+ *              for the whole subsystem, which take precedence over the
+ *              built-in subsystem handlers. The lane selects where the handler
+ *              runs, so that a slow handler does not delay the others:
+ *              NPI_AREQ_LANE_INLINE - on the thread handling all AREQs
+ *              NPI_AREQ_LANE_DEDICATED - on a thread of its own, in order
+ *              NPI_AREQ_LANE_POOL - on a shared pool of
+ *                                   NPI_IPC_AREQ_POOL_THREADS threads, in
+ *                                   no particular order
+ *              Handlers running on a dedicated or pool lane must not
+ *              register or unregister handlers themselves.
+ *
+ * input parameters
+ *
+ * @param       subSys - RPC subsystem, without command type
+ * @param       cmdId - command ID, or NPI_AREQ_CMD_ANY
+ * @param       pCback - handler
+ * @param       lane - NPI_AREQ_LANE_INLINE, NPI_AREQ_LANE_DEDICATED or NPI_AREQ_LANE_POOL
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      NPI_LNX_SUCCESS, or NPI_LNX_FAILURE if the handler is already
+ *              registered, there is no room, or its lane cannot be started.
+ *
+ **************************************************************************************************/
+int NPI_RegisterAsynchMsgCback(uint8 subSys, int cmdId, npiProcessMsg_t pCback, uint8 lane)
+{
+	npiAreqHandler_t *pFree = NULL;
+	npiAreqLane_t *pLane = NULL;
+	int i;
+
+	if ((subSys >= RPC_SYS_MAX) || (cmdId < NPI_AREQ_CMD_ANY) || (cmdId > 0xFF) ||
+			(pCback == NULL) || (lane > NPI_AREQ_LANE_POOL))
+	{
+		LOG_ERROR("[NPI Client] Invalid AREQ handler registration, subSys 0x%.2X cmdId %d lane %d\n", subSys, cmdId, lane);
+		return NPI_LNX_FAILURE;
+	}
+
+	pthread_rwlock_wrlock(&npiAreqHandlersLock);
+
+	for (i = 0; i < NPI_IPC_AREQ_HANDLERS_MAX; i++)
+	{
+		if (!npiAreqHandlers[i].inUse)
+		{
+			if (pFree == NULL)
+			{
+				pFree = &npiAreqHandlers[i];
+			}
+		}
+		else if ((npiAreqHandlers[i].subSys == subSys) && (npiAreqHandlers[i].cmdId == cmdId))
+		{
+			pthread_rwlock_unlock(&npiAreqHandlersLock);
+			LOG_ERROR("[NPI Client] AREQ handler for subSys 0x%.2X cmdId %d already registered\n", subSys, cmdId);
+			return NPI_LNX_FAILURE;
+		}
+	}
+
+	if (pFree == NULL)
+	{
+		pthread_rwlock_unlock(&npiAreqHandlersLock);
+		LOG_ERROR("[NPI Client] No room for AREQ handler, %d already registered\n", NPI_IPC_AREQ_HANDLERS_MAX);
+		return NPI_LNX_FAILURE;
+	}
+
+	if (lane == NPI_AREQ_LANE_DEDICATED)
+	{
+		pLane = npi_ipc_laneCreate(1);
+	}
+	else if (lane == NPI_AREQ_LANE_POOL)
+	{
+		if (npiAreqPool == NULL)
+		{
+			npiAreqPool = npi_ipc_laneCreate(NPI_IPC_AREQ_POOL_THREADS);
+		}
+		pLane = npiAreqPool;
+	}
+
+	if ((lane != NPI_AREQ_LANE_INLINE) && (pLane == NULL))
+	{
+		pthread_rwlock_unlock(&npiAreqHandlersLock);
+		return NPI_LNX_FAILURE;
+	}
+
+	pFree->subSys = subSys;
+	pFree->cmdId = cmdId;
+	pFree->pCback = pCback;
+	pFree->pLane = pLane;
+	pFree->inUse = TRUE;
+
+	pthread_rwlock_unlock(&npiAreqHandlersLock);
+
+	LOG_INFO("[NPI Client] Registered AREQ handler for subSys 0x%.2X cmdId %d on lane %d\n", subSys, cmdId, lane);
+	return NPI_LNX_SUCCESS;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          NPI_UnregisterAsynchMsgCback
+ *
+ * @brief       This function removes an AREQ handler registered at run time.
+ *              Messages already queued on a dedicated lane are handled before
+ *              it returns. Must not be called from the lane of the handler.
+ *
+ * input parameters
+ *
+ * @param       subSys - RPC subsystem, as registered
+ * @param       cmdId - command ID, as registered
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      NPI_LNX_SUCCESS, or NPI_LNX_FAILURE if no such handler is registered.
+ *
+ **************************************************************************************************/
+int NPI_UnregisterAsynchMsgCback(uint8 subSys, int cmdId)
+{
+	npiAreqLane_t *pLane = NULL;
+	int ret = NPI_LNX_FAILURE, i;
+
+	pthread_rwlock_wrlock(&npiAreqHandlersLock);
+
+	for (i = 0; i < NPI_IPC_AREQ_HANDLERS_MAX; i++)
+	{
+		if (npiAreqHandlers[i].inUse &&
+				(npiAreqHandlers[i].subSys == subSys) && (npiAreqHandlers[i].cmdId == cmdId))
+		{
+			if ((npiAreqHandlers[i].pLane != npiAreqPool) && npi_ipc_laneIsOwnThread(npiAreqHandlers[i].pLane))
+			{
+				LOG_ERROR("[NPI Client] AREQ handler for subSys 0x%.2X cmdId %d cannot unregister itself\n", subSys, cmdId);
+				break;
+			}
+
+			// The pool is shared, it stays until the client is closed
+			if (npiAreqHandlers[i].pLane != npiAreqPool)
+			{
+				pLane = npiAreqHandlers[i].pLane;
+			}
+			memset(&npiAreqHandlers[i], 0, sizeof(npiAreqHandler_t));
+			ret = NPI_LNX_SUCCESS;
+			break;
+		}
+	}
+
+	pthread_rwlock_unlock(&npiAreqHandlersLock);
+
+	// No new message can reach the lane now
+	if (pLane != NULL)
+	{
+		npi_ipc_laneDestroy(pLane);
+	}
+
+	return ret;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_laneCreate
+ *
+ * @brief       This function creates an AREQ handler lane and starts its threads.
+ *
+ * input parameters
+ *
+ * @param       numThreads - number of threads calling the handlers, at most
+ *                           NPI_IPC_AREQ_POOL_THREADS
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      The lane, NULL on failure.
+ *
+ **************************************************************************************************/
+static npiAreqLane_t *npi_ipc_laneCreate(int numThreads)
+{
+	npiAreqLane_t *pLane;
+
+	if ((pLane = (npiAreqLane_t *)malloc(sizeof(npiAreqLane_t))) == NULL)
+	{
+		LOG_ERROR("[NPI Client] Failed to allocate AREQ handler lane\n");
+		return NULL;
+	}
+
+	memset(pLane, 0, sizeof(npiAreqLane_t));
+	pthread_mutex_init(&pLane->mutex, NULL);
+	pthread_cond_init(&pLane->notEmpty, NULL);
+
+	for (pLane->numThreads = 0; pLane->numThreads < numThreads; pLane->numThreads++)
+	{
+		if (pthread_create(&pLane->threadId[pLane->numThreads], NULL, npi_ipc_laneThreadFunc, pLane))
+		{
+			LOG_ERROR("[NPI Client] Failed to create AREQ handler lane thread\n");
+			npi_ipc_laneDestroy(pLane);
+			return NULL;
+		}
+	}
+
+	return pLane;
+}
+
+/**************************************************************************************************
+ *
+ * @fn          npi_ipc_laneDestroy
+ *
+ * @brief       This function stops the threads of an AREQ handler lane once
+ *              the queued messages are handled, and frees it.
+ *
+ * input parameters
+ *
+ * @param       pLane - lane to destroy
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+static void npi_ipc_laneDestroy(npiAreqLane_t *pLane)
+{
+	int i;
+
+	pthread_mutex_lock(&pLane->mutex);
+	pLane->stop = TRUE;
+	pthread_cond_broadcast(&pLane->notEmpty);
+	pthread_mutex_unlock(&pLane->mutex);
+
+	for (i = 0; i < pLane->numThreads; i++)
+	{
+		pthread_join(pLane->threadId[i], NULL);
+	}
+
+	if (pLane->dropped)
+	{
+		LOG_WARN("[NPI Client] AREQ handler lane dropped %u messages\n", pLane->dropped);
+	}
+
+	pthread_cond_destroy(&pLane->notEmpty);
+	pthread_mutex_destroy(&pLane->mutex);
+	free(pLane);
 }
 
 /**************************************************************************************************
  *
- * @fn          npi_ipc_delsyncres
+ * @fn          npi_ipc_laneIsOwnThread
  *
- * @brief
+ * @brief       This function tells whether the caller is a thread of an AREQ handler lane.
  *
  * input parameters
  *
- * @param       none
+ * @param       pLane - lane, may be NULL
  *
  * output parameters
  *
  * None.
  *
- * @return      none
+ * @return      TRUE if called from a thread of pLane, FALSE otherwise.
  *
  **************************************************************************************************/
-static void npi_ipc_delsyncres(void)
+static int npi_ipc_laneIsOwnThread(npiAreqLane_t *pLane)
 {
-  // In Linux, there is no dynamically allocated resources
-  // and hence the following calls do not actually matter.
-
-  // destroy all conditional variables
-  pthread_cond_destroy(&npiLnxClientSREQcond);
-  pthread_cond_destroy(&npiLnxClientAREQcond);
+	int i;
 
-  // destroy all mutexes
-  pthread_mutex_destroy(&npiLnxClientSREQmutex);
-  pthread_mutex_destroy(&npiLnxClientAREQmutex);
+	for (i = 0; (pLane != NULL) && (i < pLane->numThreads); i++)
+	{
+		if (pthread_equal(pthread_self(), pLane->threadId[i]))
+		{
+			return TRUE;
+		}
+	}
 
+	return FALSE;
 }
 
 /**************************************************************************************************
  *
- * @fn          NPI_ClientClose
+ * @fn          npi_ipc_lanePush
  *
- * @brief       This function stops RTI surrogate module
+ * @brief       This function queues a copy of an AREQ message on a handler
+ *              lane. It never waits: the caller is the thread handling all
+ *              AREQs and responses, so when the lane is full the message is
+ *              dropped and counted instead.
  *
  * input parameters
  *
- * None.
+ * @param       pLane - lane
+ * @param       pCback - handler to call
+ * @param       pMsg - message, command type removed
  *
  * output parameters
  *
  * None.
  *
- * @return      None.
+ * @return      NPI_LNX_SUCCESS if queued, NPI_LNX_FAILURE if dropped.
  *
  **************************************************************************************************/
-void NPI_ClientClose(void)
+static int npi_ipc_lanePush(npiAreqLane_t *pLane, npiProcessMsg_t pCback, npiMsgData_t *pMsg)
 {
-	// Close the NPI socket connection
+	npiAreqLaneMsg_t *pEntry;
 
-	close(sNPIconnected);
+	pthread_mutex_lock(&pLane->mutex);
 
-	// Delete synchronization resources
-	npi_ipc_delsyncres();
+	if (pLane->count == NPI_IPC_AREQ_LANE_DEPTH)
+	{
+		uint32 dropped = ++pLane->dropped;
 
-#ifndef NPI_UNIX
-	freeaddrinfo(resAddr); // free the linked-list
-#endif //NPI_UNIX
+		pthread_mutex_unlock(&pLane->mutex);
+		LOG_WARN("[NPI Client HANDLE] AREQ handler lane full (%d messages), dropping subSys 0x%.2X cmdId 0x%.2X (%u dropped)\n",
+				NPI_IPC_AREQ_LANE_DEPTH, pMsg->subSys, pMsg->cmdId, dropped);
+		return NPI_LNX_FAILURE;
+	}
+
+	pEntry = &pLane->queue[(pLane->head + pLane->count) % NPI_IPC_AREQ_LANE_DEPTH];
+	pEntry->pCback = pCback;
+	memcpy(&pEntry->message, pMsg, pMsg->len + RPC_FRAME_HDR_SZ);
+	pLane->count++;
+
+	pthread_cond_signal(&pLane->notEmpty);
+	pthread_mutex_unlock(&pLane->mutex);
 
+	return NPI_LNX_SUCCESS;
 }
 
 /**************************************************************************************************
  *
- * @fn          NPI_SendSynchData
+ * @fn          npi_ipc_laneThreadFunc
  *
- * @brief       This function sends a message synchronously over the socket
+ * @brief       This function calls the handlers of the messages queued on an
+ *              AREQ handler lane until the lane is stopped.
  *
  * input parameters
  *
- * None.
+ * @param       ptr - lane
  *
  * output parameters
  *
  * None.
  *
- * @return      None.
+ * @return      ptr
  *
  **************************************************************************************************/
-void NPI_SendSynchData (npiMsgData_t *pMsg)
+static void *npi_ipc_laneThreadFunc(void *ptr)
 {
-	int result = 0;
-	int mutexRet = 0;
-	int bytesSent;
-	long remainingMicroseconds;
-	struct timespec expiryTime, monotonicStart;
-	long callingThreadID = syscall(SYS_gettid);
-
-	// Add Proper RPC type to header
-	((uint8*)pMsg)[RPC_POS_CMD0] = (((uint8*)pMsg)[RPC_POS_CMD0] & RPC_SUBSYSTEM_MASK) | RPC_CMD_SREQ;
-
-	int i;
-	char str[256];
-	uint8 charWritten = 0;
-	charWritten = snprintf(str, sizeof(str), "[NPI Client SEND SYNCH] Thread %ld Preparing to send %d bytes, subSys 0x%.2X, cmdId 0x%.2X, pData:",
-							callingThreadID,
-							pMsg->len,
-							pMsg->subSys,
-							pMsg->cmdId);
-	charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, "\t");
-	for (i = 0; i < pMsg->len; i++)
-	{
-		charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, " 0x%.2X", pMsg->pData[i]);
-	}
-	charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, "\n");
-	LOG_DEBUG("%s", str);
+	npiAreqLane_t *pLane = (npiAreqLane_t *)ptr;
+	npiAreqLaneMsg_t entry;
 
-	LOG_TRACE("[NPI Client SEND SYNCH][MUTEX] Thread %ld: Locking npiLnxClientSREQSerializationMutex\n", callingThreadID);
-	if ((mutexRet = pthread_mutex_lock(&npiLnxClientSREQSerializationMutex)) != 0)
+	for (;;)
 	{
-		// Should be "impossible" to get here, given the nature of the mutex, but handle case anyway.
-		// Unfortunately, there is no way to return an error from this function as-coded.
-		LOG_ERROR("[NPI Client SEND SYNCH][MUTEX] Thread %ld: Error %d waiting for npiLnxClientSREQSerializationMutex! Cannot send!\n", callingThreadID, mutexRet);
-	}
-	else
-	{
-		// Got serialization mutex, now
-		// Lock the tx/rx synchronization mutex
-		LOG_TRACE("[NPI Client SEND SYNCH][MUTEX] Thread %ld: Got serialization mutex, now Lock SRSP Mutex\n", callingThreadID);
-		int writeOnce = 0;
-		while ( (mutexRet = pthread_mutex_trylock(&npiLnxClientSREQmutex)) == EBUSY)
-		{
-			if (writeOnce == 0)
-			{
-				LOG_TRACE("[NPI Client SEND SYNCH][MUTEX] Thread %ld: SRSP Mutex busy\n", callingThreadID);
-				writeOnce++;
-			}
-			else
-			{
-				writeOnce++;
-				if ( (writeOnce % 1000) == 0)
-				{
-					LOG_TRACE("%d.", writeOnce);
-				}
-				if (writeOnce > 0xFFFFFFF0)
-					writeOnce = 1;
-				fflush(LOG_DESTINATION_FP);
-			}
-		}
-		LOG_TRACE("[NPI Client SEND SYNCH][MUTEX] Thread %ld: SRSP Lock status: %d\n", callingThreadID, mutexRet);
-
-
-		bytesSent = send(sNPIconnected, (uint8 *)pMsg, pMsg->len + RPC_FRAME_HDR_SZ, 0);
-
-		if (bytesSent == -1)
-		{
-			LOG_FATAL("[NPI Client] send");
-			exit(1);
-		}
-		else if (bytesSent != (pMsg->len + RPC_FRAME_HDR_SZ))
-		{
-			LOG_ERROR("[NPI Client] Sent only %d of %d bytes!\n", bytesSent, (pMsg->len + RPC_FRAME_HDR_SZ));
-		}
-
-		LOG_TRACE("[NPI Client SEND SYNCH] Sent %d bytes.  Waiting for synchronous response...\n", bytesSent);
-
-		// Conditional wait for the response handled in the receiving thread,
-		// wait maximum NPI_IPC_CLIENT_SYNCH_TIMEOUT seconds.  Since this is
-		// vulnerable to clock adjustments and pthread_cond_timedwait requires
-		// a realtime clock, wrap this in a monotonic clock check and retry if
-		// timed out before actual timeout in monotonic time was hit.
-		clock_gettime(CLOCK_MONOTONIC, &monotonicStart);
-		clock_gettime(CLOCK_REALTIME, &expiryTime);
-		expiryTime.tv_sec += NPI_IPC_CLIENT_SYNCH_TIMEOUT;
-		LOG_TRACE("[NPI Client SEND SYNCH][MUTEX] Thread %ld: Wait for SRSP Cond signal...\n", callingThreadID);
-		do
-		{
-			result = pthread_cond_timedwait(&npiLnxClientSREQcond, &npiLnxClientSREQmutex, &expiryTime);
-			if (result != ETIMEDOUT)
-				remainingMicroseconds = 0;
-			else
-			{
-				// Check monotonic clock to see if timeout time actually elapsed or clock jumped.
-				struct timespec monotonicCurrent;
-				long elapsedMicroseconds;
-
-				clock_gettime(CLOCK_MONOTONIC, &monotonicCurrent);
-				elapsedMicroseconds = ((long)((long)(monotonicCurrent.tv_sec) - (long)(monotonicStart.tv_sec)) * 1000000L) +
-				                      ((long)(((long)(monotonicCurrent.tv_nsec) - (long)(monotonicStart.tv_nsec))/1000L));
-
-				remainingMicroseconds = (NPI_IPC_CLIENT_SYNCH_TIMEOUT * 1000000L) - elapsedMicroseconds;
-				if (remainingMicroseconds > 0)
-				{
-					// Realtime clock must have jumped.  Set expiry time to current time + remaining timeout
-					// and loop back to try again.
-					clock_gettime(CLOCK_REALTIME, &expiryTime);
-					expiryTime.tv_sec += (remainingMicroseconds / 1000000);
-					expiryTime.tv_nsec += ((remainingMicroseconds % 1000000) * 1000);
-
-					if (expiryTime.tv_nsec > 1000000000)
-					{
-						expiryTime.tv_sec += 1;
-						expiryTime.tv_nsec -= 1000000000;
-					}
-				}
-			}
-		} while(remainingMicroseconds > 0);
-
-		if (result == ETIMEDOUT)
-		{
-			// TODO: Indicate synchronous transaction error
-			LOG_WARN("[NPI Client SEND SYNCH] Thread %ld: SRSP Cond Wait timed out!\n", callingThreadID);
-
-			// Clear response buffer before processing
-			memset(npi_ipc_srsp_buf, 0, sizeof(npiMsgData_t));
-			// Set Timeout Error to rsp buffer
-//			pMsg->pData[0]=0xFF;
-		}
-		// Wait for response
-		else if ( numOfReceievedSRSPbytes > 0)
+		pthread_mutex_lock(&pLane->mutex);
+		while ((pLane->count == 0) && !pLane->stop)
 		{
-			charWritten = snprintf(str, sizeof(str), "[NPI Client] Thread %ld received data:", callingThreadID);
-			for (i = 0; i < numOfReceievedSRSPbytes; i++)
-			{
-				charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, " 0x%.2X", (uint8)npi_ipc_srsp_buf[i]);
-			}
-			LOG_TRACE("%s", str);
-
-			// Sanity check on length
-			if (numOfReceievedSRSPbytes != ( ((npiMsgData_t *)npi_ipc_srsp_buf)->len + RPC_FRAME_HDR_SZ))
-			{
-				LOG_FATAL("[NPI Client SEND SYNCH] Mismatch in read IPC data and the expected length\n. \n\tread bytes = %d \n\tnpiMsgLength(+ 3) = %d \n\t\n",
-						numOfReceievedSRSPbytes,
-						((npiMsgData_t *)npi_ipc_srsp_buf)->len + RPC_FRAME_HDR_SZ);
-				exit(1);
-			}
-
-			// Copy response back in transmission buffer for processing
-			memcpy((uint8*)pMsg, npi_ipc_srsp_buf, numOfReceievedSRSPbytes);
+			pthread_cond_wait(&pLane->notEmpty, &pLane->mutex);
 		}
-		else
+		if (pLane->count == 0)
 		{
-			if ( numOfReceievedSRSPbytes < 0)
-				LOG_ERROR("[NPI Client] recv");
-			else
-				LOG_WARN("[NPI Client SEND SYNCH] Server closed connection\n");
+			// Stopped, and all messages handled
+			pthread_mutex_unlock(&pLane->mutex);
+			break;
 		}
 
-		numOfReceievedSRSPbytes = 0;
+		// Copy the message out so the slot is free while the handler runs
+		memcpy(&entry, &pLane->queue[pLane->head], sizeof(npiAreqLaneMsg_t));
+		pLane->head = (pLane->head + 1) % NPI_IPC_AREQ_LANE_DEPTH;
+		pLane->count--;
+		pthread_mutex_unlock(&pLane->mutex);
 
-		// Now unlock the mutex before returning
-		LOG_TRACE("[NPI Client SEND SYNCH][MUTEX] Thread %ld: Unlock SRSP Mutex\n", callingThreadID);
-		pthread_mutex_unlock(&npiLnxClientSREQmutex);
-		LOG_TRACE("[NPI Client SEND SYNCH][MUTEX] Thread %ld: Unlock npiLnxClientSREQSerializationMutex\n", callingThreadID);
-		pthread_mutex_unlock(&npiLnxClientSREQSerializationMutex);
+		entry.pCback(&entry.message);
 	}
-}
 
+	return ptr;
+}
 
 /**************************************************************************************************
  *
- * @fn          NPI_SendAsynchData
+ * @fn          NPI_ReadVersion
  *
- * @brief       This function sends a message asynchronously over the socket
+ * @brief       This API is used to read the NPI server version.
  *
  * input parameters
  *
@@ -1263,90 +3006,28 @@ void NPI_SendSynchData (npiMsgData_t *pMsg)
  * @return      None.
  *
  **************************************************************************************************/
-void NPI_SendAsynchData (npiMsgData_t *pMsg)
+void NPI_ReadVersionReq( uint8 *pValue )
 {
-	// Add Proper RPC type to header
-	if ((((uint8*)pMsg)[RPC_POS_CMD0] & RPC_CMD_TYPE_MASK) == 0)
-		((uint8*)pMsg)[RPC_POS_CMD0] = (((uint8*)pMsg)[RPC_POS_CMD0] & RPC_SUBSYSTEM_MASK) | RPC_CMD_AREQ;
-
-	int i;
-    char str[256];
-    uint8 charWritten;
-    charWritten = snprintf(str, sizeof(str), "[NPI Client SEND ASYNCH] trying to send %d bytes,\t subSys 0x%.2X, cmdId 0x%.2X, pData:",
-							pMsg->len,
-							pMsg->subSys,
-							pMsg->cmdId);
-    charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, "\t");
-    for (i = 0; i < pMsg->len; i++)
-    {
-       charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, " 0x%.2X", pMsg->pData[i]);
-    }
-    LOG_DEBUG("%s\n", str);
-
-	int bytesSent = send(sNPIconnected, (uint8 *)pMsg, pMsg->len + RPC_FRAME_HDR_SZ, 0);
-	if (bytesSent == -1)
-	{
-		LOG_FATAL("[NPI Client SEND ASYNCH] send");
-		exit(1);
-	}
-	else if (bytesSent < pMsg->len + RPC_FRAME_HDR_SZ)
-	{
-		LOG_ERROR("[NPI Client SEND ASYNCH] Sent %d bytes, of expected %d\n", bytesSent, pMsg->len + RPC_FRAME_HDR_SZ);
-	}
-}
+  npiMsgData_t pMsg;
 
-int NPI_AsynchMsgCback(npiMsgData_t *pMsg )
-{
-  npiProcessMsg_t  func;
-  int res = -1;
+  // Prepare Read Version Request
+  pMsg.subSys = RPC_SYS_SRV_CTRL;
+  pMsg.cmdId  = NPI_LNX_CMD_ID_VERSION_REQ;
+  pMsg.len    = 0;
 
-  if (npiState == NPI_STATE_READY)
-  {
-    /* check subsystem range */
-    if (pMsg->subSys < RPC_SYS_MAX)
-    {
-      /* look up processing function */
-      func = NpiAsyncMsgCbackParserTable[pMsg->subSys];
-      if (func)
-      {
-#ifdef   __DEBUG_TIME__
-         char str[256];
-         uint8 charWritten, i;
-         charWritten = snprintf(str, sizeof(str), "[NPI Client CBACK START] subSys 0x%.2X, cmdId 0x%.2X, pData:",
-                           pMsg->subSys,
-                           pMsg->cmdId);
-         charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, "\t");
-         for (i = 0; i < pMsg->len; i++)
-         {
-            charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, " 0x%.2X", pMsg->pData[i]);
-         }
-         charWritten += snprintf(&str[charWritten], sizeof(str) - charWritten, "\n");
-         LOG_DEBUG("%s", str);
-#endif //__DEBUG_TIME__
-        /* execute processing function */
-        res = (*func)(pMsg);
-#ifdef __DEBUG_TIME__
-         LOG_DEBUG("[NPI Client CBACK ENDED] \n");
-#endif //__DEBUG_TIME__
-      }
-      else
-      {
-        LOG_TRACE("Warning! Asynch Msg received not handled! Did you register the parser callback for ?: %s \n", RpcCmdType_list[pMsg->subSys]);
-      }
-    }
-    else
-    {
-        LOG_TRACE("Warning! Asynch Msg received does not correspond to any module: %d >=  RPC_SYS_MAX: \n", pMsg->subSys);
-    }
-  }
-  return res;
+  NPI_SendSynchData( &pMsg );
 
+  // copy the reply data to the client's buffer
+  // Note: the first byte of the payload is reserved for the status
+  msg_memcpy( pValue, &pMsg.pData[1], 3 );
 }
 /**************************************************************************************************
  *
- * @fn          NPI_ReadVersion
+ * @fn          npi_ipc_requestFeatures
  *
- * @brief       This API is used to read the NPI server version.
+ * @brief       This function reads the NPI server version, and asks the server
+ *              for the protocol features this client supports. Must be called
+ *              before any other request is in flight.
  *
  * input parameters
  *
@@ -1354,26 +3035,38 @@ int NPI_AsynchMsgCback(npiMsgData_t *pMsg )
  *
  * output parameters
  *
- * None.
+ * @param       *pVersion - major, minor and revision of the server
  *
  * @return      None.
  *
  **************************************************************************************************/
-void NPI_ReadVersionReq( uint8 *pValue )
+static void npi_ipc_requestFeatures( uint8 *pVersion )
 {
   npiMsgData_t pMsg;
 
-  // Prepare Read Version Request
+  // Prepare Read Version Request, with the features asked for
   pMsg.subSys = RPC_SYS_SRV_CTRL;
   pMsg.cmdId  = NPI_LNX_CMD_ID_VERSION_REQ;
-  pMsg.len    = 0;
+  pMsg.len    = 1;
+  pMsg.pData[0] = NPI_LNX_FEATURES_SUPPORTED;
 
   NPI_SendSynchData( &pMsg );
 
-  // copy the reply data to the client's buffer
   // Note: the first byte of the payload is reserved for the status
-  msg_memcpy( pValue, &pMsg.pData[1], 3 );
+  msg_memcpy( pVersion, &pMsg.pData[1], 3 );
+
+  // Older servers answer without the granted features
+  pthread_mutex_lock(&npiLnxClientSREQmutex);
+  npiClientFeatures = ((pMsg.subSys & RPC_CMD_TYPE_MASK) == RPC_CMD_SRSP) && (pMsg.len >= 5) ?
+		  (pMsg.pData[4] & NPI_LNX_FEATURES_SUPPORTED) : 0;
+  pthread_mutex_unlock(&npiLnxClientSREQmutex);
+
+  if (npiClientFeatures & NPI_LNX_FEATURE_CORRELATION_ID)
+  {
+    LOG_INFO("[NPI Client] Requests carry correlation identifiers\n");
+  }
 }
+
 /**************************************************************************************************
  *
  * @fn          NPI_ReadParamReq
@@ -1528,6 +3221,68 @@ void NPI_SetWorkaroundReq( uint8 workaroundID, uint8 *pStatus )
   msg_memcpy( pStatus, &pMsg.pData[0], pMsg.len );
 }
 
+/**************************************************************************************************
+ *
+ * @fn          NPI_SetQosClassReq
+ *
+ * @brief       This API is used to ask NPI server to change the priority class of this client.
+ *              Messages of a higher class are passed to the device first.
+ *
+ * input parameters
+ *
+ * @param       qosClass	- NPI_LNX_QOS_CLASS_INTERACTIVE, _NORMAL or _BULK
+ *
+ * output parameters
+ *
+ * @param       *pStatus 	- Pointer to buffer where status is read.
+ *
+ * None.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+void NPI_SetQosClassReq( uint8 qosClass, uint8 *pStatus )
+{
+  npiMsgData_t pMsg;
+
+  // Prepare class request
+  pMsg.subSys = RPC_SYS_SRV_CTRL;
+  pMsg.cmdId  = NPI_LNX_CMD_ID_SET_QOS_CLASS;
+  pMsg.len    = 1;
+  pMsg.pData[0] = qosClass;
+
+  NPI_SendSynchData( &pMsg );
+
+  *pStatus = pMsg.pData[0];
+  if (*pStatus == NPI_LNX_SUCCESS)
+  {
+    npiClientQosClass = qosClass;
+  }
+}
+
+/**************************************************************************************************
+ *
+ * @fn          NPI_GetQosClass
+ *
+ * @brief       This API returns the priority class this client last set with NPI_SetQosClassReq,
+ *              so that a temporary change can be undone.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      NPI_LNX_QOS_CLASS_INTERACTIVE, _NORMAL or _BULK
+ *
+ **************************************************************************************************/
+uint8 NPI_GetQosClass( void )
+{
+  return npiClientQosClass;
+}
+
 
 // -- utility porting --
 
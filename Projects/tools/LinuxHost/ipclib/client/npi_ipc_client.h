@@ -60,6 +60,18 @@ extern "C"
    * returns TRUE when initialized successfully. Otherwise, FALSE */
   int NPI_ClientInit(const char *devpath);
 
+  /* Initialize RTI Surrogate without client threads, for applications
+   * driving it from their own event loop through NPI_ClientProcess */
+  int NPI_ClientInitEventLoop(const char *devpath);
+
+  /* Descriptors to poll for reading in event loop mode */
+  void NPI_ClientGetPollFds(int *pSocketFd, int *pWakeFd);
+
+  /* Read and handle ready messages in event loop mode.
+   * pTimeout - ms after which to call again, -1 for none
+   * returns NPI_LNX_FAILURE if the connection to the server is lost */
+  int NPI_ClientProcess(int *pTimeout);
+
   /* Close RTI Surrogate */
   void NPI_ClientClose(void);
 
@@ -67,12 +79,58 @@ extern "C"
   void NPI_SendAsynchData( npiMsgData_t *pMsg );
   void NPI_SendSynchData( npiMsgData_t *pMsg );
 
+  /* Send count SREQs back to back and wait once for all their SRSPs, each
+   * message answered is replaced by its SRSP like with NPI_SendSynchData */
+  void NPI_SendSynchDataBatch( npiMsgData_t *pMsgs, int count );
+
+  /* Completion of NPI_SendSynchDataAsync, called from the AREQ handling thread.
+   * status - NPI_LNX_SUCCESS, or NPI_LNX_FAILURE if no response came
+   * pMsg - the SRSP, NULL on failure */
+  typedef void (*npiSynchDataCback_t)( int status, npiMsgData_t *pMsg, void *ctx );
+
+  /* Send an SREQ without waiting for its SRSP, several may be in flight.
+   * returns NPI_LNX_SUCCESS when sent, pCback is then always called once */
+  int NPI_SendSynchDataAsync( npiMsgData_t *pMsg, npiSynchDataCback_t pCback, void *ctx );
+
+  /* AREQ handler, called with the command type already removed from subSys */
+  typedef int (*npiProcessMsg_t)( npiMsgData_t *pBuf );
+
+  /* Execution lanes of registered AREQ handlers. A dedicated or pool lane queues
+   * up to NPI_IPC_AREQ_LANE_DEPTH messages, further ones are dropped and counted
+   * so that a slow handler never holds up the others */
+#define NPI_AREQ_LANE_INLINE		0	// on the thread handling all AREQs, in order
+#define NPI_AREQ_LANE_DEDICATED		1	// on a thread of its own, in order
+#define NPI_AREQ_LANE_POOL			2	// on a shared pool of threads, unordered
+
+  /* cmdId matching all commands of a subsystem */
+#define NPI_AREQ_CMD_ANY			(-1)
+
+  /* Register an AREQ handler for subSys and cmdId (or NPI_AREQ_CMD_ANY). It takes
+   * precedence over the built-in subsystem handler, an exact cmdId over NPI_AREQ_CMD_ANY.
+   * returns NPI_LNX_SUCCESS, or NPI_LNX_FAILURE if already registered or out of room */
+  int NPI_RegisterAsynchMsgCback( uint8 subSys, int cmdId, npiProcessMsg_t pCback, uint8 lane );
+
+  /* Remove a handler, after the messages queued on its lane are handled */
+  int NPI_UnregisterAsynchMsgCback( uint8 subSys, int cmdId );
+
   /* The following two functions allow client to control Server */
   void NPI_ConnectReq( uint8 *pStatus, uint8 length, uint8 *devPath );
   void NPI_DisconnectReq( uint8 *pStatus );
 
   void NPI_SetWorkaroundReq( uint8 workaroundID, uint8 *pStatus );
 
+  /* Select the priority class of this client, see NPI_LNX_QOS_CLASS_* */
+  void NPI_SetQosClassReq( uint8 qosClass, uint8 *pStatus );
+
+  /* Priority class last set by this client */
+  uint8 NPI_GetQosClass( void );
+
+  /* Number of client thread wake-ups which found no work, for standby power tuning */
+  uint32 NPI_ClientIdleWakeups(void);
+
+  /* Largest number of received AREQ messages that were waiting to be handled */
+  uint32 NPI_ClientAreqQueueHighWater(void);
+
   extern uint8 __DEBUG_CLIENT_ACTIVE;
 
   /**************************************************************************************************
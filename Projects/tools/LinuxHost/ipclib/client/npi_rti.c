@@ -48,6 +48,7 @@
 #include <string.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <pthread.h>
 
 #include "npi_ipc_client.h"
 #include "hal_defs.h"
@@ -61,6 +62,13 @@
 
 #define msg_memcpy(src, dst, len)	memcpy(src, dst, len)
 
+// Number of items RTI_ReadItems() and RTI_WriteItems() send before waiting for responses
+#define RTI_ITEMS_BATCH				16
+
+// Items which hold a pairing table entry
+#define RTI_PT_ITEM(_itemId) \
+  (((_itemId) == RTI_SA_ITEM_PAIRING_TABLE_ENTRY) || ((_itemId) == RTI_SA_ITEM_PT_CURRENT_ENTRY))
+
 
 #define NAME_ELEMENT(element) [element&0x1F] = #element
 
@@ -75,6 +83,19 @@ const char * const RtiAreqCmdType_list[2 + 1] = { //15 Cmd Type
  **************************************************************************************************/
 static uint8 rtiBE=FALSE; // big endian machine flag
 
+// Pairing table mirror, see RTI_ReadPairingEntry()
+typedef struct
+{
+  uint8                valid;
+  uint32               generation;  // incremented on each invalidation
+  uint8                numEntries;  // as reported by the RNP
+  rStatus_t            *pStatus;    // numEntries statuses
+  rcnNwkPairingEntry_t *pEntries;   // numEntries entries
+} rtiPtCache_t;
+
+static rtiPtCache_t rtiPtCache;
+static pthread_mutex_t rtiPtCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
 /**************************************************************************************************
  *                                     Local Function Prototypes
  **************************************************************************************************/
@@ -131,12 +152,14 @@ int RTI_AsynchMsgCback( npiMsgData_t *pMsg )
 		{
 		// confirmation to init request
 		case RTIS_CMD_ID_RTI_INIT_CNF:
+			RTI_InvalidatePairingTable();
 			RTI_InitCnf( (rStatus_t)pMsg->pData[0] );
 			break;
 
 			// confirmation to pair request
 		case RTIS_CMD_ID_RTI_PAIR_CNF:
 			// status, pairing ref table index, pairing table device type
+			RTI_InvalidatePairingTable();
 			RTI_PairCnf( (rStatus_t)pMsg->pData[0], pMsg->pData[1], pMsg->pData[2] );
 			break;
 
@@ -147,6 +170,7 @@ int RTI_AsynchMsgCback( npiMsgData_t *pMsg )
 
 			// confirmation to allow pair request
 		case RTIS_CMD_ID_RTI_ALLOW_PAIR_CNF:
+			RTI_InvalidatePairingTable();
 			RTI_AllowPairCnf( (rStatus_t) pMsg->pData[0], pMsg->pData[1], pMsg->pData[2]);
 			break;
 
@@ -184,15 +208,18 @@ int RTI_AsynchMsgCback( npiMsgData_t *pMsg )
 			break;
 
 		case RTIS_CMD_ID_RTI_UNPAIR_CNF:
+			RTI_InvalidatePairingTable();
 			RTI_UnpairCnf( (rStatus_t) pMsg->pData[0],
 					pMsg->pData[1] ); // dstIndex
 			break;
 
 		case RTIS_CMD_ID_RTI_UNPAIR_IND:
+			RTI_InvalidatePairingTable();
 			RTI_UnpairInd( pMsg->pData[0] ); // dstIndex
 			break;
 
 		case RTIS_CMD_ID_RTI_RESET_IND:
+			RTI_InvalidatePairingTable();
 			RTI_ResetInd();
 			break;
 
@@ -232,12 +259,14 @@ int RTI_AsynchMsgCback( npiMsgData_t *pMsg )
 
 #if (defined FEATURE_ZRC20) && (FEATURE_ZRC20 == TRUE)
 		case RTIS_CMD_ID_RTI_BIND_CNF://                     0x30
+			RTI_InvalidatePairingTable();
 			RTI_BindCnf( pMsg->pData[0], pMsg->pData[1] ); //
 			break;
 		case RTIS_CMD_ID_RTI_SEND_PROFILE_CMD_CNF://         0x31
 			RTI_SendProfileCommandCnf( pMsg->pData[0] ); //
 			break;
 		case RTIS_CMD_ID_RTI_BIND_IND://                     0x32
+			RTI_InvalidatePairingTable();
 			RTI_BindInd( pMsg->pData[0], pMsg->pData[1] ); //
 			break;
 		case RTIS_CMD_ID_RTI_START_VALIDATION_IND://         0x33
@@ -283,9 +312,11 @@ int RTI_AsynchMsgCback( npiMsgData_t *pMsg )
 			RTI_PollInd( pMsg->pData[0], pMsg->pData[1] ); //
 			break;
 		case RTIS_CMD_ID_RTI_UNBIND_CNF://                   0x41
+			RTI_InvalidatePairingTable();
 			RTI_UnbindCnf( pMsg->pData[0], pMsg->pData[1] ); //
 			break;
 		case RTIS_CMD_ID_RTI_UNBIND_IND://                   0x42
+			RTI_InvalidatePairingTable();
 			RTI_UnbindInd( pMsg->pData[0] ); //
 			break;
 		case RTIS_CMD_ID_RTI_BIND_ABORT_CNF://               0x43
@@ -575,6 +606,11 @@ rStatus_t RTI_WriteItemEx( uint8 profileId, uint8 itemId, uint8 len, uint8 *pVal
   // send Write Item request to NP RTIS synchronously
   NPI_SendSynchData( &pMsg );
 
+  if (RTI_PT_ITEM(itemId))
+  {
+    RTI_InvalidatePairingTable();
+  }
+
   // DEBUG
   if ( pMsg.pData[0] == RTI_ERROR_SYNCHRONOUS_NPI_TIMEOUT )
   {
@@ -631,6 +667,11 @@ rStatus_t RTI_WriteIndexedItem( uint8 profileId, uint8 itemId, uint8 index, uint
   // send Write Item request to NP RTIS synchronously
   NPI_SendSynchData( &pMsg );
 
+  if (RTI_PT_ITEM(itemId))
+  {
+    RTI_InvalidatePairingTable();
+  }
+
   // DEBUG
   if ( pMsg.pData[0] == RTI_ERROR_SYNCHRONOUS_NPI_TIMEOUT )
   {
@@ -641,6 +682,467 @@ rStatus_t RTI_WriteIndexedItem( uint8 profileId, uint8 itemId, uint8 index, uint
   return( (rStatus_t)pMsg.pData[0] );
 }
 
+/**************************************************************************************************
+ *
+ * @fn          RTI_ReadItems
+ *
+ * @brief       This API is used to read several items from Profiles' Configuration Interfaces.
+ *              The requests are sent back to back and their responses are
+ *              waited for at once, instead of one round trip per item.
+ *
+ * input parameters
+ *
+ * @param       numItems - Number of items.
+ * @param       pItems - Items to read, with profileId, itemId and len set.
+ *
+ * output parameters
+ *
+ * @param       pItems - pValue of each item holds its data, and status its result.
+ *
+ * @return      RTI_SUCCESS if all items were read, otherwise the status of
+ *              the first item which failed.
+ *
+ **************************************************************************************************/
+rStatus_t RTI_ReadItems( uint8 numItems, rtiItem_t *pItems )
+{
+  npiMsgData_t pMsgs[RTI_ITEMS_BATCH];
+  rStatus_t status = RTI_SUCCESS;
+  uint8 first, num, i;
+
+  for (first = 0; first < numItems; first += num)
+  {
+    num = ((numItems - first) < RTI_ITEMS_BATCH) ? (numItems - first) : RTI_ITEMS_BATCH;
+
+    // prep Read Item requests
+    // Note: no need to send pValue over the NPI
+    for (i = 0; i < num; i++)
+    {
+      pMsgs[i].subSys   = RPC_SYS_RCAF;
+      pMsgs[i].cmdId    = RTIS_CMD_ID_RTI_READ_ITEM_EX;
+      pMsgs[i].len      = 3;
+      pMsgs[i].pData[0] = pItems[first + i].profileId;
+      pMsgs[i].pData[1] = pItems[first + i].itemId;
+      pMsgs[i].pData[2] = pItems[first + i].len;
+    }
+
+    // send Read Item requests to NPI socket synchronously
+    NPI_SendSynchDataBatch( pMsgs, num );
+
+    for (i = 0; i < num; i++)
+    {
+      rtiItem_t *pItem = &pItems[first + i];
+
+      // a request left unanswered still has its request type
+      if ((pMsgs[i].subSys & RPC_CMD_TYPE_MASK) != RPC_CMD_SRSP)
+      {
+        pItem->status = RTI_ERROR_SYNCHRONOUS_NPI_TIMEOUT;
+      }
+      else
+      {
+        // copy the reply data to the client's buffer
+        // Note: the first byte of the payload is reserved for the status
+        msg_memcpy( pItem->pValue, &pMsgs[i].pData[1], pItem->len );
+
+        // perform endianness change
+        rtiAttribEConv( pItem->itemId, pItem->len, pItem->pValue );
+
+        pItem->status = (rStatus_t)pMsgs[i].pData[0];
+      }
+
+      if ((status == RTI_SUCCESS) && (pItem->status != RTI_SUCCESS))
+      {
+        status = pItem->status;
+      }
+    }
+  }
+
+  return( status );
+}
+
+/**************************************************************************************************
+ *
+ * @fn          RTI_WriteItems
+ *
+ * @brief       This API is used to write several items to Profiles' Configuration Interfaces.
+ *              The requests are sent back to back and their responses are
+ *              waited for at once, instead of one round trip per item. The
+ *              items are written in order.
+ *
+ * input parameters
+ *
+ * @param       numItems - Number of items.
+ * @param       pItems - Items to write, with profileId, itemId, len and pValue set.
+ *
+ * output parameters
+ *
+ * @param       pItems - status of each item holds its result.
+ *
+ * @return      RTI_SUCCESS if all items were written, otherwise the status of
+ *              the first item which failed.
+ *
+ **************************************************************************************************/
+rStatus_t RTI_WriteItems( uint8 numItems, rtiItem_t *pItems )
+{
+  npiMsgData_t pMsgs[RTI_ITEMS_BATCH];
+  rStatus_t status = RTI_SUCCESS;
+  uint8 first, num, i;
+
+  for (first = 0; first < numItems; first += num)
+  {
+    num = ((numItems - first) < RTI_ITEMS_BATCH) ? (numItems - first) : RTI_ITEMS_BATCH;
+
+    // prep Write Item requests
+    for (i = 0; i < num; i++)
+    {
+      rtiItem_t *pItem = &pItems[first + i];
+
+      pMsgs[i].subSys   = RPC_SYS_RCAF;
+      pMsgs[i].cmdId    = RTIS_CMD_ID_RTI_WRITE_ITEM_EX;
+      pMsgs[i].len      = 3 + pItem->len;
+      pMsgs[i].pData[0] = pItem->profileId;
+      pMsgs[i].pData[1] = pItem->itemId;
+      pMsgs[i].pData[2] = pItem->len;
+
+      // copy the client's data to be sent
+      msg_memcpy( &pMsgs[i].pData[3], pItem->pValue, pItem->len );
+
+      // perform endianness change
+      rtiAttribEConv( pItem->itemId, pItem->len, &pMsgs[i].pData[3] );
+    }
+
+    // send Write Item requests to NP RTIS synchronously
+    NPI_SendSynchDataBatch( pMsgs, num );
+
+    for (i = 0; i < num; i++)
+    {
+      if (RTI_PT_ITEM(pItems[first + i].itemId))
+      {
+        RTI_InvalidatePairingTable();
+        break;
+      }
+    }
+
+    for (i = 0; i < num; i++)
+    {
+      rtiItem_t *pItem = &pItems[first + i];
+
+      // a request left unanswered still has its request type
+      if ((pMsgs[i].subSys & RPC_CMD_TYPE_MASK) != RPC_CMD_SRSP)
+      {
+        pItem->status = RTI_ERROR_SYNCHRONOUS_NPI_TIMEOUT;
+      }
+      else
+      {
+        // the status is stored in the first byte of the payload
+        pItem->status = (rStatus_t)pMsgs[i].pData[0];
+      }
+
+      if ((status == RTI_SUCCESS) && (pItem->status != RTI_SUCCESS))
+      {
+        status = pItem->status;
+      }
+    }
+  }
+
+  return( status );
+}
+
+/**************************************************************************************************
+ *
+ * @fn          rtiPtCacheLoad
+ *
+ * @brief       This function reads the whole pairing table from the RNP into a mirror sized
+ *              for the table the RNP reports. Each entry is selected with
+ *              RTI_SA_ITEM_PT_CURRENT_ENTRY_INDEX and read with RTI_SA_ITEM_PT_CURRENT_ENTRY,
+ *              which every RNP version supports. The pairs are sent back to back,
+ *              RTI_ITEMS_BATCH requests at a time, and the server forwards them to the RNP
+ *              in order. The current entry index is restored afterwards, so that an
+ *              application using the index/entry pair itself does not see it change.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * @param       pCache - mirror to fill, pStatus and pEntries are allocated on success.
+ *
+ * @return      RTI_SUCCESS, or the status of the request which could not be completed.
+ *
+ **************************************************************************************************/
+static rStatus_t rtiPtCacheLoad( rtiPtCache_t *pCache )
+{
+  npiMsgData_t pMsgs[RTI_ITEMS_BATCH];
+  rStatus_t status;
+  uint8 numEntries = 0, savedIndex = 0;
+  uint8 first, num, i;
+
+  status = RTI_ReadItemEx( RTI_PROFILE_RTI, RTI_CONST_ITEM_MAX_PAIRING_TABLE_ENTRIES, 1, &numEntries );
+  if (status == RTI_SUCCESS)
+  {
+    status = RTI_ReadItemEx( RTI_PROFILE_RTI, RTI_SA_ITEM_PT_CURRENT_ENTRY_INDEX, 1, &savedIndex );
+  }
+  if (status != RTI_SUCCESS)
+  {
+    return( status );
+  }
+
+  pCache->numEntries = numEntries;
+  pCache->pStatus = (rStatus_t *) calloc(numEntries + 1, sizeof(rStatus_t));
+  pCache->pEntries = (rcnNwkPairingEntry_t *) calloc(numEntries + 1, sizeof(rcnNwkPairingEntry_t));
+  if ((pCache->pStatus == NULL) || (pCache->pEntries == NULL))
+  {
+    free(pCache->pStatus);
+    free(pCache->pEntries);
+    pCache->pStatus = NULL;
+    pCache->pEntries = NULL;
+    return( RTI_ERROR_OUT_OF_MEMORY );
+  }
+
+  for (first = 0; (first < numEntries) && (status == RTI_SUCCESS); first += num)
+  {
+    num = ((numEntries - first) < (RTI_ITEMS_BATCH / 2)) ? (numEntries - first) : (RTI_ITEMS_BATCH / 2);
+
+    // prep one index write and one entry read per pairing entry
+    for (i = 0; i < num; i++)
+    {
+      npiMsgData_t *pIndexMsg = &pMsgs[2 * i];
+      npiMsgData_t *pEntryMsg = &pMsgs[2 * i + 1];
+
+      pIndexMsg->subSys   = RPC_SYS_RCAF;
+      pIndexMsg->cmdId    = RTIS_CMD_ID_RTI_WRITE_ITEM_EX;
+      pIndexMsg->len      = 4;
+      pIndexMsg->pData[0] = RTI_PROFILE_RTI;
+      pIndexMsg->pData[1] = RTI_SA_ITEM_PT_CURRENT_ENTRY_INDEX;
+      pIndexMsg->pData[2] = 1;
+      pIndexMsg->pData[3] = first + i;
+
+      pEntryMsg->subSys   = RPC_SYS_RCAF;
+      pEntryMsg->cmdId    = RTIS_CMD_ID_RTI_READ_ITEM_EX;
+      pEntryMsg->len      = 3;
+      pEntryMsg->pData[0] = RTI_PROFILE_RTI;
+      pEntryMsg->pData[1] = RTI_SA_ITEM_PT_CURRENT_ENTRY;
+      pEntryMsg->pData[2] = sizeof(rcnNwkPairingEntry_t);
+    }
+
+    NPI_SendSynchDataBatch( pMsgs, 2 * num );
+
+    for (i = 0; i < num; i++)
+    {
+      npiMsgData_t *pIndexMsg = &pMsgs[2 * i];
+      npiMsgData_t *pEntryMsg = &pMsgs[2 * i + 1];
+      uint8 index = first + i;
+
+      // a request left unanswered still has its request type
+      if (((pIndexMsg->subSys & RPC_CMD_TYPE_MASK) != RPC_CMD_SRSP) ||
+          ((pEntryMsg->subSys & RPC_CMD_TYPE_MASK) != RPC_CMD_SRSP))
+      {
+        status = RTI_ERROR_SYNCHRONOUS_NPI_TIMEOUT;
+        break;
+      }
+
+      if (pIndexMsg->pData[0] != RTI_SUCCESS)
+      {
+        pCache->pStatus[index] = (rStatus_t)pIndexMsg->pData[0];
+      }
+      else
+      {
+        pCache->pStatus[index] = (rStatus_t)pEntryMsg->pData[0];
+        if (pCache->pStatus[index] == RTI_SUCCESS)
+        {
+          // Note: the first byte of the payload is reserved for the status
+          msg_memcpy( &pCache->pEntries[index], &pEntryMsg->pData[1], sizeof(rcnNwkPairingEntry_t) );
+
+          // perform endianness change
+          rtiAttribEConv( RTI_SA_ITEM_PT_CURRENT_ENTRY, sizeof(rcnNwkPairingEntry_t),
+              (uint8 *)&pCache->pEntries[index] );
+        }
+      }
+    }
+  }
+
+  // put the application's current entry index back
+  if (RTI_WriteItemEx( RTI_PROFILE_RTI, RTI_SA_ITEM_PT_CURRENT_ENTRY_INDEX, 1, &savedIndex ) != RTI_SUCCESS)
+  {
+    LOG_WARN("[RTI] Failed to restore pairing table current entry index %d\n", savedIndex);
+  }
+
+  if (status != RTI_SUCCESS)
+  {
+    free(pCache->pStatus);
+    free(pCache->pEntries);
+    pCache->pStatus = NULL;
+    pCache->pEntries = NULL;
+  }
+
+  return( status );
+}
+
+/**************************************************************************************************
+ *
+ * @fn          rtiPtCacheLock
+ *
+ * @brief       This function locks the pairing table mirror, loading it from the RNP first
+ *              if it is not valid. The RNP is not accessed with the lock held; if the mirror
+ *              was invalidated while it was loading, the loaded table is still served to this
+ *              caller but the next one loads it again.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      RTI_SUCCESS with rtiPtCacheMutex held, or the status of the failed load
+ *              with rtiPtCacheMutex released.
+ *
+ **************************************************************************************************/
+static rStatus_t rtiPtCacheLock( void )
+{
+  rtiPtCache_t loaded;
+  uint32 generation;
+  rStatus_t status;
+
+  pthread_mutex_lock(&rtiPtCacheMutex);
+  if (rtiPtCache.valid)
+  {
+    return( RTI_SUCCESS );
+  }
+  generation = rtiPtCache.generation;
+  pthread_mutex_unlock(&rtiPtCacheMutex);
+
+  memset(&loaded, 0, sizeof(rtiPtCache_t));
+  status = rtiPtCacheLoad( &loaded );
+  if (status != RTI_SUCCESS)
+  {
+    LOG_WARN("[RTI] Failed to load pairing table (status 0x%.2X)\n", status);
+    return( status );
+  }
+
+  pthread_mutex_lock(&rtiPtCacheMutex);
+  free(rtiPtCache.pStatus);
+  free(rtiPtCache.pEntries);
+  rtiPtCache.numEntries = loaded.numEntries;
+  rtiPtCache.pStatus = loaded.pStatus;
+  rtiPtCache.pEntries = loaded.pEntries;
+  rtiPtCache.valid = (generation == rtiPtCache.generation);
+
+  return( RTI_SUCCESS );
+}
+
+/**************************************************************************************************
+ *
+ * @fn          RTI_ReadPairingEntry
+ *
+ * @brief       This API is used to read a pairing table entry. The pairing table is mirrored
+ *              in the client: the first call loads it from the RNP in one go, and later calls
+ *              are served from memory until the mirror is invalidated by a pairing, an unpair,
+ *              a reset of the RNP or a write of a pairing entry through this library.
+ *
+ *              Note: fields the RNP updates on its own, such as the frame counter, are
+ *                    as of the time the mirror was loaded.
+ *
+ * input parameters
+ *
+ * @param       index - The pairing table index.
+ *
+ * output parameters
+ *
+ * @param       *pEntry - Pointer to buffer where the entry is placed.
+ *
+ * @return      RTI_SUCCESS, RTI_ERROR_INVALID_INDEX, or the status returned by the RNP
+ *              when the entry was read.
+ *
+ **************************************************************************************************/
+rStatus_t RTI_ReadPairingEntry( uint8 index, rcnNwkPairingEntry_t *pEntry )
+{
+  rStatus_t status;
+
+  status = rtiPtCacheLock();
+  if (status != RTI_SUCCESS)
+  {
+    return( status );
+  }
+
+  if (index >= rtiPtCache.numEntries)
+  {
+    status = RTI_ERROR_INVALID_INDEX;
+  }
+  else
+  {
+    status = rtiPtCache.pStatus[index];
+    if (status == RTI_SUCCESS)
+    {
+      memcpy(pEntry, &rtiPtCache.pEntries[index], sizeof(rcnNwkPairingEntry_t));
+    }
+  }
+  pthread_mutex_unlock(&rtiPtCacheMutex);
+
+  return( status );
+}
+
+/**************************************************************************************************
+ *
+ * @fn          RTI_GetPairingTableSize
+ *
+ * @brief       This API is used to get the number of pairing table entries, loading the
+ *              pairing table mirror if needed. See RTI_ReadPairingEntry.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      Number of entries, 0 if the pairing table could not be read.
+ *
+ **************************************************************************************************/
+uint8 RTI_GetPairingTableSize( void )
+{
+  uint8 numEntries;
+
+  if (rtiPtCacheLock() != RTI_SUCCESS)
+  {
+    return( 0 );
+  }
+  numEntries = rtiPtCache.numEntries;
+  pthread_mutex_unlock(&rtiPtCacheMutex);
+
+  return( numEntries );
+}
+
+/**************************************************************************************************
+ *
+ * @fn          RTI_InvalidatePairingTable
+ *
+ * @brief       This API is used to drop the pairing table mirror, so that the next
+ *              RTI_ReadPairingEntry() reads the table from the RNP again. The library calls it
+ *              itself on pairing, unpair and reset events and on writes of pairing entries;
+ *              clients only need it if the pairing table changes in some other way.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+void RTI_InvalidatePairingTable( void )
+{
+  pthread_mutex_lock(&rtiPtCacheMutex);
+  rtiPtCache.valid = FALSE;
+  rtiPtCache.generation++;
+  pthread_mutex_unlock(&rtiPtCacheMutex);
+}
+
 /**************************************************************************************************
  *
  * @fn          RTI_WriteItem
@@ -685,6 +1187,11 @@ rStatus_t RTI_WriteItem( uint8 itemId, uint8 len, uint8 *pValue )
   // send Write Item request to NP RTIS synchronously
   NPI_SendSynchData( &pMsg );
 
+  if (RTI_PT_ITEM(itemId))
+  {
+    RTI_InvalidatePairingTable();
+  }
+
   // DEBUG
   if ( pMsg.pData[0] == RTI_ERROR_SYNCHRONOUS_NPI_TIMEOUT )
   {
@@ -630,6 +630,16 @@ PACK_1 typedef struct ATTR_PACKED
 #endif
 
 
+// Configuration Interface item for RTI_ReadItems() and RTI_WriteItems()
+typedef struct
+{
+  uint8     profileId;  // The Profile identifier
+  uint8     itemId;     // The Configuration Interface item identifier
+  uint8     len;        // The length in bytes of the item identifier's data
+  uint8     *pValue;    // Buffer for the item's data
+  rStatus_t status;     // Result for this item, set by the call
+} rtiItem_t;
+
 // function pointer for RCN event callback function
 typedef void (*rtiRcnCbackFn_t)( void *pData );
 
@@ -660,6 +670,13 @@ extern RTILIB_API rStatus_t RTI_ReadItem(uint8 itemId, uint8 len, uint8 *pValue)
 extern RTILIB_API rStatus_t RTI_WriteItem(uint8 itemId, uint8 len, uint8 *pValue);
 extern RTILIB_API rStatus_t RTI_ReadIndexedItem(uint8 profileId, uint8 itemId, uint8 index, uint8 len, uint8 *pValue);
 extern RTILIB_API rStatus_t RTI_WriteIndexedItem(uint8 profileId, uint8 itemId, uint8 index, uint8 len, uint8 *pValue);
+extern RTILIB_API rStatus_t RTI_ReadItems(uint8 numItems, rtiItem_t *pItems);
+extern RTILIB_API rStatus_t RTI_WriteItems(uint8 numItems, rtiItem_t *pItems);
+
+// Pairing table, served from a mirror in the client
+extern RTILIB_API rStatus_t RTI_ReadPairingEntry(uint8 index, rcnNwkPairingEntry_t *pEntry);
+extern RTILIB_API uint8 RTI_GetPairingTableSize(void);
+extern RTILIB_API void RTI_InvalidatePairingTable(void);
 
 // Application Profile Interface
 // Used to access RF4CE application profile
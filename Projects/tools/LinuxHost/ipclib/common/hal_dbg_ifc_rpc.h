@@ -81,10 +81,14 @@ extern "C"
 #define DEBUG_CMD_ID_ENTER_DEBUG_MODE_REQ			0x01
 #define DEBUG_CMD_ID_PROGRAM_BUFFER_REQ				0x02
 #define DEBUG_CMD_ID_READ_FROM_CHIP_TO_BUFFER_REQ	0x03
+#define DEBUG_CMD_ID_DUMP_FLASH_REQ					0x04
 
 // Asynchronous Command IDs
 #define DEBUG_CMD_ID_PROGRAM_BUFFER_CNF				0x01
 #define DEBUG_CMD_ID_READ_FROM_CHIP_TO_BUFFER_CNF	0x02
+#define DEBUG_CMD_ID_DUMP_FLASH_DATA_IND			0x03
+#define DEBUG_CMD_ID_DUMP_FLASH_PROGRESS_IND		0x04
+#define DEBUG_CMD_ID_DUMP_FLASH_CNF					0x05
 
 // Status
 #define DEBUG_FLASH_PROGRAM_SUCCESS					0x00
@@ -95,10 +99,24 @@ extern "C"
 #define DEBUG_FLASH_FAILED_TO_READ_FLASH_SIZE		0x05
 #define DEBUG_FLASH_NO_BUFFER_CONFIGURED			0x06
 #define DEBUG_FLASH_FAILED_TO_WAIT_FOR_RESPONSE		0x07
+#define DEBUG_FLASH_FAILED_TO_READ_FLASH			0x08
+#define DEBUG_FLASH_FAILED_TO_WRITE_FILE			0x09
+#define DEBUG_FLASH_INVALID_RANGE					0x0A
+#define DEBUG_FLASH_INVALID_PATH					0x0B
 
 // Flash write block sizes
 #define DEBUG_FLASH_PROGRAM_NPI_BLOCK_SIZE			64
 #define DEBUG_FLASH_PROGRAM_BUFFER_BLOCK_SIZE		1024
+
+// Flash dump sizes
+// DEBUG_CMD_ID_DUMP_FLASH_REQ:		startAddress (uint32), size (uint32), [NUL terminated file name, relative to the server [DEBUG] dumpDir]
+// DEBUG_CMD_ID_DUMP_FLASH_DATA_IND:	address (uint32), up to DEBUG_FLASH_DUMP_NPI_BLOCK_SIZE bytes
+// DEBUG_CMD_ID_DUMP_FLASH_PROGRESS_IND:	bytes dumped (uint32), total (uint32)
+// DEBUG_CMD_ID_DUMP_FLASH_CNF:		status, bytes dumped (uint32)
+#define DEBUG_FLASH_DUMP_NPI_BLOCK_SIZE				240
+#define DEBUG_FLASH_DUMP_BURST_SIZE					2048
+#define DEBUG_FLASH_DUMP_BANK_SIZE					0x8000
+#define DEBUG_FLASH_DUMP_PATH_MAX_LEN				(AP_MAX_BUF_LEN - 8)
 /*********************************************************************
  * CONSTANTS
  */
@@ -135,6 +153,7 @@ extern uint8 Hal_configure_buffer(uint32 bufferSize, uint32 startAddress);
 
 extern int Hal_program_bufferReq(void);
 extern int Hal_read_from_chip_to_bufferReq(void);
+extern int Hal_dump_flashReq(uint32 startAddress, uint32 size, const char *path);
 extern int Hal_EnterDebugModeReq(void);
 
 extern void Hal_program_bufferCnf(uint8 status);
@@ -223,6 +223,28 @@ extern const pNPI_SendAsynchDataFn NPI_SendAsynchDataFnArr[];
 typedef int (*pNPI_SendSynchDataFn) ( npiMsgData_t *pMsg );
 extern const pNPI_SendSynchDataFn NPI_SendSynchDataFnArr[];
 
+/**************************************************************************************************
+ * @fn          NPI_SendSynchBuf
+ *
+ * @brief       As NPI_SendSynchData, for devices which receive frames into message buffers
+ *              (see npi_lnx_msgbuf.h). The SRSP is handed over in the buffer it was received
+ *              in instead of being copied. NULL for the devices which do not.
+ *
+ * input parameters
+ *
+ * @param *pMsg  - Pointer to data to be sent synchronously (i.e. the SREQ).
+ *
+ * output parameters
+ *
+ * @param **ppRsp - SRSP buffer with one reference held by the caller, NULL if none came.
+ *
+ * @return      STATUS
+ **************************************************************************************************
+ */
+struct npiMsgBuf_s;		// see npi_lnx_msgbuf.h
+typedef int (*pNPI_SendSynchBufFn) ( npiMsgData_t *pMsg, struct npiMsgBuf_s **ppRsp );
+extern const pNPI_SendSynchBufFn NPI_SendSynchBufFnArr[];
+
 /**************************************************************************************************
  * @fn          NPI_AsynchMsgCback
  *
@@ -150,6 +150,8 @@ int NPI_LNX_IPC_NotifyError(uint16 source, const char* errorMsg);
 #define NPI_LNX_ERROR_IPC_NOTIFY_ERR_CREATE_SOCKET					0x01080200
 #define NPI_LNX_ERROR_IPC_NOTIFY_ERR_CONNECT 						0x01080300
 #define NPI_LNX_ERROR_IPC_NOTIFY_ERR_SET_SOCKET_OPTIONS				0x01080400
+#define NPI_LNX_ERROR_IPC_NOTIFY_ERR_CREATE_CHANNEL					0x01080500
+#define NPI_LNX_ERROR_IPC_NOTIFY_ERR_QUEUE_FULL						(0x01080600 | JUST_WARNING)
 #define NPI_LNX_ERROR_IPC_THREAD_CREATION_FAILED					0x01090100
 
 /*
@@ -162,6 +164,7 @@ int NPI_LNX_IPC_NotifyError(uint16 source, const char* errorMsg);
 #define NPI_LNX_ERROR_UART_OPEN_FAILED_DEVICE						0x02010300
 #define NPI_LNX_ERROR_UART_OPEN_FAILED_ASYNCH_CB_THREAD				0x02010400
 #define NPI_LNX_ERROR_UART_OPEN_FAILED_RX_THREAD					0x02010500
+#define NPI_LNX_ERROR_UART_OPEN_FAILED_SLEEP_GOV_THREAD				0x02010600
 #define NPI_LNX_ERROR_UART_CLOSE_GENERIC							0x02020100
 #define NPI_LNX_ERROR_UART_SEND_FRAME_FAILED_TO_WRITE				0x02030100
 #define NPI_LNX_ERROR_UART_SEND_FRAME_FAILED_TO_ALLOCATE			0x02030200
@@ -169,6 +172,7 @@ int NPI_LNX_IPC_NotifyError(uint16 source, const char* errorMsg);
 #define NPI_LNX_ERROR_UART_RX_THREAD								0x02050100
 #define NPI_LNX_ERROR_UART_RX_THREAD_MAX_ATTEMPTS					0x02050200
 #define NPI_LNX_ERROR_UART_ASYNCH_CB_PROC_THREAD					0x02060100
+#define NPI_LNX_ERROR_UART_SLEEP_GOV_WAKEUP_TIMEDOUT				0x02070100
 
 // Error codes for SPI
 #define NPI_LNX_ERROR_SPI_GENERIC									0x03000100
@@ -182,16 +186,19 @@ int NPI_LNX_IPC_NotifyError(uint16 source, const char* errorMsg);
 #define NPI_LNX_ERROR_SPI_OPEN_FAILED_POLL_COND						0x03010800
 #define NPI_LNX_ERROR_SPI_OPEN_FAILED_SRDY_COND						0x03010900
 #define NPI_LNX_ERROR_SPI_OPEN_FAILED_SRDY_LOCK_MUTEX				0x03010A00
+#define NPI_LNX_ERROR_SPI_OPEN_FAILED_DISPATCH_THREAD				0x03010B00
 #define NPI_LNX_ERROR_SPI_CLOSE_GENERIC								0x03020100
 #define NPI_LNX_ERROR_SPI_POLL_LOCK_VAR_ERROR						0x03030100
 #define NPI_LNX_ERROR_SPI_POLL_DATA_SRDY_CLR_TIMEOUT_POSSIBLE_RESET	(0x03040100 | RESET_REQUESTED | JUST_WARNING)
 #define NPI_LNX_ERROR_SPI_POLL_THREAD_SREQ_CONFLICT					0x03050100
 #define NPI_LNX_ERROR_SPI_POLL_THREAD_POLL_UNLOCK					0x03050200
 #define NPI_LNX_ERROR_SPI_POLL_THREAD_POLL_LOCK						0x03050300
+#define NPI_LNX_ERROR_SPI_POLL_THREAD_NO_BUFFER						0x03050400
 #define NPI_LNX_ERROR_SPI_EVENT_THREAD_OPEN_EVENT_FD				0x03060100
 #define NPI_LNX_ERROR_SPI_EVENT_THREAD_POLL_FD_FAILED				0x03060200
 #define NPI_LNX_ERROR_SPI_EVENT_THREAD_FAILED_POLL					0x03070100
 #define NPI_LNX_ERROR_SPI_INT_THREAD_FAILED_POLL					0x03080100
+#define NPI_LNX_ERROR_SPI_DISPATCH_THREAD							0x03090100
 
 // Error codes for HAL SPI
 #define NPI_LNX_ERROR_HAL_SPI_GENERIC									0x04000100
@@ -221,6 +228,7 @@ int NPI_LNX_IPC_NotifyError(uint16 source, const char* errorMsg);
 #define NPI_LNX_ERROR_I2C_OPEN_FAILED_POLL_COND						0x05010800
 #define NPI_LNX_ERROR_I2C_OPEN_FAILED_SRDY_COND						0x05010900
 #define NPI_LNX_ERROR_I2C_OPEN_FAILED_SRDY_LOCK_MUTEX				0x05010A00
+#define NPI_LNX_ERROR_I2C_OPEN_FAILED_DISPATCH_THREAD				0x05010B00
 #define NPI_LNX_ERROR_I2C_CLOSE_GENERIC								0x05020100
 #define NPI_LNX_ERROR_I2C_SEND_ASYNCH_FAILED_LOCK					0x05030100
 #define NPI_LNX_ERROR_I2C_SEND_ASYNCH_FAILED_UNLOCK					0x05030200
@@ -228,12 +236,14 @@ int NPI_LNX_IPC_NotifyError(uint16 source, const char* errorMsg);
 #define NPI_LNX_ERROR_I2C_SEND_SYNCH_FAILED_UNLOCK					0x05040200
 #define NPI_LNX_ERROR_I2C_POLL_THREAD_FAILED_LOCK					0x05050100
 #define NPI_LNX_ERROR_I2C_POLL_THREAD_FAILED_UNLOCK					0x05050200
+#define NPI_LNX_ERROR_I2C_POLL_THREAD_NO_BUFFER						0x05050300
 #define NPI_LNX_ERROR_I2C_EVENT_THREAD_OPEN_EVENT_FD				0x05060100
 #define NPI_LNX_ERROR_I2C_EVENT_THREAD_POLL_FD_FAILED				0x05060200
 #define NPI_LNX_ERROR_I2C_EVENT_THREAD_FAILED_POLL					0x05070100
 #define NPI_LNX_ERROR_I2C_EVENT_THREAD_FAILED_LOCK					0x05070200
 #define NPI_LNX_ERROR_I2C_INT_THREAD_FAILED_POLL					0x05080100
 #define NPI_LNX_ERROR_I2C_POLL_LOCK_VAR_ERROR						0x05090100
+#define NPI_LNX_ERROR_I2C_DISPATCH_THREAD							0x050A0100
 
 // Error codes for HAL I2C
 #define NPI_LNX_ERROR_HAL_I2C_GENERIC								0x06000100
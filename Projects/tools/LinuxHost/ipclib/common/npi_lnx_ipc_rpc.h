@@ -64,6 +64,7 @@ extern "C" {
 #define NPI_LNX_CMD_ID_RESET_DEVICE					0x05
 #define NPI_LNX_CMD_ID_DISCONNECT_DEVICE			0x06
 #define NPI_LNX_CMD_ID_CONNECT_DEVICE				0x07
+#define NPI_LNX_CMD_ID_SET_QOS_CLASS				0x08
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // Common
@@ -75,6 +76,51 @@ extern "C" {
 
 #define NPI_LNX_PARAM_NB_CONNECTIONS 		1
 #define NPI_LNX_PARAM_DEVICE_USED			2
+// Idle wake-up counter of each server thread as uint32 little endian,
+// in the order main, UART rx, UART async callback, SPI/I2C poll, SPI/I2C event,
+// SPI/I2C AREQ dispatch, UART sleep governor.
+#define NPI_LNX_PARAM_IDLE_WAKEUPS			3
+// RNP sleep governor statistics as uint32 little endian; wake count, wake
+// timeouts, sleep count, batched requests, wake latency min/avg/max in us,
+// followed by the 10 bucket wake latency histogram (UART only).
+#define NPI_LNX_PARAM_SLEEP_GOVERNOR		4
+// SREQ response cache counters as uint32 little endian; hits, misses,
+// invalidations, followed by the number of read-only SREQs answered with the
+// response of an identical SREQ from another client.
+#define NPI_LNX_PARAM_SREQ_CACHE			5
+// Scheduler statistics as uint32 little endian; for each class in priority
+// order, messages handled, average and longest queueing delay in us.
+#define NPI_LNX_PARAM_QOS					6
+// Message buffer pool statistics as uint32 little endian; pool size, buffers
+// in use, peak in use, allocations, allocations served from the heap because
+// the pool was empty.
+#define NPI_LNX_PARAM_MSG_BUFFERS			7
+// SPI/I2C AREQ dispatch queue statistics as uint32 little endian; AREQs queued,
+// AREQs dropped because the queue was full, current and peak queue depth,
+// average and longest time in us from SRDY service start to queueing, average
+// and longest time in us an AREQ waited for the dispatch thread.
+#define NPI_LNX_PARAM_AREQ_DISPATCH			8
+
+// Priority classes of NPI_LNX_CMD_ID_SET_QOS_CLASS. Messages from a class are
+// passed to the device before any from a lower class, connections within a
+// class share it fairly. Connections start in the normal class.
+#define NPI_LNX_QOS_CLASS_INTERACTIVE		0
+#define NPI_LNX_QOS_CLASS_NORMAL			1
+#define NPI_LNX_QOS_CLASS_BULK				2
+#define NPI_LNX_QOS_NUM_CLASSES				3
+
+// Protocol features. A client asks for them with a one byte payload to
+// NPI_LNX_CMD_ID_VERSION_REQ, and the server grants those it supports in a
+// fifth response byte. A server which answers with four bytes grants none.
+// Features apply from the message after the response on.
+//
+// With NPI_LNX_FEATURE_CORRELATION_ID, every SREQ the client sends carries a
+// one byte identifier right after the 3-byte header, not counted in len. The
+// SRSP carries the same identifier at the same place. Responses may come in
+// any order, and the server answers a request it fails to pass on with a
+// one byte 0xFF payload.
+#define NPI_LNX_FEATURE_CORRELATION_ID		0x01
+#define NPI_LNX_FEATURES_SUPPORTED			(NPI_LNX_FEATURE_CORRELATION_ID)
 
 #define NPI_LNX_WORKAROUND_CDC_BOOTLOADER	1
 /* ------------------------------------------------------------------------------------------------
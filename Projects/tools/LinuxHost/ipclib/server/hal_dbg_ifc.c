@@ -48,6 +48,7 @@
 #include <string.h>
 #include <getopt.h>
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <sys/ioctl.h>
 #include <linux/types.h>
 #include <sys/poll.h>
@@ -59,6 +60,7 @@
 #include  "hal_dbg_ifc_rpc.h"
 
 #include "npi_lnx_error.h"
+#include "npi_lnx_serial_configuration.h"
 #include "tiLogging.h"
 
 #ifdef __STRESS_TEST__
@@ -219,6 +221,9 @@ static struct
 
 static uint8 *flashBuffer = NULL;
 
+// Directory flash dumps are written to, empty if dumping to files is disabled
+static char halDbgDumpDir[DEBUG_FLASH_DUMP_PATH_MAX_LEN + 1] = "";
+
 /**************************************************************************************************
  *                                          FUNCTIONS - API
  **************************************************************************************************/
@@ -241,6 +246,9 @@ uint8 Hal_configure_buffer(uint32 bufferSize, uint32 startAddress);
 
 int Hal_program_bufferReq(void);
 int Hal_read_from_chip_to_bufferReq(void);
+int Hal_dump_flashReq(uint32 startAddress, uint32 size, const char *path);
+static uint8 Hal_dump_flashPath(const char *name, int len, char *path);
+static void Hal_dump_flashCnf(uint8 status, uint32 bytesDumped);
 
 int Hal_chip_erase(void);
 int Hal_write_flash_memory_block(uint8 *src, uint32 start_addr, uint16 num_bytes);
@@ -372,6 +380,33 @@ int Hal_DebugInterface_AsynchMsgCback( npiMsgData_t *pMsg )
 		case DEBUG_CMD_ID_READ_FROM_CHIP_TO_BUFFER_REQ:
 			ret = Hal_read_from_chip_to_bufferReq();
 			break;
+		case DEBUG_CMD_ID_DUMP_FLASH_REQ:
+		{
+			// Optional file name follows start address and size
+			char path[DEBUG_FLASH_DUMP_PATH_MAX_LEN + 1] = "";
+			uint32 startAddress, size;
+			uint8 status = DEBUG_FLASH_PROGRAM_SUCCESS;
+			if (pMsg->len < (2 * sizeof(uint32)))
+			{
+				LOG_ERROR("[DEBUG INTERFACE] Flash dump request too short (%d bytes)\n", pMsg->len);
+				status = DEBUG_FLASH_INVALID_RANGE;
+			}
+			else if (pMsg->len > (2 * sizeof(uint32)))
+			{
+				status = Hal_dump_flashPath((const char *)&pMsg->pData[8], pMsg->len - 8, path);
+			}
+
+			if (status != DEBUG_FLASH_PROGRAM_SUCCESS)
+			{
+				// Not a debug interface failure; the confirmation is enough for the client
+				Hal_dump_flashCnf(status, 0);
+				break;
+			}
+			memcpy(&startAddress, &pMsg->pData[0], sizeof(uint32));
+			memcpy(&size, &pMsg->pData[4], sizeof(uint32));
+			ret = Hal_dump_flashReq(startAddress, size, path);
+			break;
+		}
 		default:
 			npi_ipc_errno = NPI_LNX_ERROR_HAL_DBG_IFC_ASYNCH_INVALID_CMDID;
 			ret = NPI_LNX_FAILURE;
@@ -381,6 +416,51 @@ int Hal_DebugInterface_AsynchMsgCback( npiMsgData_t *pMsg )
 	return ret;
 }
 
+/**************************************************************************************************
+ *
+ * @fn          Hal_DebugInterface_ReadConfiguration
+ *
+ * @brief       Reads the optional [DEBUG] dumpDir key, the directory flash dumps
+ *              requested with a file name are written to.
+ *
+ * input parameters
+ *
+ * @param       serialCfgFd	- open configuration file
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      NPI_LNX_SUCCESS
+ **************************************************************************************************
+ */
+int Hal_DebugInterface_ReadConfiguration(FILE *serialCfgFd)
+{
+	char strBuf[128];
+	size_t len;
+
+	if (NPI_LNX_SUCCESS == SerialConfigParser(serialCfgFd, "DEBUG", "dumpDir", strBuf))
+	{
+		// Keep room for the file name, and drop a trailing separator
+		len = strnlen(strBuf, sizeof(strBuf));
+		while ((len > 1) && (strBuf[len - 1] == '/'))
+		{
+			strBuf[--len] = 0;
+		}
+		if ((strBuf[0] != '/') || (len >= (DEBUG_FLASH_DUMP_PATH_MAX_LEN / 2)))
+		{
+			LOG_WARN("[DEBUG] Ignoring dumpDir %s, must be an absolute path\n", strBuf);
+		}
+		else
+		{
+			memcpy(halDbgDumpDir, strBuf, len + 1);
+			LOG_INFO("[DEBUG] Flash dumps written to %s\n", halDbgDumpDir);
+		}
+	}
+
+	return NPI_LNX_SUCCESS;
+}
+
 /**************************************************************************//**
 * @brief    Resets the DUP into debug mode. Function assumes that
 *           the programmer I/O has already been configured using e.g.
@@ -1105,6 +1185,246 @@ int Hal_read_from_chip_to_bufferReq()
 	return ret;
 }
 
+/****************************************************************************
+* @brief    Dumps a range of flash, bypassing the flash programmer buffer.
+* 			Flash is read in bursts of DEBUG_FLASH_DUMP_BURST_SIZE bytes and
+* 			either written to a file on the server, or streamed to the
+* 			clients as DEBUG_CMD_ID_DUMP_FLASH_DATA_IND. Progress is reported
+* 			after each burst, and completion with DEBUG_CMD_ID_DUMP_FLASH_CNF.
+*
+* @param    startAddress	flash address to start from
+* @param    size			number of bytes to dump
+* @param    path			file to write to, or empty string to stream
+*
+* @return   STATUS.
+******************************************************************************/
+int Hal_dump_flashReq(uint32 startAddress, uint32 size, const char *path)
+{
+	int ret = NPI_LNX_SUCCESS;
+	int fd = -1;
+	uint8 burst[DEBUG_FLASH_DUMP_BURST_SIZE];
+	uint32 address = startAddress;
+	uint32 bytesDumped = 0;
+	uint32 flashSize = 0;
+	uint8 chipId = 0;
+
+	uint8 status = DEBUG_FLASH_PROGRAM_SUCCESS;
+
+	ret = Hal_read_chip_id(&chipId);
+	if (ret == NPI_LNX_SUCCESS)
+	{
+		ret = Hal_read_flash_size(&chipId, &flashSize);
+	}
+
+	if (ret != NPI_LNX_SUCCESS)
+	{
+		status = DEBUG_FLASH_FAILED_TO_READ_FLASH_SIZE;
+	}
+	else if ((size == 0) || (startAddress >= flashSize) || (size > (flashSize - startAddress)))
+	{
+		LOG_ERROR("[DEBUG INTERFACE] Invalid dump range @0x%.6X, %u bytes (flash size %u)\n",
+				startAddress, size, flashSize);
+		status = DEBUG_FLASH_INVALID_RANGE;
+		ret = NPI_LNX_FAILURE;
+	}
+	else if ((path != NULL) && (*path != 0))
+	{
+		fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, S_IRUSR | S_IWUSR);
+		if (fd < 0)
+		{
+			LOG_ERROR("[DEBUG INTERFACE] Could not open %s for flash dump\n", path);
+			perror("open");
+			status = DEBUG_FLASH_FAILED_TO_WRITE_FILE;
+			ret = NPI_LNX_FAILURE;
+		}
+	}
+
+	if (ret == NPI_LNX_SUCCESS)
+	{
+		LOG_INFO("[DEBUG INTERFACE] Dumping %u bytes from @0x%.6X to %s\n",
+				size, startAddress, (fd >= 0) ? path : "clients");
+	}
+
+	while ((ret == NPI_LNX_SUCCESS) && (bytesDumped < size))
+	{
+		// Flash banks are always mapped in the upper 32K of XDATA
+		uint8 bank = (uint8)(address / DEBUG_FLASH_DUMP_BANK_SIZE);
+		uint16 xdataAddress = (uint16)(0x8000 | (address % DEBUG_FLASH_DUMP_BANK_SIZE));
+		uint32 bankLeft = DEBUG_FLASH_DUMP_BANK_SIZE - (address % DEBUG_FLASH_DUMP_BANK_SIZE);
+		uint32 burstSize = size - bytesDumped;
+
+		// A burst never crosses a bank boundary
+		burstSize = MIN(burstSize, DEBUG_FLASH_DUMP_BURST_SIZE);
+		burstSize = MIN(burstSize, bankLeft);
+
+		ret = Hal_read_flash_memory_block(bank, xdataAddress, (uint16)burstSize, burst);
+		if (ret != NPI_LNX_SUCCESS)
+		{
+			LOG_ERROR("[DEBUG INTERFACE] Failed to read flash @0x%.6X\n", address);
+			status = DEBUG_FLASH_FAILED_TO_READ_FLASH;
+			break;
+		}
+
+		if (fd >= 0)
+		{
+			uint32 written = 0;
+			while (written < burstSize)
+			{
+				ssize_t n = write(fd, &burst[written], burstSize - written);
+				if (n <= 0)
+				{
+					perror("write");
+					status = DEBUG_FLASH_FAILED_TO_WRITE_FILE;
+					ret = NPI_LNX_FAILURE;
+					break;
+				}
+				written += n;
+			}
+		}
+		else
+		{
+			npiMsgData_t dataInd;
+			uint32 offset;
+			dataInd.subSys = RPC_SYS_DEBUG | RPC_CMD_AREQ;
+			dataInd.cmdId = DEBUG_CMD_ID_DUMP_FLASH_DATA_IND;
+			for (offset = 0; offset < burstSize; offset += DEBUG_FLASH_DUMP_NPI_BLOCK_SIZE)
+			{
+				uint32 blockAddress = address + offset;
+				uint32 blockSize = burstSize - offset;
+				blockSize = MIN(blockSize, DEBUG_FLASH_DUMP_NPI_BLOCK_SIZE);
+				memcpy(dataInd.pData, &blockAddress, sizeof(uint32));
+				memcpy(&dataInd.pData[sizeof(uint32)], &burst[offset], blockSize);
+				dataInd.len = sizeof(uint32) + blockSize;
+				NPI_AsynchMsgCback(&dataInd);
+			}
+		}
+
+		if (ret == NPI_LNX_SUCCESS)
+		{
+			npiMsgData_t progressInd;
+			address += burstSize;
+			bytesDumped += burstSize;
+
+			progressInd.len = 2 * sizeof(uint32);
+			progressInd.subSys = RPC_SYS_DEBUG | RPC_CMD_AREQ;
+			progressInd.cmdId = DEBUG_CMD_ID_DUMP_FLASH_PROGRESS_IND;
+			memcpy(progressInd.pData, &bytesDumped, sizeof(uint32));
+			memcpy(&progressInd.pData[sizeof(uint32)], &size, sizeof(uint32));
+			NPI_AsynchMsgCback(&progressInd);
+
+			LOG_DEBUG("[DEBUG INTERFACE] Dumped %u of %u bytes (%u%%)\n",
+					bytesDumped, size, (bytesDumped * 100) / size);
+		}
+	}
+
+	if (fd >= 0)
+	{
+		if ((fsync(fd) != 0) && (ret == NPI_LNX_SUCCESS))
+		{
+			perror("fsync");
+			status = DEBUG_FLASH_FAILED_TO_WRITE_FILE;
+			ret = NPI_LNX_FAILURE;
+		}
+		close(fd);
+	}
+
+	LOG_INFO("[DEBUG INTERFACE] Flash dump done, %u of %u bytes, status 0x%.2X\n",
+			bytesDumped, size, status);
+
+	// Send the asynchronous response back
+	Hal_dump_flashCnf(status, bytesDumped);
+
+	if ((status == DEBUG_FLASH_INVALID_RANGE) || (status == DEBUG_FLASH_FAILED_TO_WRITE_FILE))
+	{
+		// Not a debug interface failure; the confirmation is enough for the client
+		ret = NPI_LNX_SUCCESS;
+	}
+
+	return ret;
+}
+
+/****************************************************************************
+* @brief    Resolves the file name of a flash dump request. Files are only
+* 			written inside the configured [DEBUG] dumpDir; absolute names
+* 			and names with ".." components are rejected.
+*
+* @param    name			file name from the request
+* @param    len				number of bytes available at name
+* @param    path			resolved path, DEBUG_FLASH_DUMP_PATH_MAX_LEN + 1 bytes,
+* 							empty string to stream to the clients
+*
+* @return   DEBUG_FLASH_PROGRAM_SUCCESS or DEBUG_FLASH_INVALID_PATH.
+******************************************************************************/
+static uint8 Hal_dump_flashPath(const char *name, int len, char *path)
+{
+	const char *component;
+	int written;
+
+	path[0] = 0;
+	if (memchr(name, 0, len) == NULL)
+	{
+		LOG_ERROR("[DEBUG INTERFACE] Flash dump file name not terminated\n");
+		return DEBUG_FLASH_INVALID_PATH;
+	}
+	if (name[0] == 0)
+	{
+		// Stream to the clients
+		return DEBUG_FLASH_PROGRAM_SUCCESS;
+	}
+	if (halDbgDumpDir[0] == 0)
+	{
+		LOG_ERROR("[DEBUG INTERFACE] No [DEBUG] dumpDir configured, cannot write %s\n", name);
+		return DEBUG_FLASH_INVALID_PATH;
+	}
+	if (name[0] == '/')
+	{
+		LOG_ERROR("[DEBUG INTERFACE] Flash dump file name %s must be relative\n", name);
+		return DEBUG_FLASH_INVALID_PATH;
+	}
+	for (component = name; *component != 0; )
+	{
+		size_t componentLen = strcspn(component, "/");
+		if ((componentLen == 2) && (component[0] == '.') && (component[1] == '.'))
+		{
+			LOG_ERROR("[DEBUG INTERFACE] Flash dump file name %s leaves dumpDir\n", name);
+			return DEBUG_FLASH_INVALID_PATH;
+		}
+		component += componentLen;
+		if (*component == '/')
+		{
+			component++;
+		}
+	}
+
+	written = snprintf(path, DEBUG_FLASH_DUMP_PATH_MAX_LEN + 1, "%s/%s", halDbgDumpDir, name);
+	if ((written < 0) || (written > DEBUG_FLASH_DUMP_PATH_MAX_LEN))
+	{
+		LOG_ERROR("[DEBUG INTERFACE] Flash dump path too long for %s\n", name);
+		path[0] = 0;
+		return DEBUG_FLASH_INVALID_PATH;
+	}
+	return DEBUG_FLASH_PROGRAM_SUCCESS;
+}
+
+/****************************************************************************
+* @brief    Sends DEBUG_CMD_ID_DUMP_FLASH_CNF to the clients.
+*
+* @param    status			DEBUG_FLASH_xxx status
+* @param    bytesDumped		number of bytes dumped
+*
+* @return   None.
+******************************************************************************/
+static void Hal_dump_flashCnf(uint8 status, uint32 bytesDumped)
+{
+	npiMsgData_t pMsg;
+	pMsg.len = 1 + sizeof(uint32);
+	pMsg.subSys = RPC_SYS_DEBUG | RPC_CMD_AREQ;
+	pMsg.cmdId = DEBUG_CMD_ID_DUMP_FLASH_CNF;
+	pMsg.pData[0] = status;
+	memcpy(&pMsg.pData[1], &bytesDumped, sizeof(uint32));
+	NPI_AsynchMsgCback(&pMsg);
+}
+
 /****************************************************************************
 * @brief    Writes a block of data to the flash programmer buffer.
 *
@@ -107,6 +107,7 @@ void HalGpioDDClose( void );
 void HalGpioDCClose( void );
 int Hal_DebugInterface_SynchMsgCback( npiMsgData_t *pMsg );
 int Hal_DebugInterface_AsynchMsgCback( npiMsgData_t *pMsg );
+int Hal_DebugInterface_ReadConfiguration(FILE *serialCfgFd);
 int Hal_EnterDebugModeReq(void);
 int halGpioDDSetDirection(uint8 direction);
 
@@ -0,0 +1,444 @@
+/**************************************************************************************************
+  Filename:       npi_lnx_dispatch.c
+  Revised:        $Date: 2016-05-12 10:12:31 -0700 (Thu, 12 May 2016) $
+  Revision:       $Revision: 1 $
+
+  Description:    This file contains the queue which hands asynchronous messages
+                  read by the SPI and I2C poll threads over to a dispatch thread,
+                  so that the bus is served again without waiting for the clients.
+
+
+  Copyright (C) {2016} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**************************************************************************************************/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "npi_lnx.h"
+#include "npi_lnx_dispatch.h"
+#include "npi_lnx_msgbuf.h"
+#include "npi_lnx_sched.h"
+#include "npi_lnx_serial_configuration.h"
+#include "npi_lnx_error.h"
+#include "tiLogging.h"
+
+// -- Typedefs --
+
+typedef struct
+{
+	npiMsgBuf_t *pBuf;
+	struct timespec queuedAt;
+} npiDispatchEntry_t;
+
+typedef struct
+{
+	unsigned long long totalUs;
+	uint32 maxUs;
+} npiDispatchTime_t;
+
+// -- Local Variables --
+
+static int npiDispatchQueueDepth = NPI_LNX_DISPATCH_QUEUE_DEPTH_DEFAULT;
+
+// Ring buffer written by the poll thread and read by the dispatch thread
+static pthread_mutex_t npiDispatchLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t npiDispatchCond = PTHREAD_COND_INITIALIZER;
+static npiDispatchEntry_t *npiDispatchQueue = NULL;
+static int npiDispatchHead = 0;		// next entry to dispatch
+static int npiDispatchCount = 0;
+static uint8 npiDispatchTerminate = FALSE;
+
+static pthread_t npiDispatchThread;
+static uint16 npiDispatchErrorSource = 0;
+
+static uint32 npiDispatchQueued = 0;
+static uint32 npiDispatchDropped = 0;
+static uint32 npiDispatchPeakDepth = 0;
+static npiDispatchTime_t npiDispatchService;
+static npiDispatchTime_t npiDispatchDelay;
+
+// -- Forward references of local functions --
+
+static void *npiDispatchEntry(void *ptr);
+static void npiDispatchAddTime(npiDispatchTime_t *pTime, const struct timespec *pFrom,
+		const struct timespec *pTo);
+
+// -- Public functions --
+
+/******************************************************************************
+ * @fn         NPI_LNX_DispatchReadConfiguration
+ *
+ * @brief      This function reads the optional [DISPATCH] section of the
+ *             configuration file.
+ *
+ * input parameters
+ *
+ * @param      serialCfgFd	- open configuration file
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     NPI_LNX_SUCCESS
+ ******************************************************************************
+ */
+int NPI_LNX_DispatchReadConfiguration(FILE *serialCfgFd)
+{
+	char strBuf[128];
+	long value;
+
+	if (NPI_LNX_SUCCESS == SerialConfigParser(serialCfgFd, "DISPATCH", "queueDepth", strBuf))
+	{
+		value = strtol(strBuf, NULL, 0);
+		if ((value < 1) || (value > NPI_LNX_DISPATCH_QUEUE_DEPTH_MAX))
+		{
+			LOG_WARN("[DISPATCH] Ignoring queueDepth %ld, must be 1..%d\n", value, NPI_LNX_DISPATCH_QUEUE_DEPTH_MAX);
+		}
+		else
+		{
+			npiDispatchQueueDepth = (int)value;
+			LOG_INFO("[DISPATCH] Queue depth %d\n", npiDispatchQueueDepth);
+		}
+	}
+
+	return NPI_LNX_SUCCESS;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_DispatchOpen
+ *
+ * @brief      Create the queue and start the thread which passes queued
+ *             messages to NPI_AsynchMsgCback().
+ *
+ * input parameters
+ *
+ * @param      errorSource	- module/thread reported through
+ *                              NPI_LNX_IPC_NotifyError() when the thread
+ *                              exits
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     NPI_LNX_SUCCESS or NPI_LNX_FAILURE
+ ******************************************************************************
+ */
+int NPI_LNX_DispatchOpen(uint16 errorSource)
+{
+	npiDispatchEntry_t *pQueue;
+
+	pQueue = calloc(npiDispatchQueueDepth, sizeof(npiDispatchEntry_t));
+	if (pQueue == NULL)
+	{
+		LOG_ERROR("[DISPATCH] Failed to allocate a queue of %d messages\n", npiDispatchQueueDepth);
+		return NPI_LNX_FAILURE;
+	}
+
+	pthread_mutex_lock(&npiDispatchLock);
+	npiDispatchQueue = pQueue;
+	npiDispatchHead = 0;
+	npiDispatchCount = 0;
+	npiDispatchTerminate = FALSE;
+	npiDispatchErrorSource = errorSource;
+	pthread_mutex_unlock(&npiDispatchLock);
+
+	// Priority and CPU affinity come from the [REALTIME] profile if configured
+	if (NPI_LNX_SchedCreateThread(&npiDispatchThread, NPI_LNX_SCHED_THREAD_DISPATCH, npiDispatchEntry, NULL))
+	{
+		pthread_mutex_lock(&npiDispatchLock);
+		npiDispatchQueue = NULL;
+		pthread_mutex_unlock(&npiDispatchLock);
+		free(pQueue);
+		return NPI_LNX_FAILURE;
+	}
+
+	return NPI_LNX_SUCCESS;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_DispatchClose
+ *
+ * @brief      Stop the dispatch thread and drop the messages still queued.
+ *             Does nothing if the queue is not open.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+void NPI_LNX_DispatchClose(void)
+{
+	npiDispatchEntry_t *pQueue;
+
+	pthread_mutex_lock(&npiDispatchLock);
+	pQueue = npiDispatchQueue;
+	if (pQueue == NULL)
+	{
+		pthread_mutex_unlock(&npiDispatchLock);
+		return;
+	}
+	npiDispatchTerminate = TRUE;
+	pthread_cond_signal(&npiDispatchCond);
+	pthread_mutex_unlock(&npiDispatchLock);
+
+	// wait till the thread terminates
+	pthread_join(npiDispatchThread, NULL);
+
+	pthread_mutex_lock(&npiDispatchLock);
+	while (npiDispatchCount > 0)
+	{
+		NPI_LNX_MsgBufRelease(pQueue[npiDispatchHead].pBuf);
+		npiDispatchHead = (npiDispatchHead + 1) % npiDispatchQueueDepth;
+		npiDispatchCount--;
+	}
+	npiDispatchQueue = NULL;
+	pthread_mutex_unlock(&npiDispatchLock);
+
+	free(pQueue);
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_DispatchPost
+ *
+ * @brief      Queue an asynchronous message for the dispatch thread. Never
+ *             blocks on the clients; when the queue is full the message is
+ *             dropped and counted.
+ *
+ * input parameters
+ *
+ * @param      pBuf			- message, taken over from the caller
+ * @param      pServiceStart	- CLOCK_MONOTONIC time the device started to be
+ *                              served for this message
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     NPI_LNX_SUCCESS, NPI_LNX_FAILURE if the message was dropped.
+ ******************************************************************************
+ */
+int NPI_LNX_DispatchPost(npiMsgBuf_t *pBuf, const struct timespec *pServiceStart)
+{
+	npiDispatchEntry_t *pEntry;
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	pthread_mutex_lock(&npiDispatchLock);
+	npiDispatchAddTime(&npiDispatchService, pServiceStart, &now);
+	if ((npiDispatchQueue == NULL) || (npiDispatchCount == npiDispatchQueueDepth))
+	{
+		npiDispatchDropped++;
+		pthread_mutex_unlock(&npiDispatchLock);
+
+		LOG_WARN("[DISPATCH] Queue full, dropped AREQ subsys 0x%.2X cmd 0x%.2X\n",
+				pBuf->msg.subSys, pBuf->msg.cmdId);
+		NPI_LNX_MsgBufRelease(pBuf);
+		return NPI_LNX_FAILURE;
+	}
+
+	pEntry = &npiDispatchQueue[(npiDispatchHead + npiDispatchCount) % npiDispatchQueueDepth];
+	pEntry->pBuf = pBuf;
+	pEntry->queuedAt = now;
+	npiDispatchCount++;
+	npiDispatchQueued++;
+	if ((uint32)npiDispatchCount > npiDispatchPeakDepth)
+	{
+		npiDispatchPeakDepth = npiDispatchCount;
+	}
+
+	/* wake up the dispatch thread */
+	pthread_cond_signal(&npiDispatchCond);
+	pthread_mutex_unlock(&npiDispatchLock);
+
+	return NPI_LNX_SUCCESS;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_DispatchGetStats
+ *
+ * @brief      Read the queue statistics.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * @param      pQueued		- messages queued
+ * @param      pDropped		- messages dropped, queue full
+ * @param      pDepth			- messages currently queued
+ * @param      pPeakDepth		- highest pDepth seen
+ * @param      pServiceAvgUs	- average time from start of device service to queueing
+ * @param      pServiceMaxUs	- longest such time
+ * @param      pDelayAvgUs	- average time a message waited in the queue
+ * @param      pDelayMaxUs	- longest such time
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+void NPI_LNX_DispatchGetStats(uint32 *pQueued, uint32 *pDropped, uint32 *pDepth,
+		uint32 *pPeakDepth, uint32 *pServiceAvgUs, uint32 *pServiceMaxUs,
+		uint32 *pDelayAvgUs, uint32 *pDelayMaxUs)
+{
+	uint32 serviced;
+
+	pthread_mutex_lock(&npiDispatchLock);
+	*pQueued = npiDispatchQueued;
+	*pDropped = npiDispatchDropped;
+	*pDepth = npiDispatchCount;
+	*pPeakDepth = npiDispatchPeakDepth;
+	serviced = npiDispatchQueued + npiDispatchDropped;
+	*pServiceAvgUs = (serviced > 0) ? (uint32)(npiDispatchService.totalUs / serviced) : 0;
+	*pServiceMaxUs = npiDispatchService.maxUs;
+	// Delays are recorded as messages leave the queue
+	serviced = npiDispatchQueued - npiDispatchCount;
+	*pDelayAvgUs = (serviced > 0) ? (uint32)(npiDispatchDelay.totalUs / serviced) : 0;
+	*pDelayMaxUs = npiDispatchDelay.maxUs;
+	pthread_mutex_unlock(&npiDispatchLock);
+}
+
+// -- Local functions --
+
+/******************************************************************************
+ * @fn         npiDispatchEntry
+ *
+ * @brief      Dispatch thread entry function. Passes queued messages to
+ *             NPI_AsynchMsgCback() in the order they were read.
+ *
+ * input parameters
+ *
+ * @param      ptr		- unused
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     NULL
+ ******************************************************************************
+ */
+static void *npiDispatchEntry(void *ptr)
+{
+	npiDispatchEntry_t entry;
+	struct timespec now;
+	int ret = NPI_LNX_SUCCESS;
+	char *errorMsg;
+
+	((void)ptr);
+	pthread_mutex_lock(&npiDispatchLock);
+	while (!npiDispatchTerminate)
+	{
+		if (npiDispatchCount == 0)
+		{
+			// wait for signal
+			pthread_cond_wait(&npiDispatchCond, &npiDispatchLock);
+			if ((npiDispatchCount == 0) && !npiDispatchTerminate)
+			{
+				NPI_LNX_SchedIdleWakeup(NPI_LNX_SCHED_THREAD_DISPATCH);
+			}
+			continue;
+		}
+
+		entry = npiDispatchQueue[npiDispatchHead];
+		npiDispatchHead = (npiDispatchHead + 1) % npiDispatchQueueDepth;
+		npiDispatchCount--;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		npiDispatchAddTime(&npiDispatchDelay, &entry.queuedAt, &now);
+
+		// unlock mutex so that the poll thread can keep queueing while the
+		// clients are served
+		pthread_mutex_unlock(&npiDispatchLock);
+
+		ret = NPI_AsynchMsgCback(&entry.pBuf->msg);
+		NPI_LNX_MsgBufRelease(entry.pBuf);
+
+		pthread_mutex_lock(&npiDispatchLock);
+		if (ret != NPI_LNX_SUCCESS)
+		{
+			npiDispatchTerminate = TRUE;
+		}
+	}
+	pthread_mutex_unlock(&npiDispatchLock);
+
+	if (ret == NPI_LNX_FAILURE)
+		errorMsg = "AREQ dispatch thread exited with error. Please check global error message\n";
+	else
+		errorMsg = "AREQ dispatch thread exited without error\n";
+
+	NPI_LNX_IPC_NotifyError(npiDispatchErrorSource, errorMsg);
+
+	return NULL;
+}
+
+/******************************************************************************
+ * @fn         npiDispatchAddTime
+ *
+ * @brief      Account one interval in a time statistic.
+ *
+ * input parameters
+ *
+ * @param      pTime	- statistic to update
+ * @param      pFrom	- start of the interval
+ * @param      pTo		- end of the interval
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+static void npiDispatchAddTime(npiDispatchTime_t *pTime, const struct timespec *pFrom,
+		const struct timespec *pTo)
+{
+	long long us;
+
+	us = ((long long)(pTo->tv_sec - pFrom->tv_sec) * 1000000LL) +
+			((pTo->tv_nsec - pFrom->tv_nsec) / 1000);
+	if (us < 0)
+	{
+		us = 0;
+	}
+	pTime->totalUs += us;
+	if (us > pTime->maxUs)
+	{
+		pTime->maxUs = (uint32)us;
+	}
+}
@@ -0,0 +1,177 @@
+/**************************************************************************************************
+  Filename:       npi_lnx_dispatch.h
+  Revised:        $Date: 2016-05-12 10:12:31 -0700 (Thu, 12 May 2016) $
+  Revision:       $Revision: 1 $
+
+  Description:    This file defines the queue which hands asynchronous messages
+                  read by the SPI and I2C poll threads over to a dispatch thread.
+
+
+  Copyright (C) {2016} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**************************************************************************************************/
+#ifndef NPI_DISPATCH_LNX_H
+#define NPI_DISPATCH_LNX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <time.h>
+
+#include "hal_types.h"
+#include "npi_lnx_msgbuf.h"
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Constants
+
+  // Messages waiting for the dispatch thread when the configuration does not
+  // say otherwise
+#define NPI_LNX_DISPATCH_QUEUE_DEPTH_DEFAULT	64
+#define NPI_LNX_DISPATCH_QUEUE_DEPTH_MAX		1024
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Interface function prototypes
+
+  /******************************************************************************
+   * @fn         NPI_LNX_DispatchReadConfiguration
+   *
+   * @brief      This function reads the optional [DISPATCH] section of the
+   *             configuration file.
+   *
+   * input parameters
+   *
+   * @param      serialCfgFd	- open configuration file
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     NPI_LNX_SUCCESS
+   ******************************************************************************
+   */
+  extern int NPI_LNX_DispatchReadConfiguration(FILE *serialCfgFd);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_DispatchOpen
+   *
+   * @brief      Create the queue and start the thread which passes queued
+   *             messages to NPI_AsynchMsgCback().
+   *
+   * input parameters
+   *
+   * @param      errorSource	- module/thread reported through
+   *                              NPI_LNX_IPC_NotifyError() when the thread
+   *                              exits
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     NPI_LNX_SUCCESS or NPI_LNX_FAILURE
+   ******************************************************************************
+   */
+  extern int NPI_LNX_DispatchOpen(uint16 errorSource);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_DispatchClose
+   *
+   * @brief      Stop the dispatch thread and drop the messages still queued.
+   *             Does nothing if the queue is not open.
+   *
+   * input parameters
+   *
+   * None.
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     None.
+   ******************************************************************************
+   */
+  extern void NPI_LNX_DispatchClose(void);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_DispatchPost
+   *
+   * @brief      Queue an asynchronous message for the dispatch thread. Never
+   *             blocks on the clients; when the queue is full the message is
+   *             dropped and counted.
+   *
+   * input parameters
+   *
+   * @param      pBuf			- message, taken over from the caller
+   * @param      pServiceStart	- CLOCK_MONOTONIC time the device started to be
+   *                              served for this message
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     NPI_LNX_SUCCESS, NPI_LNX_FAILURE if the message was dropped.
+   ******************************************************************************
+   */
+  extern int NPI_LNX_DispatchPost(npiMsgBuf_t *pBuf, const struct timespec *pServiceStart);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_DispatchGetStats
+   *
+   * @brief      Read the queue statistics.
+   *
+   * input parameters
+   *
+   * None.
+   *
+   * output parameters
+   *
+   * @param      pQueued		- messages queued
+   * @param      pDropped		- messages dropped, queue full
+   * @param      pDepth			- messages currently queued
+   * @param      pPeakDepth		- highest pDepth seen
+   * @param      pServiceAvgUs	- average time from start of device service to queueing
+   * @param      pServiceMaxUs	- longest such time
+   * @param      pDelayAvgUs	- average time a message waited in the queue
+   * @param      pDelayMaxUs	- longest such time
+   *
+   * @return     None.
+   ******************************************************************************
+   */
+  extern void NPI_LNX_DispatchGetStats(uint32 *pQueued, uint32 *pDropped, uint32 *pDepth,
+		  uint32 *pPeakDepth, uint32 *pServiceAvgUs, uint32 *pServiceMaxUs,
+		  uint32 *pDelayAvgUs, uint32 *pDelayMaxUs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NPI_DISPATCH_LNX_H
@@ -0,0 +1,599 @@
+/**************************************************************************************************
+  Filename:       npi_lnx_errlog.c
+  Revised:        $Date: 2016-05-12 10:12:31 -0700 (Thu, 12 May 2016) $
+  Revision:       $Revision: 1 $
+
+  Description:    This file contains the NPI server error log, which keeps the
+                  log file open and writes it from a background thread.
+
+
+  Copyright (C) {2016} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**************************************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "npi_lnx.h"
+#include "npi_lnx_errlog.h"
+#include "npi_lnx_serial_configuration.h"
+#include "npi_lnx_error.h"
+#include "tiLogging.h"
+
+// -- Constants --
+
+// Longest message, including time stamp and error code
+#define NPI_ERRLOG_LINE_MAX				256
+
+// Messages queued while the writer is busy, a burst beyond that is dropped
+#define NPI_ERRLOG_BUF_SIZE				16384
+
+// Longest wait of NPI_LNX_ErrLogFlush()
+#define NPI_ERRLOG_FLUSH_TIMEOUT		2
+
+// -- Local Variables --
+
+static char npiErrLogPath[512];
+static int npiErrLogFd = -1;
+static off_t npiErrLogSize = 0;
+
+// Rotation, disabled by default
+static long npiErrLogMaxSize = 0;
+static int npiErrLogMaxFiles = 0;
+
+// Messages are appended to the active buffer, while the writer writes the other one
+static char npiErrLogBuf[2][NPI_ERRLOG_BUF_SIZE];
+static int npiErrLogBufLen = 0;
+static int npiErrLogActive = 0;
+static uint32 npiErrLogQueued = 0;
+static uint32 npiErrLogWritten = 0;
+static uint32 npiErrLogDropped = 0;
+
+static uint8 npiErrLogRunning = FALSE;
+static uint8 npiErrLogStop = FALSE;
+static pthread_t npiErrLogThread;
+static pthread_mutex_t npiErrLogMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t npiErrLogCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t npiErrLogWrittenCond = PTHREAD_COND_INITIALIZER;
+
+// Time stamp of the current second
+static time_t npiErrLogStampSec = (time_t)-1;
+static char npiErrLogStamp[40];
+
+// -- Forward references of local functions --
+
+static int npiErrLogFormat(char *buf, const char *str, int errorCode);
+static void npiErrLogWriteFd(const char *buf, int len);
+static void npiErrLogReopen(void);
+static void npiErrLogRotate(void);
+static void *npiErrLogWriter(void *ptr);
+
+// -- Public functions --
+
+/******************************************************************************
+ * @fn         NPI_LNX_ErrLogReadConfiguration
+ *
+ * @brief      This function reads the optional rotation keys of the [LOG]
+ *             section of the configuration file.
+ *
+ * input parameters
+ *
+ * @param      serialCfgFd	- open configuration file
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     NPI_LNX_SUCCESS
+ ******************************************************************************
+ */
+int NPI_LNX_ErrLogReadConfiguration(FILE *serialCfgFd)
+{
+	char strBuf[128];
+
+	if (NPI_LNX_SUCCESS == SerialConfigParser(serialCfgFd, "LOG", "maxSize", strBuf))
+	{
+		npiErrLogMaxSize = strtol(strBuf, NULL, 0);
+		if (npiErrLogMaxSize < 0)
+		{
+			npiErrLogMaxSize = 0;
+		}
+	}
+	if (NPI_LNX_SUCCESS == SerialConfigParser(serialCfgFd, "LOG", "maxFiles", strBuf))
+	{
+		npiErrLogMaxFiles = strtol(strBuf, NULL, 0);
+		if (npiErrLogMaxFiles < 0)
+		{
+			npiErrLogMaxFiles = 0;
+		}
+	}
+
+	if (npiErrLogMaxSize)
+	{
+		LOG_INFO("[ERRLOG] Rotating error log at %ld bytes, keeping %d files\n", npiErrLogMaxSize, npiErrLogMaxFiles);
+	}
+
+	return NPI_LNX_SUCCESS;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_ErrLogOpen
+ *
+ * @brief      Open the error log and start its writer thread. Until then,
+ *             and if this fails, messages are written synchronously.
+ *
+ * input parameters
+ *
+ * @param      path	- log file, empty string for stderr
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     NPI_LNX_SUCCESS, NPI_LNX_FAILURE if the file or the thread
+ *             could not be created.
+ ******************************************************************************
+ */
+int NPI_LNX_ErrLogOpen(const char *path)
+{
+	if (npiErrLogRunning)
+	{
+		return NPI_LNX_SUCCESS;
+	}
+
+	snprintf(npiErrLogPath, sizeof(npiErrLogPath), "%s", path);
+	npiErrLogReopen();
+	if (npiErrLogFd < 0)
+	{
+		return NPI_LNX_FAILURE;
+	}
+
+	npiErrLogStop = FALSE;
+	if (pthread_create(&npiErrLogThread, NULL, npiErrLogWriter, NULL))
+	{
+		LOG_ERROR("[ERRLOG] Failed to create writer thread, writing synchronously\n");
+		return NPI_LNX_FAILURE;
+	}
+	npiErrLogRunning = TRUE;
+
+	return NPI_LNX_SUCCESS;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_ErrLogWrite
+ *
+ * @brief      Queue a time stamped message with an error code for the
+ *             error log. Does not block on the file.
+ *
+ * input parameters
+ *
+ * @param      str		- message, trailing newlines are removed
+ * @param      errorCode	- error code appended to the message
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+void NPI_LNX_ErrLogWrite(const char *str, int errorCode)
+{
+	char line[NPI_ERRLOG_LINE_MAX];
+	int len;
+
+	pthread_mutex_lock(&npiErrLogMutex);
+	len = npiErrLogFormat(line, str, errorCode);
+
+	if (!npiErrLogRunning)
+	{
+		// Not open yet, or no writer thread. Before the configuration is read
+		// the path is empty, which means stderr.
+		if (npiErrLogFd < 0)
+		{
+			npiErrLogReopen();
+		}
+		npiErrLogWriteFd(line, len);
+		pthread_mutex_unlock(&npiErrLogMutex);
+		return;
+	}
+
+	if ((npiErrLogBufLen + len) > NPI_ERRLOG_BUF_SIZE)
+	{
+		npiErrLogDropped++;
+	}
+	else
+	{
+		memcpy(&npiErrLogBuf[npiErrLogActive][npiErrLogBufLen], line, len);
+		npiErrLogBufLen += len;
+		npiErrLogQueued++;
+		pthread_cond_signal(&npiErrLogCond);
+	}
+	pthread_mutex_unlock(&npiErrLogMutex);
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_ErrLogFlush
+ *
+ * @brief      Wait until every queued message is written, e.g. before
+ *             exit().
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+void NPI_LNX_ErrLogFlush(void)
+{
+	struct timespec expiryTime;
+
+	pthread_mutex_lock(&npiErrLogMutex);
+	clock_gettime(CLOCK_REALTIME, &expiryTime);
+	expiryTime.tv_sec += NPI_ERRLOG_FLUSH_TIMEOUT;
+	while (npiErrLogRunning && (npiErrLogWritten != npiErrLogQueued))
+	{
+		if (pthread_cond_timedwait(&npiErrLogWrittenCond, &npiErrLogMutex, &expiryTime) == ETIMEDOUT)
+		{
+			break;
+		}
+	}
+	pthread_mutex_unlock(&npiErrLogMutex);
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_ErrLogClose
+ *
+ * @brief      Write what is queued, stop the writer thread and close the
+ *             log file.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+void NPI_LNX_ErrLogClose(void)
+{
+	if (npiErrLogRunning)
+	{
+		pthread_mutex_lock(&npiErrLogMutex);
+		npiErrLogStop = TRUE;
+		pthread_cond_signal(&npiErrLogCond);
+		pthread_mutex_unlock(&npiErrLogMutex);
+		pthread_join(npiErrLogThread, NULL);
+		npiErrLogRunning = FALSE;
+	}
+
+	if (npiErrLogFd > STDERR_FILENO)
+	{
+		close(npiErrLogFd);
+	}
+	npiErrLogFd = -1;
+}
+
+// -- Local functions --
+
+/******************************************************************************
+ * @fn         npiErrLogFormat
+ *
+ * @brief      Format a log line, "[Www Mmm dd hh:mm:ss yyyy] message. Error: 0000000X".
+ *             The time stamp is only formatted once a second. Called with
+ *             npiErrLogMutex held.
+ *
+ * input parameters
+ *
+ * @param      str		- message
+ * @param      errorCode	- error code
+ *
+ * output parameters
+ *
+ * @param      buf		- the line, NPI_ERRLOG_LINE_MAX bytes
+ *
+ * @return     Length of the line
+ ******************************************************************************
+ */
+static int npiErrLogFormat(char *buf, const char *str, int errorCode)
+{
+	time_t timeNow = time(NULL);
+	int strLen = strlen(str), len;
+
+	if (timeNow != npiErrLogStampSec)
+	{
+		struct tm timeNowInfo;
+
+		localtime_r(&timeNow, &timeNowInfo);
+		strftime(npiErrLogStamp, sizeof(npiErrLogStamp), "%a %b %e %H:%M:%S %Y", &timeNowInfo);
+		npiErrLogStampSec = timeNow;
+	}
+
+	// Remove \n characters
+	while ((strLen > 0) && (str[strLen - 1] == '\n'))
+	{
+		strLen--;
+	}
+
+	len = snprintf(buf, NPI_ERRLOG_LINE_MAX, "[%s] %.*s. Error: %.8X\n", npiErrLogStamp, strLen, str, errorCode);
+	if (len >= NPI_ERRLOG_LINE_MAX)
+	{
+		len = NPI_ERRLOG_LINE_MAX - 1;
+		buf[len - 1] = '\n';
+	}
+	return len;
+}
+
+/******************************************************************************
+ * @fn         npiErrLogWriteFd
+ *
+ * @brief      Write to the log file, rotating it when it exceeds the
+ *             configured size. Only called from one thread at a time.
+ *
+ * input parameters
+ *
+ * @param      buf	- data
+ * @param      len	- its length
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+static void npiErrLogWriteFd(const char *buf, int len)
+{
+	int done, chunk;
+
+	if (npiErrLogFd < 0)
+	{
+		LOG_ERROR("Could not write \n%.*s\n to npiLnxLog.\n", len, buf);
+		return;
+	}
+
+	while (len > 0)
+	{
+		chunk = len;
+		if (npiErrLogMaxSize && (npiErrLogFd > STDERR_FILENO) && ((npiErrLogSize + chunk) > npiErrLogMaxSize))
+		{
+			// Write the lines that still fit, a line that fits nowhere goes alone
+			for (chunk = npiErrLogMaxSize - npiErrLogSize; (chunk > 0) && (buf[chunk - 1] != '\n'); chunk--);
+			if (chunk <= 0)
+			{
+				if (npiErrLogSize > 0)
+				{
+					npiErrLogRotate();
+					continue;
+				}
+				for (chunk = 1; (chunk < len) && (buf[chunk - 1] != '\n'); chunk++);
+			}
+		}
+
+		done = write(npiErrLogFd, buf, chunk);
+		if (done < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			LOG_ERROR("Could not write to npiLnxLog. Error: %.8X\n", errno);
+			break;
+		}
+		buf += done;
+		len -= done;
+		npiErrLogSize += done;
+
+		if (npiErrLogMaxSize && (npiErrLogFd > STDERR_FILENO) && (npiErrLogSize >= npiErrLogMaxSize))
+		{
+			npiErrLogRotate();
+		}
+	}
+}
+
+/******************************************************************************
+ * @fn         npiErrLogReopen
+ *
+ * @brief      (Re)open the log file at npiErrLogPath, stderr if it is empty.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+static void npiErrLogReopen(void)
+{
+	struct stat fileStat;
+
+	if (npiErrLogFd > STDERR_FILENO)
+	{
+		close(npiErrLogFd);
+	}
+
+	if (!*npiErrLogPath)
+	{
+		// Empty string for log path means use stderr
+		npiErrLogFd = STDERR_FILENO;
+		npiErrLogSize = 0;
+		return;
+	}
+
+	npiErrLogFd = open(npiErrLogPath, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, S_IRWXU);
+	if (npiErrLogFd < 0)
+	{
+		LOG_ERROR("Could not open npiLnxLog %s. Error: %.8X\n", npiErrLogPath, errno);
+		return;
+	}
+	npiErrLogSize = (fstat(npiErrLogFd, &fileStat) == 0) ? fileStat.st_size : 0;
+}
+
+/******************************************************************************
+ * @fn         npiErrLogRotate
+ *
+ * @brief      Rename log.N-1 to log.N, ..., log to log.1 and start a new log.
+ *             Without files to keep, the log is truncated instead.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+static void npiErrLogRotate(void)
+{
+	char from[sizeof(npiErrLogPath) + 16], to[sizeof(npiErrLogPath) + 16];
+	int i;
+
+	if (npiErrLogMaxFiles == 0)
+	{
+		if (ftruncate(npiErrLogFd, 0) == 0)
+		{
+			npiErrLogSize = 0;
+		}
+		return;
+	}
+
+	for (i = npiErrLogMaxFiles - 1; i > 0; i--)
+	{
+		snprintf(from, sizeof(from), "%s.%d", npiErrLogPath, i);
+		snprintf(to, sizeof(to), "%s.%d", npiErrLogPath, i + 1);
+		rename(from, to);
+	}
+	snprintf(to, sizeof(to), "%s.1", npiErrLogPath);
+	rename(npiErrLogPath, to);
+
+	npiErrLogReopen();
+}
+
+/******************************************************************************
+ * @fn         npiErrLogWriter
+ *
+ * @brief      Writer thread. Takes the buffer filled by NPI_LNX_ErrLogWrite()
+ *             and writes it while new messages go to the other buffer. Also
+ *             reopens the log when it was moved away, e.g. by logrotate.
+ *
+ * input parameters
+ *
+ * @param      ptr	- unused
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     NULL
+ ******************************************************************************
+ */
+static void *npiErrLogWriter(void *ptr)
+{
+	char dropNotice[NPI_ERRLOG_LINE_MAX];
+	int len, dropLen, buf;
+	uint32 queued;
+	struct stat pathStat, fdStat;
+
+	(void)ptr;
+
+	pthread_mutex_lock(&npiErrLogMutex);
+	for (;;)
+	{
+		while (!npiErrLogBufLen && !npiErrLogDropped && !npiErrLogStop)
+		{
+			pthread_cond_wait(&npiErrLogCond, &npiErrLogMutex);
+		}
+		if (!npiErrLogBufLen && !npiErrLogDropped)
+		{
+			break;
+		}
+
+		// Swap buffers
+		buf = npiErrLogActive;
+		len = npiErrLogBufLen;
+		queued = npiErrLogQueued;
+		npiErrLogActive ^= 1;
+		npiErrLogBufLen = 0;
+		dropLen = 0;
+		if (npiErrLogDropped)
+		{
+			char msg[64];
+
+			snprintf(msg, sizeof(msg), "%u messages dropped", npiErrLogDropped);
+			dropLen = npiErrLogFormat(dropNotice, msg, NPI_LNX_SUCCESS);
+			npiErrLogDropped = 0;
+		}
+		pthread_mutex_unlock(&npiErrLogMutex);
+
+		// Pick up a new file if the current one was moved away
+		if ((npiErrLogFd > STDERR_FILENO) &&
+				((stat(npiErrLogPath, &pathStat) != 0) ||
+				 ((fstat(npiErrLogFd, &fdStat) == 0) && (pathStat.st_ino != fdStat.st_ino))))
+		{
+			npiErrLogReopen();
+		}
+
+		npiErrLogWriteFd(npiErrLogBuf[buf], len);
+		if (dropLen)
+		{
+			npiErrLogWriteFd(dropNotice, dropLen);
+		}
+
+		pthread_mutex_lock(&npiErrLogMutex);
+		npiErrLogWritten = queued;
+		pthread_cond_broadcast(&npiErrLogWrittenCond);
+	}
+	pthread_mutex_unlock(&npiErrLogMutex);
+
+	return NULL;
+}
@@ -0,0 +1,156 @@
+/**************************************************************************************************
+  Filename:       npi_lnx_errlog.h
+  Revised:        $Date: 2016-05-12 10:12:31 -0700 (Thu, 12 May 2016) $
+  Revision:       $Revision: 1 $
+
+  Description:    This file defines the NPI server error log, which keeps the
+                  log file open and writes it from a background thread.
+
+
+  Copyright (C) {2016} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**************************************************************************************************/
+#ifndef NPI_ERRLOG_LNX_H
+#define NPI_ERRLOG_LNX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+
+#include "hal_types.h"
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Interface function prototypes
+
+  /******************************************************************************
+   * @fn         NPI_LNX_ErrLogReadConfiguration
+   *
+   * @brief      This function reads the optional rotation keys of the [LOG]
+   *             section of the configuration file.
+   *
+   * input parameters
+   *
+   * @param      serialCfgFd	- open configuration file
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     NPI_LNX_SUCCESS
+   ******************************************************************************
+   */
+  extern int NPI_LNX_ErrLogReadConfiguration(FILE *serialCfgFd);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_ErrLogOpen
+   *
+   * @brief      Open the error log and start its writer thread. Until then,
+   *             and if this fails, messages are written synchronously.
+   *
+   * input parameters
+   *
+   * @param      path	- log file, empty string for stderr
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     NPI_LNX_SUCCESS, NPI_LNX_FAILURE if the file or the thread
+   *             could not be created.
+   ******************************************************************************
+   */
+  extern int NPI_LNX_ErrLogOpen(const char *path);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_ErrLogWrite
+   *
+   * @brief      Queue a time stamped message with an error code for the
+   *             error log. Does not block on the file.
+   *
+   * input parameters
+   *
+   * @param      str		- message, trailing newlines are removed
+   * @param      errorCode	- error code appended to the message
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     None.
+   ******************************************************************************
+   */
+  extern void NPI_LNX_ErrLogWrite(const char *str, int errorCode);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_ErrLogFlush
+   *
+   * @brief      Wait until every queued message is written, e.g. before
+   *             exit().
+   *
+   * input parameters
+   *
+   * None.
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     None.
+   ******************************************************************************
+   */
+  extern void NPI_LNX_ErrLogFlush(void);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_ErrLogClose
+   *
+   * @brief      Write what is queued, stop the writer thread and close the
+   *             log file.
+   *
+   * input parameters
+   *
+   * None.
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     None.
+   ******************************************************************************
+   */
+  extern void NPI_LNX_ErrLogClose(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NPI_ERRLOG_LNX_H
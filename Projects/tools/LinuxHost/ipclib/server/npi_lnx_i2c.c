@@ -41,6 +41,7 @@
 
 #include <sys/time.h>
 #include <sys/types.h>
+#include <time.h>
 #include <sys/stat.h>
 #include <sys/signal.h>
 #include <fcntl.h>
@@ -62,6 +63,9 @@
 #include "aic.h"
 #include "npi_lnx.h"
 #include "npi_lnx_i2c.h"
+#include "npi_lnx_sched.h"
+#include "npi_lnx_msgbuf.h"
+#include "npi_lnx_dispatch.h"
 #include "hal_rpc.h"
 #include "hal_gpio.h"
 
@@ -124,6 +128,10 @@ static int global_srdy;
 static pthread_cond_t   npi_srdy_H2L_poll;
 
 static pthread_mutex_t  npiSrdyLock;
+#ifdef NPI_TICKLESS
+// pipe used to wake up the event thread for termination
+static int              npiEventWakePipe[2] = {-1, -1};
+#endif
 #define INIT 0
 #define READY 1
 #endif
@@ -767,23 +775,38 @@ static int npi_initThreads(void)
 	// initialize I2C receive thread related variables
 	npi_poll_terminate = 0;
 
-	// TODO: it is ideal to make this thread higher priority
-	// but linux does not allow realtime of FIFO scheduling policy for
-	// non-priviledged threads.
+	// AREQs read by the poll thread are delivered from a separate thread
+	if (NPI_LNX_DispatchOpen(NPI_LNX_ERROR_MODULE_MASK(NPI_LNX_ERROR_I2C_DISPATCH_THREAD)) != NPI_LNX_SUCCESS)
+	{
+		npi_ipc_errno = NPI_LNX_ERROR_I2C_OPEN_FAILED_DISPATCH_THREAD;
+		return NPI_LNX_FAILURE;
+	}
 
-	if(pthread_create(&npiPollThread, NULL, npi_poll_entry, NULL))
+	// Priority and CPU affinity come from the [REALTIME] profile if configured
+	if(NPI_LNX_SchedCreateThread(&npiPollThread, NPI_LNX_SCHED_THREAD_POLL, npi_poll_entry, NULL))
 	{
 		// thread creation failed
 		NPI_I2C_CloseDevice();
+		NPI_LNX_DispatchClose();
 		npi_ipc_errno = NPI_LNX_ERROR_I2C_OPEN_FAILED_POLL_THREAD;
 		return NPI_LNX_FAILURE;
 	}
 #ifdef SRDY_INTERRUPT
+#ifdef NPI_TICKLESS
+	if (pipe(npiEventWakePipe) < 0)
+	{
+		NPI_I2C_CloseDevice();
+		NPI_LNX_DispatchClose();
+		npi_ipc_errno = NPI_LNX_ERROR_I2C_OPEN_FAILED_EVENT_THREAD;
+		return NPI_LNX_FAILURE;
+	}
+#endif
 
-	if(pthread_create(&npiEventThread, NULL, npi_event_entry, NULL))
+	if(NPI_LNX_SchedCreateThread(&npiEventThread, NPI_LNX_SCHED_THREAD_EVENT, npi_event_entry, NULL))
 	{
 		// thread creation failed
 		NPI_I2C_CloseDevice();
+		NPI_LNX_DispatchClose();
 		npi_ipc_errno = NPI_LNX_ERROR_I2C_OPEN_FAILED_EVENT_THREAD;
 		return NPI_LNX_FAILURE;
 	}
@@ -858,7 +881,8 @@ static int npi_initsyncres(void)
 static void *npi_poll_entry(void *ptr)
 {
 	int ret = NPI_LNX_SUCCESS;
-	uint8 readbuf[128];
+	npiMsgBuf_t *pPollBuf;
+	struct timespec serviceStart;
 #ifndef SRDY_INTERRUPT
 	uint8 pollStatus = FALSE;
 #endif //SRDY_INTERRUPT
@@ -932,23 +956,29 @@ static void *npi_poll_entry(void *ptr)
 			}
 
 			//RNP is polling, retrieve the data
-			*readbuf = 0; //Poll Command has zero data bytes.
-			*(readbuf+1) = RPC_CMD_POLL;
-			*(readbuf+2) = 0;
-			ret = npi_i2c_pollData((npiMsgData_t *)readbuf);
+			clock_gettime(CLOCK_MONOTONIC, &serviceStart);
+			pPollBuf = NPI_LNX_MsgBufAlloc();
+			if (pPollBuf)
+			{
+				pPollBuf->msg.len = 0; //Poll Command has zero data bytes.
+				pPollBuf->msg.subSys = RPC_CMD_POLL;
+				pPollBuf->msg.cmdId = 0;
+				ret = npi_i2c_pollData(&pPollBuf->msg);
+			}
+			else
+			{
+				npi_ipc_errno = NPI_LNX_ERROR_I2C_POLL_THREAD_NO_BUFFER;
+				ret = NPI_LNX_FAILURE;
+			}
 			if (ret == NPI_LNX_SUCCESS)
 			{
 				//Check if polling was successful
-				if ((readbuf[RPC_POS_CMD0] & RPC_CMD_TYPE_MASK) == RPC_CMD_AREQ)
+				if ((pPollBuf->msg.subSys & RPC_CMD_TYPE_MASK) == RPC_CMD_AREQ)
 				{
-//					((uint8 *)readbuf)[RPC_POS_CMD0] =  RPC_SUBSYSTEM_MASK;
-					ret = NPI_AsynchMsgCback((npiMsgData_t *)(readbuf));
-					if (ret != NPI_LNX_SUCCESS)
-					{
-						// Exit thread to invoke report to main thread
-						npi_poll_terminate = 1;
-						LOG_ERROR("%s:%d: ERROR! Terminating poll because RPC_CMD_AREQ.\n", __FUNCTION__, __LINE__);
-					}
+					// The dispatch thread passes it on to the clients, so that
+					// SRDY is served again without waiting for them
+					NPI_LNX_DispatchPost(pPollBuf, &serviceStart);
+					pPollBuf = NULL;
 				}
 			}
 			else
@@ -980,6 +1010,8 @@ static void *npi_poll_entry(void *ptr)
 				}
 			}
 
+			NPI_LNX_MsgBufRelease(pPollBuf);
+
 			if (!PollLockVar)
 			{
 				ret = PollLockVarError(__LINE__, !PollLockVar);
@@ -1030,6 +1062,8 @@ static void *npi_poll_entry(void *ptr)
 				}
 			}
 
+			NPI_LNX_SchedIdleWakeup(NPI_LNX_SCHED_THREAD_POLL);
+
 #ifdef SRDY_INTERRUPT
 			if ( __BIG_DEBUG_ACTIVE == TRUE )
 			{
@@ -1153,6 +1187,10 @@ static void npi_termpoll(void)
 {
   //This will cause the Thread to exit
   npi_poll_terminate = 1;
+#if (defined SRDY_INTERRUPT) && (defined NPI_TICKLESS)
+  if (write(npiEventWakePipe[1], "T", 1) < 0)
+    LOG_ERROR("%s(): Failed to wake up event thread\n", __FUNCTION__);
+#endif
   LOG_ERROR("%s:%d: Terminating poll because...well, we're %s().\n", __FUNCTION__, __LINE__, __FUNCTION__);
 
 #ifdef SRDY_INTERRUPT
@@ -1170,8 +1208,15 @@ static void npi_termpoll(void)
   // wait till the thread terminates
   pthread_join(npiPollThread, NULL);
 
+  // nothing is queued anymore, stop delivering
+  NPI_LNX_DispatchClose();
+
 #ifdef SRDY_INTERRUPT
   pthread_join(npiEventThread, NULL);
+#ifdef NPI_TICKLESS
+  close(npiEventWakePipe[0]);
+  close(npiEventWakePipe[1]);
+#endif
 #endif //SRDY_INTERRUPT
 }
 
@@ -1203,7 +1248,7 @@ static void *npi_event_entry(void *ptr)
 	int ret = NPI_LNX_SUCCESS;
 	int timeout = I2C_ISR_POLL_TIMEOUT_MS_MAX;
 	/* Timeout in msec. Drop down to I2C_ISR_POLL_TIMEOUT_MS_MIN if two consecutive interrupts are missed */
-	struct pollfd pollfds[1];
+	struct pollfd pollfds[2];
 	int val;
 
 	((void)ptr);
@@ -1216,7 +1261,17 @@ static void *npi_event_entry(void *ptr)
 		memset((void*) pollfds, 0, sizeof(pollfds));
 		pollfds[0].fd = GpioSrdyFd; /* Wait for input */
 		pollfds[0].events = POLLPRI; /* Wait for input */
+#ifdef NPI_TICKLESS
+		pollfds[1].fd = npiEventWakePipe[0];
+		pollfds[1].events = POLLIN;
+		result = poll(pollfds, 2, timeout);
+		if (npi_poll_terminate)
+		{
+			break;
+		}
+#else
 		result = poll(pollfds, 1, timeout);
+#endif
 
 		// Make sure we're not in Asynch data or Synch data, so check if npiSrdyLock is available
 		if (pthread_mutex_trylock(&npiSrdyLock) != 0)
@@ -1233,6 +1288,15 @@ static void *npi_event_entry(void *ptr)
 					time_printf("[%s] SRDY found to be asserted while we are transmitting\n", __FUNCTION__);
 				}
 			}
+#ifdef NPI_TICKLESS
+			// The edge, if any, is consumed while the transaction holds the
+			// lock. Keep a bounded timeout so that SRDY is checked again once
+			// the transaction is done, instead of waiting for the next edge.
+			if (timeout < 0)
+			{
+				timeout = I2C_ISR_POLL_TIMEOUT_MS_MAX;
+			}
+#endif
 			continue;
 		}
 		else
@@ -1293,6 +1357,15 @@ static void *npi_event_entry(void *ptr)
 						}
 
 						missedInterrupt = 0;
+						NPI_LNX_SchedIdleWakeup(NPI_LNX_SCHED_THREAD_EVENT);
+#ifdef NPI_TICKLESS
+						// SRDY is idle and no interrupt was missed, so block
+						// until the next edge instead of waking periodically.
+						if (timeout == I2C_ISR_POLL_TIMEOUT_MS_MAX)
+						{
+							timeout = -1;
+						}
+#endif
 					}
 					result = global_srdy = val; // Update global SRDY tracker here as well, as no errors has occurred.
 				}
@@ -68,9 +68,12 @@
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #endif
 
 #include <sys/time.h>
+#include <sys/eventfd.h>
+#include <pthread.h>
 
 #include "OEM_NpiStartupHook.h"
 
@@ -80,6 +83,12 @@
 #include "npi_lnx_ipc_rpc.h"
 #include "tiLogging.h"
 #include "npi_lnx_serial_configuration.h"
+#include "npi_lnx_sched.h"
+#include "npi_lnx_sreq_cache.h"
+#include "npi_lnx_qos.h"
+#include "npi_lnx_errlog.h"
+#include "npi_lnx_msgbuf.h"
+#include "npi_lnx_dispatch.h"
 
 #if (defined NPI_SPI) && (NPI_SPI == TRUE)
 #include "npi_lnx_spi.h"
@@ -216,6 +225,22 @@ const pNPI_SendSynchDataFn NPI_SendSynchDataFnArr[] =
 #endif
 };
 
+const pNPI_SendSynchBufFn NPI_SendSynchBufFnArr[] =
+{
+#if (defined NPI_UART) && (NPI_UART == TRUE)
+		NPI_UART_SendSynchBuf,
+#else
+		NULL,
+#endif
+		NULL,
+		NULL,
+#if (defined NPI_UART_USB) && (NPI_UART_USB == TRUE)
+		NPI_UART_SendSynchBuf,
+#else
+		NULL,
+#endif
+};
+
 const pNPI_ResetSlaveFn NPI_ResetSlaveFnArr[] =
 {
 		NULL,
@@ -273,9 +298,30 @@ static int fdmax;
 static struct
 {
 	int list[NPI_SERVER_CONNECTION_QUEUE_SIZE];
+	uint8 features[NPI_SERVER_CONNECTION_QUEUE_SIZE];	// NPI_LNX_FEATURE_* granted to list[i]
 	int size;
 } activeConnections;
 
+// Number of SREQs answered together with an identical one
+static uint32 sreqCoalescedCount = 0;
+
+// Errors reported by the driver threads through NPI_LNX_IPC_NotifyError(),
+// picked up by the main loop when npiIpcErrorFd becomes readable.
+#define NPI_IPC_ERROR_QUEUE_SIZE		8
+typedef struct
+{
+	uint16 source;
+	int errorCode;
+	char msg[AP_MAX_BUF_LEN + 1];
+} npiIpcError_t;
+
+static npiIpcError_t npiIpcErrorQueue[NPI_IPC_ERROR_QUEUE_SIZE];
+static int npiIpcErrorHead = 0;
+static int npiIpcErrorCount = 0;
+static uint32 npiIpcErrorDropped = 0;
+static pthread_mutex_t npiIpcErrorMutex = PTHREAD_MUTEX_INITIALIZER;
+static int npiIpcErrorFd = -1;
+
 // Variables for Configuration
 npiSerialCfg_t serialCfg;
 
@@ -316,17 +362,21 @@ static struct
  **************************************************************************************************/
 static void NPI_LNX_IPC_Exit(int ret, uint8 freeSerial);
 
-static int NPI_LNX_IPC_SendData(npiMsgData_t const *sendBuf, int connection);
+static int NPI_LNX_IPC_SendData(npiMsgData_t const *sendBuf, int connection, int corrId);
 static int NPI_LNX_IPC_ConnectionHandle(int connection, npiMsgData_t *recvBuf);
+static void NPI_LNX_IPC_CoalesceSREQ(int connection, const npiMsgData_t *pSreq, const npiMsgData_t *pSrsp);
 
 static int removeFromActiveList(int c);
 static int addToActiveList(int c);
+static uint8 *activeListFeatures(int c);
 
 static int setupSocket(npiSerialCfg_t *serialCfg);
 static int configureDebugInterface(void);
 static void writeToNpiLnxLog(const char* str);
+static int npiIpcProcessErrors(char *toNpiLnxLog);
+static void npiIpcResetDevice(void);
 
-static int npi_ServerCmdHandle(npiMsgData_t *npi_ipc_buf);
+static int npi_ServerCmdHandle(npiMsgData_t *npi_ipc_buf, int connection);
 
 /**************************************************************************************************
  * @fn          halDelay
@@ -361,53 +411,8 @@ static int npi_ServerCmdHandle(npiMsgData_t *npi_ipc_buf);
 
 static void writeToNpiLnxLog(const char* str)
 {
-	static const int kStrSize=255;
-	int npiLnxLogFd;
-	size_t ix = 0;
-	char *fullStr = (char *)malloc(kStrSize);
-	char *inStr = (char *)malloc(kStrSize);
-
-	time_t timeNow;
-	struct tm * timeNowinfo;
-
-	time ( &timeNow );
-	timeNowinfo = localtime ( &timeNow );
-
-	snprintf(fullStr, kStrSize, "[%s", asctime(timeNowinfo));
-	snprintf(inStr, kStrSize, "%s", str);
-	// Remove \n characters
-	fullStr[strlen(fullStr) - 2] = 0;
-	for (ix = strlen(str) - 1; ix > MAX(strlen(str), 4); ix--)
-	{
-		if (inStr[ix] == '\n')
-			inStr[ix] = 0;
-	}
-	// Concatenate and add global error code
-	ix = strlen(fullStr);
-	snprintf(fullStr+ix, kStrSize-ix, "] %s. Error: %.8X\n", inStr, npi_ipc_errno);
-
-	// Write error message to /dev/npiLnxLog
-	if (*serialCfg.logPath)
-		npiLnxLogFd = open(serialCfg.logPath,  O_WRONLY | O_APPEND | O_CREAT, S_IRWXU);
-	else
-		npiLnxLogFd = STDERR_FILENO; // Empty string for log path means use stderr
-
-	if (npiLnxLogFd > 0)
-	{
-		write(npiLnxLogFd, fullStr, strlen(fullStr));
-//		LOG_DEBUG("Wrote:\n%s\n to npiLnxLog.log\n", fullStr, errno);
-	}
-	else
-	{
-		LOG_ERROR("Could not write \n%s\n to npiLnxLog. Error: %.8X\n", str, errno);
-		perror("open");
-	}
-
-	if (*serialCfg.logPath)
-		close(npiLnxLogFd);
-
-	free(fullStr);
-	free(inStr);
+	// Queued for the error log writer thread, see npi_lnx_errlog.c
+	NPI_LNX_ErrLogWrite(str, npi_ipc_errno);
 }
 
 static void print_usage_and_exit(const char *prog)
@@ -556,12 +561,26 @@ int main(int argc, char *argv[])
 	if (NPI_LNX_SUCCESS == getSerialConfiguration(configFilePath, &serialCfg))
 	{
 		LOG_ALWAYS("Successfully read configuration parameters\n");
+		NPI_LNX_ErrLogOpen(serialCfg.logPath);
 	}
 	else
 	{
 		NPI_LNX_IPC_Exit(NPI_LNX_FAILURE, FALSE);
 	}
 
+	// Error channel of the driver threads, needed before any of them runs
+	if ((npiIpcErrorFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+	{
+		LOG_FATAL("Could not create error channel, errno %d\n", errno);
+		npi_ipc_errno = NPI_LNX_ERROR_IPC_NOTIFY_ERR_CREATE_CHANNEL;
+		NPI_LNX_IPC_Exit(NPI_LNX_FAILURE, FALSE);
+	}
+
+	/**********************************************************************
+	 * Apply the real-time profile before any I/O thread is created
+	 */
+	NPI_LNX_SchedInit();
+
 	/**********************************************************************
 	 * Open the serial interface
 	 */
@@ -688,6 +707,11 @@ int main(int argc, char *argv[])
 	FD_SET(sNPIlisten, &activeConnectionsFDs);
 	fdmax = sNPIlisten;
 
+	// And the error channel
+	FD_SET(npiIpcErrorFd, &activeConnectionsFDs);
+	if (npiIpcErrorFd > fdmax)
+		fdmax = npiIpcErrorFd;
+
 #if (defined __DEBUG_TIME__) || (__STRESS_TEST__)
 	clock_gettime(CLOCK_MONOTONIC, &gStartTime);
 #endif // (defined __DEBUG_TIME__) || (__STRESS_TEST__)
@@ -708,192 +732,193 @@ int main(int argc, char *argv[])
 				ret = NPI_LNX_FAILURE;
 				break;
 			}
+			NPI_LNX_SchedIdleWakeup(NPI_LNX_SCHED_THREAD_MAIN);
 			continue;
 		}
 
-		// Then process this activity
-		for (c = 0; c <= fdmax; c++)
+		// Errors of the driver threads go first, they may ask for a reset
+		if (FD_ISSET(npiIpcErrorFd, &activeConnectionsFDsSafeCopy))
+		{
+			ret = npiIpcProcessErrors(toNpiLnxLog);
+			if (ret != NPI_LNX_SUCCESS)
+			{
+				break;
+			}
+		}
+
+		// Then accept new connections
+		if (FD_ISSET(sNPIlisten, &activeConnectionsFDsSafeCopy))
 		{
-			if (FD_ISSET(c, &activeConnectionsFDsSafeCopy))
+			int addrLen = 0;
+			// Accept a connection from a client.
+			addrLen = sizeof(their_addr);
+			justConnected = accept(sNPIlisten,
+					(struct sockaddr *) &their_addr,
+					(socklen_t *) &addrLen);
+
+			if (justConnected == -1)
+			{
+				perror("accept");
+				npi_ipc_errno = NPI_LNX_ERROR_IPC_SOCKET_ACCEPT;
+				ret = NPI_LNX_FAILURE;
+				break;
+			}
+			else
 			{
-				if (c == sNPIlisten)
-				{
-					int addrLen = 0;
-					// Accept a connection from a client.
-					addrLen = sizeof(their_addr);
-					justConnected = accept(sNPIlisten,
-							(struct sockaddr *) &their_addr,
-							(socklen_t *) &addrLen);
-
-					if (justConnected == -1)
-					{
-						perror("accept");
-						npi_ipc_errno = NPI_LNX_ERROR_IPC_SOCKET_ACCEPT;
-						ret = NPI_LNX_FAILURE;
-						break;
-					}
-					else
-					{
 #ifndef NPI_UNIX
-						char ipstr[INET6_ADDRSTRLEN];
-						char ipstr2[INET6_ADDRSTRLEN];
+				char ipstr[INET6_ADDRSTRLEN];
+				char ipstr2[INET6_ADDRSTRLEN];
+				int noDelay = 1;
+
+				// Responses to pipelined requests go out back to back, do not
+				// hold them back until the client acknowledges the first one.
+				if (setsockopt(justConnected, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(int)) == -1)
+				{
+					LOG_WARN("Could not disable Nagle's algorithm on #%d, errno %d\n", justConnected, errno);
+				}
 #endif //NPI_UNIX
-						FD_SET(justConnected, &activeConnectionsFDs);
-						if (justConnected > fdmax)
-							fdmax = justConnected;
+				FD_SET(justConnected, &activeConnectionsFDs);
+				if (justConnected > fdmax)
+					fdmax = justConnected;
 #ifdef NPI_UNIX
-						snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Connected to #%d.", justConnected);
+				snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Connected to #%d.", justConnected);
 #else
-						//                                            debug_
-						inet_ntop(AF_INET, &((struct sockaddr_in *) &their_addr)->sin_addr, ipstr, sizeof ipstr);
-						inet_ntop(AF_INET6, &((struct sockaddr_in6 *)&their_addr)->sin6_addr, ipstr2, sizeof ipstr2);
-						snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Connected to #%d.(%s / %s)", justConnected, ipstr, ipstr2);
+				//                                            debug_
+				inet_ntop(AF_INET, &((struct sockaddr_in *) &their_addr)->sin_addr, ipstr, sizeof ipstr);
+				inet_ntop(AF_INET6, &((struct sockaddr_in6 *)&their_addr)->sin6_addr, ipstr2, sizeof ipstr2);
+				snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Connected to #%d.(%s / %s)", justConnected, ipstr, ipstr2);
 #endif //NPI_UNIX
-						writeToNpiLnxLog(toNpiLnxLog);
-						LOG_INFO("%s\n", toNpiLnxLog);
-						ret = addToActiveList(justConnected);
+				writeToNpiLnxLog(toNpiLnxLog);
+				LOG_INFO("%s\n", toNpiLnxLog);
+				if (addToActiveList(justConnected) != NPI_LNX_SUCCESS)
+				{
+					// No room for another client, turn this one away but keep serving the others
+					snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Rejected #%d, too many connections.", justConnected);
+					writeToNpiLnxLog(toNpiLnxLog);
+					LOG_WARN("%s\n", toNpiLnxLog);
+					// Undo whatever part of the registration succeeded, list and scheduler
+					removeFromActiveList(justConnected);
+					close(justConnected);
+					FD_CLR(justConnected, &activeConnectionsFDs);
+				}
 
 #ifdef __DEBUG_TIME__
-						if (__DEBUG_TIME_ACTIVE == TRUE)
-						{
-							clock_gettime(CLOCK_MONOTONIC, &gStartTime);
-						}
-#endif //__DEBUG_TIME__
-					}
+				if (__DEBUG_TIME_ACTIVE == TRUE)
+				{
+					clock_gettime(CLOCK_MONOTONIC, &gStartTime);
 				}
-				else
+#endif //__DEBUG_TIME__
+			}
+		}
+
+		// Then pass the client messages on, in the order given by the scheduler
+		while ((ret == NPI_LNX_SUCCESS) && ((c = NPI_LNX_QosNext()) != -1))
+		{
+			ret = NPI_LNX_IPC_ConnectionHandle(c, &npiIpcRecvBuf);
+			if (ret == NPI_LNX_SUCCESS)
+			{
+				// Everything is ok
+			}
+			else
+			{
+				uint8 childThread;
+				switch (npi_ipc_errno)
 				{
-					ret = NPI_LNX_IPC_ConnectionHandle(c, &npiIpcRecvBuf);
-					if (ret == NPI_LNX_SUCCESS)
+				case NPI_LNX_ERROR_IPC_RECV_DATA_DISCONNECT:
+					close(c);
+					LOG_INFO("Removing connection #%d due to disconnect.\n", c);
+					// Connection closed. Remove from set
+					FD_CLR(c, &activeConnectionsFDs);
+					// We should now set ret to NPI_SUCCESS, but there is still one fatal error
+					// possibility so simply set ret = to return value from removeFromActiveList().
+					ret = removeFromActiveList(c);
+					snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Removed connection #%d", c);
+					//							LOG_WARN("%s\n", toNpiLnxLog);
+					writeToNpiLnxLog(toNpiLnxLog);
+					break;
+				case NPI_LNX_ERROR_UART_SEND_SYNCH_TIMEDOUT:
+					//This case can happen in some particular condition:
+					// if the network is in BOOT mode, it will not answer any synchronous request other than SYS_BOOT request.
+					// if we exit immediately, we will never be able to recover the NP device.
+					// This may be replace in the future by an update of the RNP behavior
+					LOG_WARN("Synchronous Request Timeout...");
+					snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Removed connection #%d", c);
+					LOG_WARN("%s\n", toNpiLnxLog);
+					writeToNpiLnxLog(toNpiLnxLog);
+					ret = NPI_LNX_SUCCESS;
+					npi_ipc_errno = NPI_LNX_SUCCESS;
+					break;
+
+				case NPI_LNX_ERROR_HAL_DBG_IFC_WAIT_DUP_READY:
+					// Device did not respond, it may be that it's not in debug mode anymore.
+					LOG_WARN("Chip failed to respond\n");
+					// This error should not be considered critical at this stage.
+					snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Could not get chip ID, device not in debug mode as it failed to respond\n");
+					writeToNpiLnxLog(toNpiLnxLog);
+					npi_ipc_errno = NPI_LNX_SUCCESS;
+					ret = NPI_LNX_SUCCESS;
+					break;
+				case NPI_LNX_ERROR_HAL_DBG_IFC_ASYNCH_INVALID_CMDID:
+					// This is not a critical error, so don't cause server to exit.
+					// It simply tells that an invalid AREQ CMD was requested.
+					snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Invalid asynchronous request to debug interface #%c", c);
+					writeToNpiLnxLog(toNpiLnxLog);
+					ret = NPI_LNX_SUCCESS;
+					npi_ipc_errno = NPI_LNX_SUCCESS;
+					break;
+				default:
+					if (npi_ipc_errno == NPI_LNX_SUCCESS)
+					{
+						// Do not report and abort if there is no real error.
+						ret = NPI_LNX_SUCCESS;
+					}
+					else if (NPI_LNX_ERROR_JUST_WARNING(npi_ipc_errno))
 					{
-						// Everything is ok
+						// This may be caused by an unexpected reset. Write it to the log,
+						// but keep going.
+						// Everything about the error can be found in the message, and in npi_ipc_errno:
+						childThread = npiIpcRecvBuf.cmdId;
+						snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Child thread with ID %d in module %d reported error:\t%.*s",
+								NPI_LNX_ERROR_THREAD(childThread),
+								NPI_LNX_ERROR_MODULE(childThread),
+								(int)sizeof(npiIpcRecvBuf.pData),
+								(char *)(npiIpcRecvBuf.pData));
+						//							LOG_WARN("%s\n", toNpiLnxLog);
+						writeToNpiLnxLog(toNpiLnxLog);
+						// Force continuation
+						ret = NPI_LNX_SUCCESS;
 					}
 					else
 					{
-						uint8 childThread;
-						switch (npi_ipc_errno)
-						{
-						case NPI_LNX_ERROR_IPC_RECV_DATA_DISCONNECT:
-							close(c);
-							LOG_INFO("Removing connection #%d due to disconnect.\n", c);
-							// Connection closed. Remove from set
-							FD_CLR(c, &activeConnectionsFDs);
-							// We should now set ret to NPI_SUCCESS, but there is still one fatal error
-							// possibility so simply set ret = to return value from removeFromActiveList().
-							ret = removeFromActiveList(c);
-							snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Removed connection #%d", c);
-							//							LOG_WARN("%s\n", toNpiLnxLog);
-							writeToNpiLnxLog(toNpiLnxLog);
-							break;
-						case NPI_LNX_ERROR_UART_SEND_SYNCH_TIMEDOUT:
-							//This case can happen in some particular condition:
-							// if the network is in BOOT mode, it will not answer any synchronous request other than SYS_BOOT request.
-							// if we exit immediately, we will never be able to recover the NP device.
-							// This may be replace in the future by an update of the RNP behavior
-							LOG_WARN("Synchronous Request Timeout...");
-							snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Removed connection #%d", c);
-							LOG_WARN("%s\n", toNpiLnxLog);
-							writeToNpiLnxLog(toNpiLnxLog);
-							ret = NPI_LNX_SUCCESS;
-							npi_ipc_errno = NPI_LNX_SUCCESS;
-							break;
-
-						case NPI_LNX_ERROR_HAL_DBG_IFC_WAIT_DUP_READY:
-							// Device did not respond, it may be that it's not in debug mode anymore.
-							LOG_WARN("Chip failed to respond\n");
-							// This error should not be considered critical at this stage.
-							snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Could not get chip ID, device not in debug mode as it failed to respond\n");
-							writeToNpiLnxLog(toNpiLnxLog);
-							npi_ipc_errno = NPI_LNX_SUCCESS;
-							ret = NPI_LNX_SUCCESS;
-							break;
-						case NPI_LNX_ERROR_HAL_DBG_IFC_ASYNCH_INVALID_CMDID:
-							// This is not a critical error, so don't cause server to exit.
-							// It simply tells that an invalid AREQ CMD was requested.
-							snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Invalid asynchronous request to debug interface #%c", c);
-							writeToNpiLnxLog(toNpiLnxLog);
-							ret = NPI_LNX_SUCCESS;
-							npi_ipc_errno = NPI_LNX_SUCCESS;
-							break;
-						default:
-							if (npi_ipc_errno == NPI_LNX_SUCCESS)
-							{
-								// Do not report and abort if there is no real error.
-								ret = NPI_LNX_SUCCESS;
-							}
-							else if (NPI_LNX_ERROR_JUST_WARNING(npi_ipc_errno))
-							{
-								// This may be caused by an unexpected reset. Write it to the log,
-								// but keep going.
-								// Everything about the error can be found in the message, and in npi_ipc_errno:
-								childThread = npiIpcRecvBuf.cmdId;
-								snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Child thread with ID %d in module %d reported error:\t%.*s",
-										NPI_LNX_ERROR_THREAD(childThread),
-										NPI_LNX_ERROR_MODULE(childThread),
-										(int)sizeof(npiIpcRecvBuf.pData),
-										(char *)(npiIpcRecvBuf.pData));
-								//							LOG_WARN("%s\n", toNpiLnxLog);
-								writeToNpiLnxLog(toNpiLnxLog);
-								// Force continuation
-								ret = NPI_LNX_SUCCESS;
-							}
-							else
-							{
-								//							debug_
-								LOG_ERROR("npi_ipc_errno 0x%.8X\n", npi_ipc_errno);
-								// Everything about the error can be found in the message, and in npi_ipc_errno:
-								childThread = npiIpcRecvBuf.cmdId;
-								snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Child thread with ID %d in module %d reported error:\t%.*s",
-										NPI_LNX_ERROR_THREAD(childThread),
-										NPI_LNX_ERROR_MODULE(childThread),
-										(int)sizeof(npiIpcRecvBuf.pData),
-										(char *)(npiIpcRecvBuf.pData));
-								//							LOG_ERROR("%s\n", toNpiLnxLog);
-								writeToNpiLnxLog(toNpiLnxLog);
-							}
-							break;
-						}
+						//							debug_
+						LOG_ERROR("npi_ipc_errno 0x%.8X\n", npi_ipc_errno);
+						// Everything about the error can be found in the message, and in npi_ipc_errno:
+						childThread = npiIpcRecvBuf.cmdId;
+						snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Child thread with ID %d in module %d reported error:\t%.*s",
+								NPI_LNX_ERROR_THREAD(childThread),
+								NPI_LNX_ERROR_MODULE(childThread),
+								(int)sizeof(npiIpcRecvBuf.pData),
+								(char *)(npiIpcRecvBuf.pData));
+						//							LOG_ERROR("%s\n", toNpiLnxLog);
+						writeToNpiLnxLog(toNpiLnxLog);
+					}
+					break;
+				}
 
-						// Check if error requested a reset
-						if (NPI_LNX_ERROR_RESET_REQUESTED(npi_ipc_errno))
-						{
-							// Yes, utilize server control API to reset current device
-							// Do it by reconnecting so that threads are kept synchronized
-							npiMsgData_t npi_ipc_buf_tmp;
-							int localRet = NPI_LNX_SUCCESS;
-							LOG_WARN("Reset was requested, so try to disconnect device %d\n", serialCfg.devIdx);
-							npi_ipc_buf_tmp.cmdId = NPI_LNX_CMD_ID_DISCONNECT_DEVICE;
-							localRet = npi_ServerCmdHandle((npiMsgData_t *)&npi_ipc_buf_tmp);
-							LOG_WARN("Disconnection from device %d was %s\n", serialCfg.devIdx, (localRet == NPI_LNX_SUCCESS) ? "successful" : "unsuccessful");
-							if (localRet == NPI_LNX_SUCCESS)
-							{
-								LOG_WARN("Then try to connect device %d again\n", serialCfg.devIdx);
-								int bigDebugWas = __BIG_DEBUG_ACTIVE;
-								if (bigDebugWas == FALSE)
-								{
-									__BIG_DEBUG_ACTIVE = TRUE;
-									LOG_ALWAYS("__BIG_DEBUG_ACTIVE set to TRUE\n");
-								}
-								npi_ipc_buf_tmp.cmdId = NPI_LNX_CMD_ID_CONNECT_DEVICE;
-								localRet = npi_ServerCmdHandle((npiMsgData_t *)&npi_ipc_buf_tmp);
-								LOG_WARN("Reconnection to device %d was %s\n", serialCfg.devIdx, (localRet == NPI_LNX_SUCCESS) ? "successful" : "unsuccessful");
-								if (bigDebugWas == FALSE)
-								{
-									__BIG_DEBUG_ACTIVE = FALSE;
-									LOG_ALWAYS("__BIG_DEBUG_ACTIVE set to FALSE\n");
-								}
-							}
-						}
+				// Check if error requested a reset
+				if (NPI_LNX_ERROR_RESET_REQUESTED(npi_ipc_errno))
+				{
+					npiIpcResetDevice();
+				}
 
-						// If this error was sent through socket; close this connection
-						if ((npiIpcRecvBuf.subSys & RPC_CMD_TYPE_MASK) == RPC_CMD_NOTIFY_ERR)
-						{
-							close(c);
-							LOG_ERROR("Removing connection #%d due to RPC_CMD_NOTIFY_ERR\n", c);
-							// Connection closed. Remove from set
-							FD_CLR(c, &activeConnectionsFDs);
-						}
-					}
+				// If this error was sent through socket; close this connection
+				if ((npiIpcRecvBuf.subSys & RPC_CMD_TYPE_MASK) == RPC_CMD_NOTIFY_ERR)
+				{
+					close(c);
+					LOG_ERROR("Removing connection #%d due to RPC_CMD_NOTIFY_ERR\n", c);
+					// Connection closed. Remove from set
+					FD_CLR(c, &activeConnectionsFDs);
+					NPI_LNX_QosRemoveConnection(c);
 				}
 			}
 		}
@@ -909,6 +934,7 @@ int main(int argc, char *argv[])
 	freeaddrinfo(servinfo); // free the linked-list
 #endif //NPI_UNIX
 	(NPI_CloseDeviceFnArr[serialCfg.devIdx])();
+	NPI_LNX_ErrLogClose();
 
 	// Free all remaining memory
 	NPI_LNX_IPC_Exit(NPI_LNX_SUCCESS + 1, TRUE);
@@ -942,14 +968,22 @@ int main(int argc, char *argv[])
 
 static int addToActiveList(int c)
 {
-	if (activeConnections.size <= NPI_SERVER_CONNECTION_QUEUE_SIZE)
+	if (activeConnections.size < NPI_SERVER_CONNECTION_QUEUE_SIZE)
 	{
 		// Entry at position activeConnections.size is always the last available entry
 		activeConnections.list[activeConnections.size] = c;
+		activeConnections.features[activeConnections.size] = 0;
 
 		// Increment size
 		activeConnections.size++;
 
+		// Schedule its messages from now on
+		if (NPI_LNX_QosAddConnection(c) != NPI_LNX_SUCCESS)
+		{
+			npi_ipc_errno = NPI_LNX_ERROR_IPC_ADD_TO_ACTIVE_LIST_NO_ROOM;
+			return NPI_LNX_FAILURE;
+		}
+
 		return NPI_LNX_SUCCESS;
 	}
 	else
@@ -992,6 +1026,8 @@ static int removeFromActiveList(int c)
 
 	if (i < activeConnections.size)
 	{
+		NPI_LNX_QosRemoveConnection(c);
+
 		//Check if the last active conection has been removed
 		if (activeConnections.size == 1)
 		{
@@ -1005,6 +1041,7 @@ static int removeFromActiveList(int c)
 
 			// Found our entry, replace this entry by the last entry
 			activeConnections.list[i] = activeConnections.list[activeConnections.size - 1];
+			activeConnections.features[i] = activeConnections.features[activeConnections.size - 1];
 
 			// Decrement size
 			activeConnections.size--;
@@ -1028,6 +1065,41 @@ static int removeFromActiveList(int c)
 	}
 }
 
+/**************************************************************************************************
+ *
+ * @fn          activeListFeatures
+ *
+ * @brief       Manage active connections, find the protocol features of a connection
+ *
+ * input parameters
+ *
+ * @param       c - connection
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      Pointer to the NPI_LNX_FEATURE_* flags of the connection. A connection
+ *              not in the list points to a scratch value of 0.
+ *
+ **************************************************************************************************/
+static uint8 *activeListFeatures(int c)
+{
+	static uint8 noFeatures;
+	int i;
+
+	for (i = 0; i < activeConnections.size; i++)
+	{
+		if (activeConnections.list[i] == c)
+		{
+			return &activeConnections.features[i];
+		}
+	}
+
+	noFeatures = 0;
+	return &noFeatures;
+}
+
 #ifdef __DEBUG_TIME__
 static void time_print_npi_ipc_buf(const char *strDirection, const npiMsgData_t *npiMsgData, struct timespec const *callersStartTime, struct timespec const *callersCurrentTime, struct timespec *callersPreviousTime)
 {
@@ -1074,7 +1146,14 @@ static void time_print_npi_ipc_buf(const char *strDirection, const npiMsgData_t
  **************************************************************************************************/
 static int NPI_LNX_IPC_ConnectionHandle(int connection, npiMsgData_t *recvBuf)
 {
-	npiMsgData_t sendBuf;
+	npiMsgData_t sreqCopy;
+	uint8 coalesce = FALSE;
+	uint8 sreqSubSys = 0, sreqCmdId = 0;
+	int corrId = -1;
+	npiSreqCacheKey_t sreqCacheKey;
+	// SRSP to send, in recvBuf unless it is held in a message buffer
+	npiMsgData_t *pSrsp = recvBuf;
+	npiMsgBuf_t *pSrspBuf = NULL;
 	char tmpStr[512];
 	size_t strLen;
 	strLen = 0;
@@ -1123,6 +1202,23 @@ static int NPI_LNX_IPC_ConnectionHandle(int connection, npiMsgData_t *recvBuf)
 	else if (n == RPC_FRAME_HDR_SZ)
 	{
 		// LOG_DEBUG("%s(): Receive message header (good)...\n", __FUNCTION__);
+		sreqSubSys = recvBuf->subSys;
+		sreqCmdId = recvBuf->cmdId;
+		// Requests on a connection which negotiated correlation identifiers
+		// carry one right after the header
+		if (((recvBuf->subSys & RPC_CMD_TYPE_MASK) == RPC_CMD_SREQ) &&
+				(*activeListFeatures(connection) & NPI_LNX_FEATURE_CORRELATION_ID))
+		{
+			uint8 id;
+			if (recv(connection, &id, 1, MSG_WAITALL) != 1)
+			{
+				// A request without its identifier cannot be answered, drop the client
+				LOG_WARN("Client #%d disconnected while sending a correlation identifier.\n", connection);
+				npi_ipc_errno = NPI_LNX_ERROR_IPC_RECV_DATA_DISCONNECT;
+				return NPI_LNX_FAILURE;
+			}
+			corrId = id;
+		}
 		// Now read out the payload of the NPI message, if it exists
 		if (recvBuf->len > 0)
 		{
@@ -1199,6 +1295,9 @@ static int NPI_LNX_IPC_ConnectionHandle(int connection, npiMsgData_t *recvBuf)
 			{
 				if (serialCfg.debugSupported)
 				{
+					// The debug interface may reprogram the RNP
+					NPI_LNX_SreqCacheInvalidate(NPI_LNX_SREQ_CACHE_IMMUTABLE);
+
 					// Synchronous Call to Debug Interface
 					ret = Hal_DebugInterface_SynchMsgCback(recvBuf);
 				}
@@ -1214,15 +1313,40 @@ static int NPI_LNX_IPC_ConnectionHandle(int connection, npiMsgData_t *recvBuf)
 			{
 
 				//SREQ Command send to this server.
-				ret = npi_ServerCmdHandle(recvBuf);
+				ret = npi_ServerCmdHandle(recvBuf, connection);
+			}
+			else if (NPI_LNX_SreqCacheLookup(recvBuf, &sreqCacheKey, &pSrspBuf) == TRUE)
+			{
+				// Served from the cache, the device is not accessed
+				pSrsp = &pSrspBuf->msg;
+				ret = NPI_LNX_SUCCESS;
 			}
 			else
 			{
 				uint8 sreqHdr[RPC_FRAME_HDR_SZ] = {0};
 				// Retain the header for later integrity check
 				memcpy(sreqHdr, recvBuf, RPC_FRAME_HDR_SZ);
+				// Retain read-only requests whole, so that identical ones from
+				// other clients can share the response
+				if (NPI_LNX_SreqCacheIsReadOnly(recvBuf) == TRUE)
+				{
+					memcpy(&sreqCopy, recvBuf, RPC_FRAME_HDR_SZ + recvBuf->len);
+					coalesce = TRUE;
+				}
 				// Synchronous request requires an answer...
-				ret = (NPI_SendSynchDataFnArr[serialCfg.devIdx])(recvBuf);
+				if (NPI_SendSynchBufFnArr[serialCfg.devIdx])
+				{
+					// ...which is sent on from the buffer the device driver received it in
+					ret = (NPI_SendSynchBufFnArr[serialCfg.devIdx])(recvBuf, &pSrspBuf);
+					if (pSrspBuf)
+					{
+						pSrsp = &pSrspBuf->msg;
+					}
+				}
+				else
+				{
+					ret = (NPI_SendSynchDataFnArr[serialCfg.devIdx])(recvBuf);
+				}
 				if ( (ret != NPI_LNX_SUCCESS) &&
 						( (npi_ipc_errno == NPI_LNX_ERROR_HAL_GPIO_WAIT_SRDY_CLEAR_POLL_TIMEDOUT) ||
 							(npi_ipc_errno == NPI_LNX_ERROR_HAL_GPIO_WAIT_SRDY_SET_POLL_TIMEDOUT) ))
@@ -1230,22 +1354,33 @@ static int NPI_LNX_IPC_ConnectionHandle(int connection, npiMsgData_t *recvBuf)
 					// Report this error to client through a pseudo response
 					recvBuf->len = 1;
 					recvBuf->pData[0] = 0xFF;
+					pSrsp = recvBuf;
 				}
 				else
 				{
 					// Capture incoherent SRSP, check type and subsystem
-					if ( (( recvBuf->subSys & ~(RPC_SUBSYSTEM_MASK)) != RPC_CMD_SRSP )
+					if ( (( pSrsp->subSys & ~(RPC_SUBSYSTEM_MASK)) != RPC_CMD_SRSP )
 						||
-						  (( recvBuf->subSys & (RPC_SUBSYSTEM_MASK)) != (sreqHdr[RPC_POS_CMD0] & RPC_SUBSYSTEM_MASK))
+						  (( pSrsp->subSys & (RPC_SUBSYSTEM_MASK)) != (sreqHdr[RPC_POS_CMD0] & RPC_SUBSYSTEM_MASK))
 						)
 					{
 						// Report this error to client through a pseudo response
+						pSrsp = recvBuf;
 						recvBuf->len = 1;
 						recvBuf->subSys = (sreqHdr[RPC_POS_CMD0] & RPC_SUBSYSTEM_MASK) | RPC_CMD_SRSP;
 						recvBuf->cmdId = sreqHdr[RPC_POS_CMD1];
 						recvBuf->pData[0] = 0xFF;
+						coalesce = FALSE;
+					}
+					else
+					{
+						NPI_LNX_SreqCacheStore(&sreqCacheKey, pSrsp, pSrspBuf);
 					}
 				}
+				if (ret != NPI_LNX_SUCCESS)
+				{
+					coalesce = FALSE;
+				}
 			}
 
 			if ( (ret == NPI_LNX_SUCCESS) ||
@@ -1253,36 +1388,60 @@ static int NPI_LNX_IPC_ConnectionHandle(int connection, npiMsgData_t *recvBuf)
 						(npi_ipc_errno == NPI_LNX_ERROR_HAL_GPIO_WAIT_SRDY_SET_POLL_TIMEDOUT) ||
 					(npi_ipc_errno == NPI_LNX_ERROR_HAL_DBG_IFC_WAIT_DUP_READY) )
 			{
-				n = ( (int)recvBuf->len + RPC_FRAME_HDR_SZ );
-
-				// Copy response into transmission buffer
-				memcpy(&sendBuf, recvBuf, n);
+				n = ( (int)pSrsp->len + RPC_FRAME_HDR_SZ );
 
-				// Command type is not set, so set it here
-				sendBuf.subSys |= RPC_CMD_SRSP;
+				// The response is sent from the buffer it was read into, the
+				// device driver's or the receive buffer.
+				if (pSrsp == recvBuf)
+				{
+					// Command type is not set, so set it here. A response held
+					// in a message buffer was checked to be a SRSP already.
+					recvBuf->subSys |= RPC_CMD_SRSP;
+				}
 
 				strLen = 0;
-				for (i = 0; i < sendBuf.len; i++)
+				for (i = 0; i < pSrsp->len; i++)
 				{
-					snprintf(tmpStr+strLen, sizeof(tmpStr)-strLen, "%02X ", sendBuf.pData[i]);
+					snprintf(tmpStr+strLen, sizeof(tmpStr)-strLen, "%02X ", pSrsp->pData[i]);
 					strLen += 3;
 				}
-				LOG_DEBUG("NPI SRSP:  (Total Len %d, Data Len %d, subSys 0x%02x, cmdId 0x%02x) PAYLOAD: %s\n", n, sendBuf.len, sendBuf.subSys, sendBuf.cmdId, tmpStr);
+				LOG_DEBUG("NPI SRSP:  (Total Len %d, Data Len %d, subSys 0x%02x, cmdId 0x%02x) PAYLOAD: %s\n", n, pSrsp->len, pSrsp->subSys, pSrsp->cmdId, tmpStr);
 
-				if (sendBuf.len == 0)
+				if (pSrsp->len == 0)
 				{
 					LOG_ERROR("SRSP is 0!\n");
 				}
 
 				//			pthread_mutex_lock(&npiSyncRespLock);
 				// Send bytes
-				ret = NPI_LNX_IPC_SendData(&sendBuf, connection);
+				ret = NPI_LNX_IPC_SendData(pSrsp, connection, corrId);
+
+				if (coalesce == TRUE)
+				{
+					// The same response goes to the other clients which asked for it
+					NPI_LNX_IPC_CoalesceSREQ(connection, &sreqCopy, pSrsp);
+				}
 			}
 			else
 			{
 				// Keep status from NPI_SendSynchDataFnArr
 				LOG_ERROR("SRSP: ret = 0x%.8X, npi_ipc_errno 0x%.8X\n", ret, npi_ipc_errno);
+
+				if (corrId >= 0)
+				{
+					// The client waits for this identifier, do not let it time out
+					int savedErrno = npi_ipc_errno;
+					recvBuf->len = 1;
+					recvBuf->subSys = (sreqSubSys & RPC_SUBSYSTEM_MASK) | RPC_CMD_SRSP;
+					recvBuf->cmdId = sreqCmdId;
+					recvBuf->pData[0] = 0xFF;
+					NPI_LNX_IPC_SendData(recvBuf, connection, corrId);
+					npi_ipc_errno = savedErrno;
+				}
 			}
+
+			// Sent to every client which waited for it, the cache keeps its own reference
+			NPI_LNX_MsgBufRelease(pSrspBuf);
 		}
 		else if ((recvBuf->subSys & RPC_CMD_TYPE_MASK) == RPC_CMD_AREQ)
 		{
@@ -1313,7 +1472,7 @@ static int NPI_LNX_IPC_ConnectionHandle(int connection, npiMsgData_t *recvBuf)
 				// Print caller ID
 				LOG_INFO("AREQ received from %d to control NPI Server\n", connection);
 				//AREQ Command send to this server.
-				ret = npi_ServerCmdHandle(recvBuf);
+				ret = npi_ServerCmdHandle(recvBuf, connection);
 			}
 			else
 			{
@@ -1347,11 +1506,6 @@ static int NPI_LNX_IPC_ConnectionHandle(int connection, npiMsgData_t *recvBuf)
 		LOG_ERROR("%s(): Received %d bytes when asked for %d (RPC_FRAME_HDR_SZ)\n", __FUNCTION__, n, RPC_FRAME_HDR_SZ);
 	}
 
-#if (defined __BIG_DEBUG__) && (__BIG_DEBUG__ == TRUE)
-	// This will effectively result in an echo
-	memcpy(&sendBuf, recvBuf, sizeof(sendBuf));
-#endif
-
 	if ((ret == (int)NPI_LNX_FAILURE) && (npi_ipc_errno == (int)NPI_LNX_ERROR_IPC_RECV_DATA_DISCONNECT))
 	{
 		LOG_DEBUG("Done with %d\n", connection);
@@ -1364,6 +1518,69 @@ static int NPI_LNX_IPC_ConnectionHandle(int connection, npiMsgData_t *recvBuf)
 	return ret;
 }
 
+/**************************************************************************************************
+ *
+ * @fn          NPI_LNX_IPC_CoalesceSREQ
+ *
+ * @brief       Answer read-only SREQs identical to one just served by the device. Only the
+ *              message at the head of each other connection is considered, so the order of
+ *              the responses seen by each client is preserved.
+ *
+ * input parameters
+ *
+ *    connection - connection the SREQ was received on
+ *		pSreq - SREQ as received from the client
+ *		pSrsp - SRSP sent to the client
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ *
+ **************************************************************************************************/
+static void NPI_LNX_IPC_CoalesceSREQ(int connection, const npiMsgData_t *pSreq, const npiMsgData_t *pSrsp)
+{
+	uint8 peekBuf[sizeof(npiMsgData_t) + 1];
+	int idx, c, idLen, size;
+	// A client going away here is dealt with on its own turn, do not report it for this one
+	int savedErrno = npi_ipc_errno;
+
+	// Walk backwards, NPI_LNX_IPC_SendData() may remove a connection from the list
+	for (idx = activeConnections.size - 1; idx >= 0; idx--)
+	{
+		c = activeConnections.list[idx];
+		if (c == connection)
+		{
+			continue;
+		}
+
+		// Compare around the correlation identifier, if this client sends one
+		idLen = (*activeListFeatures(c) & NPI_LNX_FEATURE_CORRELATION_ID) ? 1 : 0;
+		size = RPC_FRAME_HDR_SZ + idLen + pSreq->len;
+
+		while ((recv(c, peekBuf, size, MSG_PEEK | MSG_DONTWAIT) == size) &&
+				(memcmp(peekBuf, pSreq, RPC_FRAME_HDR_SZ) == 0) &&
+				(memcmp(&peekBuf[RPC_FRAME_HDR_SZ + idLen], pSreq->pData, pSreq->len) == 0))
+		{
+			if (recv(c, peekBuf, size, MSG_DONTWAIT) != size)
+			{
+				break;
+			}
+			sreqCoalescedCount++;
+			LOG_DEBUG("SREQ (subSys 0x%02x, cmdId 0x%02x) from #%d answered along with #%d\n",
+					pSreq->subSys, pSreq->cmdId, c, connection);
+
+			if (NPI_LNX_IPC_SendData(pSrsp, c, idLen ? peekBuf[RPC_FRAME_HDR_SZ] : -1) != NPI_LNX_SUCCESS)
+			{
+				break;
+			}
+		}
+	}
+
+	npi_ipc_errno = savedErrno;
+}
+
 /**************************************************************************************************
  *
  * @fn          NPI_LNX_IPC_SendData
@@ -1374,6 +1591,7 @@ static int NPI_LNX_IPC_ConnectionHandle(int connection, npiMsgData_t *recvBuf)
  *
  * @param          sendBuf                            - message to send
  * @param          connection                         - connection to send message (for synchronous response) otherwise -1 for all connections
+ * @param          corrId                             - correlation identifier of the request answered, -1 if none
  *
  * output parameters
  *
@@ -1382,7 +1600,7 @@ static int NPI_LNX_IPC_ConnectionHandle(int connection, npiMsgData_t *recvBuf)
  * @return      STATUS
  *
  **************************************************************************************************/
-static int NPI_LNX_IPC_SendData(npiMsgData_t const *sendBuf, int connection)
+static int NPI_LNX_IPC_SendData(npiMsgData_t const *sendBuf, int connection, int corrId)
 {
 	int bytesSent = 0, ix=0, ret = NPI_LNX_SUCCESS;
 	int len = (int)(sendBuf->len) + RPC_FRAME_HDR_SZ;
@@ -1493,9 +1711,32 @@ static int NPI_LNX_IPC_SendData(npiMsgData_t const *sendBuf, int connection)
 	}
 	else
 	{
+		uint8 id = (uint8)corrId;
+		struct iovec iov[3];
+		struct msghdr msg;
+
+		// Header, correlation identifier (if any) and payload are gathered
+		// by the socket, the message is not copied into a frame first
+		memset(&msg, 0, sizeof(msg));
+		iov[0].iov_base = (void *)sendBuf;
+		iov[0].iov_len = RPC_FRAME_HDR_SZ;
+		msg.msg_iov = iov;
+		msg.msg_iovlen = 1;
+		if (corrId >= 0)
+		{
+			// The correlation identifier goes right after the header
+			iov[msg.msg_iovlen].iov_base = &id;
+			iov[msg.msg_iovlen].iov_len = 1;
+			msg.msg_iovlen++;
+			len++;
+		}
+		iov[msg.msg_iovlen].iov_base = (void *)sendBuf->pData;
+		iov[msg.msg_iovlen].iov_len = sendBuf->len;
+		msg.msg_iovlen++;
+
 		// Send to specific connection only
 //		LOG_DEBUG("[AREQ] Sending message...\n");
-		bytesSent = send(connection, (char *)sendBuf, len, MSG_NOSIGNAL);
+		bytesSent = sendmsg(connection, &msg, MSG_NOSIGNAL);
 //		LOG_DEBUIG("[AREQ] Sent %d byte message...\n", bytesSent);
 
 		LOG_DEBUG("...sent %d bytes to Client #%d\n", bytesSent, connection);
@@ -1564,6 +1805,8 @@ int NPI_AsynchMsgCback(npiMsgData_t *pMsg)
 	}
 	LOG_DEBUG("\n");
 
+	// Reset indications drop the session scoped SREQ responses
+	NPI_LNX_SreqCacheAsynchMsg(pMsg);
 
 #ifdef __STRESS_TEST__
 
@@ -1599,7 +1842,7 @@ int NPI_AsynchMsgCback(npiMsgData_t *pMsg)
 	}
 #endif //__STRESS_TEST__
 
-	return NPI_LNX_IPC_SendData(pMsg, -1);
+	return NPI_LNX_IPC_SendData(pMsg, -1, -1);
 }
 
 
@@ -1631,6 +1874,7 @@ static void NPI_LNX_IPC_Exit(int ret, uint8 freeSerial)
 
 		// Write error message to /dev/npiLnxLog
 		writeToNpiLnxLog("Could not open device");
+		NPI_LNX_ErrLogFlush();
 
 		exit(npi_ipc_errno);
 	}
@@ -1657,133 +1901,169 @@ static void NPI_LNX_IPC_Exit(int ret, uint8 freeSerial)
 int NPI_LNX_IPC_NotifyError(uint16 source, const char* errorMsg)
 {
 	int ret = NPI_LNX_SUCCESS;
-	int sNPIconnected;
-#ifndef NPI_UNIX
-	struct addrinfo *resAddr;
-#endif //NPI_UNIX
-
-	const char *ipAddress = "127.0.0.1";
-
-
-	/**********************************************************************
-	 * Connect to the NPI server
-	 **********************************************************************/
+	npiIpcError_t *pError;
+	size_t len;
 
-#ifdef NPI_UNIX
-	int len;
-	struct sockaddr_un remote;
-
-	if ((sNPIconnected = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+	pthread_mutex_lock(&npiIpcErrorMutex);
+	if (npiIpcErrorCount == NPI_IPC_ERROR_QUEUE_SIZE)
 	{
-		perror("socket");
-		ret = NPI_LNX_ERROR_IPC_NOTIFY_ERR_CREATE_SOCKET;
-	}
-#else
-	struct addrinfo hints;
-
-	memset(&hints, 0, sizeof(hints));
-	hints.ai_family = AF_UNSPEC;
-	hints.ai_socktype = SOCK_STREAM;
-
-	//    ipAddress = "192.168.128.133";
-	//    if ((res = getaddrinfo(NULL, ipAddress, &hints, &resAddr)) != 0)
-	if (serialCfg.port == NULL)
-	{
-		// Fall back to default if port was not found in the configuration file
-		LOG_WARN("Port not sent to NPI_LNX_IPC_NotifyError. Will use default port: %s", NPI_PORT);
-		LOG_INFO("getaddrinfo: %s\n", gai_strerror(ret));
-		ret = NPI_LNX_ERROR_IPC_NOTIFY_ERR_GET_ADDR_INFO;
+		// The main loop is behind, it will report how many were lost
+		npiIpcErrorDropped++;
+		ret = NPI_LNX_ERROR_IPC_NOTIFY_ERR_QUEUE_FULL;
 	}
 	else
 	{
-		LOG_DEBUG("[NOTIFY_ERROR] Port: %s\n", serialCfg.port);
-		if ((ret = getaddrinfo(ipAddress, serialCfg.port, &hints, &resAddr)) != 0)
+		pError = &npiIpcErrorQueue[(npiIpcErrorHead + npiIpcErrorCount) % NPI_IPC_ERROR_QUEUE_SIZE];
+		pError->source = source;
+		// Take the error now, the thread may go on and change it
+		pError->errorCode = npi_ipc_errno;
+		snprintf(pError->msg, sizeof(pError->msg), "%s", errorMsg);
+		// If last character is \n then remove it.
+		len = strlen(pError->msg);
+		if ((len > 0) && (pError->msg[len - 1] == '\n'))
 		{
-			LOG_INFO("getaddrinfo: %s\n", gai_strerror(ret));
-			ret = NPI_LNX_ERROR_IPC_NOTIFY_ERR_GET_ADDR_INFO;
-		}
-		else
-		{
-			ret = NPI_LNX_SUCCESS;
+			pError->msg[len - 1] = 0;
 		}
+		npiIpcErrorCount++;
 	}
+	pthread_mutex_unlock(&npiIpcErrorMutex);
 
-
-	if ((sNPIconnected = socket(resAddr->ai_family, resAddr->ai_socktype, resAddr->ai_protocol)) == -1)
+	if ((ret == NPI_LNX_SUCCESS) && (eventfd_write(npiIpcErrorFd, 1) < 0))
 	{
-		perror("socket");
-		ret = NPI_LNX_ERROR_IPC_NOTIFY_ERR_CREATE_SOCKET;
+		LOG_ERROR("[NOTIFY_ERROR] Could not wake up main loop, errno %d\n", errno);
 	}
-#endif
 
-	LOG_DEBUG("[NOTIFY] Trying to connect...\n");
-
-#ifdef NPI_UNIX
-	remote.sun_family = AF_UNIX;
-	strcpy(remote.sun_path, ipAddress);
-	len = strlen(remote.sun_path) + sizeof(remote.sun_family);
-	if (connect(sNPIconnected, (struct sockaddr *)&remote, len) == -1)
-	{
-		perror("connect");
-		ret = NPI_LNX_ERROR_IPC_NOTIFY_ERR_CONNECT;
-	}
-#else
-	if (connect(sNPIconnected, resAddr->ai_addr, resAddr->ai_addrlen) == -1)
-	{
-		perror("connect");
-		ret = NPI_LNX_ERROR_IPC_NOTIFY_ERR_CONNECT;
-	}
-#endif
+	return ret;
+}
 
-	if (ret == NPI_LNX_SUCCESS)
-		LOG_DEBUG("[NOTIFY] Connected.\n");
+/**************************************************************************************************
+ * @fn          npiIpcProcessErrors
+ *
+ * @brief       Handle the errors queued by NPI_LNX_IPC_NotifyError(). Warnings are logged,
+ *              other errors are logged and stop the server. A requested reset reconnects
+ *              the device.
+ *
+ * input parameters
+ *
+ * @param       toNpiLnxLog	- buffer of AP_MAX_BUF_LEN bytes for the log message
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      NPI_LNX_SUCCESS, NPI_LNX_FAILURE if a thread reported a fatal error
+ **************************************************************************************************
+ */
+static int npiIpcProcessErrors(char *toNpiLnxLog)
+{
+	int ret = NPI_LNX_SUCCESS;
+	npiIpcError_t error;
+	uint32 dropped;
+	eventfd_t wakeups;
 
+	eventfd_read(npiIpcErrorFd, &wakeups);
 
-	int no = 0;
-	// allow out-of-band data
-	if (setsockopt(sNPIconnected, SOL_SOCKET, SO_OOBINLINE, &no, sizeof(int)) == -1)
+	for (;;)
 	{
-		perror("setsockopt");
-		ret = NPI_LNX_ERROR_IPC_NOTIFY_ERR_SET_SOCKET_OPTIONS;
-	}
+		pthread_mutex_lock(&npiIpcErrorMutex);
+		if (npiIpcErrorCount == 0)
+		{
+			pthread_mutex_unlock(&npiIpcErrorMutex);
+			break;
+		}
+		error = npiIpcErrorQueue[npiIpcErrorHead];
+		npiIpcErrorHead = (npiIpcErrorHead + 1) % NPI_IPC_ERROR_QUEUE_SIZE;
+		npiIpcErrorCount--;
+		dropped = npiIpcErrorDropped;
+		npiIpcErrorDropped = 0;
+		pthread_mutex_unlock(&npiIpcErrorMutex);
+
+		if (dropped)
+		{
+			LOG_WARN("[NOTIFY_ERROR] %u error notifications were dropped\n", dropped);
+		}
 
-	npiMsgData_t msg;
+		npi_ipc_errno = error.errorCode;
+		if (npi_ipc_errno == NPI_LNX_SUCCESS)
+		{
+			// Do not report and abort if there is no real error.
+			continue;
+		}
 
-	if (strlen(errorMsg) <= AP_MAX_BUF_LEN)
-	{
-		memcpy(msg.pData, errorMsg, strlen(errorMsg));
-	}
-	else
-	{
-		errorMsg = "Default msg. Requested msg too long.\n";
-		memcpy(msg.pData, errorMsg, strlen(errorMsg));
-		LOG_WARN("[NOTIFY_ERROR] Size of error message too long (%zd, max %d).\n",
-				strlen(errorMsg),
-				AP_MAX_BUF_LEN);
-	}
-	// If last character is \n then remove it.
-	if ((msg.pData[strlen(errorMsg) - 1]) == '\n')
-	{
-		msg.pData[strlen(errorMsg) - 1] = 0;
-		msg.len = strlen(errorMsg);
-	}
-	else
-	{
-		msg.pData[strlen(errorMsg)] = 0;
-		msg.len = strlen(errorMsg) + 1;
-	}
+		// Everything about the error can be found in the message, and in npi_ipc_errno:
+		snprintf(toNpiLnxLog, AP_MAX_BUF_LEN, "Child thread with ID %d in module %d reported error:\t%.180s",
+				NPI_LNX_ERROR_THREAD(error.source),
+				NPI_LNX_ERROR_MODULE(error.source),
+				error.msg);
+		if (!NPI_LNX_ERROR_JUST_WARNING(npi_ipc_errno))
+		{
+			LOG_ERROR("npi_ipc_errno 0x%.8X\n", npi_ipc_errno);
+			ret = NPI_LNX_FAILURE;
+		}
+		writeToNpiLnxLog(toNpiLnxLog);
 
-	// For now the only required info here is command type.
-	msg.subSys = RPC_CMD_NOTIFY_ERR;
-	// CmdId is filled with the source identifier.
-	msg.cmdId = source;
+		// Check if error requested a reset
+		if (NPI_LNX_ERROR_RESET_REQUESTED(npi_ipc_errno))
+		{
+			npiIpcResetDevice();
+		}
 
-	send(sNPIconnected, &msg, msg.len + RPC_FRAME_HDR_SZ, MSG_NOSIGNAL);
+		if (ret != NPI_LNX_SUCCESS)
+		{
+			break;
+		}
+	}
 
 	return ret;
 }
 
-static int npi_ServerCmdHandle(npiMsgData_t *pNpi_ipc_buf)
+/**************************************************************************************************
+ * @fn          npiIpcResetDevice
+ *
+ * @brief       Reset the device on request of an error, by disconnecting and connecting it
+ *              again so that the driver threads are kept synchronized.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None
+ **************************************************************************************************
+ */
+static void npiIpcResetDevice(void)
+{
+	// Utilize server control API to reset current device
+	npiMsgData_t npi_ipc_buf_tmp;
+	int localRet = NPI_LNX_SUCCESS;
+	LOG_WARN("Reset was requested, so try to disconnect device %d\n", serialCfg.devIdx);
+	npi_ipc_buf_tmp.cmdId = NPI_LNX_CMD_ID_DISCONNECT_DEVICE;
+	localRet = npi_ServerCmdHandle((npiMsgData_t *)&npi_ipc_buf_tmp, -1);
+	LOG_WARN("Disconnection from device %d was %s\n", serialCfg.devIdx, (localRet == NPI_LNX_SUCCESS) ? "successful" : "unsuccessful");
+	if (localRet == NPI_LNX_SUCCESS)
+	{
+		LOG_WARN("Then try to connect device %d again\n", serialCfg.devIdx);
+		int bigDebugWas = __BIG_DEBUG_ACTIVE;
+		if (bigDebugWas == FALSE)
+		{
+			__BIG_DEBUG_ACTIVE = TRUE;
+			LOG_ALWAYS("__BIG_DEBUG_ACTIVE set to TRUE\n");
+		}
+		npi_ipc_buf_tmp.cmdId = NPI_LNX_CMD_ID_CONNECT_DEVICE;
+		localRet = npi_ServerCmdHandle((npiMsgData_t *)&npi_ipc_buf_tmp, -1);
+		LOG_WARN("Reconnection to device %d was %s\n", serialCfg.devIdx, (localRet == NPI_LNX_SUCCESS) ? "successful" : "unsuccessful");
+		if (bigDebugWas == FALSE)
+		{
+			__BIG_DEBUG_ACTIVE = FALSE;
+			LOG_ALWAYS("__BIG_DEBUG_ACTIVE set to FALSE\n");
+		}
+	}
+}
+
+static int npi_ServerCmdHandle(npiMsgData_t *pNpi_ipc_buf, int connection)
 {
 	int ret = NPI_LNX_SUCCESS;
 
@@ -1818,8 +2098,21 @@ static int npi_ServerCmdHandle(npiMsgData_t *pNpi_ipc_buf)
 			break;
 
 		case NPI_LNX_CMD_ID_VERSION_REQ:
+			if ((pNpi_ipc_buf->len >= 1) && (connection >= 0))
+			{
+				// Client asks for protocol features, grant those supported.
+				// They apply from the next message on.
+				uint8 *pFeatures = activeListFeatures(connection);
+				*pFeatures = pNpi_ipc_buf->pData[0] & NPI_LNX_FEATURES_SUPPORTED;
+				pNpi_ipc_buf->len = 5;
+				pNpi_ipc_buf->pData[4] = *pFeatures;
+				LOG_INFO("Connection #%d uses protocol features 0x%.2X\n", connection, *pFeatures);
+			}
+			else
+			{
+				pNpi_ipc_buf->len = 4;
+			}
 			// Set return status
-			pNpi_ipc_buf->len = 4;
 			pNpi_ipc_buf->pData[0] = NPI_LNX_SUCCESS;
 			pNpi_ipc_buf->pData[1] = NPI_LNX_MAJOR_VERSION;
 			pNpi_ipc_buf->pData[2] = NPI_LNX_MINOR_VERSION;
@@ -1851,6 +2144,144 @@ static int npi_ServerCmdHandle(npiMsgData_t *pNpi_ipc_buf)
 					ret = NPI_LNX_SUCCESS;
 					break;
 
+				case NPI_LNX_PARAM_IDLE_WAKEUPS:
+				{
+					int idx;
+					uint32 count;
+
+					pNpi_ipc_buf->len = 1 + (4 * NPI_LNX_SCHED_THREAD_COUNT);
+					pNpi_ipc_buf->pData[0] = NPI_LNX_SUCCESS;
+					for (idx = 0; idx < NPI_LNX_SCHED_THREAD_COUNT; idx++)
+					{
+						count = NPI_LNX_SchedGetIdleWakeups((npiSchedThread_t)idx);
+						pNpi_ipc_buf->pData[1 + (4 * idx)] = (uint8)count;
+						pNpi_ipc_buf->pData[2 + (4 * idx)] = (uint8)(count >> 8);
+						pNpi_ipc_buf->pData[3 + (4 * idx)] = (uint8)(count >> 16);
+						pNpi_ipc_buf->pData[4 + (4 * idx)] = (uint8)(count >> 24);
+					}
+
+					ret = NPI_LNX_SUCCESS;
+					break;
+				}
+
+#if (defined NPI_UART) && (NPI_UART == TRUE)
+				case NPI_LNX_PARAM_SLEEP_GOVERNOR:
+				{
+					npiUartSleepStats_t sleepStats;
+					uint32 *pValue = (uint32 *)&sleepStats;
+					int idx;
+
+					// Statistics stay zero unless a UART device with the sleep governor is open
+					if ((serialCfg.devIdx == NPI_SERVER_DEVICE_INDEX_UART) ||
+						(serialCfg.devIdx == NPI_SERVER_DEVICE_INDEX_UART_USB))
+					{
+						NPI_UART_GetSleepStats(&sleepStats);
+					}
+					else
+					{
+						memset(&sleepStats, 0, sizeof(sleepStats));
+					}
+
+					pNpi_ipc_buf->len = 1 + sizeof(sleepStats);
+					pNpi_ipc_buf->pData[0] = NPI_LNX_SUCCESS;
+					for (idx = 0; idx < (int)(sizeof(sleepStats) / sizeof(uint32)); idx++)
+					{
+						pNpi_ipc_buf->pData[1 + (4 * idx)] = (uint8)pValue[idx];
+						pNpi_ipc_buf->pData[2 + (4 * idx)] = (uint8)(pValue[idx] >> 8);
+						pNpi_ipc_buf->pData[3 + (4 * idx)] = (uint8)(pValue[idx] >> 16);
+						pNpi_ipc_buf->pData[4 + (4 * idx)] = (uint8)(pValue[idx] >> 24);
+					}
+
+					ret = NPI_LNX_SUCCESS;
+					break;
+				}
+#endif
+
+				case NPI_LNX_PARAM_SREQ_CACHE:
+				{
+					uint32 value[4];
+					int idx;
+
+					NPI_LNX_SreqCacheGetStats(&value[0], &value[1], &value[2]);
+					value[3] = sreqCoalescedCount;
+					pNpi_ipc_buf->len = 1 + sizeof(value);
+					pNpi_ipc_buf->pData[0] = NPI_LNX_SUCCESS;
+					for (idx = 0; idx < 4; idx++)
+					{
+						pNpi_ipc_buf->pData[1 + (4 * idx)] = (uint8)value[idx];
+						pNpi_ipc_buf->pData[2 + (4 * idx)] = (uint8)(value[idx] >> 8);
+						pNpi_ipc_buf->pData[3 + (4 * idx)] = (uint8)(value[idx] >> 16);
+						pNpi_ipc_buf->pData[4 + (4 * idx)] = (uint8)(value[idx] >> 24);
+					}
+
+					ret = NPI_LNX_SUCCESS;
+					break;
+				}
+
+				case NPI_LNX_PARAM_QOS:
+				{
+					uint32 value[3 * NPI_LNX_QOS_NUM_CLASSES];
+					int idx;
+
+					for (idx = 0; idx < NPI_LNX_QOS_NUM_CLASSES; idx++)
+					{
+						NPI_LNX_QosGetStats(idx, &value[3 * idx], &value[(3 * idx) + 1], &value[(3 * idx) + 2]);
+					}
+					pNpi_ipc_buf->len = 1 + sizeof(value);
+					pNpi_ipc_buf->pData[0] = NPI_LNX_SUCCESS;
+					for (idx = 0; idx < (3 * NPI_LNX_QOS_NUM_CLASSES); idx++)
+					{
+						pNpi_ipc_buf->pData[1 + (4 * idx)] = (uint8)value[idx];
+						pNpi_ipc_buf->pData[2 + (4 * idx)] = (uint8)(value[idx] >> 8);
+						pNpi_ipc_buf->pData[3 + (4 * idx)] = (uint8)(value[idx] >> 16);
+						pNpi_ipc_buf->pData[4 + (4 * idx)] = (uint8)(value[idx] >> 24);
+					}
+
+					ret = NPI_LNX_SUCCESS;
+					break;
+				}
+
+				case NPI_LNX_PARAM_MSG_BUFFERS:
+				{
+					uint32 value[5];
+					int idx;
+
+					NPI_LNX_MsgBufGetStats(&value[0], &value[1], &value[2], &value[3], &value[4]);
+					pNpi_ipc_buf->len = 1 + sizeof(value);
+					pNpi_ipc_buf->pData[0] = NPI_LNX_SUCCESS;
+					for (idx = 0; idx < 5; idx++)
+					{
+						pNpi_ipc_buf->pData[1 + (4 * idx)] = (uint8)value[idx];
+						pNpi_ipc_buf->pData[2 + (4 * idx)] = (uint8)(value[idx] >> 8);
+						pNpi_ipc_buf->pData[3 + (4 * idx)] = (uint8)(value[idx] >> 16);
+						pNpi_ipc_buf->pData[4 + (4 * idx)] = (uint8)(value[idx] >> 24);
+					}
+
+					ret = NPI_LNX_SUCCESS;
+					break;
+				}
+
+				case NPI_LNX_PARAM_AREQ_DISPATCH:
+				{
+					uint32 value[8];
+					int idx;
+
+					NPI_LNX_DispatchGetStats(&value[0], &value[1], &value[2], &value[3],
+							&value[4], &value[5], &value[6], &value[7]);
+					pNpi_ipc_buf->len = 1 + sizeof(value);
+					pNpi_ipc_buf->pData[0] = NPI_LNX_SUCCESS;
+					for (idx = 0; idx < 8; idx++)
+					{
+						pNpi_ipc_buf->pData[1 + (4 * idx)] = (uint8)value[idx];
+						pNpi_ipc_buf->pData[2 + (4 * idx)] = (uint8)(value[idx] >> 8);
+						pNpi_ipc_buf->pData[3 + (4 * idx)] = (uint8)(value[idx] >> 16);
+						pNpi_ipc_buf->pData[4 + (4 * idx)] = (uint8)(value[idx] >> 24);
+					}
+
+					ret = NPI_LNX_SUCCESS;
+					break;
+				}
+
 				default:
 					npi_ipc_errno = NPI_LNX_ERROR_IPC_RECV_DATA_INVALID_GET_PARAM_CMD;
 					ret = NPI_LNX_FAILURE;
@@ -1859,6 +2290,7 @@ static int npi_ServerCmdHandle(npiMsgData_t *pNpi_ipc_buf)
 			break;
 
 		case NPI_LNX_CMD_ID_RESET_DEVICE:
+			NPI_LNX_SreqCacheInvalidate(NPI_LNX_SREQ_CACHE_IMMUTABLE);
 			if (serialCfg.devIdx == NPI_SERVER_DEVICE_INDEX_SPI)
 			{
 				// Perform Reset of the RNP
@@ -1891,6 +2323,7 @@ static int npi_ServerCmdHandle(npiMsgData_t *pNpi_ipc_buf)
 
 		case NPI_LNX_CMD_ID_DISCONNECT_DEVICE:
 			LOG_DEBUG("Trying to disconnect device %d\n", serialCfg.devIdx);
+			NPI_LNX_SreqCacheInvalidate(NPI_LNX_SREQ_CACHE_IMMUTABLE);
 			(NPI_CloseDeviceFnArr[serialCfg.devIdx])();
 			LOG_DEBUG("Preparing return message after disconnecting device %d\n", serialCfg.devIdx);
 			pNpi_ipc_buf->len = 1;
@@ -1899,6 +2332,7 @@ static int npi_ServerCmdHandle(npiMsgData_t *pNpi_ipc_buf)
 
 		case NPI_LNX_CMD_ID_CONNECT_DEVICE:
 			LOG_DEBUG("Trying to connect to device %d, %s\n", serialCfg.devIdx, serialCfg.devPath);
+			NPI_LNX_SreqCacheInvalidate(NPI_LNX_SREQ_CACHE_IMMUTABLE);
 			switch(serialCfg.devIdx)
 			{
 				case NPI_SERVER_DEVICE_INDEX_UART_USB:
@@ -1942,7 +2376,7 @@ static int npi_ServerCmdHandle(npiMsgData_t *pNpi_ipc_buf)
 //					resetBuf->len = 0;
 //					resetBuf->subSys = 0x4A;
 //					resetBuf->cmdId = 0x0D;
-//					NPI_LNX_IPC_SendData(resetBuf, -1);
+//					NPI_LNX_IPC_SendData(resetBuf, -1, -1);
 //					free(resetBuf);
 				#endif
 					break;
@@ -1965,6 +2399,14 @@ static int npi_ServerCmdHandle(npiMsgData_t *pNpi_ipc_buf)
 			pNpi_ipc_buf->pData[0] = ret;
 			break; // End case NPI_LNX_CMD_ID_CONNECT_DEVICE
 
+		case NPI_LNX_CMD_ID_SET_QOS_CLASS:
+			// Only a client can have its class changed
+			pNpi_ipc_buf->pData[0] = (uint8)((connection < 0) ? NPI_LNX_FAILURE :
+					NPI_LNX_QosSetClass(connection, pNpi_ipc_buf->pData[0]));
+			pNpi_ipc_buf->len = 1;
+			ret = NPI_LNX_SUCCESS;
+			break;
+
 		default:
 			npi_ipc_errno = NPI_LNX_ERROR_IPC_RECV_DATA_INVALID_SREQ;
 			ret = NPI_LNX_FAILURE;
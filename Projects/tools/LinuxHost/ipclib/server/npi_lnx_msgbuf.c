@@ -0,0 +1,300 @@
+/**************************************************************************************************
+  Filename:       npi_lnx_msgbuf.c
+  Revised:        $Date: 2016-05-12 10:12:31 -0700 (Thu, 12 May 2016) $
+  Revision:       $Revision: 1 $
+
+  Description:    This file contains the pool of reference counted message buffers
+                  which carry NPI frames from the device drivers to the clients.
+
+
+  Copyright (C) {2016} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**************************************************************************************************/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "npi_lnx.h"
+#include "npi_lnx_msgbuf.h"
+#include "npi_lnx_serial_configuration.h"
+#include "npi_lnx_error.h"
+#include "tiLogging.h"
+
+// -- Local Variables --
+
+static int npiMsgBufPoolSize = NPI_LNX_MSGBUF_POOL_SIZE_DEFAULT;
+
+// Buffers are taken by the device threads and returned by whichever thread
+// drops the last reference.
+static pthread_mutex_t npiMsgBufLock = PTHREAD_MUTEX_INITIALIZER;
+static npiMsgBuf_t *npiMsgBufPool = NULL;		// allocated on first use
+static npiMsgBuf_t *npiMsgBufFreeList = NULL;
+
+static uint32 npiMsgBufInUse = 0;
+static uint32 npiMsgBufPeak = 0;
+static uint32 npiMsgBufAllocs = 0;
+static uint32 npiMsgBufHeapAllocs = 0;
+
+// -- Forward references of local functions --
+
+static void npiMsgBufCreatePool(void);
+
+// -- Public functions --
+
+/******************************************************************************
+ * @fn         NPI_LNX_MsgBufReadConfiguration
+ *
+ * @brief      This function reads the optional [MSGBUF] section of the
+ *             configuration file.
+ *
+ * input parameters
+ *
+ * @param      serialCfgFd	- open configuration file
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     NPI_LNX_SUCCESS
+ ******************************************************************************
+ */
+int NPI_LNX_MsgBufReadConfiguration(FILE *serialCfgFd)
+{
+	char strBuf[128];
+	long value;
+
+	if (NPI_LNX_SUCCESS == SerialConfigParser(serialCfgFd, "MSGBUF", "poolSize", strBuf))
+	{
+		value = strtol(strBuf, NULL, 0);
+		if ((value < 1) || (value > NPI_LNX_MSGBUF_POOL_SIZE_MAX))
+		{
+			LOG_WARN("[MSGBUF] Ignoring poolSize %ld, must be 1..%d\n", value, NPI_LNX_MSGBUF_POOL_SIZE_MAX);
+		}
+		else
+		{
+			npiMsgBufPoolSize = (int)value;
+			LOG_INFO("[MSGBUF] %d buffers\n", npiMsgBufPoolSize);
+		}
+	}
+
+	return NPI_LNX_SUCCESS;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_MsgBufAlloc
+ *
+ * @brief      Take a buffer from the pool, with one reference held by the
+ *             caller. When the pool is empty the buffer is allocated from
+ *             the heap instead.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     The buffer, NULL if out of memory.
+ ******************************************************************************
+ */
+npiMsgBuf_t *NPI_LNX_MsgBufAlloc(void)
+{
+	npiMsgBuf_t *pBuf;
+
+	pthread_mutex_lock(&npiMsgBufLock);
+	if (npiMsgBufPool == NULL)
+	{
+		npiMsgBufCreatePool();
+	}
+
+	pBuf = npiMsgBufFreeList;
+	if (pBuf != NULL)
+	{
+		npiMsgBufFreeList = pBuf->pNext;
+	}
+	else
+	{
+		pBuf = (npiMsgBuf_t *)malloc(sizeof(npiMsgBuf_t));
+		if (pBuf == NULL)
+		{
+			pthread_mutex_unlock(&npiMsgBufLock);
+			LOG_ERROR("[MSGBUF] Out of memory\n");
+			return NULL;
+		}
+		pBuf->pooled = FALSE;
+		npiMsgBufHeapAllocs++;
+	}
+
+	npiMsgBufAllocs++;
+	if (++npiMsgBufInUse > npiMsgBufPeak)
+	{
+		npiMsgBufPeak = npiMsgBufInUse;
+	}
+	pthread_mutex_unlock(&npiMsgBufLock);
+
+	pBuf->pNext = NULL;
+	pBuf->refCount = 1;
+
+	return pBuf;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_MsgBufHold
+ *
+ * @brief      Take one more reference on a buffer. The message must not be
+ *             changed while more than one reference is held.
+ *
+ * input parameters
+ *
+ * @param      pBuf		- buffer the caller holds a reference on
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+void NPI_LNX_MsgBufHold(npiMsgBuf_t *pBuf)
+{
+	__sync_add_and_fetch(&pBuf->refCount, 1);
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_MsgBufRelease
+ *
+ * @brief      Drop a reference on a buffer, the last one returns it to the
+ *             pool, or to the heap.
+ *
+ * input parameters
+ *
+ * @param      pBuf		- buffer, may be NULL
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+void NPI_LNX_MsgBufRelease(npiMsgBuf_t *pBuf)
+{
+	if ((pBuf == NULL) || (__sync_sub_and_fetch(&pBuf->refCount, 1) != 0))
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&npiMsgBufLock);
+	npiMsgBufInUse--;
+	if (pBuf->pooled)
+	{
+		pBuf->pNext = npiMsgBufFreeList;
+		npiMsgBufFreeList = pBuf;
+		pBuf = NULL;
+	}
+	pthread_mutex_unlock(&npiMsgBufLock);
+
+	free(pBuf);
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_MsgBufGetStats
+ *
+ * @brief      Read the pool occupancy.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * @param      pSize			- buffers in the pool
+ * @param      pInUse			- buffers currently held, pooled or not
+ * @param      pPeak			- highest pInUse seen
+ * @param      pAllocs		- buffers handed out
+ * @param      pHeapAllocs	- of which allocated from the heap, pool empty
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+void NPI_LNX_MsgBufGetStats(uint32 *pSize, uint32 *pInUse, uint32 *pPeak,
+		uint32 *pAllocs, uint32 *pHeapAllocs)
+{
+	pthread_mutex_lock(&npiMsgBufLock);
+	*pSize = npiMsgBufPool ? npiMsgBufPoolSize : 0;
+	*pInUse = npiMsgBufInUse;
+	*pPeak = npiMsgBufPeak;
+	*pAllocs = npiMsgBufAllocs;
+	*pHeapAllocs = npiMsgBufHeapAllocs;
+	pthread_mutex_unlock(&npiMsgBufLock);
+}
+
+// -- Local functions --
+
+/******************************************************************************
+ * @fn         npiMsgBufCreatePool
+ *
+ * @brief      Allocate the pool and chain its buffers in the free list. If
+ *             this fails every buffer comes from the heap.
+ *             Must be called with npiMsgBufLock held.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+static void npiMsgBufCreatePool(void)
+{
+	int idx;
+
+	npiMsgBufPool = (npiMsgBuf_t *)calloc(npiMsgBufPoolSize, sizeof(npiMsgBuf_t));
+	if (npiMsgBufPool == NULL)
+	{
+		LOG_ERROR("[MSGBUF] Could not allocate %d buffers\n", npiMsgBufPoolSize);
+		npiMsgBufPoolSize = 0;
+		return;
+	}
+
+	for (idx = npiMsgBufPoolSize - 1; idx >= 0; idx--)
+	{
+		npiMsgBufPool[idx].pooled = TRUE;
+		npiMsgBufPool[idx].pNext = npiMsgBufFreeList;
+		npiMsgBufFreeList = &npiMsgBufPool[idx];
+	}
+}
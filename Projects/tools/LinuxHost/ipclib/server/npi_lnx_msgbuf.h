@@ -0,0 +1,186 @@
+/**************************************************************************************************
+  Filename:       npi_lnx_msgbuf.h
+  Revised:        $Date: 2016-05-12 10:12:31 -0700 (Thu, 12 May 2016) $
+  Revision:       $Revision: 1 $
+
+  Description:    This file defines the pool of reference counted message buffers
+                  which carry NPI frames from the device drivers to the clients.
+
+
+  Copyright (C) {2016} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**************************************************************************************************/
+#ifndef NPI_MSGBUF_LNX_H
+#define NPI_MSGBUF_LNX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "hal_types.h"
+#include "npi_lnx.h"
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Constants
+
+  // Buffers preallocated when the configuration does not say otherwise
+#define NPI_LNX_MSGBUF_POOL_SIZE_DEFAULT	64
+#define NPI_LNX_MSGBUF_POOL_SIZE_MAX		1024
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Typedefs
+
+  // A frame is written once into msg by the driver which receives it, and is
+  // read only from then on. Every holder which keeps it beyond the call it
+  // was handed in takes a reference, the last NPI_LNX_MsgBufRelease() gives
+  // it back to the pool.
+  typedef struct npiMsgBuf_s
+  {
+	  struct npiMsgBuf_s *pNext;	// free for use while a single reference is held
+	  uint32 refCount;
+	  uint8 pooled;					// FALSE if allocated because the pool was empty
+	  npiMsgData_t msg;
+  } npiMsgBuf_t;
+
+  // Buffer holding a message handed out by NPI_LNX_MsgBufAlloc()
+#define NPI_LNX_MSGBUF_FROM_MSG(pMsg)	((npiMsgBuf_t *)((uint8 *)(pMsg) - offsetof(npiMsgBuf_t, msg)))
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Interface function prototypes
+
+  /******************************************************************************
+   * @fn         NPI_LNX_MsgBufReadConfiguration
+   *
+   * @brief      This function reads the optional [MSGBUF] section of the
+   *             configuration file.
+   *
+   * input parameters
+   *
+   * @param      serialCfgFd	- open configuration file
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     NPI_LNX_SUCCESS
+   ******************************************************************************
+   */
+  extern int NPI_LNX_MsgBufReadConfiguration(FILE *serialCfgFd);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_MsgBufAlloc
+   *
+   * @brief      Take a buffer from the pool, with one reference held by the
+   *             caller. When the pool is empty the buffer is allocated from
+   *             the heap instead.
+   *
+   * input parameters
+   *
+   * None.
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     The buffer, NULL if out of memory.
+   ******************************************************************************
+   */
+  extern npiMsgBuf_t *NPI_LNX_MsgBufAlloc(void);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_MsgBufHold
+   *
+   * @brief      Take one more reference on a buffer. The message must not be
+   *             changed while more than one reference is held.
+   *
+   * input parameters
+   *
+   * @param      pBuf		- buffer the caller holds a reference on
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     None.
+   ******************************************************************************
+   */
+  extern void NPI_LNX_MsgBufHold(npiMsgBuf_t *pBuf);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_MsgBufRelease
+   *
+   * @brief      Drop a reference on a buffer, the last one returns it to the
+   *             pool, or to the heap.
+   *
+   * input parameters
+   *
+   * @param      pBuf		- buffer, may be NULL
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     None.
+   ******************************************************************************
+   */
+  extern void NPI_LNX_MsgBufRelease(npiMsgBuf_t *pBuf);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_MsgBufGetStats
+   *
+   * @brief      Read the pool occupancy.
+   *
+   * input parameters
+   *
+   * None.
+   *
+   * output parameters
+   *
+   * @param      pSize			- buffers in the pool
+   * @param      pInUse			- buffers currently held, pooled or not
+   * @param      pPeak			- highest pInUse seen
+   * @param      pAllocs		- buffers handed out
+   * @param      pHeapAllocs	- of which allocated from the heap, pool empty
+   *
+   * @return     None.
+   ******************************************************************************
+   */
+  extern void NPI_LNX_MsgBufGetStats(uint32 *pSize, uint32 *pInUse, uint32 *pPeak,
+		  uint32 *pAllocs, uint32 *pHeapAllocs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NPI_MSGBUF_LNX_H
@@ -0,0 +1,512 @@
+/**************************************************************************************************
+  Filename:       npi_lnx_qos.c
+  Revised:        $Date: 2016-05-12 10:12:31 -0700 (Thu, 12 May 2016) $
+  Revision:       $Revision: 1 $
+
+  Description:    This file contains the NPI server scheduler which decides in which
+                  order client messages are passed to the device.
+
+
+  Copyright (C) {2016} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**************************************************************************************************/
+
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include "npi_lnx.h"
+#include "npi_lnx_qos.h"
+#include "npi_lnx_ipc_rpc.h"
+#include "npi_lnx_serial_configuration.h"
+#include "npi_lnx_error.h"
+#include "tiLogging.h"
+
+// -- Constants --
+
+// At least the size of the server connection list
+#define NPI_QOS_MAX_CONNECTIONS			32
+
+// Bytes a connection may send per round-robin turn, one full message by default
+#define NPI_QOS_DEFAULT_QUANTUM			(RPC_FRAME_HDR_SZ + AP_MAX_BUF_LEN)
+
+// Messages handed out before NPI_LNX_QosNext() lets the server go back to select()
+#define NPI_QOS_BURST					16
+
+// -- Typedefs --
+
+typedef struct
+{
+	int fd;
+	uint8 qosClass;
+	uint8 pending;					// a message is at the head of the socket
+	int deficit;					// bytes left in the current turn
+	struct timespec readySince;		// when the pending message was first seen
+} npiQosConnection_t;
+
+typedef struct
+{
+	uint32 count;
+	unsigned long long totalUs;
+	uint32 maxUs;
+} npiQosStats_t;
+
+// -- Local Variables --
+
+// Only used from the server main thread, so there is no locking
+static npiQosConnection_t npiQosConnections[NPI_QOS_MAX_CONNECTIONS];
+static int npiQosNumConnections = 0;
+
+static int npiQosQuantum[NPI_LNX_QOS_NUM_CLASSES] =
+{
+		NPI_QOS_DEFAULT_QUANTUM, NPI_QOS_DEFAULT_QUANTUM, NPI_QOS_DEFAULT_QUANTUM
+};
+static const char * const npiQosQuantumKeys[NPI_LNX_QOS_NUM_CLASSES] =
+{
+		"interactiveQuantum", "normalQuantum", "bulkQuantum"
+};
+
+// Round-robin position of each class, the connection whose turn it is
+static int npiQosCursor[NPI_LNX_QOS_NUM_CLASSES] = { -1, -1, -1 };
+
+static int npiQosBurst = 0;
+
+static npiQosStats_t npiQosStats[NPI_LNX_QOS_NUM_CLASSES];
+
+// -- Forward references of local functions --
+
+static int npiQosFind(int connection);
+static int npiQosNextPending(uint8 qosClass, int from);
+static int npiQosCost(int connection);
+
+// -- Public functions --
+
+/******************************************************************************
+ * @fn         NPI_LNX_QosReadConfiguration
+ *
+ * @brief      This function reads the optional [QOS] section of the
+ *             configuration file.
+ *
+ * input parameters
+ *
+ * @param      serialCfgFd	- open configuration file
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     NPI_LNX_SUCCESS
+ ******************************************************************************
+ */
+int NPI_LNX_QosReadConfiguration(FILE *serialCfgFd)
+{
+	char strBuf[128];
+	int qosClass, quantum;
+
+	for (qosClass = 0; qosClass < NPI_LNX_QOS_NUM_CLASSES; qosClass++)
+	{
+		if (NPI_LNX_SUCCESS == SerialConfigParser(serialCfgFd, "QOS", (char *)npiQosQuantumKeys[qosClass], strBuf))
+		{
+			quantum = atoi(strBuf);
+			if (quantum > 0)
+			{
+				npiQosQuantum[qosClass] = quantum;
+			}
+			LOG_INFO("[QOS] %s = %d\n", npiQosQuantumKeys[qosClass], npiQosQuantum[qosClass]);
+		}
+	}
+
+	return NPI_LNX_SUCCESS;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_QosAddConnection
+ *
+ * @brief      Start scheduling a client connection, in the normal class.
+ *
+ * input parameters
+ *
+ * @param      connection	- client socket
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     NPI_LNX_SUCCESS, NPI_LNX_FAILURE if there is no room left.
+ ******************************************************************************
+ */
+int NPI_LNX_QosAddConnection(int connection)
+{
+	npiQosConnection_t *pConn;
+
+	if (npiQosNumConnections >= NPI_QOS_MAX_CONNECTIONS)
+	{
+		return NPI_LNX_FAILURE;
+	}
+
+	pConn = &npiQosConnections[npiQosNumConnections++];
+	memset(pConn, 0, sizeof(npiQosConnection_t));
+	pConn->fd = connection;
+	pConn->qosClass = NPI_LNX_QOS_CLASS_NORMAL;
+
+	return NPI_LNX_SUCCESS;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_QosRemoveConnection
+ *
+ * @brief      Stop scheduling a client connection.
+ *
+ * input parameters
+ *
+ * @param      connection	- client socket
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+void NPI_LNX_QosRemoveConnection(int connection)
+{
+	int idx = npiQosFind(connection);
+	int qosClass;
+
+	if (idx < 0)
+	{
+		return;
+	}
+
+	// Keep the table packed, the last entry takes the free slot
+	npiQosNumConnections--;
+	for (qosClass = 0; qosClass < NPI_LNX_QOS_NUM_CLASSES; qosClass++)
+	{
+		if (npiQosCursor[qosClass] == idx)
+		{
+			npiQosCursor[qosClass] = -1;
+		}
+		else if (npiQosCursor[qosClass] == npiQosNumConnections)
+		{
+			npiQosCursor[qosClass] = idx;
+		}
+	}
+	npiQosConnections[idx] = npiQosConnections[npiQosNumConnections];
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_QosSetClass
+ *
+ * @brief      Move a client connection to another priority class.
+ *
+ * input parameters
+ *
+ * @param      connection	- client socket
+ * @param      qosClass	- NPI_LNX_QOS_CLASS_INTERACTIVE, _NORMAL or _BULK
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     NPI_LNX_SUCCESS, NPI_LNX_FAILURE for an unknown connection
+ *             or class.
+ ******************************************************************************
+ */
+int NPI_LNX_QosSetClass(int connection, uint8 qosClass)
+{
+	int idx = npiQosFind(connection);
+
+	if ((idx < 0) || (qosClass >= NPI_LNX_QOS_NUM_CLASSES))
+	{
+		return NPI_LNX_FAILURE;
+	}
+
+	if (npiQosCursor[npiQosConnections[idx].qosClass] == idx)
+	{
+		npiQosCursor[npiQosConnections[idx].qosClass] = -1;
+	}
+	npiQosConnections[idx].qosClass = qosClass;
+	npiQosConnections[idx].deficit = 0;
+	LOG_INFO("[QOS] Connection #%d moved to class %d\n", connection, qosClass);
+
+	return NPI_LNX_SUCCESS;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_QosNext
+ *
+ * @brief      Pick the client connection whose message is to be handled
+ *             next. Classes are served in strict priority order, and the
+ *             connections of a class share it by deficit round-robin over
+ *             message bytes. Returns -1 when no message is pending, and
+ *             also after a burst of messages so that new connections are
+ *             accepted.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     Client socket with a message ready to be read, -1 if none.
+ ******************************************************************************
+ */
+int NPI_LNX_QosNext(void)
+{
+	struct pollfd pfds[NPI_QOS_MAX_CONNECTIONS];
+	struct timespec now;
+	npiQosConnection_t *pConn;
+	int idx, qosClass, cost;
+	uint32 delayUs;
+
+	if (npiQosBurst >= NPI_QOS_BURST)
+	{
+		npiQosBurst = 0;
+		return -1;
+	}
+
+	// Readiness is polled again before each pick, so that a message arriving
+	// from a higher class while another was handled goes first
+	for (idx = 0; idx < npiQosNumConnections; idx++)
+	{
+		pfds[idx].fd = npiQosConnections[idx].fd;
+		pfds[idx].events = POLLIN;
+		pfds[idx].revents = 0;
+	}
+	if ((npiQosNumConnections == 0) || (poll(pfds, npiQosNumConnections, 0) <= 0))
+	{
+		npiQosBurst = 0;
+		return -1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	for (idx = 0; idx < npiQosNumConnections; idx++)
+	{
+		pConn = &npiQosConnections[idx];
+		if (pfds[idx].revents & (POLLIN | POLLHUP | POLLERR))
+		{
+			if (!pConn->pending)
+			{
+				pConn->pending = TRUE;
+				pConn->readySince = now;
+			}
+		}
+		else
+		{
+			// An idle connection does not keep credit
+			pConn->pending = FALSE;
+			pConn->deficit = 0;
+		}
+	}
+
+	for (qosClass = 0; qosClass < NPI_LNX_QOS_NUM_CLASSES; qosClass++)
+	{
+		idx = npiQosNextPending(qosClass, npiQosCursor[qosClass]);
+		if (idx < 0)
+		{
+			continue;
+		}
+
+		if (idx != npiQosCursor[qosClass])
+		{
+			// Start of a turn
+			npiQosCursor[qosClass] = idx;
+			npiQosConnections[idx].deficit += npiQosQuantum[qosClass];
+		}
+
+		// Pass the turn on until a connection can afford its next message.
+		// Every pass adds a quantum, so this ends.
+		cost = npiQosCost(npiQosConnections[idx].fd);
+		while (npiQosConnections[idx].deficit < cost)
+		{
+			idx = npiQosNextPending(qosClass, (idx + 1) % npiQosNumConnections);
+			npiQosCursor[qosClass] = idx;
+			npiQosConnections[idx].deficit += npiQosQuantum[qosClass];
+			cost = npiQosCost(npiQosConnections[idx].fd);
+		}
+
+		pConn = &npiQosConnections[idx];
+		pConn->deficit -= cost;
+		pConn->pending = FALSE;
+
+		delayUs = (uint32)(((now.tv_sec - pConn->readySince.tv_sec) * 1000000) +
+				((now.tv_nsec - pConn->readySince.tv_nsec) / 1000));
+		npiQosStats[qosClass].count++;
+		npiQosStats[qosClass].totalUs += delayUs;
+		if (delayUs > npiQosStats[qosClass].maxUs)
+		{
+			npiQosStats[qosClass].maxUs = delayUs;
+		}
+
+		npiQosBurst++;
+		return pConn->fd;
+	}
+
+	npiQosBurst = 0;
+	return -1;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_QosGetStats
+ *
+ * @brief      Read the queueing delay statistics of a class.
+ *
+ * input parameters
+ *
+ * @param      qosClass	- NPI_LNX_QOS_CLASS_INTERACTIVE, _NORMAL or _BULK
+ *
+ * output parameters
+ *
+ * @param      pCount		- messages handed out
+ * @param      pAvgUs		- average queueing delay in us
+ * @param      pMaxUs		- longest queueing delay in us
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+void NPI_LNX_QosGetStats(uint8 qosClass, uint32 *pCount, uint32 *pAvgUs, uint32 *pMaxUs)
+{
+	if (qosClass >= NPI_LNX_QOS_NUM_CLASSES)
+	{
+		*pCount = *pAvgUs = *pMaxUs = 0;
+		return;
+	}
+
+	*pCount = npiQosStats[qosClass].count;
+	*pAvgUs = (npiQosStats[qosClass].count > 0) ?
+			(uint32)(npiQosStats[qosClass].totalUs / npiQosStats[qosClass].count) : 0;
+	*pMaxUs = npiQosStats[qosClass].maxUs;
+}
+
+// -- Local functions --
+
+/******************************************************************************
+ * @fn         npiQosFind
+ *
+ * @brief      Find the entry of a client connection.
+ *
+ * input parameters
+ *
+ * @param      connection	- client socket
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     Index in npiQosConnections, -1 if not found.
+ ******************************************************************************
+ */
+static int npiQosFind(int connection)
+{
+	int idx;
+
+	for (idx = 0; idx < npiQosNumConnections; idx++)
+	{
+		if (npiQosConnections[idx].fd == connection)
+		{
+			return idx;
+		}
+	}
+
+	return -1;
+}
+
+/******************************************************************************
+ * @fn         npiQosNextPending
+ *
+ * @brief      Find the next connection of a class with a pending message.
+ *
+ * input parameters
+ *
+ * @param      qosClass	- class
+ * @param      from		- index to start from, wrapping around; -1 for 0
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     Index in npiQosConnections, -1 if the class has nothing pending.
+ ******************************************************************************
+ */
+static int npiQosNextPending(uint8 qosClass, int from)
+{
+	int n, idx;
+
+	if (from < 0)
+	{
+		from = 0;
+	}
+
+	for (n = 0; n < npiQosNumConnections; n++)
+	{
+		idx = (from + n) % npiQosNumConnections;
+		if ((npiQosConnections[idx].qosClass == qosClass) && npiQosConnections[idx].pending)
+		{
+			return idx;
+		}
+	}
+
+	return -1;
+}
+
+/******************************************************************************
+ * @fn         npiQosCost
+ *
+ * @brief      Size of the message at the head of a socket, without reading it.
+ *
+ * input parameters
+ *
+ * @param      connection	- client socket
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     Message length in bytes. 0 if the header is not all there or
+ *             the client hung up, so that the server handles it at once.
+ ******************************************************************************
+ */
+static int npiQosCost(int connection)
+{
+	uint8 hdr[RPC_FRAME_HDR_SZ];
+
+	if (recv(connection, hdr, RPC_FRAME_HDR_SZ, MSG_PEEK | MSG_DONTWAIT) != RPC_FRAME_HDR_SZ)
+	{
+		return 0;
+	}
+
+	return RPC_FRAME_HDR_SZ + hdr[RPC_POS_LEN];
+}
@@ -0,0 +1,179 @@
+/**************************************************************************************************
+  Filename:       npi_lnx_qos.h
+  Revised:        $Date: 2016-05-12 10:12:31 -0700 (Thu, 12 May 2016) $
+  Revision:       $Revision: 1 $
+
+  Description:    This file defines the NPI server scheduler which decides in which
+                  order client messages are passed to the device.
+
+
+  Copyright (C) {2016} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**************************************************************************************************/
+#ifndef NPI_QOS_LNX_H
+#define NPI_QOS_LNX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+
+#include "hal_types.h"
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Interface function prototypes
+
+  /******************************************************************************
+   * @fn         NPI_LNX_QosReadConfiguration
+   *
+   * @brief      This function reads the optional [QOS] section of the
+   *             configuration file.
+   *
+   * input parameters
+   *
+   * @param      serialCfgFd	- open configuration file
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     NPI_LNX_SUCCESS
+   ******************************************************************************
+   */
+  extern int NPI_LNX_QosReadConfiguration(FILE *serialCfgFd);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_QosAddConnection
+   *
+   * @brief      Start scheduling a client connection, in the normal class.
+   *
+   * input parameters
+   *
+   * @param      connection	- client socket
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     NPI_LNX_SUCCESS, NPI_LNX_FAILURE if there is no room left.
+   ******************************************************************************
+   */
+  extern int NPI_LNX_QosAddConnection(int connection);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_QosRemoveConnection
+   *
+   * @brief      Stop scheduling a client connection.
+   *
+   * input parameters
+   *
+   * @param      connection	- client socket
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     None.
+   ******************************************************************************
+   */
+  extern void NPI_LNX_QosRemoveConnection(int connection);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_QosSetClass
+   *
+   * @brief      Move a client connection to another priority class.
+   *
+   * input parameters
+   *
+   * @param      connection	- client socket
+   * @param      qosClass	- NPI_LNX_QOS_CLASS_INTERACTIVE, _NORMAL or _BULK
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     NPI_LNX_SUCCESS, NPI_LNX_FAILURE for an unknown connection
+   *             or class.
+   ******************************************************************************
+   */
+  extern int NPI_LNX_QosSetClass(int connection, uint8 qosClass);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_QosNext
+   *
+   * @brief      Pick the client connection whose message is to be handled
+   *             next. Classes are served in strict priority order, and the
+   *             connections of a class share it by deficit round-robin over
+   *             message bytes. Returns -1 when no message is pending, and
+   *             also after a burst of messages so that new connections are
+   *             accepted.
+   *
+   * input parameters
+   *
+   * None.
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     Client socket with a message ready to be read, -1 if none.
+   ******************************************************************************
+   */
+  extern int NPI_LNX_QosNext(void);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_QosGetStats
+   *
+   * @brief      Read the queueing delay statistics of a class. The delay of
+   *             a message runs from when it was first seen at the head of
+   *             its socket until it was handed out by NPI_LNX_QosNext().
+   *
+   * input parameters
+   *
+   * @param      qosClass	- NPI_LNX_QOS_CLASS_INTERACTIVE, _NORMAL or _BULK
+   *
+   * output parameters
+   *
+   * @param      pCount		- messages handed out
+   * @param      pAvgUs		- average queueing delay in us
+   * @param      pMaxUs		- longest queueing delay in us
+   *
+   * @return     None.
+   ******************************************************************************
+   */
+  extern void NPI_LNX_QosGetStats(uint8 qosClass, uint32 *pCount, uint32 *pAvgUs, uint32 *pMaxUs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NPI_QOS_LNX_H
@@ -0,0 +1,510 @@
+/**************************************************************************************************
+  Filename:       npi_lnx_sched.c
+  Revised:        $Date: 2016-05-12 10:12:31 -0700 (Thu, 12 May 2016) $
+  Revision:       $Revision: 1 $
+
+  Description:    This file contains the real-time scheduling, CPU affinity and
+                  memory locking profile for the NPI server I/O threads.
+
+
+  Copyright (C) {2016} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**************************************************************************************************/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "npi_lnx.h"
+#include "npi_lnx_sched.h"
+#include "npi_lnx_serial_configuration.h"
+#include "npi_lnx_error.h"
+#include "tiLogging.h"
+
+// -- Constants --
+
+// Period of the wake-up latency self-test
+#define NPI_SCHED_SELFTEST_PERIOD_NS	1000000
+
+// Largest number of samples accepted for the self-test
+#define NPI_SCHED_SELFTEST_MAX_SAMPLES	60000
+
+// -- Typedefs --
+
+typedef struct
+{
+	int priority;			// SCHED_FIFO priority, 0 for SCHED_OTHER
+	uint8 affinitySet;
+	cpu_set_t affinity;
+} npiSchedThreadCfg_t;
+
+typedef struct
+{
+	int numSamples;
+	long *pLatency;		// in nanoseconds
+} npiSchedLatencyTest_t;
+
+// -- Local Variables --
+
+static const char *npiSchedThreadNames[NPI_LNX_SCHED_THREAD_COUNT] =
+{
+		"main",
+		"uartRx",
+		"uartAsync",
+		"poll",
+		"event",
+		"dispatch",
+		"uartSleepGov",
+};
+
+static npiSchedThreadCfg_t npiSchedThreadCfg[NPI_LNX_SCHED_THREAD_COUNT];
+static uint8 npiSchedLockMemory = FALSE;
+static size_t npiSchedStackSize = 0;
+static int npiSchedSelfTestSamples = 0;
+
+// Wake-ups which found no work, per thread
+static uint32 npiSchedIdleWakeups[NPI_LNX_SCHED_THREAD_COUNT];
+
+// -- Forward references of local functions --
+
+static int npiSchedBuildAttr(pthread_attr_t *attr, npiSchedThread_t schedThread);
+static void npiSchedSelfTest(void);
+static void npiSchedMeasure(const char *label, npiSchedThread_t schedThread, uint8 useProfile);
+static void *npiSchedLatencyEntry(void *ptr);
+static int npiSchedCompareLong(const void *a, const void *b);
+
+// -- Public functions --
+
+/******************************************************************************
+ * @fn         NPI_LNX_SchedReadConfiguration
+ *
+ * @brief      This function reads the optional [REALTIME] section of the
+ *             configuration file. Missing keys leave the thread on the
+ *             default time sharing policy.
+ *
+ * input parameters
+ *
+ * @param      serialCfgFd	- open configuration file
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     NPI_LNX_SUCCESS
+ ******************************************************************************
+ */
+int NPI_LNX_SchedReadConfiguration(FILE *serialCfgFd)
+{
+	char strBuf[128];
+	char key[32];
+	int idx, cpu, minPrio, maxPrio;
+	unsigned long mask;
+
+	memset(npiSchedThreadCfg, 0, sizeof(npiSchedThreadCfg));
+	minPrio = sched_get_priority_min(SCHED_FIFO);
+	maxPrio = sched_get_priority_max(SCHED_FIFO);
+
+	for (idx = 0; idx < NPI_LNX_SCHED_THREAD_COUNT; idx++)
+	{
+		snprintf(key, sizeof(key), "%sPriority", npiSchedThreadNames[idx]);
+		if (NPI_LNX_SUCCESS == SerialConfigParser(serialCfgFd, "REALTIME", key, strBuf))
+		{
+			npiSchedThreadCfg[idx].priority = atoi(strBuf);
+			if (npiSchedThreadCfg[idx].priority > 0)
+			{
+				if (npiSchedThreadCfg[idx].priority < minPrio)
+					npiSchedThreadCfg[idx].priority = minPrio;
+				else if (npiSchedThreadCfg[idx].priority > maxPrio)
+					npiSchedThreadCfg[idx].priority = maxPrio;
+			}
+			else
+			{
+				npiSchedThreadCfg[idx].priority = 0;
+			}
+			LOG_INFO("[SCHED] %s thread priority %d\n", npiSchedThreadNames[idx],
+					npiSchedThreadCfg[idx].priority);
+		}
+
+		snprintf(key, sizeof(key), "%sAffinity", npiSchedThreadNames[idx]);
+		if (NPI_LNX_SUCCESS == SerialConfigParser(serialCfgFd, "REALTIME", key, strBuf))
+		{
+			mask = strtoul(strBuf, NULL, 0);
+			CPU_ZERO(&npiSchedThreadCfg[idx].affinity);
+			for (cpu = 0; (cpu < (int)(8 * sizeof(mask))) && (cpu < CPU_SETSIZE); cpu++)
+			{
+				if (mask & (1UL << cpu))
+					CPU_SET(cpu, &npiSchedThreadCfg[idx].affinity);
+			}
+			// An empty mask means no restriction
+			npiSchedThreadCfg[idx].affinitySet = (mask != 0);
+			LOG_INFO("[SCHED] %s thread affinity 0x%lX\n", npiSchedThreadNames[idx], mask);
+		}
+	}
+
+	if (NPI_LNX_SUCCESS == SerialConfigParser(serialCfgFd, "REALTIME", "mlockall", strBuf))
+	{
+		npiSchedLockMemory = (atoi(strBuf) != 0);
+	}
+	if (NPI_LNX_SUCCESS == SerialConfigParser(serialCfgFd, "REALTIME", "stackSize", strBuf))
+	{
+		npiSchedStackSize = strtoul(strBuf, NULL, 0);
+		if ((npiSchedStackSize != 0) && (npiSchedStackSize < PTHREAD_STACK_MIN))
+			npiSchedStackSize = PTHREAD_STACK_MIN;
+	}
+	if (NPI_LNX_SUCCESS == SerialConfigParser(serialCfgFd, "REALTIME", "selfTest", strBuf))
+	{
+		npiSchedSelfTestSamples = atoi(strBuf);
+		if (npiSchedSelfTestSamples > NPI_SCHED_SELFTEST_MAX_SAMPLES)
+			npiSchedSelfTestSamples = NPI_SCHED_SELFTEST_MAX_SAMPLES;
+	}
+
+	return NPI_LNX_SUCCESS;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_SchedInit
+ *
+ * @brief      This function locks memory if configured, applies the profile
+ *             of the calling (main) thread and runs the wake-up latency
+ *             self-test if enabled.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     NPI_LNX_SUCCESS
+ ******************************************************************************
+ */
+int NPI_LNX_SchedInit(void)
+{
+	npiSchedThreadCfg_t *pCfg = &npiSchedThreadCfg[NPI_LNX_SCHED_THREAD_MAIN];
+	struct sched_param param;
+	int rc;
+
+	// Run the self-test first so that the baseline is not affected by the
+	// main thread profile inherited by the measurement threads.
+	if (npiSchedSelfTestSamples > 0)
+	{
+		npiSchedSelfTest();
+	}
+
+	if (npiSchedLockMemory)
+	{
+		// Avoid page faults in the I/O path; requires CAP_IPC_LOCK or a
+		// sufficient RLIMIT_MEMLOCK.
+		if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0)
+			LOG_WARN("[SCHED] mlockall() failed: %s\n", strerror(errno));
+		else
+			LOG_INFO("[SCHED] Memory locked\n");
+	}
+
+	if (pCfg->affinitySet)
+	{
+		rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &pCfg->affinity);
+		if (rc == EINVAL)
+			LOG_WARN("[SCHED] main thread affinity has no CPU present and online, using default affinity\n");
+		else if (rc)
+			LOG_WARN("[SCHED] Could not set main thread affinity: %s\n", strerror(rc));
+	}
+
+	if (pCfg->priority > 0)
+	{
+		memset(&param, 0, sizeof(param));
+		param.sched_priority = pCfg->priority;
+		rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if (rc)
+			LOG_WARN("[SCHED] Could not set main thread to SCHED_FIFO %d: %s\n",
+					pCfg->priority, strerror(rc));
+	}
+
+	return NPI_LNX_SUCCESS;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_SchedCreateThread
+ *
+ * @brief      Drop-in replacement for pthread_create() which creates the
+ *             thread with the policy, priority, CPU affinity and stack size
+ *             configured for the given thread.
+ *
+ * input parameters
+ *
+ * @param      thread		- thread handle to fill in
+ * @param      schedThread	- which profile to apply
+ * @param      startRoutine	- thread entry function
+ * @param      arg			- argument for the thread entry function
+ *
+ * output parameters
+ *
+ * @param      thread		- thread handle
+ *
+ * @return     0 if the thread was created, error number from pthread_create()
+ *             otherwise.
+ ******************************************************************************
+ */
+int NPI_LNX_SchedCreateThread(pthread_t *thread, npiSchedThread_t schedThread,
+		void *(*startRoutine)(void *), void *arg)
+{
+	pthread_attr_t attr;
+	cpu_set_t inherited;
+	int rc;
+
+	if (npiSchedBuildAttr(&attr, schedThread) != NPI_LNX_SUCCESS)
+	{
+		return pthread_create(thread, NULL, startRoutine, arg);
+	}
+
+	rc = pthread_create(thread, &attr, startRoutine, arg);
+	if (rc == EPERM)
+	{
+		// Not privileged to use SCHED_FIFO, run with default scheduling
+		// rather than failing to open the device.
+		LOG_WARN("[SCHED] Not permitted to apply profile to %s thread, using default scheduling\n",
+				npiSchedThreadNames[schedThread]);
+		pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+		rc = pthread_create(thread, &attr, startRoutine, arg);
+	}
+	if ((rc == EINVAL) && npiSchedThreadCfg[schedThread].affinitySet)
+	{
+		// A CPU of the mask is not present or offline, run on the CPUs of
+		// the creating thread rather than failing to open the device.
+		LOG_WARN("[SCHED] %s thread affinity not usable, using default affinity\n",
+				npiSchedThreadNames[schedThread]);
+		if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &inherited) == 0)
+		{
+			pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &inherited);
+			rc = pthread_create(thread, &attr, startRoutine, arg);
+		}
+	}
+	pthread_attr_destroy(&attr);
+
+	return rc;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_SchedIdleWakeup
+ *
+ * @brief      Count a wake-up of the given thread which found no work to do,
+ *             e.g. a poll() timeout. Safe to call from any thread.
+ *
+ * input parameters
+ *
+ * @param      schedThread	- thread which woke up
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+void NPI_LNX_SchedIdleWakeup(npiSchedThread_t schedThread)
+{
+	__sync_fetch_and_add(&npiSchedIdleWakeups[schedThread], 1);
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_SchedGetIdleWakeups
+ *
+ * @brief      Read the idle wake-up counter of the given thread.
+ *
+ * input parameters
+ *
+ * @param      schedThread	- thread to read counter of
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     Number of idle wake-ups since the server started.
+ ******************************************************************************
+ */
+uint32 NPI_LNX_SchedGetIdleWakeups(npiSchedThread_t schedThread)
+{
+	return __sync_fetch_and_add(&npiSchedIdleWakeups[schedThread], 0);
+}
+
+// -- private functions --
+
+/* Fill in thread attributes for the given profile */
+static int npiSchedBuildAttr(pthread_attr_t *attr, npiSchedThread_t schedThread)
+{
+	npiSchedThreadCfg_t *pCfg = &npiSchedThreadCfg[schedThread];
+	struct sched_param param;
+
+	if (pthread_attr_init(attr))
+	{
+		return NPI_LNX_FAILURE;
+	}
+
+	// Always set the policy explicitly, otherwise a thread without its own
+	// priority would inherit SCHED_FIFO from a prioritized main thread.
+	memset(&param, 0, sizeof(param));
+	param.sched_priority = pCfg->priority;
+	pthread_attr_setinheritsched(attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(attr, (pCfg->priority > 0) ? SCHED_FIFO : SCHED_OTHER);
+	pthread_attr_setschedparam(attr, &param);
+
+	if (pCfg->affinitySet)
+	{
+		pthread_attr_setaffinity_np(attr, sizeof(cpu_set_t), &pCfg->affinity);
+	}
+
+	if (npiSchedStackSize)
+	{
+		// With mlockall(MCL_FUTURE) the whole stack is locked, so allow it
+		// to be trimmed.
+		pthread_attr_setstacksize(attr, npiSchedStackSize);
+	}
+
+	return NPI_LNX_SUCCESS;
+}
+
+/* Measure wake-up latency without and with the profile for each configured thread */
+static void npiSchedSelfTest(void)
+{
+	int idx;
+
+	LOG_ALWAYS("[SCHED] Wake-up latency self-test, %d samples at %d us period\n",
+			npiSchedSelfTestSamples, NPI_SCHED_SELFTEST_PERIOD_NS / 1000);
+
+	npiSchedMeasure("default", NPI_LNX_SCHED_THREAD_MAIN, FALSE);
+
+	for (idx = 0; idx < NPI_LNX_SCHED_THREAD_COUNT; idx++)
+	{
+		if ((npiSchedThreadCfg[idx].priority > 0) || npiSchedThreadCfg[idx].affinitySet)
+		{
+			npiSchedMeasure(npiSchedThreadNames[idx], (npiSchedThread_t)idx, TRUE);
+		}
+	}
+}
+
+/* Run one measurement thread and report the latency distribution */
+static void npiSchedMeasure(const char *label, npiSchedThread_t schedThread, uint8 useProfile)
+{
+	npiSchedLatencyTest_t test;
+	pthread_attr_t attr;
+	pthread_t thread;
+	long sum = 0;
+	int i, rc;
+
+	test.numSamples = npiSchedSelfTestSamples;
+	test.pLatency = (long *)malloc(test.numSamples * sizeof(long));
+	if (test.pLatency == NULL)
+	{
+		LOG_WARN("[SCHED] Self-test could not allocate sample buffer\n");
+		return;
+	}
+
+	if (useProfile)
+	{
+		rc = NPI_LNX_SchedCreateThread(&thread, schedThread, npiSchedLatencyEntry, &test);
+	}
+	else
+	{
+		pthread_attr_init(&attr);
+		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+		pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+		rc = pthread_create(&thread, &attr, npiSchedLatencyEntry, &test);
+		pthread_attr_destroy(&attr);
+	}
+
+	if (rc)
+	{
+		LOG_WARN("[SCHED] Self-test could not create %s thread: %s\n", label, strerror(rc));
+		free(test.pLatency);
+		return;
+	}
+	pthread_join(thread, NULL);
+
+	qsort(test.pLatency, test.numSamples, sizeof(long), npiSchedCompareLong);
+	for (i = 0; i < test.numSamples; i++)
+	{
+		sum += test.pLatency[i];
+	}
+	LOG_ALWAYS("[SCHED] %-9s wake-up latency [us]: min %ld, avg %ld, p99 %ld, max %ld\n",
+			label,
+			test.pLatency[0] / 1000,
+			(sum / test.numSamples) / 1000,
+			test.pLatency[(test.numSamples * 99) / 100] / 1000,
+			test.pLatency[test.numSamples - 1] / 1000);
+
+	free(test.pLatency);
+}
+
+/* Measurement thread, sleeps to absolute deadlines and records the overshoot */
+static void *npiSchedLatencyEntry(void *ptr)
+{
+	npiSchedLatencyTest_t *pTest = (npiSchedLatencyTest_t *)ptr;
+	struct timespec deadline, now;
+	int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	for (i = 0; i < pTest->numSamples; i++)
+	{
+		deadline.tv_nsec += NPI_SCHED_SELFTEST_PERIOD_NS;
+		if (deadline.tv_nsec >= 1000000000)
+		{
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000;
+		}
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR)
+			;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		pTest->pLatency[i] = (now.tv_sec - deadline.tv_sec) * 1000000000L
+				+ (now.tv_nsec - deadline.tv_nsec);
+	}
+
+	return NULL;
+}
+
+static int npiSchedCompareLong(const void *a, const void *b)
+{
+	long la = *(const long *)a;
+	long lb = *(const long *)b;
+
+	return (la > lb) - (la < lb);
+}
+
+/**************************************************************************************************
+ */
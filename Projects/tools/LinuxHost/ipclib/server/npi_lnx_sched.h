@@ -0,0 +1,182 @@
+/**************************************************************************************************
+  Filename:       npi_lnx_sched.h
+  Revised:        $Date: 2016-05-12 10:12:31 -0700 (Thu, 12 May 2016) $
+  Revision:       $Revision: 1 $
+
+  Description:    This file defines the real-time scheduling profile applied to the
+                  NPI server I/O threads.
+
+
+  Copyright (C) {2016} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**************************************************************************************************/
+#ifndef NPI_SCHED_LNX_H
+#define NPI_SCHED_LNX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <pthread.h>
+
+#include "hal_types.h"
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Typedefs
+
+  // Threads that can be given their own scheduling profile.
+  // The configuration keys in section [REALTIME] are prefixed with the
+  // names listed in npiSchedThreadNames, e.g. pollPriority=40.
+  typedef enum
+  {
+	  NPI_LNX_SCHED_THREAD_MAIN = 0,	// Socket main loop
+	  NPI_LNX_SCHED_THREAD_UART_RX,		// npiRxThread
+	  NPI_LNX_SCHED_THREAD_UART_ASYNC,	// npiAsyncCbackThread
+	  NPI_LNX_SCHED_THREAD_POLL,		// SPI/I2C npiPollThread
+	  NPI_LNX_SCHED_THREAD_EVENT,		// SPI/I2C npiEventThread
+	  NPI_LNX_SCHED_THREAD_DISPATCH,	// SPI/I2C npiDispatchThread
+	  NPI_LNX_SCHED_THREAD_UART_SLEEPGOV,	// npiSleepGovThread
+	  NPI_LNX_SCHED_THREAD_COUNT
+  } npiSchedThread_t;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Interface function prototypes
+
+  /******************************************************************************
+   * @fn         NPI_LNX_SchedReadConfiguration
+   *
+   * @brief      This function reads the optional [REALTIME] section of the
+   *             configuration file. Missing keys leave the thread on the
+   *             default time sharing policy.
+   *
+   * input parameters
+   *
+   * @param      serialCfgFd	- open configuration file
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     NPI_LNX_SUCCESS
+   ******************************************************************************
+   */
+  extern int NPI_LNX_SchedReadConfiguration(FILE *serialCfgFd);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_SchedInit
+   *
+   * @brief      This function locks memory if configured, applies the profile
+   *             of the calling (main) thread and runs the wake-up latency
+   *             self-test if enabled. Must be called before the device is
+   *             opened so that the I/O threads inherit the main thread mask.
+   *
+   * input parameters
+   *
+   * None.
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     NPI_LNX_SUCCESS. Missing privileges are only reported as
+   *             warnings, the server then runs with default scheduling.
+   ******************************************************************************
+   */
+  extern int NPI_LNX_SchedInit(void);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_SchedCreateThread
+   *
+   * @brief      Drop-in replacement for pthread_create() which creates the
+   *             thread with the policy, priority, CPU affinity and stack size
+   *             configured for the given thread.
+   *
+   * input parameters
+   *
+   * @param      thread		- thread handle to fill in
+   * @param      schedThread	- which profile to apply
+   * @param      startRoutine	- thread entry function
+   * @param      arg			- argument for the thread entry function
+   *
+   * output parameters
+   *
+   * @param      thread		- thread handle
+   *
+   * @return     0 if the thread was created, error number from pthread_create()
+   *             otherwise.
+   ******************************************************************************
+   */
+  extern int NPI_LNX_SchedCreateThread(pthread_t *thread, npiSchedThread_t schedThread,
+		  void *(*startRoutine)(void *), void *arg);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_SchedIdleWakeup
+   *
+   * @brief      Count a wake-up of the given thread which found no work to do,
+   *             e.g. a poll() timeout. Safe to call from any thread.
+   *
+   * input parameters
+   *
+   * @param      schedThread	- thread which woke up
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     None.
+   ******************************************************************************
+   */
+  extern void NPI_LNX_SchedIdleWakeup(npiSchedThread_t schedThread);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_SchedGetIdleWakeups
+   *
+   * @brief      Read the idle wake-up counter of the given thread.
+   *
+   * input parameters
+   *
+   * @param      schedThread	- thread to read counter of
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     Number of idle wake-ups since the server started.
+   ******************************************************************************
+   */
+  extern uint32 NPI_LNX_SchedGetIdleWakeups(npiSchedThread_t schedThread);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NPI_SCHED_LNX_H
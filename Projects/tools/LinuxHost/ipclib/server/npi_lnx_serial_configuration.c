@@ -42,14 +42,29 @@
 #include "stdio.h"
 #include "stdlib.h"
 #include <unistd.h>
+#include <errno.h>
 
 #include "npi_lnx.h"
 #include "npi_lnx_serial_configuration.h"
+#include "npi_lnx_sched.h"
+#include "npi_lnx_sreq_cache.h"
+#include "npi_lnx_qos.h"
+#include "npi_lnx_errlog.h"
+#include "npi_lnx_msgbuf.h"
+#include "npi_lnx_dispatch.h"
+#include "hal_dbg_ifc.h"
 #include "npi_lnx_error.h"
 #include "tiLogging.h"
+#include "configStore.h"
 
 static char* pStrBufRoot;
 
+// Parsed configuration file, built on the first SerialConfigParser call
+static configStore_t *serialCfgStore = NULL;
+
+// Size of the value buffers handed to SerialConfigParser
+#define SERIAL_CFG_VALUE_MAX 128
+
 
 #define IDX_GPIO          0
 #define IDX_LEVEL_SHIFTER 1
@@ -184,6 +199,17 @@ int getSerialConfiguration(const char *configFilePath, npiSerialCfg_t *serialCfg
 		LOG_ALWAYS("No log file path configured. Logs will go to stderr.\n");
 	}
 
+	// Optionally take logging off the calling threads
+	strBuf = pStrBufRoot;
+	if ((NPI_LNX_SUCCESS == SerialConfigParser(serialCfgFd, "LOG", "async", strBuf)) &&
+			(strtol(strBuf, NULL, 0) != 0))
+	{
+		if (tiLogging_InitAsync())
+		{
+			LOG_INFO("Asynchronous logging enabled\n");
+		}
+	}
+
 	// If Debug Interface is supported, configure it.
 	if (NPI_LNX_FAILURE == (SerialConfigParser(serialCfgFd, "DEBUG", "supported", strBuf)))
 	{
@@ -196,6 +222,27 @@ int getSerialConfiguration(const char *configFilePath, npiSerialCfg_t *serialCfg
 		serialCfg->debugSupported = strBuf[0] - '0';
 	}
 
+	// Optional directory for flash dumps written on the server
+	Hal_DebugInterface_ReadConfiguration(serialCfgFd);
+
+	// Optional real-time scheduling profile for the I/O threads
+	NPI_LNX_SchedReadConfiguration(serialCfgFd);
+
+	// Optional cache of constant SREQ responses
+	NPI_LNX_SreqCacheReadConfiguration(serialCfgFd);
+
+	// Optional scheduler quanta
+	NPI_LNX_QosReadConfiguration(serialCfgFd);
+
+	// Optional error log rotation
+	NPI_LNX_ErrLogReadConfiguration(serialCfgFd);
+
+	// Optional size of the message buffer pool
+	NPI_LNX_MsgBufReadConfiguration(serialCfgFd);
+
+	// Optional depth of the SPI/I2C AREQ dispatch queue
+	NPI_LNX_DispatchReadConfiguration(serialCfgFd);
+
 	uint8 gpioStart = 0, gpioEnd = 0;
 	if (serialCfg->debugSupported)
 	{
@@ -397,6 +444,14 @@ int getSerialConfiguration(const char *configFilePath, npiSerialCfg_t *serialCfg
 			{
 				serialCfg->serial.npiUartCfg.flowcontrol=0;
 			}
+			if (NPI_LNX_SUCCESS == (SerialConfigParser(serialCfgFd, "UART", "sleepIdleTimeout", strBuf)))
+			{
+				serialCfg->serial.npiUartCfg.sleepIdleTimeout = strtoul(strBuf, NULL, 10);
+			}
+			else
+			{
+				serialCfg->serial.npiUartCfg.sleepIdleTimeout = 0;
+			}
 		#endif
 			break;
 
@@ -501,6 +556,14 @@ int getSerialConfiguration(const char *configFilePath, npiSerialCfg_t *serialCfg
 		strncpy(serialCfg->port, strBuf, sizeof(serialCfg->port)-1);
 	}
 
+	// Everything has been read
+	configStore_Free(serialCfgStore);
+	serialCfgStore = NULL;
+	if (serialCfgFd != NULL)
+	{
+		fclose(serialCfgFd);
+	}
+
 	return retVal;
 }
 
@@ -508,7 +571,8 @@ int getSerialConfiguration(const char *configFilePath, npiSerialCfg_t *serialCfg
  *
  * @fn          SerialConfigParser
  *
- * @brief       This function searches for a string a returns its value
+ * @brief       This function searches for a string a returns its value. The file is
+ *              parsed once into an index, later keys are looked up without reading it.
  *
  * input parameters
  *
@@ -525,133 +589,42 @@ int getSerialConfiguration(const char *configFilePath, npiSerialCfg_t *serialCfg
  **************************************************************************************************/
 int SerialConfigParser(FILE* serialCfgFd, const char* section, const char* key, char* resultString)
 {
-	uint8 sectionFound = FALSE, invalidLineLen = FALSE;
-	char* resString = NULL;
-	char* resStringToFree = NULL;
-	char* psStr; // Processing string pointer
-	int res = NPI_LNX_FAILURE;
+	const char *value;
 
+	LOG_DEBUG("Serial Config Parsing: [%s] %s\n", section, key);
 
-	resString = (char *)malloc (128);
-	if (resString == NULL)
+	// Do nothing if the file doesn't exist
+	if (serialCfgFd == NULL)
 	{
-		npi_ipc_errno = NPI_LNX_ERROR_IPC_GENERIC;
+		npi_ipc_errno = NPI_LNX_ERROR_IPC_SERIAL_CFG_FILE_DOES_NOT_EXIST;
 		return NPI_LNX_FAILURE;
 	}
-	resStringToFree = resString;
-	LOG_DEBUG("------------------------------------------------------\n");
-	LOG_DEBUG("Serial Config Parsing:\n");
-	LOG_DEBUG("- \tSection: \t%s\n", section);
-	LOG_DEBUG("- \tKey: \t\t%s\n", key);
 
-	// Do nothing if the file doesn't exist
-	if (serialCfgFd != NULL)
+	// Parse the file on first use, every following key is a table lookup
+	if (!configStore_IsCurrent(serialCfgStore, fileno(serialCfgFd)))
 	{
-		// Make sure we start search from the beginning of the file
-		fseek(serialCfgFd, 0, SEEK_SET);
-
-		// Search through the configuration file for the wanted
-		while ((resString = fgets(resString, 128, serialCfgFd)) != NULL)
+		configStore_Free(serialCfgStore);
+		serialCfgStore = configStore_LoadFd(fileno(serialCfgFd));
+		if (serialCfgStore == NULL)
 		{
-			// Check if we have a valid line, i.e. begins with [.
-			// Note! No valid line can span more than 128 bytes. Hence we
-			// must hold off parsing until we hit a newline.
-			if (strlen(resString) == 128)
-			{
-				invalidLineLen = TRUE;
-				LOG_DEBUG("Found line > 128 bytes! Too long!\n");
-				fflush(LOG_DESTINATION_FP);
-			}
-			else
-			{
-				// First time we find a valid line length after having
-				// found invalid line length may be the end of the
-				// invalid line. Hence, do not process this string.
-				// We set the invalidLineLen parameter to FALSE after
-				// the processing logic.
-				if (invalidLineLen == FALSE)
-				{
-					// Remove the newline character (ok even if line had length 128)
-					resString[strlen(resString) - 1] = '\0';
-
-					LOG_TRACE("Found line < 128 bytes...");
-					fflush(LOG_DESTINATION_FP);
-					if (resString[0] == '[')
-					{
-						LOG_DEBUG("Found section %s\n", resString);
-						// Search for wanted section
-						psStr = strstr(resString, section);
-						if (psStr != NULL)
-						{
-							resString = psStr;
-							// We found our wanted section. Now search for wanted key.
-							sectionFound = TRUE;
-							LOG_DEBUG("Found wanted section!\n");
-						}
-						else
-						{
-							// We found another section.
-							sectionFound = FALSE;
-						}
-					}
-					else if (sectionFound == TRUE)
-					{
-						LOG_DEBUG("Line to process %s (strlen=%zd)\n",
-								resString,
-								strlen(resString));
-						// We have found our section, now we search for wanted key
-						// Check for commented lines, tagged with '#', and
-						// lines > 0 in length
-						if ((resString[0] != '#') && (strlen(resString) > 0))
-						{
-							// Search for wanted section
-							psStr = strstr(resString, key);
-							if (psStr != NULL)
-							{
-								LOG_DEBUG("Found key \t'%s' in \t'%s'\n", key, resString);
-								// We found our key. The value is located after the '='
-								// after the key.
-								// LOG_DEBUG("%s\n", psStr);
-								psStr = strtok(psStr, "=");
-
-								// strtok doesn't work if the value is specified as "" (empty string) because it will
-								// skip both quotes.  If we're at a quote, check for "" and handle that without strtok.
-								if (strncmp(psStr+strlen(psStr)+1, "\"\"", 2) == 0)
-									psStr = psStr+strlen(psStr); // No need to parse, just point to null so string is empty.
-								else
-									psStr = strtok(NULL, "=;\"");
-								LOG_DEBUG("%s\n", psStr);
-
-								resString = psStr;
-								res = NPI_LNX_SUCCESS;
-								LOG_DEBUG("Found value '%s'\n", resString);
-								strcpy(resultString, resString);
-								LOG_DEBUG("Found value2 '%s'\n", resultString);
-								// We can return this string to the calling function
-								break;
-							}
-						}
-					}
-               else
-               {
-                  // LOG_DEBUG("Irrelevant line (%s)\n", resString);
-               }
-				}
-				else
-				{
-					LOG_DEBUG("Found end of line > 128 bytes\n");
-					invalidLineLen = FALSE;
-				}
-			}
+			LOG_ERROR("Could not parse configuration file: %s\n", strerror(errno));
+			npi_ipc_errno = NPI_LNX_ERROR_IPC_GENERIC;
+			return NPI_LNX_FAILURE;
 		}
 	}
-	else
+
+	value = configStore_Get(serialCfgStore, section, key);
+	if (value == NULL)
 	{
-		npi_ipc_errno = NPI_LNX_ERROR_IPC_SERIAL_CFG_FILE_DOES_NOT_EXIST;
-		free(resStringToFree);
+		return NPI_LNX_FAILURE;
+	}
+	if (strlen(value) >= SERIAL_CFG_VALUE_MAX)
+	{
+		LOG_WARN("Ignoring [%s] %s, value longer than %d bytes\n", section, key, SERIAL_CFG_VALUE_MAX - 1);
 		return NPI_LNX_FAILURE;
 	}
 
-	free(resStringToFree);
-	return res;
+	strcpy(resultString, value);
+	LOG_DEBUG("Found value '%s'\n", resultString);
+	return NPI_LNX_SUCCESS;
 }
@@ -0,0 +1,549 @@
+/**************************************************************************************************
+  Filename:       npi_lnx_sreq_cache.c
+  Revised:        $Date: 2016-05-12 10:12:31 -0700 (Thu, 12 May 2016) $
+  Revision:       $Revision: 1 $
+
+  Description:    This file contains the NPI server cache of SREQ responses which
+                  do not change while the RNP session lasts.
+
+
+  Copyright (C) {2016} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**************************************************************************************************/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "npi_lnx.h"
+#include "npi_lnx_sreq_cache.h"
+#include "npi_lnx_serial_configuration.h"
+#include "npi_lnx_error.h"
+#include "tiLogging.h"
+
+// -- Constants --
+
+// Number of responses kept, the oldest is replaced when full
+#define NPI_SREQ_CACHE_SIZE				16
+
+// RemoTI commands and items the cache knows about (see rtis_lnx.h and rti_lnx.h)
+#define NPI_SREQ_CACHE_RTI_READ_ITEM		0x01
+#define NPI_SREQ_CACHE_RTI_WRITE_ITEM		0x02
+#define NPI_SREQ_CACHE_RTI_READ_ITEM_EX		0x21
+#define NPI_SREQ_CACHE_RTI_WRITE_ITEM_EX	0x22
+#define NPI_SREQ_CACHE_RTI_INIT_CNF			0x01
+#define NPI_SREQ_CACHE_RTI_RESET_IND		0x0D
+#define NPI_SREQ_CACHE_SYS_RESET_IND		0x80
+#define NPI_SREQ_CACHE_SYS_PING				0x01
+
+#define NPI_SREQ_CACHE_RTI_PROFILE_RTI		0xFF	// profile identifier of the RTI's own items
+#define NPI_SREQ_CACHE_RTI_IEEE_ADDRESS		0x84
+#define NPI_SREQ_CACHE_RTI_CONST_FIRST		0xC0	// software version .. extended software version
+#define NPI_SREQ_CACHE_RTI_CONST_LAST		0xC4
+#define NPI_SREQ_CACHE_RTI_IMAGE_ID_FIRST	0xD0	// OAD and RNP image identifiers
+#define NPI_SREQ_CACHE_RTI_IMAGE_ID_LAST	0xD1
+
+// -- Typedefs --
+
+// Declares the SREQs whose responses may be cached. The item identifier at
+// itemPos in the payload must be within [itemFirst, itemLast]. With rtiProfile
+// set, the profile identifier in front of it must be the RTI's: profiles use
+// the same item identifiers for attributes the RNP may change on its own.
+typedef struct
+{
+	uint8 subSys;
+	uint8 cmdId;
+	uint8 itemPos;
+	uint8 itemFirst;
+	uint8 itemLast;
+	npiSreqCacheScope_t scope;
+	uint8 rtiProfile;
+} npiSreqCacheRule_t;
+
+typedef struct
+{
+	uint8 inUse;
+	npiSreqCacheKey_t key;
+	npiMsgBuf_t *pRsp;		// reference held while in use
+} npiSreqCacheEntry_t;
+
+// -- Local Variables --
+
+static const npiSreqCacheRule_t npiSreqCacheRules[] =
+{
+		// RTI_ReadItemEx(profileId, itemId, len), RTI profile only
+		{ RPC_SYS_RCAF, NPI_SREQ_CACHE_RTI_READ_ITEM_EX, 1,
+				NPI_SREQ_CACHE_RTI_CONST_FIRST, NPI_SREQ_CACHE_RTI_CONST_LAST, NPI_LNX_SREQ_CACHE_IMMUTABLE, TRUE },
+		{ RPC_SYS_RCAF, NPI_SREQ_CACHE_RTI_READ_ITEM_EX, 1,
+				NPI_SREQ_CACHE_RTI_IMAGE_ID_FIRST, NPI_SREQ_CACHE_RTI_IMAGE_ID_LAST, NPI_LNX_SREQ_CACHE_IMMUTABLE, TRUE },
+		{ RPC_SYS_RCAF, NPI_SREQ_CACHE_RTI_READ_ITEM_EX, 1,
+				NPI_SREQ_CACHE_RTI_IEEE_ADDRESS, NPI_SREQ_CACHE_RTI_IEEE_ADDRESS, NPI_LNX_SREQ_CACHE_SESSION, TRUE },
+		// RTI_ReadItem(itemId, len)
+		{ RPC_SYS_RCAF, NPI_SREQ_CACHE_RTI_READ_ITEM, 0,
+				NPI_SREQ_CACHE_RTI_CONST_FIRST, NPI_SREQ_CACHE_RTI_CONST_LAST, NPI_LNX_SREQ_CACHE_IMMUTABLE },
+		{ RPC_SYS_RCAF, NPI_SREQ_CACHE_RTI_READ_ITEM, 0,
+				NPI_SREQ_CACHE_RTI_IMAGE_ID_FIRST, NPI_SREQ_CACHE_RTI_IMAGE_ID_LAST, NPI_LNX_SREQ_CACHE_IMMUTABLE },
+		{ RPC_SYS_RCAF, NPI_SREQ_CACHE_RTI_READ_ITEM, 0,
+				NPI_SREQ_CACHE_RTI_IEEE_ADDRESS, NPI_SREQ_CACHE_RTI_IEEE_ADDRESS, NPI_LNX_SREQ_CACHE_SESSION },
+};
+
+// Writes which may change a cached item, same layout as the rules above
+static const npiSreqCacheRule_t npiSreqCacheWrites[] =
+{
+		{ RPC_SYS_RCAF, NPI_SREQ_CACHE_RTI_WRITE_ITEM_EX, 1, 0, 0, NPI_LNX_SREQ_CACHE_IMMUTABLE },
+		{ RPC_SYS_RCAF, NPI_SREQ_CACHE_RTI_WRITE_ITEM, 0, 0, 0, NPI_LNX_SREQ_CACHE_IMMUTABLE },
+};
+
+// SREQs which do not change the device state, so that identical ones queued
+// by several clients may share one response (see NPI_LNX_SreqCacheIsReadOnly)
+static const npiSreqCacheRule_t npiSreqCacheReads[] =
+{
+		{ RPC_SYS_RCAF, NPI_SREQ_CACHE_RTI_READ_ITEM_EX, 1, 0, 0, NPI_LNX_SREQ_CACHE_SESSION },
+		{ RPC_SYS_RCAF, NPI_SREQ_CACHE_RTI_READ_ITEM, 0, 0, 0, NPI_LNX_SREQ_CACHE_SESSION },
+		{ RPC_SYS_SYS, NPI_SREQ_CACHE_SYS_PING, 0, 0, 0, NPI_LNX_SREQ_CACHE_SESSION },
+};
+
+static uint8 npiSreqCacheEnabled = TRUE;
+
+// Entries are written by the main thread; invalidations may come from the
+// device threads delivering AREQs.
+static pthread_mutex_t npiSreqCacheLock = PTHREAD_MUTEX_INITIALIZER;
+static npiSreqCacheEntry_t npiSreqCache[NPI_SREQ_CACHE_SIZE];
+static uint8 npiSreqCacheNext = 0;
+// Incremented on each invalidation, so that a response which was in flight
+// during one is not stored
+static uint32 npiSreqCacheGeneration = 0;
+
+static uint32 npiSreqCacheHits = 0;
+static uint32 npiSreqCacheMisses = 0;
+static uint32 npiSreqCacheInvalidations = 0;
+
+// -- Forward references of local functions --
+
+static const npiSreqCacheRule_t *npiSreqCacheMatch(const npiSreqCacheRule_t *pRules, int numRules,
+		const npiMsgData_t *pMsg);
+static uint8 npiSreqCacheIsCachedItem(uint8 itemId);
+
+// -- Public functions --
+
+/******************************************************************************
+ * @fn         NPI_LNX_SreqCacheReadConfiguration
+ *
+ * @brief      This function reads the optional [SREQ_CACHE] section of the
+ *             configuration file. The cache is enabled by default.
+ *
+ * input parameters
+ *
+ * @param      serialCfgFd	- open configuration file
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     NPI_LNX_SUCCESS
+ ******************************************************************************
+ */
+int NPI_LNX_SreqCacheReadConfiguration(FILE *serialCfgFd)
+{
+	char strBuf[128];
+
+	if (NPI_LNX_SUCCESS == SerialConfigParser(serialCfgFd, "SREQ_CACHE", "enabled", strBuf))
+	{
+		npiSreqCacheEnabled = (atoi(strBuf) != 0);
+		LOG_INFO("[SREQ CACHE] %s\n", npiSreqCacheEnabled ? "Enabled" : "Disabled");
+	}
+
+	return NPI_LNX_SUCCESS;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_SreqCacheLookup
+ *
+ * @brief      Look up a device SREQ before it is sent. On a hit the device
+ *             must not be accessed. A write of a cached item drops the cache.
+ *
+ * input parameters
+ *
+ * @param      pMsg		- SREQ received from a client
+ *
+ * output parameters
+ *
+ * @param      pKey		- key to pass to NPI_LNX_SreqCacheStore() on a miss
+ * @param      ppRsp		- cached SRSP on a hit, with a reference held by the
+ *                          caller. It must not be changed.
+ *
+ * @return     TRUE on a hit, FALSE otherwise.
+ ******************************************************************************
+ */
+uint8 NPI_LNX_SreqCacheLookup(const npiMsgData_t *pMsg, npiSreqCacheKey_t *pKey, npiMsgBuf_t **ppRsp)
+{
+	const npiSreqCacheRule_t *pRule;
+	int idx;
+
+	memset(pKey, 0, sizeof(*pKey));
+	if (!npiSreqCacheEnabled)
+	{
+		return FALSE;
+	}
+
+	if ((pMsg->subSys & RPC_SUBSYSTEM_MASK) == RPC_SYS_BOOT)
+	{
+		// The RNP image may be about to change
+		NPI_LNX_SreqCacheInvalidate(NPI_LNX_SREQ_CACHE_IMMUTABLE);
+		return FALSE;
+	}
+
+	pRule = npiSreqCacheMatch(npiSreqCacheWrites,
+			sizeof(npiSreqCacheWrites) / sizeof(npiSreqCacheWrites[0]), pMsg);
+	if ((pRule != NULL) && npiSreqCacheIsCachedItem(pMsg->pData[pRule->itemPos]))
+	{
+		NPI_LNX_SreqCacheInvalidate(NPI_LNX_SREQ_CACHE_IMMUTABLE);
+		return FALSE;
+	}
+
+	pRule = npiSreqCacheMatch(npiSreqCacheRules,
+			sizeof(npiSreqCacheRules) / sizeof(npiSreqCacheRules[0]), pMsg);
+	if ((pRule == NULL) || (pMsg->len > NPI_LNX_SREQ_CACHE_KEY_MAX))
+	{
+		return FALSE;
+	}
+
+	pKey->cacheable = TRUE;
+	pKey->scope = pRule->scope;
+	pKey->subSys = pMsg->subSys & RPC_SUBSYSTEM_MASK;
+	pKey->cmdId = pMsg->cmdId;
+	pKey->len = pMsg->len;
+	memcpy(pKey->pData, pMsg->pData, pMsg->len);
+
+	pthread_mutex_lock(&npiSreqCacheLock);
+	pKey->generation = npiSreqCacheGeneration;
+	for (idx = 0; idx < NPI_SREQ_CACHE_SIZE; idx++)
+	{
+		npiSreqCacheEntry_t *pEntry = &npiSreqCache[idx];
+
+		if (pEntry->inUse &&
+				(pEntry->key.subSys == pKey->subSys) &&
+				(pEntry->key.cmdId == pKey->cmdId) &&
+				(pEntry->key.len == pKey->len) &&
+				(memcmp(pEntry->key.pData, pKey->pData, pKey->len) == 0))
+		{
+			// The entry may be dropped by another thread while the caller sends it
+			NPI_LNX_MsgBufHold(pEntry->pRsp);
+			*ppRsp = pEntry->pRsp;
+			npiSreqCacheHits++;
+			pthread_mutex_unlock(&npiSreqCacheLock);
+
+			LOG_DEBUG("[SREQ CACHE] Hit subSys 0x%.2X cmdId 0x%.2X\n", pKey->subSys, pKey->cmdId);
+			return TRUE;
+		}
+	}
+	npiSreqCacheMisses++;
+	pthread_mutex_unlock(&npiSreqCacheLock);
+
+	return FALSE;
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_SreqCacheStore
+ *
+ * @brief      Store the response of a SREQ which missed. Nothing is stored
+ *             if the SREQ is not cacheable, if the response carries a
+ *             failure status, or if the cache was invalidated while the
+ *             SREQ was with the device.
+ *
+ * input parameters
+ *
+ * @param      pKey		- key filled in by NPI_LNX_SreqCacheLookup()
+ * @param      pRsp		- SRSP from the device
+ * @param      pRspBuf	- buffer holding pRsp, the cache takes a reference on
+ *                          it instead of a copy. NULL if pRsp is not in one.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+void NPI_LNX_SreqCacheStore(const npiSreqCacheKey_t *pKey, const npiMsgData_t *pRsp, npiMsgBuf_t *pRspBuf)
+{
+	npiSreqCacheEntry_t *pEntry;
+
+	// The first byte of the RemoTI item responses is the status
+	if (!pKey->cacheable || (pRsp->len == 0) || (pRsp->pData[0] != 0))
+	{
+		return;
+	}
+
+	if (pRspBuf)
+	{
+		NPI_LNX_MsgBufHold(pRspBuf);
+	}
+	else
+	{
+		// Devices which do not receive into message buffers
+		pRspBuf = NPI_LNX_MsgBufAlloc();
+		if (pRspBuf == NULL)
+		{
+			return;
+		}
+		memcpy(&pRspBuf->msg, pRsp, RPC_FRAME_HDR_SZ + pRsp->len);
+	}
+
+	pthread_mutex_lock(&npiSreqCacheLock);
+	if (pKey->generation == npiSreqCacheGeneration)
+	{
+		pEntry = &npiSreqCache[npiSreqCacheNext];
+		npiSreqCacheNext = (npiSreqCacheNext + 1) % NPI_SREQ_CACHE_SIZE;
+
+		if (pEntry->inUse)
+		{
+			NPI_LNX_MsgBufRelease(pEntry->pRsp);
+		}
+		pEntry->inUse = TRUE;
+		memcpy(&pEntry->key, pKey, sizeof(*pKey));
+		pEntry->pRsp = pRspBuf;
+		pRspBuf = NULL;
+	}
+	pthread_mutex_unlock(&npiSreqCacheLock);
+
+	// Not stored
+	NPI_LNX_MsgBufRelease(pRspBuf);
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_SreqCacheInvalidate
+ *
+ * @brief      Drop cached responses. Safe to call from any thread.
+ *
+ * input parameters
+ *
+ * @param      scope		- NPI_LNX_SREQ_CACHE_SESSION drops the session
+ *                          scoped responses only, NPI_LNX_SREQ_CACHE_IMMUTABLE
+ *                          drops all of them.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+void NPI_LNX_SreqCacheInvalidate(npiSreqCacheScope_t scope)
+{
+	int idx;
+
+	pthread_mutex_lock(&npiSreqCacheLock);
+	for (idx = 0; idx < NPI_SREQ_CACHE_SIZE; idx++)
+	{
+		if (npiSreqCache[idx].inUse && (npiSreqCache[idx].key.scope <= scope))
+		{
+			npiSreqCache[idx].inUse = FALSE;
+			NPI_LNX_MsgBufRelease(npiSreqCache[idx].pRsp);
+			npiSreqCache[idx].pRsp = NULL;
+		}
+	}
+	npiSreqCacheGeneration++;
+	npiSreqCacheInvalidations++;
+	pthread_mutex_unlock(&npiSreqCacheLock);
+
+	LOG_DEBUG("[SREQ CACHE] Dropped %s responses\n",
+			(scope == NPI_LNX_SREQ_CACHE_SESSION) ? "session" : "all");
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_SreqCacheAsynchMsg
+ *
+ * @brief      Watch an AREQ from the device for reset indications, which
+ *             drop the session scoped responses.
+ *
+ * input parameters
+ *
+ * @param      pMsg		- AREQ received from the device
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+void NPI_LNX_SreqCacheAsynchMsg(const npiMsgData_t *pMsg)
+{
+	uint8 subSys = pMsg->subSys & RPC_SUBSYSTEM_MASK;
+
+	if (((subSys == RPC_SYS_RCAF) &&
+			((pMsg->cmdId == NPI_SREQ_CACHE_RTI_RESET_IND) || (pMsg->cmdId == NPI_SREQ_CACHE_RTI_INIT_CNF))) ||
+		((subSys == RPC_SYS_SYS) && (pMsg->cmdId == NPI_SREQ_CACHE_SYS_RESET_IND)))
+	{
+		NPI_LNX_SreqCacheInvalidate(NPI_LNX_SREQ_CACHE_SESSION);
+	}
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_SreqCacheGetStats
+ *
+ * @brief      Read the cache counters.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * @param      pHits			- SREQs served from the cache
+ * @param      pMisses		- cacheable SREQs sent to the device
+ * @param      pInvalidations	- number of times the cache was dropped
+ *
+ * @return     None.
+ ******************************************************************************
+ */
+void NPI_LNX_SreqCacheGetStats(uint32 *pHits, uint32 *pMisses, uint32 *pInvalidations)
+{
+	pthread_mutex_lock(&npiSreqCacheLock);
+	*pHits = npiSreqCacheHits;
+	*pMisses = npiSreqCacheMisses;
+	*pInvalidations = npiSreqCacheInvalidations;
+	pthread_mutex_unlock(&npiSreqCacheLock);
+}
+
+/******************************************************************************
+ * @fn         NPI_LNX_SreqCacheIsReadOnly
+ *
+ * @brief      Check whether a SREQ only reads from the device.
+ *
+ * input parameters
+ *
+ * @param      pMsg		- SREQ received from a client
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     TRUE if sending the SREQ twice in a row yields the same
+ *             response, FALSE otherwise.
+ ******************************************************************************
+ */
+uint8 NPI_LNX_SreqCacheIsReadOnly(const npiMsgData_t *pMsg)
+{
+	// MT_SYS_PING has no payload, all others carry at least the item identifier
+	if ((pMsg->len == 0) && ((pMsg->subSys & RPC_SUBSYSTEM_MASK) == RPC_SYS_SYS))
+	{
+		return (pMsg->cmdId == NPI_SREQ_CACHE_SYS_PING) ? TRUE : FALSE;
+	}
+
+	return (npiSreqCacheMatch(npiSreqCacheReads,
+			sizeof(npiSreqCacheReads) / sizeof(npiSreqCacheReads[0]), pMsg) != NULL) ? TRUE : FALSE;
+}
+
+// -- Local functions --
+
+/******************************************************************************
+ * @fn         npiSreqCacheMatch
+ *
+ * @brief      Find the rule a SREQ matches.
+ *
+ * input parameters
+ *
+ * @param      pRules		- rule table
+ * @param      numRules		- number of rules in the table
+ * @param      pMsg			- SREQ
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     Matching rule, NULL if none. A rule with itemFirst and
+ *             itemLast both 0 matches any item, of any profile unless
+ *             rtiProfile is set.
+ ******************************************************************************
+ */
+static const npiSreqCacheRule_t *npiSreqCacheMatch(const npiSreqCacheRule_t *pRules, int numRules,
+		const npiMsgData_t *pMsg)
+{
+	int idx;
+	uint8 itemId;
+
+	for (idx = 0; idx < numRules; idx++)
+	{
+		if (((pMsg->subSys & RPC_SUBSYSTEM_MASK) != pRules[idx].subSys) ||
+				(pMsg->cmdId != pRules[idx].cmdId) ||
+				(pMsg->len <= pRules[idx].itemPos))
+		{
+			continue;
+		}
+
+		if (pRules[idx].rtiProfile && (pMsg->pData[0] != NPI_SREQ_CACHE_RTI_PROFILE_RTI))
+		{
+			continue;
+		}
+
+		itemId = pMsg->pData[pRules[idx].itemPos];
+		if (((pRules[idx].itemFirst == 0) && (pRules[idx].itemLast == 0)) ||
+				((itemId >= pRules[idx].itemFirst) && (itemId <= pRules[idx].itemLast)))
+		{
+			return &pRules[idx];
+		}
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ * @fn         npiSreqCacheIsCachedItem
+ *
+ * @brief      Check whether an item identifier is covered by a rule.
+ *
+ * input parameters
+ *
+ * @param      itemId		- item identifier
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return     TRUE if responses for this item may be cached.
+ ******************************************************************************
+ */
+static uint8 npiSreqCacheIsCachedItem(uint8 itemId)
+{
+	int idx;
+
+	for (idx = 0; idx < (int)(sizeof(npiSreqCacheRules) / sizeof(npiSreqCacheRules[0])); idx++)
+	{
+		if ((itemId >= npiSreqCacheRules[idx].itemFirst) && (itemId <= npiSreqCacheRules[idx].itemLast))
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
@@ -0,0 +1,234 @@
+/**************************************************************************************************
+  Filename:       npi_lnx_sreq_cache.h
+  Revised:        $Date: 2016-05-12 10:12:31 -0700 (Thu, 12 May 2016) $
+  Revision:       $Revision: 1 $
+
+  Description:    This file defines the cache of SREQ responses which do not change
+                  while the RNP session lasts.
+
+
+  Copyright (C) {2016} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**************************************************************************************************/
+#ifndef NPI_SREQ_CACHE_LNX_H
+#define NPI_SREQ_CACHE_LNX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+
+#include "hal_types.h"
+#include "npi_lnx.h"
+#include "npi_lnx_msgbuf.h"
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Constants
+
+  // Longest SREQ payload which can be a cache key
+#define NPI_LNX_SREQ_CACHE_KEY_MAX			8
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Typedefs
+
+  // What a cached response stays valid for
+  typedef enum
+  {
+	  NPI_LNX_SREQ_CACHE_SESSION = 0,	// until the RNP resets
+	  NPI_LNX_SREQ_CACHE_IMMUTABLE		// until the device is reset or reconnected by the server
+  } npiSreqCacheScope_t;
+
+  // Filled in by NPI_LNX_SreqCacheLookup() on a miss, and handed back to
+  // NPI_LNX_SreqCacheStore() with the response.
+  typedef struct
+  {
+	  uint8 cacheable;
+	  uint8 scope;
+	  uint32 generation;
+	  uint8 subSys;
+	  uint8 cmdId;
+	  uint8 len;
+	  uint8 pData[NPI_LNX_SREQ_CACHE_KEY_MAX];
+  } npiSreqCacheKey_t;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Interface function prototypes
+
+  /******************************************************************************
+   * @fn         NPI_LNX_SreqCacheReadConfiguration
+   *
+   * @brief      This function reads the optional [SREQ_CACHE] section of the
+   *             configuration file. The cache is enabled by default.
+   *
+   * input parameters
+   *
+   * @param      serialCfgFd	- open configuration file
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     NPI_LNX_SUCCESS
+   ******************************************************************************
+   */
+  extern int NPI_LNX_SreqCacheReadConfiguration(FILE *serialCfgFd);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_SreqCacheLookup
+   *
+   * @brief      Look up a device SREQ before it is sent. On a hit the device
+   *             must not be accessed. A write of a cached item drops the cache.
+   *
+   * input parameters
+   *
+   * @param      pMsg		- SREQ received from a client
+   *
+   * output parameters
+   *
+   * @param      pKey		- key to pass to NPI_LNX_SreqCacheStore() on a miss
+   * @param      ppRsp		- cached SRSP on a hit, with a reference held by the
+   *                          caller. It must not be changed.
+   *
+   * @return     TRUE on a hit, FALSE otherwise.
+   ******************************************************************************
+   */
+  extern uint8 NPI_LNX_SreqCacheLookup(const npiMsgData_t *pMsg, npiSreqCacheKey_t *pKey, npiMsgBuf_t **ppRsp);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_SreqCacheStore
+   *
+   * @brief      Store the response of a SREQ which missed. Nothing is stored
+   *             if the SREQ is not cacheable, if the response carries a
+   *             failure status, or if the cache was invalidated while the
+   *             SREQ was with the device.
+   *
+   * input parameters
+   *
+   * @param      pKey		- key filled in by NPI_LNX_SreqCacheLookup()
+   * @param      pRsp		- SRSP from the device
+   * @param      pRspBuf	- buffer holding pRsp, the cache takes a reference on
+   *                          it instead of a copy. NULL if pRsp is not in one.
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     None.
+   ******************************************************************************
+   */
+  extern void NPI_LNX_SreqCacheStore(const npiSreqCacheKey_t *pKey, const npiMsgData_t *pRsp, npiMsgBuf_t *pRspBuf);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_SreqCacheInvalidate
+   *
+   * @brief      Drop cached responses. Safe to call from any thread.
+   *
+   * input parameters
+   *
+   * @param      scope		- NPI_LNX_SREQ_CACHE_SESSION drops the session
+   *                          scoped responses only, NPI_LNX_SREQ_CACHE_IMMUTABLE
+   *                          drops all of them.
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     None.
+   ******************************************************************************
+   */
+  extern void NPI_LNX_SreqCacheInvalidate(npiSreqCacheScope_t scope);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_SreqCacheAsynchMsg
+   *
+   * @brief      Watch an AREQ from the device for reset indications, which
+   *             drop the session scoped responses.
+   *
+   * input parameters
+   *
+   * @param      pMsg		- AREQ received from the device
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     None.
+   ******************************************************************************
+   */
+  extern void NPI_LNX_SreqCacheAsynchMsg(const npiMsgData_t *pMsg);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_SreqCacheGetStats
+   *
+   * @brief      Read the cache counters.
+   *
+   * input parameters
+   *
+   * None.
+   *
+   * output parameters
+   *
+   * @param      pHits			- SREQs served from the cache
+   * @param      pMisses		- cacheable SREQs sent to the device
+   * @param      pInvalidations	- number of times the cache was dropped
+   *
+   * @return     None.
+   ******************************************************************************
+   */
+  extern void NPI_LNX_SreqCacheGetStats(uint32 *pHits, uint32 *pMisses, uint32 *pInvalidations);
+
+  /******************************************************************************
+   * @fn         NPI_LNX_SreqCacheIsReadOnly
+   *
+   * @brief      Check whether a SREQ only reads from the device. Identical
+   *             read-only SREQs from several clients may be answered with
+   *             a single device transaction.
+   *
+   * input parameters
+   *
+   * @param      pMsg		- SREQ received from a client
+   *
+   * output parameters
+   *
+   * None.
+   *
+   * @return     TRUE if sending the SREQ twice in a row yields the same
+   *             response, FALSE otherwise.
+   ******************************************************************************
+   */
+  extern uint8 NPI_LNX_SreqCacheIsReadOnly(const npiMsgData_t *pMsg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NPI_SREQ_CACHE_LNX_H
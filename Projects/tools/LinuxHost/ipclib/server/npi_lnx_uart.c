@@ -52,10 +52,13 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <semaphore.h>
+#include <poll.h>
 
 #include "aic.h"
 #include "npi_lnx.h"
 #include "npi_lnx_uart.h"
+#include "npi_lnx_sched.h"
+#include "npi_lnx_msgbuf.h"
 
 #include "npi_lnx_error.h"
 #include "tiLogging.h"
@@ -73,14 +76,6 @@
 
 // -- Constants --
 
-// Header portion of npiMsgData_t data structure
-// The constant may have to change as npiMsgData_t structure changes.
-#define NPI_MSG_DATA_HDR_LEN (sizeof(npiMsgData_t) - AP_MAX_BUF_LEN)
-
-// Size of header for callback data buffer, which should include linked list
-// pointers for queuing
-#define NPI_CBACK_BUF_HDR_LEN (sizeof(npiAsyncDataHdr_t) + NPI_MSG_DATA_HDR_LEN)
-
 // Time out value for response from RNP
 #define NPI_RNP_TIMEOUT 2 // in seconds
 
@@ -89,6 +84,17 @@
 // UART Flow Control
 #define NPI_FLOWCONTROL	0
 
+// RTIS sleep control commands, as defined in rtis_lnx.h
+#define NPI_UART_RTIS_CMD_ID_ENABLE_SLEEP_REQ	0x09
+#define NPI_UART_RTIS_CMD_ID_DISABLE_SLEEP_REQ	0x0A
+#define NPI_UART_RTIS_CMD_ID_ENABLE_SLEEP_CNF	0x08
+#define NPI_UART_RTIS_CMD_ID_DISABLE_SLEEP_CNF	0x09
+
+// RNP power states tracked by the sleep governor
+#define NPI_UART_RNP_AWAKE		0x00
+#define NPI_UART_RNP_ASLEEP		0x01
+#define NPI_UART_RNP_WAKING		0x02
+
 // State values for UART frame parsing
 #define SOP_STATE      0x00
 #define CMD_STATE1     0x01
@@ -99,11 +105,6 @@
 
 
 // -- Typedefs --
-typedef struct _npiAsyncDataHdr_t
-{
-	struct _npiAsyncDataHdr_t *pNext;
-} npiAsyncDataHdr_t;
-
 typedef struct _npi_parseinfo_str {
 	int state;
 	uint8 LEN_Token;
@@ -111,7 +112,7 @@ typedef struct _npi_parseinfo_str {
 	uint8 CMD1_Token;
 	uint8 FSC_Token;
 	uint8 tempDataLen;
-	uint8 *pMsg;
+	npiMsgBuf_t *pMsgBuf;
 } npi_parseinfo_t;
 
 // -- Global Variables --
@@ -123,13 +124,15 @@ npi_tracehook_t npi_tracehook_tx = NULL;
 // State variable used to indicate that a device is open.
 static int npiOpenFlag = FALSE;
 
-static npiUartCfg_t uartCfg = {NPI_BAUDRATE, NPI_FLOWCONTROL};
+static npiUartCfg_t uartCfg = {NPI_BAUDRATE, NPI_FLOWCONTROL, 0};
 
 // mutex to protect write calls
 static pthread_mutex_t npi_write_mutex;
 
-// pointer to synchronous response data buffer
+// pointer to the request waiting for its synchronous response
 static npiMsgData_t *pNpiSyncData;
+// synchronous response, handed over to the waiting caller in its receive buffer
+static npiMsgBuf_t *pNpiSyncRspBuf;
 // conditional variable for synchronous response
 static pthread_cond_t npiSyncRespCond;
 static pthread_mutex_t npiSyncRespLock;
@@ -142,11 +145,39 @@ static int npiAsyncTerminate;
 // conditional variable to wake up UART sleep disabling thread
 static pthread_cond_t npiUartWakeupCond;
 static pthread_mutex_t npiUartWakeupLock;
+static int npiUartWakeupRxd;
+
+// RNP sleep governor. The governor keeps the RNP awake while requests are in
+// flight, re-enables sleep once the link has been idle for
+// uartCfg.sleepIdleTimeout ms and wakes the RNP once for all requests queued
+// while it was asleep.
+static pthread_t npiSleepGovThread;
+static pthread_cond_t npiSleepGovCond;
+static pthread_mutex_t npiSleepGovLock;
+static int npiSleepGovTerminate;
+static int npiSleepGovState;
+static int npiSleepGovInflight;
+static int npiSleepGovHold;		// set by bootloader requests, cleared by the RNP
+static int npiSleepGovEnableCnfPending;
+static int npiSleepGovDisableCnfPending;
+static struct timespec npiSleepGovLastActivity;
+static npiUartSleepStats_t npiSleepGovStats;
+static unsigned long long npiSleepGovLatencySumUs;
+
+// Upper bounds of the wake latency histogram buckets, in microseconds
+static const uint32 npiSleepGovLatencyBounds[NPI_UART_WAKE_LATENCY_BUCKETS - 1] =
+{
+	500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 500000
+};
 
 // conditional variable to wake up UART receive thread
 static pthread_cond_t npi_rx_cond;
 static pthread_mutex_t npi_rx_mutex;
 static sem_t signal_mutex;
+#ifdef NPI_TICKLESS
+// pipe used to wake up UART receive thread for termination
+static int npi_rx_wakepipe[2] = {-1, -1};
+#endif
 // callback thread
 static pthread_t npiAsyncCbackThread;
 
@@ -154,8 +185,8 @@ static pthread_t npiAsyncCbackThread;
 static pthread_t npiRxThread;
 
 // linked list pointers for asynchronous message reception
-static npiAsyncDataHdr_t *pNpiAsyncQueueHead;
-static npiAsyncDataHdr_t *pNpiAsyncQueueTail;
+static npiMsgBuf_t *pNpiAsyncQueueHead;
+static npiMsgBuf_t *pNpiAsyncQueueTail;
 
 // received frame parsing state
 static int npi_rx_terminate;
@@ -174,6 +205,13 @@ static void npi_delsyncres(void);
 // thread termination subroutines
 static void npi_termasync(void);
 static void npi_termrx(void);
+static void npi_termsleepgov(void);
+
+// sleep governor subroutines
+static void npi_sleepgov_acquire(uint8 subsystem, uint8 cmd);
+static void npi_sleepgov_release(uint8 subsystem, uint8 cmd);
+static int npi_sleepgov_filter(uint8 subsystem, uint8 cmd);
+static int npi_wakeup(uint32 *pLatencyUs);
 
 // uart subroutines
 static int npi_opentty(const char *devpath);
@@ -181,15 +219,18 @@ static void npi_closetty(void);
 static int npi_write(const void *buf, size_t count);
 static int npi_sendframe(uint8 subsystem, uint8 cmd, uint8 *data, uint8 len);
 static int npi_parseframe(const unsigned char *buf, int len);
-static int npi_procframe( uint8 subsystemId, uint8 commandId, uint8 *pBuf, uint8 length);
+static int npi_procframe(npiMsgBuf_t *pMsgBuf);
 static uint8 npi_calcfcs(uint8 len, uint8 cmd0, uint8 cmd1, uint8 *data);
+#ifndef NPI_TICKLESS
 static void npi_iohandler(int status);
 static void npi_installsig(void);
+#endif
 static int pthread_accurate_cond_timedwait(pthread_cond_t *__restrict __cond, pthread_mutex_t *__restrict __mutex, struct timespec timeout);
 
 // thread entry routines
 static void *npiAsyncCbackProc(void *ptr);
 static void *npi_rx_entry(void *ptr);
+static void *npi_sleepgov_entry(void *ptr);
 
 // -- Public functions --
 
@@ -221,11 +262,13 @@ int NPI_UART_OpenDevice(const char *portName, void *pCfg)
 	{
 		uartCfg.speed = ((npiUartCfg_t *)pCfg)->speed;
 		uartCfg.flowcontrol = ((npiUartCfg_t *)pCfg)->flowcontrol;
+		uartCfg.sleepIdleTimeout = ((npiUartCfg_t *)pCfg)->sleepIdleTimeout;
 	}
 	else
 	{
 		uartCfg.speed = NPI_BAUDRATE;
 		uartCfg.flowcontrol = NPI_FLOWCONTROL;
+		uartCfg.sleepIdleTimeout = 0;
 	}
 
 	if (npiOpenFlag)
@@ -250,9 +293,21 @@ int NPI_UART_OpenDevice(const char *portName, void *pCfg)
 
 	// initialize sync call variable
 	pNpiSyncData = NULL;
+	pNpiSyncRspBuf = NULL;
+
+	// initialize sleep governor variables, the RNP is assumed awake when opened
+	npiSleepGovTerminate = 0;
+	npiSleepGovState = NPI_UART_RNP_AWAKE;
+	npiSleepGovInflight = 0;
+	npiSleepGovHold = FALSE;
+	npiSleepGovEnableCnfPending = 0;
+	npiSleepGovDisableCnfPending = 0;
+	memset(&npiSleepGovStats, 0, sizeof(npiSleepGovStats));
+	npiSleepGovLatencySumUs = 0;
+	clock_gettime(CLOCK_MONOTONIC, &npiSleepGovLastActivity);
 
 	// create asynchronous callback thread
-	if (pthread_create(&npiAsyncCbackThread, NULL, npiAsyncCbackProc, NULL )) {
+	if (NPI_LNX_SchedCreateThread(&npiAsyncCbackThread, NPI_LNX_SCHED_THREAD_UART_ASYNC, npiAsyncCbackProc, NULL)) {
 		// thread creation failed
 		npiOpenFlag = FALSE;
 
@@ -274,15 +329,30 @@ int NPI_UART_OpenDevice(const char *portName, void *pCfg)
 	}
 
 
-	// create UART receive thread
+#ifdef NPI_TICKLESS
+	if (pipe(npi_rx_wakepipe) < 0)
+	{
+		npi_termasync();
+		npi_closetty();
+
+		npi_delsyncres();
 
-	// TODO: it is ideal to make this thread higher priority
-	// but linux does not allow realtime of FIFO scheduling policy for
-	// non-priviledged threads.
-	if (pthread_create(&npiRxThread, NULL, npi_rx_entry, NULL)) {
+		npiOpenFlag = FALSE;
+
+		npi_ipc_errno = NPI_LNX_ERROR_UART_OPEN_FAILED_RX_THREAD;
+		return NPI_LNX_FAILURE;
+	}
+#endif
+
+	// create UART receive thread, with the [REALTIME] profile if configured
+	if (NPI_LNX_SchedCreateThread(&npiRxThread, NPI_LNX_SCHED_THREAD_UART_RX, npi_rx_entry, NULL)) {
 		// thread creation failed
 		npi_termasync();
 		npi_closetty();
+#ifdef NPI_TICKLESS
+		close(npi_rx_wakepipe[0]);
+		close(npi_rx_wakepipe[1]);
+#endif
 
 		npi_delsyncres();
 
@@ -292,6 +362,25 @@ int NPI_UART_OpenDevice(const char *portName, void *pCfg)
 		return NPI_LNX_FAILURE;
 	}
 
+	if (uartCfg.sleepIdleTimeout)
+	{
+		LOG_INFO("[UART] RNP sleep governor enabled, idle window %u ms\n", uartCfg.sleepIdleTimeout);
+		if (NPI_LNX_SchedCreateThread(&npiSleepGovThread, NPI_LNX_SCHED_THREAD_UART_SLEEPGOV, npi_sleepgov_entry, NULL))
+		{
+			// thread creation failed
+			npi_termrx();
+			npi_closetty();
+			npi_termasync();
+
+			npi_delsyncres();
+
+			npiOpenFlag = FALSE;
+
+			npi_ipc_errno = NPI_LNX_ERROR_UART_OPEN_FAILED_SLEEP_GOV_THREAD;
+			return NPI_LNX_FAILURE;
+		}
+	}
+
 	return NPI_LNX_SUCCESS;
 }
 
@@ -314,6 +403,16 @@ int NPI_UART_OpenDevice(const char *portName, void *pCfg)
 void NPI_UART_CloseDevice(void)
 {
 	LOG_DEBUG("[UART] UART device closing... \n");
+	if (uartCfg.sleepIdleTimeout)
+	{
+		npi_termsleepgov();
+		LOG_INFO("[UART] Sleep governor: %u wakes (%u timed out), %u sleeps, %u batched requests, wake latency min/avg/max %u/%u/%u us\n",
+				npiSleepGovStats.wakeCount, npiSleepGovStats.wakeTimeouts, npiSleepGovStats.sleepCount,
+				npiSleepGovStats.batchedTx, npiSleepGovStats.latencyMinUs,
+				npiSleepGovStats.wakeCount > npiSleepGovStats.wakeTimeouts ?
+						(uint32)(npiSleepGovLatencySumUs / (npiSleepGovStats.wakeCount - npiSleepGovStats.wakeTimeouts)) : 0,
+				npiSleepGovStats.latencyMaxUs);
+	}
 	npi_termrx();
 	LOG_DEBUG("[UART] UART thread closed... \n");
 	npi_closetty();
@@ -347,7 +446,13 @@ void NPI_UART_CloseDevice(void)
  */
 int NPI_UART_SendAsynchData( npiMsgData_t *pMsg )
 {
-	return npi_sendframe(pMsg->subSys | RPC_CMD_AREQ, pMsg->cmdId, pMsg->pData, pMsg->len);
+	int ret;
+
+	npi_sleepgov_acquire(pMsg->subSys, pMsg->cmdId);
+	ret = npi_sendframe(pMsg->subSys | RPC_CMD_AREQ, pMsg->cmdId, pMsg->pData, pMsg->len);
+	npi_sleepgov_release(pMsg->subSys, pMsg->cmdId);
+
+	return ret;
 }
 
 
@@ -371,23 +476,60 @@ int NPI_UART_SendAsynchData( npiMsgData_t *pMsg )
  **************************************************************************************************
  */
 int NPI_UART_SendSynchData( npiMsgData_t *pMsg )
+{
+	npiMsgBuf_t *pRsp;
+	int ret = NPI_UART_SendSynchBuf(pMsg, &pRsp);
+
+	if (pRsp)
+	{
+		memcpy(pMsg, &pRsp->msg, RPC_FRAME_HDR_SZ + pRsp->msg.len);
+		NPI_LNX_MsgBufRelease(pRsp);
+	}
+	else
+	{
+		// Clear buffer, so that the request is not taken for its response
+		pMsg->subSys = RPC_SYS_RES0 | RPC_CMD_RES6;
+	}
+
+	return ret;
+}
+
+/**************************************************************************************************
+ * @fn          NPI_UART_SendSynchBuf
+ *
+ * @brief       This function sends a SREQ and waits for the reply, which is handed over
+ *              in the buffer the receive thread read it into.
+ *
+ * input parameters
+ *
+ * @param *pMsg  - Pointer to data to be sent synchronously (i.e. the SREQ).
+ *
+ * output parameters
+ *
+ * @param **ppRsp - SRSP buffer with one reference held by the caller, NULL if none came.
+ *
+ * @return      STATUS
+ **************************************************************************************************
+ */
+int NPI_UART_SendSynchBuf( npiMsgData_t *pMsg, npiMsgBuf_t **ppRsp )
 {
 	int result, ret = NPI_LNX_SUCCESS;
+	uint8 subSys = pMsg->subSys, cmdId = pMsg->cmdId;
+
+	npi_sleepgov_acquire(subSys, cmdId);
 
 	pthread_mutex_lock(&npiSyncRespLock);
 	pNpiSyncData = pMsg;
+	pNpiSyncRspBuf = NULL;
 	ret = npi_sendframe(pMsg->subSys | RPC_CMD_SREQ, pMsg->cmdId, pMsg->pData, pMsg->len);
-	// Clear buffer
-	pMsg->subSys = RPC_SYS_RES0 | RPC_CMD_RES6;
 
 	if (ret == NPI_LNX_SUCCESS)
 	{
 		// Response may have already come in. This may be the case for Serial Bootloader which is really fast.
-		if ( ((pMsg->subSys & RPC_CMD_TYPE_MASK) == RPC_CMD_SRSP) ||
-			 ((pMsg->subSys & RPC_SUBSYSTEM_MASK) == RPC_SYS_BOOT) )
+		if (pNpiSyncRspBuf)
 		{
 			LOG_DEBUG("[UART] Synchronous Response received early, subSys 0x%.2X, cmdId 0x%.2X, pData[0] 0x%.2X\n",
-					pMsg->subSys, pMsg->cmdId, pMsg->pData[0]);
+					pNpiSyncRspBuf->msg.subSys, pNpiSyncRspBuf->msg.cmdId, pNpiSyncRspBuf->msg.pData[0]);
 		}
 		else
 		{
@@ -399,9 +541,6 @@ int NPI_UART_SendSynchData( npiMsgData_t *pMsg )
 			if (ETIMEDOUT == result)
 			{
 				// TODO: Indicate synchronous transaction error
-				// Uncommenting the following line will cause assert when connection is not there
-				// Uncomment it only during debugging.
-				// pMsg->pData[0] = 0xff;
 				LOG_DEBUG("[UART] Send synch data timed out\n");
 				npi_ipc_errno = NPI_LNX_ERROR_UART_SEND_SYNCH_TIMEDOUT;
 				ret = NPI_LNX_FAILURE;
@@ -411,18 +550,23 @@ int NPI_UART_SendSynchData( npiMsgData_t *pMsg )
 				LOG_DEBUG("[UART] Did not time out\n");
 			}
 		}
-		if ( ((pMsg->subSys & RPC_SUBSYSTEM_MASK) == RPC_SYS_BOOT) &&
-			 ((pMsg->subSys & RPC_CMD_TYPE_MASK) == RPC_CMD_SREQ) )
+		if ( pNpiSyncRspBuf &&
+			 ((pNpiSyncRspBuf->msg.subSys & RPC_SUBSYSTEM_MASK) == RPC_SYS_BOOT) &&
+			 ((pNpiSyncRspBuf->msg.subSys & RPC_CMD_TYPE_MASK) == RPC_CMD_SREQ) )
 		{
 			// There is a bug in early versions of the UART serial bootloader where the request type is SREQ,
 			// although it should be SRSP
-			pMsg->subSys = RPC_SYS_BOOT | RPC_CMD_SRSP;
+			pNpiSyncRspBuf->msg.subSys = RPC_SYS_BOOT | RPC_CMD_SRSP;
 		}
 	}
-	// Clear the pointer.
+	// Take the response over, one coming later is dropped by npi_procframe()
+	*ppRsp = pNpiSyncRspBuf;
+	pNpiSyncRspBuf = NULL;
 	pNpiSyncData = NULL;
 	pthread_mutex_unlock(&npiSyncRespLock);
 
+	npi_sleepgov_release(subSys, cmdId);
+
 	return ret;
 }
 
@@ -445,23 +589,44 @@ int NPI_UART_SendSynchData( npiMsgData_t *pMsg )
  */
 void npiUartDisableSleep( void )
 {
-	static uint8    pBuf[] = { 0x00 };
-	struct timespec timeout;
+	uint32 latencyUs;
 
-	// wait for a signal triggered by a character received only after
-	// sending wakeup character.
-	pthread_mutex_lock(&npiUartWakeupLock);
+	npi_wakeup(&latencyUs);
+}
 
-	// Send wakeup character
-	npi_write(pBuf, sizeof(pBuf));
+/**************************************************************************************************
+ * @fn          NPI_UART_GetSleepStats
+ *
+ * @brief       This function returns a snapshot of the RNP sleep governor
+ *              statistics; wake and sleep counts and the wake latency
+ *              distribution.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * @param *pStats  - Pointer to the statistics to fill in.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void NPI_UART_GetSleepStats( npiUartSleepStats_t *pStats )
+{
+	uint32 acknowledged;
 
-	// wait for wakeup
-	// The timeout is handy for the PC host application to move on when RNP goes wrong.
-	timeout.tv_sec = NPI_RNP_TIMEOUT;
-	timeout.tv_nsec = 0;
-	pthread_accurate_cond_timedwait(&npiUartWakeupCond, &npiUartWakeupLock, timeout);
+	if (!npiOpenFlag)
+	{
+		memset(pStats, 0, sizeof(*pStats));
+		return;
+	}
 
-	pthread_mutex_unlock(&npiUartWakeupLock);
+	pthread_mutex_lock(&npiSleepGovLock);
+	*pStats = npiSleepGovStats;
+	acknowledged = npiSleepGovStats.wakeCount - npiSleepGovStats.wakeTimeouts;
+	pStats->latencyAvgUs = acknowledged ? (uint32)(npiSleepGovLatencySumUs / acknowledged) : 0;
+	pthread_mutex_unlock(&npiSleepGovLock);
 }
 
 // -- private functions --
@@ -474,6 +639,7 @@ static void npi_initsyncres(void)
 	pthread_mutex_init(&npiSyncRespLock, NULL);
 	pthread_mutex_init(&npiAsyncLock, NULL);
 	pthread_mutex_init(&npiUartWakeupLock, NULL);
+	pthread_mutex_init(&npiSleepGovLock, NULL);
 	pthread_mutex_init(&npi_rx_mutex, NULL);
 	sem_init(&signal_mutex,0,1);
 
@@ -482,6 +648,16 @@ static void npi_initsyncres(void)
 	pthread_cond_init(&npiAsyncCond, NULL);
 	pthread_cond_init(&npiUartWakeupCond, NULL);
 	pthread_cond_init(&npi_rx_cond, NULL);
+
+	// the sleep governor waits for absolute deadlines on the monotonic clock
+	{
+		pthread_condattr_t condAttr;
+
+		pthread_condattr_init(&condAttr);
+		pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+		pthread_cond_init(&npiSleepGovCond, &condAttr);
+		pthread_condattr_destroy(&condAttr);
+	}
 }
 
 /* Destroy thread synchronization resources */
@@ -494,6 +670,7 @@ static void npi_delsyncres(void)
 	pthread_cond_destroy(&npiSyncRespCond);
 	pthread_cond_destroy(&npiAsyncCond);
 	pthread_cond_destroy(&npiUartWakeupCond);
+	pthread_cond_destroy(&npiSleepGovCond);
 	pthread_cond_destroy(&npi_rx_cond);
 
 	// destroy all mutexes
@@ -501,6 +678,7 @@ static void npi_delsyncres(void)
 	pthread_mutex_destroy(&npiSyncRespLock);
 	pthread_mutex_destroy(&npiAsyncLock);
 	pthread_mutex_destroy(&npiUartWakeupLock);
+	pthread_mutex_destroy(&npiSleepGovLock);
 	pthread_mutex_destroy(&npi_rx_mutex);
 	sem_destroy(&signal_mutex);
 
@@ -513,7 +691,7 @@ static void npi_delsyncres(void)
 // NPI function.
 static void *npiAsyncCbackProc(void *ptr)
 {
-	npiAsyncDataHdr_t *pElement;
+	npiMsgBuf_t *pElement;
 	int ret = NPI_LNX_SUCCESS;
 	char *errorMsg;
 
@@ -541,8 +719,8 @@ static void *npiAsyncCbackProc(void *ptr)
 				pthread_mutex_unlock(&npiAsyncLock);
 
 				// callback
-				ret = NPI_AsynchMsgCback((npiMsgData_t *)(pElement + 1));
-				free(pElement);
+				ret = NPI_AsynchMsgCback(&pElement->msg);
+				NPI_LNX_MsgBufRelease(pElement);
 				pElement = NULL;
 
 				// lock the mutext again before checking the terminate condition and queue
@@ -584,6 +762,7 @@ static void *npi_rx_entry(void *ptr)
 	unsigned char readbuf[255];
 	int rc;
 	int ret = NPI_LNX_SUCCESS;
+	int waited = FALSE;
 
 	/* install signal handler */
 	//npi_installsig();
@@ -599,12 +778,14 @@ static void *npi_rx_entry(void *ptr)
 	while (!npi_rx_terminate)
 	{
 		int readcount;
+		int bytesRead = 0;
 
 		do
 		{
 			readcount = read(npi_fd, readbuf, sizeof(readbuf));
 			if (readcount > 0)
 			{
+				bytesRead += readcount;
 				ret = npi_parseframe(readbuf, readcount);
 				if (ret == NPI_LNX_FAILURE)
 				{
@@ -632,6 +813,12 @@ static void *npi_rx_entry(void *ptr)
 			}
 		} while (readcount > 0);
 
+		if (waited && !bytesRead && !npi_rx_terminate)
+		{
+			// Woke up without anything to read
+			NPI_LNX_SchedIdleWakeup(NPI_LNX_SCHED_THREAD_UART_RX);
+		}
+
 		if (ret == NPI_LNX_FAILURE)
 		{
 			npi_rx_terminate = 1;
@@ -639,7 +826,30 @@ static void *npi_rx_entry(void *ptr)
 		}
 		else
 		{
-#ifdef NPI_UNRELIABLE_SIGACTION
+			waited = TRUE;
+#if (defined NPI_TICKLESS)
+			/* Block until the device is readable or termination is signalled */
+			{
+				struct pollfd pollfds[2];
+				char drain[8];
+
+				pollfds[0].fd = npi_fd;
+				pollfds[0].events = POLLIN;
+				pollfds[1].fd = npi_rx_wakepipe[0];
+				pollfds[1].events = POLLIN;
+				LOG_DEBUG("%s(): Wait for data\n", __FUNCTION__);
+				rc = poll(pollfds, 2, -1);
+				if ((rc > 0) && (pollfds[1].revents & POLLIN))
+				{
+					if (read(npi_rx_wakepipe[0], drain, sizeof(drain)) < 0)
+						LOG_ERROR("%s(): Failed to drain wake pipe\n", __FUNCTION__);
+				}
+				else if ((rc < 0) && (errno != EINTR))
+				{
+					LOG_ERROR("%s(): Unexpected error from poll: %d\n", __FUNCTION__, errno);
+				}
+			}
+#elif (defined NPI_UNRELIABLE_SIGACTION)
 			/* In some system, sigaction is not reliable hence poll reading even without signal. */
 			{
 				int waitTime = 10000000;
@@ -678,6 +888,63 @@ static void *npi_rx_entry(void *ptr)
 	return NULL;
 }
 
+/* Sleep governor thread entry routine */
+static void *npi_sleepgov_entry(void *ptr)
+{
+	struct timespec deadline, now;
+	uint8 dummy = 0;
+
+	(void)ptr; // Unused
+
+	pthread_mutex_lock(&npiSleepGovLock);
+	while (!npiSleepGovTerminate)
+	{
+		if ((npiSleepGovState != NPI_UART_RNP_AWAKE) || npiSleepGovInflight || npiSleepGovHold)
+		{
+			// Nothing to do until the RNP is awake and the link is quiet
+			pthread_cond_wait(&npiSleepGovCond, &npiSleepGovLock);
+			continue;
+		}
+
+		// Idle window is counted from the last request or indication
+		deadline.tv_sec = npiSleepGovLastActivity.tv_sec + (uartCfg.sleepIdleTimeout / 1000);
+		deadline.tv_nsec = npiSleepGovLastActivity.tv_nsec + ((uartCfg.sleepIdleTimeout % 1000) * 1000000);
+		if (deadline.tv_nsec >= 1000000000)
+		{
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if ((now.tv_sec < deadline.tv_sec) ||
+			((now.tv_sec == deadline.tv_sec) && (now.tv_nsec < deadline.tv_nsec)))
+		{
+			pthread_cond_timedwait(&npiSleepGovCond, &npiSleepGovLock, &deadline);
+			continue;
+		}
+
+		// Burst is over, let the RNP sleep. The request is sent with the lock
+		// held so that no wakeup character can overtake it.
+		LOG_DEBUG("[UART] Sleep governor: link idle for %u ms, enabling RNP sleep\n", uartCfg.sleepIdleTimeout);
+		npiSleepGovState = NPI_UART_RNP_ASLEEP;
+		npiSleepGovEnableCnfPending++;
+		if (npi_sendframe(RPC_SYS_RCAF | RPC_CMD_AREQ, NPI_UART_RTIS_CMD_ID_ENABLE_SLEEP_REQ, &dummy, 0) == NPI_LNX_SUCCESS)
+		{
+			npiSleepGovStats.sleepCount++;
+		}
+		else
+		{
+			// RNP never got the request, it is still awake. Retry after another idle window.
+			LOG_WARN("[UART] Sleep governor: failed to enable RNP sleep\n");
+			npiSleepGovState = NPI_UART_RNP_AWAKE;
+			npiSleepGovEnableCnfPending--;
+			npiSleepGovLastActivity = now;
+		}
+	}
+	pthread_mutex_unlock(&npiSleepGovLock);
+
+	return NULL;
+}
+
 /* Terminate Asynchronous thread */
 static void npi_termasync(void)
 {
@@ -697,7 +964,10 @@ static void npi_termrx(void)
 	// send terminate signal
 	npi_rx_terminate = 1;
 	LOG_DEBUG("[UART] [MUTEX] Signaling thread that we have terminated\n");
-#ifdef NPI_UNRELIABLE_SIGACTION
+#if (defined NPI_TICKLESS)
+	if (write(npi_rx_wakepipe[1], "T", 1) < 0)
+		LOG_ERROR("%s(): Failed to wake up rx thread\n", __FUNCTION__);
+#elif (defined NPI_UNRELIABLE_SIGACTION)
 	pthread_cond_signal(&npi_rx_cond);
 #else
 	sem_post(&signal_mutex);
@@ -706,6 +976,23 @@ static void npi_termrx(void)
 	// wait till the thread terminates
 	LOG_DEBUG("[UART] [MUTEX] Waiting for thread to finish termination\n");
 	pthread_join(npiRxThread, NULL);
+#ifdef NPI_TICKLESS
+	close(npi_rx_wakepipe[0]);
+	close(npi_rx_wakepipe[1]);
+#endif
+}
+
+/* Terminate sleep governor thread */
+static void npi_termsleepgov(void)
+{
+	// send terminate signal
+	pthread_mutex_lock(&npiSleepGovLock);
+	npiSleepGovTerminate = 1;
+	pthread_cond_broadcast(&npiSleepGovCond);
+	pthread_mutex_unlock(&npiSleepGovLock);
+
+	// wait till the thread terminates
+	pthread_join(npiSleepGovThread, NULL);
 }
 
 /* Open TTY device
@@ -720,11 +1007,16 @@ static int npi_opentty(const char *devpath)
 		return npi_fd;
 	}
 
+#ifdef NPI_TICKLESS
+	/* the receive thread polls the descriptor, no SIGIO needed */
+	fcntl(npi_fd, F_SETFL, FNDELAY);
+#else
 	/* install signal handler */
 	npi_installsig();
 
 	/* make the file descriptor asynchronous */
 	fcntl(npi_fd, F_SETFL, FASYNC | FNDELAY);
+#endif
 
 	/* save current port settings */
 	tcgetattr(npi_fd, &npi_oldtio);
@@ -896,6 +1188,7 @@ static int npi_parseframe(const unsigned char *buf, int len)
 	{
 		// fire UART wakeup signal
 		pthread_mutex_lock(&npiUartWakeupLock);
+		npiUartWakeupRxd = TRUE;
 		pthread_cond_signal(&npiUartWakeupCond);
 		pthread_mutex_unlock(&npiUartWakeupLock);
 	}
@@ -917,11 +1210,10 @@ static int npi_parseframe(const unsigned char *buf, int len)
 
 			npi_parseinfo.tempDataLen = 0;
 
-			/* Allocate memory for the data */
-			npi_parseinfo.pMsg = (uint8 *)malloc(
-					NPI_CBACK_BUF_HDR_LEN + npi_parseinfo.LEN_Token );
+			/* Take a buffer for the frame, it is not copied again on its way to the clients */
+			npi_parseinfo.pMsgBuf = NPI_LNX_MsgBufAlloc();
 
-			if (npi_parseinfo.pMsg)
+			if (npi_parseinfo.pMsgBuf)
 			{
 				/* Fill up what we can */
 				npi_parseinfo.state = CMD_STATE1;
@@ -955,7 +1247,7 @@ static int npi_parseframe(const unsigned char *buf, int len)
 		case DATA_STATE:
 
 			/* Fill in the buffer the first byte of the data */
-			npi_parseinfo.pMsg[NPI_CBACK_BUF_HDR_LEN + npi_parseinfo.tempDataLen++] = ch;
+			npi_parseinfo.pMsgBuf->msg.pData[npi_parseinfo.tempDataLen++] = ch;
 
 			/* Check number of bytes left in the Rx buffer */
 			bytesInRxBuffer = len;
@@ -963,7 +1255,7 @@ static int npi_parseframe(const unsigned char *buf, int len)
 			/* If the remainder of the data is there, read them all, otherwise, just read enough */
 			if (bytesInRxBuffer <= npi_parseinfo.LEN_Token - npi_parseinfo.tempDataLen)
 			{
-				memcpy(&npi_parseinfo.pMsg[NPI_CBACK_BUF_HDR_LEN + npi_parseinfo.tempDataLen],
+				memcpy(&npi_parseinfo.pMsgBuf->msg.pData[npi_parseinfo.tempDataLen],
 						buf, bytesInRxBuffer);
 				buf += bytesInRxBuffer;
 				len -= bytesInRxBuffer;
@@ -971,7 +1263,7 @@ static int npi_parseframe(const unsigned char *buf, int len)
 			}
 			else
 			{
-				memcpy(&npi_parseinfo.pMsg[NPI_CBACK_BUF_HDR_LEN + npi_parseinfo.tempDataLen],
+				memcpy(&npi_parseinfo.pMsgBuf->msg.pData[npi_parseinfo.tempDataLen],
 						buf, npi_parseinfo.LEN_Token - npi_parseinfo.tempDataLen);
 				buf += npi_parseinfo.LEN_Token - npi_parseinfo.tempDataLen;
 				len -= npi_parseinfo.LEN_Token - npi_parseinfo.tempDataLen;
@@ -993,21 +1285,23 @@ static int npi_parseframe(const unsigned char *buf, int len)
 					npi_parseinfo.LEN_Token,
 					npi_parseinfo.CMD0_Token,
 					npi_parseinfo.CMD1_Token,
-					&npi_parseinfo.pMsg[NPI_CBACK_BUF_HDR_LEN])
+					npi_parseinfo.pMsgBuf->msg.pData)
 					== npi_parseinfo.FSC_Token))
 			{
 				// Trace the received data
 				if (npi_tracehook_rx)
 				{
 					npi_tracehook_rx(npi_parseinfo.CMD0_Token, npi_parseinfo.CMD1_Token,
-							&npi_parseinfo.pMsg[NPI_CBACK_BUF_HDR_LEN],
+							npi_parseinfo.pMsgBuf->msg.pData,
 							npi_parseinfo.LEN_Token);
 				}
 
 				LOG_DEBUG("[UART] npi_parseframe: found frame, going to npi_procframe\n");
 				// process the received frame
-				ret = npi_procframe(npi_parseinfo.CMD0_Token, npi_parseinfo.CMD1_Token,
-						npi_parseinfo.pMsg, npi_parseinfo.LEN_Token);
+				npi_parseinfo.pMsgBuf->msg.len = npi_parseinfo.LEN_Token;
+				npi_parseinfo.pMsgBuf->msg.subSys = npi_parseinfo.CMD0_Token;
+				npi_parseinfo.pMsgBuf->msg.cmdId = npi_parseinfo.CMD1_Token;
+				ret = npi_procframe(npi_parseinfo.pMsgBuf);
 			}
 			else
 			{
@@ -1018,10 +1312,11 @@ static int npi_parseframe(const unsigned char *buf, int len)
 						npi_parseinfo.CMD1_Token,
 						npi_parseinfo.FSC_Token);
 				/* deallocate the msg */
-				free ( (uint8 *)npi_parseinfo.pMsg );
+				NPI_LNX_MsgBufRelease(npi_parseinfo.pMsgBuf);
 			}
 
 			/* Reset the state, send or discard the buffers at this point */
+			npi_parseinfo.pMsgBuf = NULL;
 			npi_parseinfo.state = SOP_STATE;
 
 			break;
@@ -1034,44 +1329,49 @@ static int npi_parseframe(const unsigned char *buf, int len)
 	return ret;
 }
 
-/* Process received frame */
-static int npi_procframe( uint8 subsystemId, uint8 commandId, uint8 *pBuf,
-		uint8 length)
+/* Process received frame, pMsgBuf is taken over */
+static int npi_procframe(npiMsgBuf_t *pMsgBuf)
 {
 	int ret = NPI_LNX_SUCCESS;
 	int i;
 	int charCount = 0;
 	char tmpStr[512];
+	npiMsgData_t *pFrame = &pMsgBuf->msg;
+	uint8 subsystemId = pFrame->subSys;
+	uint8 commandId = pFrame->cmdId;
+	uint8 length = pFrame->len;
 
 	snprintf(tmpStr, sizeof(tmpStr), "[UART] npi_procframe, subsys: 0x%.2x, Cmd ID: 0x%.2X, length: %d ,Data: ", subsystemId, commandId, length);
 
 	for (i=0;i<length;i++)
 	{
-		snprintf(&tmpStr[charCount], sizeof(tmpStr) - charCount, "%.2x ", pBuf[i]);
+		snprintf(&tmpStr[charCount], sizeof(tmpStr) - charCount, "%.2x ", pFrame->pData[i]);
 		charCount += 3;
 	}
 	snprintf(&tmpStr[charCount], sizeof(tmpStr) - charCount, "\n");
 	LOG_DEBUG("%s", tmpStr);
 
-	if ( ((subsystemId & RPC_CMD_TYPE_MASK) == RPC_CMD_SRSP) ||
+	if (npi_sleepgov_filter(subsystemId, commandId))
+	{
+		// confirmation of a sleep request issued by the sleep governor itself
+		NPI_LNX_MsgBufRelease(pMsgBuf);
+	}
+	else if ( ((subsystemId & RPC_CMD_TYPE_MASK) == RPC_CMD_SRSP) ||
 			((subsystemId & RPC_SUBSYSTEM_MASK) == RPC_SYS_BOOT))
 	{
 		// synchronous response
 
 		pthread_mutex_lock(&npiSyncRespLock);
-		npiMsgData_t *pMsg = pNpiSyncData;
-		if (pMsg)
+		if (pNpiSyncData && !pNpiSyncRspBuf)
 		{
-			// Fill in the synchronous response buffer
-			memcpy(&pMsg->pData, pBuf + NPI_CBACK_BUF_HDR_LEN, length);
-			pMsg->len = length;
-			pMsg->subSys = subsystemId;
-			pMsg->cmdId = commandId;
+			// Hand the buffer over to the waiting caller, the frame is not copied
+			pNpiSyncRspBuf = pMsgBuf;
+		}
+		else
+		{
+			// if no one waits, no action should be taken
+			NPI_LNX_MsgBufRelease(pMsgBuf);
 		}
-		// if pointer is NULL, no action should be taken
-
-		// the buffer usage is done, no more use expected
-		free(pBuf);
 
 		LOG_DEBUG("[UART] npi_procframe signal synch response received (invoked by read loop) \n");
 		// Unblock the synchronous request call
@@ -1080,31 +1380,20 @@ static int npi_procframe( uint8 subsystemId, uint8 commandId, uint8 *pBuf,
 	}
 	else
 	{
-		// must be an asynchronous message
-
-		// type cast to asynchornous message queue element data structure
-		npiAsyncDataHdr_t *pElement = (npiAsyncDataHdr_t *) pBuf;
-
-		// type cast the message structure
-		npiMsgData_t *pMsg = (npiMsgData_t *) (pBuf + sizeof(npiAsyncDataHdr_t));
-
-		// Fill in the message structure
-		pMsg->len = length;
-		pMsg->subSys = subsystemId;
-		pMsg->cmdId = commandId;
-		pElement->pNext = NULL;
+		// must be an asynchronous message, the queue takes over the buffer
+		pMsgBuf->pNext = NULL;
 
 		// queue the message
 		pthread_mutex_lock(&npiAsyncLock);
 		if (pNpiAsyncQueueHead)
 		{
-			pNpiAsyncQueueHead->pNext = pElement;
+			pNpiAsyncQueueHead->pNext = pMsgBuf;
 		}
 		else
 		{
-			pNpiAsyncQueueTail = pElement;
+			pNpiAsyncQueueTail = pMsgBuf;
 		}
-		pNpiAsyncQueueHead = pElement;
+		pNpiAsyncQueueHead = pMsgBuf;
 
 		LOG_DEBUG("[UART] npi_procframe signal areq callback thread (invoked by read loop) \n");
 		/* wake up the asynchronous callback thread */
@@ -1115,6 +1404,194 @@ static int npi_procframe( uint8 subsystemId, uint8 commandId, uint8 *pBuf,
 	return ret;
 }
 
+/* Make sure the RNP is awake before a request is sent to it.
+ * Requests arriving while another request is waking the RNP are queued
+ * behind that single wake. */
+static void npi_sleepgov_acquire(uint8 subsystem, uint8 cmd)
+{
+	uint32 latencyUs;
+	uint8 dummy = 0;
+	int bucket;
+
+	(void)cmd; // Unused
+
+	if (!uartCfg.sleepIdleTimeout)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&npiSleepGovLock);
+	npiSleepGovInflight++;
+	// Serial bootloader traffic must not be interleaved with sleep requests.
+	// Requests of other clients do not end the hold, only the RNP answering
+	// outside the bootloader does, see npi_sleepgov_filter().
+	if ((subsystem & RPC_SUBSYSTEM_MASK) == RPC_SYS_BOOT)
+	{
+		npiSleepGovHold = TRUE;
+	}
+
+	if (npiSleepGovState == NPI_UART_RNP_WAKING)
+	{
+		npiSleepGovStats.batchedTx++;
+		while (npiSleepGovState == NPI_UART_RNP_WAKING)
+		{
+			pthread_cond_wait(&npiSleepGovCond, &npiSleepGovLock);
+		}
+	}
+
+	if (npiSleepGovState == NPI_UART_RNP_ASLEEP)
+	{
+		npiSleepGovState = NPI_UART_RNP_WAKING;
+		pthread_mutex_unlock(&npiSleepGovLock);
+
+		if (npi_wakeup(&latencyUs) == NPI_LNX_SUCCESS)
+		{
+			// Keep the RNP awake until the governor enables sleep again
+			pthread_mutex_lock(&npiSleepGovLock);
+			npiSleepGovDisableCnfPending++;
+			pthread_mutex_unlock(&npiSleepGovLock);
+			npi_sendframe(RPC_SYS_RCAF | RPC_CMD_AREQ, NPI_UART_RTIS_CMD_ID_DISABLE_SLEEP_REQ, &dummy, 0);
+
+			pthread_mutex_lock(&npiSleepGovLock);
+			if ((npiSleepGovStats.wakeCount == npiSleepGovStats.wakeTimeouts) ||
+				(latencyUs < npiSleepGovStats.latencyMinUs))
+			{
+				npiSleepGovStats.latencyMinUs = latencyUs;
+			}
+			if (latencyUs > npiSleepGovStats.latencyMaxUs)
+			{
+				npiSleepGovStats.latencyMaxUs = latencyUs;
+			}
+			npiSleepGovLatencySumUs += latencyUs;
+			for (bucket = 0; bucket < (NPI_UART_WAKE_LATENCY_BUCKETS - 1); bucket++)
+			{
+				if (latencyUs < npiSleepGovLatencyBounds[bucket])
+				{
+					break;
+				}
+			}
+			npiSleepGovStats.latencyHist[bucket]++;
+			LOG_DEBUG("[UART] Sleep governor: RNP woke up in %u us\n", latencyUs);
+		}
+		else
+		{
+			// Send the request anyway, its own timeout reports a dead RNP
+			pthread_mutex_lock(&npiSleepGovLock);
+			npiSleepGovStats.wakeTimeouts++;
+			LOG_WARN("[UART] Sleep governor: RNP did not acknowledge wakeup\n");
+		}
+		npiSleepGovStats.wakeCount++;
+		npiSleepGovState = NPI_UART_RNP_AWAKE;
+		pthread_cond_broadcast(&npiSleepGovCond);
+	}
+	pthread_mutex_unlock(&npiSleepGovLock);
+}
+
+/* Mark the end of a request, the idle window restarts from here */
+static void npi_sleepgov_release(uint8 subsystem, uint8 cmd)
+{
+	if (!uartCfg.sleepIdleTimeout)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&npiSleepGovLock);
+	npiSleepGovInflight--;
+	if (((subsystem & RPC_SUBSYSTEM_MASK) == RPC_SYS_RCAF) &&
+		(cmd == NPI_UART_RTIS_CMD_ID_ENABLE_SLEEP_REQ))
+	{
+		// Application put the RNP to sleep itself, wake it on the next request
+		npiSleepGovState = NPI_UART_RNP_ASLEEP;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &npiSleepGovLastActivity);
+	pthread_cond_broadcast(&npiSleepGovCond);
+	pthread_mutex_unlock(&npiSleepGovLock);
+}
+
+/* Account for a frame received from the RNP.
+ * return TRUE if the frame confirms a sleep request issued by the governor
+ * and must not be forwarded to the clients. */
+static int npi_sleepgov_filter(uint8 subsystem, uint8 cmd)
+{
+	int drop = FALSE;
+
+	if (!uartCfg.sleepIdleTimeout)
+	{
+		return FALSE;
+	}
+
+	pthread_mutex_lock(&npiSleepGovLock);
+	if (npiSleepGovHold && ((subsystem & RPC_SUBSYSTEM_MASK) != RPC_SYS_BOOT))
+	{
+		// RNP runs the application image again, sleep may be managed
+		npiSleepGovHold = FALSE;
+		pthread_cond_broadcast(&npiSleepGovCond);
+	}
+	if (((subsystem & RPC_SUBSYSTEM_MASK) == RPC_SYS_RCAF) &&
+		((subsystem & RPC_CMD_TYPE_MASK) == RPC_CMD_AREQ))
+	{
+		if ((cmd == NPI_UART_RTIS_CMD_ID_ENABLE_SLEEP_CNF) && npiSleepGovEnableCnfPending)
+		{
+			npiSleepGovEnableCnfPending--;
+			drop = TRUE;
+		}
+		else if ((cmd == NPI_UART_RTIS_CMD_ID_DISABLE_SLEEP_CNF) && npiSleepGovDisableCnfPending)
+		{
+			npiSleepGovDisableCnfPending--;
+			drop = TRUE;
+		}
+	}
+	if (!drop && (npiSleepGovState == NPI_UART_RNP_AWAKE))
+	{
+		// Indications from the RNP extend the burst as well
+		clock_gettime(CLOCK_MONOTONIC, &npiSleepGovLastActivity);
+	}
+	pthread_mutex_unlock(&npiSleepGovLock);
+
+	return drop;
+}
+
+/* Send the wakeup character and wait for the RNP to answer.
+ * return NPI_LNX_SUCCESS if the RNP answered within NPI_RNP_TIMEOUT */
+static int npi_wakeup(uint32 *pLatencyUs)
+{
+	static uint8    pBuf[] = { 0x00 };
+	struct timespec timeout, start, end;
+	int result = 0;
+	int acknowledged;
+
+	// wait for a signal triggered by a character received only after
+	// sending wakeup character.
+	pthread_mutex_lock(&npiUartWakeupLock);
+	npiUartWakeupRxd = FALSE;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	// Send wakeup character
+	npi_write(pBuf, sizeof(pBuf));
+
+	// wait for wakeup
+	// The timeout is handy for the PC host application to move on when RNP goes wrong.
+	timeout.tv_sec = NPI_RNP_TIMEOUT;
+	timeout.tv_nsec = 0;
+	while (!npiUartWakeupRxd && (result != ETIMEDOUT))
+	{
+		result = pthread_accurate_cond_timedwait(&npiUartWakeupCond, &npiUartWakeupLock, timeout);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	acknowledged = npiUartWakeupRxd;
+
+	pthread_mutex_unlock(&npiUartWakeupLock);
+
+	*pLatencyUs = (uint32)(((end.tv_sec - start.tv_sec) * 1000000) + ((end.tv_nsec - start.tv_nsec) / 1000));
+	if (!acknowledged)
+	{
+		npi_ipc_errno = NPI_LNX_ERROR_UART_SLEEP_GOV_WAKEUP_TIMEDOUT;
+		return NPI_LNX_FAILURE;
+	}
+
+	return NPI_LNX_SUCCESS;
+}
+
 /* Calculate NPI frame FCS */
 static uint8 npi_calcfcs( uint8 len, uint8 cmd0, uint8 cmd1, uint8 *data_ptr )
 {
@@ -1192,6 +1669,7 @@ static int pthread_accurate_cond_timedwait(pthread_cond_t *__restrict __cond, pt
 	return result;
 }
 
+#ifndef NPI_TICKLESS
 static void npi_iohandler(int signum)
 {
 	// This is a potential reentrant function.
@@ -1236,6 +1714,7 @@ static void npi_installsig(void)
 		perror("fcntl");
 	}
 }
+#endif // NPI_TICKLESS
 #endif // #if (defined NPI_UART) && (NPI_UART == TRUE)
 
 /**************************************************************************************************
@@ -63,8 +63,25 @@ PACK_1 typedef struct ATTR_PACKED
 {
 	  uint32 speed;
 	  uint8 flowcontrol;
+	  uint32 sleepIdleTimeout;	// ms without traffic before the RNP is put to sleep, 0 disables the sleep governor
 } npiUartCfg_t;
 
+// Number of buckets in the wake latency histogram. Bucket upper bounds are
+// 0.5, 1, 2, 5, 10, 20, 50, 100 and 500 ms, the last bucket holds the rest.
+#define NPI_UART_WAKE_LATENCY_BUCKETS	10
+
+typedef struct
+{
+	  uint32 wakeCount;			// wake handshakes performed by the sleep governor
+	  uint32 wakeTimeouts;		// wake handshakes the RNP did not acknowledge
+	  uint32 sleepCount;		// times the sleep governor re-enabled RNP sleep
+	  uint32 batchedTx;			// requests that were queued behind a wake already in progress
+	  uint32 latencyMinUs;		// fastest acknowledged wake handshake, in microseconds
+	  uint32 latencyAvgUs;		// average acknowledged wake handshake, in microseconds
+	  uint32 latencyMaxUs;		// slowest acknowledged wake handshake, in microseconds
+	  uint32 latencyHist[NPI_UART_WAKE_LATENCY_BUCKETS];
+} npiUartSleepStats_t;
+
   /////////////////////////////////////////////////////////////////////////////
   // globals
 
@@ -154,6 +171,45 @@ PACK_1 typedef struct ATTR_PACKED
    */
   extern int NPI_UART_SendSynchData( npiMsgData_t *pMsg );
 
+  /**************************************************************************************************
+   * @fn          NPI_UART_SendSynchBuf
+   *
+   * @brief       This function sends a SREQ and waits for the reply, which is handed over
+   *              in the buffer the receive thread read it into.
+   *
+   * input parameters
+   *
+   * @param *pMsg  - Pointer to data to be sent synchronously (i.e. the SREQ).
+   *
+   * output parameters
+   *
+   * @param **ppRsp - SRSP buffer with one reference held by the caller, NULL if none came.
+   *
+   * @return      STATUS
+   **************************************************************************************************
+   */
+  extern int NPI_UART_SendSynchBuf( npiMsgData_t *pMsg, struct npiMsgBuf_s **ppRsp );
+
+  /**************************************************************************************************
+   * @fn          NPI_UART_GetSleepStats
+   *
+   * @brief       This function returns a snapshot of the RNP sleep governor
+   *              statistics; wake and sleep counts and the wake latency
+   *              distribution.
+   *
+   * input parameters
+   *
+   * None.
+   *
+   * output parameters
+   *
+   * @param *pStats  - Pointer to the statistics to fill in.
+   *
+   * @return      None.
+   **************************************************************************************************
+   */
+  extern void NPI_UART_GetSleepStats( npiUartSleepStats_t *pStats );
+
 #ifdef __cplusplus
 }
 #endif